@@ -0,0 +1,14 @@
+#include <absl/log/globals.h>
+#include <benchmark/benchmark.h>
+
+int main(int argc, char **argv) {
+    // Hot paths log at INFO, which would be measured along with them
+    absl::SetMinLogLevel(absl::LogSeverityAtLeast::kWarning);
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
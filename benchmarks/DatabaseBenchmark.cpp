@@ -0,0 +1,93 @@
+#include <benchmark/benchmark.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <database/ProtobufDatabase.hpp>
+#include <database/SQLiteDatabase.hpp>
+#include <filesystem>
+#include <string>
+
+namespace {
+
+constexpr int kUsers = 256;
+constexpr int kMedia = 256;
+constexpr UserId kFirstUser = 100000;
+
+// A new database in a temporary file, with kUsers whitelisted and kMedia
+// media names
+template <typename Database>
+class ScratchDatabase {
+   public:
+    explicit ScratchDatabase(const std::string_view name)
+        : file_(std::filesystem::temp_directory_path() /
+                ("tgbot_bench_" + std::string(name) + "_" +
+                 std::to_string(::getpid()))) {
+        std::filesystem::remove(file_);
+        if (!database_.loadDatabaseFromFile(file_)) {
+            return;
+        }
+        database_.initDatabase();
+        for (int i = 0; i < kUsers; ++i) {
+            (void)database_.addUserToList(DatabaseBase::ListType::WHITELIST,
+                                          kFirstUser + i);
+        }
+        for (int i = 0; i < kMedia; ++i) {
+            (void)database_.addMediaInfo({"media" + std::to_string(i),
+                                          "unique" + std::to_string(i),
+                                          {"name" + std::to_string(i)}});
+        }
+        loaded_ = true;
+    }
+    ~ScratchDatabase() {
+        database_.unloadDatabase();
+        std::filesystem::remove(file_);
+    }
+
+    [[nodiscard]] bool loaded() const { return loaded_; }
+    Database* operator->() { return &database_; }
+
+   private:
+    std::filesystem::path file_;
+    Database database_;
+    bool loaded_ = false;
+};
+
+// What authorization does for every command
+// Args: 1 if the user is in the list
+template <typename Database>
+void BM_CheckUserInList(benchmark::State& state, const char* name) {
+    ScratchDatabase<Database> database(name);
+    const UserId user = state.range(0) ? kFirstUser + kUsers / 2 : 1;
+    if (!database.loaded()) {
+        state.SkipWithError("Cannot create the database");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(database->checkUserInList(
+            DatabaseBase::ListType::WHITELIST, user));
+    }
+}
+
+template <typename Database>
+void BM_QueryMediaInfo(benchmark::State& state, const char* name) {
+    ScratchDatabase<Database> database(name);
+    const std::string media = "name" + std::to_string(kMedia / 2);
+    if (!database.loaded()) {
+        state.SkipWithError("Cannot create the database");
+        return;
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(database->queryMediaInfo(media));
+    }
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_CheckUserInList<SQLiteDatabase>, sqlite, "sqlite")
+    ->Arg(0)
+    ->Arg(1);
+BENCHMARK_CAPTURE(BM_CheckUserInList<ProtoDatabase>, proto, "proto")
+    ->Arg(0)
+    ->Arg(1);
+BENCHMARK_CAPTURE(BM_QueryMediaInfo<SQLiteDatabase>, sqlite, "sqlite");
+BENCHMARK_CAPTURE(BM_QueryMediaInfo<ProtoDatabase>, proto, "proto");
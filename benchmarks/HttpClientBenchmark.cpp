@@ -0,0 +1,147 @@
+#include <benchmark/benchmark.h>
+#include <httplib.h>
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+#include <openssl/x509v3.h>
+#include <tgbot/net/CurlHttpClient.h>
+
+#include <PooledCurlHttpClient.hpp>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr std::string_view kResponse = R"({"ok":true,"result":true})";
+
+// A self signed certificate for localhost, also written to a PEM file for
+// the clients to trust
+struct LocalhostCertificate {
+    LocalhostCertificate() : key(EVP_EC_gen("P-256")), cert(X509_new()) {
+        X509_set_version(cert, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+        X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+        X509_gmtime_adj(X509_getm_notAfter(cert), 24 * 60 * 60);
+        X509_set_pubkey(cert, key);
+        X509_NAME* name = X509_get_subject_name(cert);
+        X509_NAME_add_entry_by_txt(
+            name, "CN", MBSTRING_ASC,
+            reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(cert, name);
+
+        X509V3_CTX ctx;
+        X509V3_set_ctx_nodb(&ctx);
+        X509V3_set_ctx(&ctx, cert, cert, nullptr, nullptr, 0);
+        for (const auto& [nid, value] :
+             {std::pair{NID_basic_constraints, "critical,CA:TRUE"},
+              std::pair{NID_subject_alt_name, "DNS:localhost"}}) {
+            X509_EXTENSION* ext =
+                X509V3_EXT_conf_nid(nullptr, &ctx, nid, value);
+            X509_add_ext(cert, ext, -1);
+            X509_EXTENSION_free(ext);
+        }
+        X509_sign(cert, key, EVP_sha256());
+
+        file = std::filesystem::temp_directory_path() / "tgbot_bench_ca.pem";
+        FILE* out = std::fopen(file.c_str(), "w");
+        if (out == nullptr) {
+            throw std::runtime_error("Cannot write " + file.string());
+        }
+        PEM_write_X509(out, cert);
+        std::fclose(out);
+    }
+    ~LocalhostCertificate() {
+        std::filesystem::remove(file);
+        X509_free(cert);
+        EVP_PKEY_free(key);
+    }
+
+    EVP_PKEY* key;
+    X509* cert;
+    std::filesystem::path file;
+};
+
+// Answers every Bot API method with a small JSON, like Telegram does
+class MockApiServer {
+   public:
+    MockApiServer() : server_(cert_.cert, cert_.key) {
+        const auto reply = [](const httplib::Request&, httplib::Response& res) {
+            res.set_content(std::string(kResponse), "application/json");
+        };
+        server_.Get(R"(/bot[^/]+/\w+)", reply);
+        server_.Post(R"(/bot[^/]+/\w+)", reply);
+        server_.set_keep_alive_max_count(1 << 20);
+        port_ = server_.bind_to_any_port("localhost");
+        thread_ = std::thread([this] { server_.listen_after_bind(); });
+        while (!server_.is_running()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    ~MockApiServer() {
+        server_.stop();
+        thread_.join();
+    }
+
+    [[nodiscard]] TgBot::Url url(const std::string_view method) const {
+        return TgBot::Url("https://localhost:" + std::to_string(port_) +
+                          "/bot123:token/" + std::string(method));
+    }
+    [[nodiscard]] std::string caFile() const { return cert_.file.string(); }
+
+   private:
+    LocalhostCertificate cert_;
+    httplib::SSLServer server_;
+    int port_ = 0;
+    std::thread thread_;
+};
+
+MockApiServer& mockServer() {
+    static MockApiServer server;
+    return server;
+}
+
+// A sendMessage per iteration, from every benchmark thread
+void sendMessages(benchmark::State& state, const TgBot::HttpClient& client) {
+    const auto url = mockServer().url("sendMessage");
+    const std::vector<TgBot::HttpReqArg> args{{"chat_id", "1"},
+                                              {"text", "Hello"}};
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(client.makeRequest(url, args));
+    }
+}
+
+// TgBot's own client, which closes the connection after every request
+void BM_CurlHttpClient(benchmark::State& state) {
+    static const auto client = [] {
+        auto client = std::make_unique<TgBot::CurlHttpClient>();
+        curl_easy_setopt(client->curlSettings, CURLOPT_CAINFO,
+                         mockServer().caFile().c_str());
+        return client;
+    }();
+    sendMessages(state, *client);
+}
+
+void BM_PooledCurlHttpClient(benchmark::State& state) {
+    static const auto client = [] {
+        PooledCurlHttpClient::Options options;
+        options.caInfo = mockServer().caFile();
+        return std::make_unique<PooledCurlHttpClient>(options);
+    }();
+    sendMessages(state, *client);
+    if (state.thread_index() == 0) {
+        state.counters["connections"] =
+            static_cast<double>(client->connectionsOpened());
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_CurlHttpClient)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_PooledCurlHttpClient)->ThreadRange(1, 8)->UseRealTime();
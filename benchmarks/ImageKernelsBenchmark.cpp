@@ -0,0 +1,222 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <imagep/ImageKernels.hpp>
+#include <imagep/ImageParallel.hpp>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace {
+
+constexpr int kMinSide = 512;
+constexpr int kMaxSide = 4096;
+
+std::unique_ptr<uint8_t[]> makeImage(size_t size) {
+    auto data = std::make_unique_for_overwrite<uint8_t[]>(size);
+    std::mt19937 gen(size);
+    std::uniform_int_distribution<int> dist(0, 255);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(dist(gen));
+    }
+    return data;
+}
+
+// The per-pixel loop the backends used before ImageKernels, for comparison.
+void rotateNaive(const uint8_t* src, uint8_t* dst, size_t width, size_t height,
+                 int channels, int angle) {
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            for (int c = 0; c < channels; ++c) {
+                switch (angle) {
+                    case 90:
+                        dst[(x * height + (height - y - 1)) * channels + c] =
+                            src[(y * width + x) * channels + c];
+                        break;
+                    case 180:
+                        dst[((height - y - 1) * width + (width - x - 1)) *
+                                channels +
+                            c] = src[(y * width + x) * channels + c];
+                        break;
+                    case 270:
+                        dst[((width - x - 1) * height + y) * channels + c] =
+                            src[(y * width + x) * channels + c];
+                        break;
+                }
+            }
+        }
+    }
+}
+
+void greyscaleNaive(uint8_t* data, size_t pixels, int channels) {
+    for (size_t i = 0; i < pixels * channels; i += channels) {
+        const auto grey = static_cast<uint8_t>(
+            0.299 * data[i] + 0.587 * data[i + 1] + 0.114 * data[i + 2]);
+        data[i] = data[i + 1] = data[i + 2] = grey;
+    }
+}
+
+// Args: side, channels, angle
+template <bool kNaive>
+void BM_Rotate(benchmark::State& state) {
+    const auto side = static_cast<size_t>(state.range(0));
+    const auto channels = static_cast<int>(state.range(1));
+    const auto angle = static_cast<int>(state.range(2));
+    const size_t bytes = side * side * channels;
+    const auto src = makeImage(bytes);
+    const auto dst = std::make_unique_for_overwrite<uint8_t[]>(bytes);
+
+    for (auto _ : state) {
+        if constexpr (kNaive) {
+            rotateNaive(src.get(), dst.get(), side, side, channels, angle);
+        } else {
+            ImageKernels::rotate(src.get(), dst.get(), side, side, channels,
+                                 angle);
+        }
+        benchmark::DoNotOptimize(dst.get());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+// Args: side, channels
+void BM_GreyscaleNaive(benchmark::State& state) {
+    const auto side = static_cast<size_t>(state.range(0));
+    const auto channels = static_cast<int>(state.range(1));
+    const size_t bytes = side * side * channels;
+    const auto data = makeImage(bytes);
+
+    for (auto _ : state) {
+        greyscaleNaive(data.get(), side * side, channels);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+void BM_Greyscale(benchmark::State& state, ImageKernels::Isa isa) {
+    const auto side = static_cast<size_t>(state.range(0));
+    const auto channels = static_cast<int>(state.range(1));
+    const size_t bytes = side * side * channels;
+    const auto data = makeImage(bytes);
+
+    for (auto _ : state) {
+        ImageKernels::to_greyscale(data.get(), side * side, channels, isa);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+// Rotate then greyscale, as separate passes or as one fused plan.
+// Args: side, channels, angle
+template <bool kFused>
+void BM_RotateGreyscale(benchmark::State& state) {
+    const auto side = static_cast<size_t>(state.range(0));
+    const auto channels = static_cast<int>(state.range(1));
+    const auto angle = static_cast<int>(state.range(2));
+    const size_t bytes = side * side * channels;
+    const auto src = makeImage(bytes);
+    const auto dst = std::make_unique_for_overwrite<uint8_t[]>(bytes);
+
+    for (auto _ : state) {
+        if constexpr (kFused) {
+            ImageKernels::TransformPlan plan(side, side);
+            plan.rotate(angle);
+            plan.greyscale();
+            plan.execute(src.get(), dst.get(), channels);
+        } else {
+            ImageKernels::rotate(src.get(), dst.get(), side, side, channels,
+                                 angle);
+            ImageKernels::to_greyscale(dst.get(), side * side, channels);
+        }
+        benchmark::DoNotOptimize(dst.get());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+// The fused rotate and greyscale, on a given number of threads.
+// Args: side, threads
+void BM_RotateGreyscaleThreads(benchmark::State& state) {
+    const auto side = static_cast<size_t>(state.range(0));
+    const auto threads = static_cast<unsigned>(state.range(1));
+    constexpr int kChannels = 4;
+    const size_t bytes = side * side * kChannels;
+    const auto src = makeImage(bytes);
+    const auto dst = std::make_unique_for_overwrite<uint8_t[]>(bytes);
+
+    // No threshold, so the thread count is the only variable
+    ImageKernels::setParallelism(threads, 0);
+    for (auto _ : state) {
+        ImageKernels::TransformPlan plan(side, side);
+        plan.rotate(90);
+        plan.greyscale();
+        plan.execute(src.get(), dst.get(), kChannels);
+        benchmark::DoNotOptimize(dst.get());
+        benchmark::ClobberMemory();
+    }
+    ImageKernels::setParallelism(0);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+void RotateArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"side", "channels", "angle"});
+    for (int side = kMinSide; side <= kMaxSide; side *= 2) {
+        for (int channels : {3, 4}) {
+            for (int angle : {90, 180, 270}) {
+                b->Args({side, channels, angle});
+            }
+        }
+    }
+}
+
+void GreyscaleArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"side", "channels"});
+    for (int side = kMinSide; side <= kMaxSide; side *= 2) {
+        for (int channels : {3, 4}) {
+            b->Args({side, channels});
+        }
+    }
+}
+
+void ThreadsArgs(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"side", "threads"});
+    const unsigned cores = std::max(1U, std::thread::hardware_concurrency());
+    for (int side : {1024, kMaxSide}) {
+        for (unsigned threads = 1; threads <= cores; threads *= 2) {
+            b->Args({side, threads});
+        }
+        if ((cores & (cores - 1)) != 0) {
+            b->Args({side, cores});
+        }
+    }
+}
+
+const bool kRegistered = [] {
+    using ImageKernels::Isa;
+    for (Isa isa : {Isa::kScalar, Isa::kSSE41, Isa::kAVX2, Isa::kNEON}) {
+        if (!ImageKernels::isSupported(isa)) {
+            continue;
+        }
+        benchmark::RegisterBenchmark(
+            ("BM_Greyscale/" + std::string(ImageKernels::isaName(isa))).c_str(),
+            BM_Greyscale, isa)
+            ->Apply(GreyscaleArgs);
+    }
+    return true;
+}();
+
+}  // namespace
+
+BENCHMARK(BM_Rotate<false>)->Apply(RotateArgs);
+BENCHMARK(BM_Rotate<true>)->Name("BM_RotateNaive")->Apply(RotateArgs);
+BENCHMARK(BM_GreyscaleNaive)->Apply(GreyscaleArgs);
+BENCHMARK(BM_RotateGreyscale<true>)
+    ->Name("BM_RotateGreyscaleFused")
+    ->Apply(RotateArgs);
+BENCHMARK(BM_RotateGreyscale<false>)
+    ->Name("BM_RotateGreyscaleSeparate")
+    ->Apply(RotateArgs);
+// Workers don't count in the CPU time of the benchmark thread
+BENCHMARK(BM_RotateGreyscaleThreads)->Apply(ThreadsArgs)->UseRealTime();
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <tgbot/types/Chat.h>
+#include <tgbot/types/Message.h>
+#include <tgbot/types/User.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Synthetic messages, like the ones Telegram sends to group chats.
+ *
+ * Senders and chats come from fixed pools, and are the same objects across
+ * messages like tgbot gives them. Messages are dated now, so they pass the
+ * age checks. The same seed makes the same messages.
+ */
+class MessageGenerator {
+   public:
+    MessageGenerator(const size_t chats, const size_t users,
+                     const uint32_t seed = 1)
+        : random_(seed) {
+        for (size_t i = 0; i < chats; ++i) {
+            auto chat = std::make_shared<TgBot::Chat>();
+            chat->id = -1000000000000 - static_cast<int64_t>(i);
+            chat->type = TgBot::Chat::Type::Supergroup;
+            chat->title = "Chat " + std::to_string(i);
+            chats_.emplace_back(std::move(chat));
+        }
+        for (size_t i = 0; i < users; ++i) {
+            auto user = std::make_shared<TgBot::User>();
+            user->id = 100000 + static_cast<int64_t>(i);
+            user->firstName = "User";
+            user->username = "user" + std::to_string(i);
+            users_.emplace_back(std::move(user));
+        }
+    }
+
+    // Words of lowercase letters, about length characters in total
+    std::string text(const size_t length) {
+        std::uniform_int_distribution<int> letter('a', 'z');
+        std::uniform_int_distribution<int> word(2, 9);
+        std::string out;
+        out.reserve(length + 10);
+        while (out.size() < length) {
+            for (int i = word(random_); i > 0; --i) {
+                out += static_cast<char>(letter(random_));
+            }
+            out += ' ';
+        }
+        out.resize(length);
+        return out;
+    }
+
+    // From a random sender, in a random chat
+    TgBot::Message::Ptr message(std::string text) {
+        auto message = std::make_shared<TgBot::Message>();
+        message->messageId = nextId_++;
+        message->date = std::chrono::system_clock::to_time_t(
+            std::chrono::system_clock::now());
+        message->chat = pick(chats_);
+        message->from = pick(users_);
+        message->text = std::move(text);
+        return message;
+    }
+
+    TgBot::Message::Ptr message(const size_t length) {
+        return message(text(length));
+    }
+
+    // Like "/command@botname args"
+    TgBot::Message::Ptr command(const std::string_view name,
+                                const std::string_view args) {
+        std::string text = "/";
+        text += name;
+        text += "@benchbot";
+        if (!args.empty()) {
+            text += ' ';
+            text += args;
+        }
+        return message(std::move(text));
+    }
+
+    // A message with text, replying to another with replyText
+    TgBot::Message::Ptr reply(std::string text, std::string replyText) {
+        auto out = message(std::move(text));
+        out->replyToMessage = message(std::move(replyText));
+        out->replyToMessage->chat = out->chat;
+        return out;
+    }
+
+    [[nodiscard]] const std::vector<TgBot::User::Ptr>& users() const {
+        return users_;
+    }
+
+   private:
+    template <typename T>
+    const T& pick(const std::vector<T>& from) {
+        std::uniform_int_distribution<size_t> index(0, from.size() - 1);
+        return from[index(random_)];
+    }
+
+    std::mt19937 random_;
+    std::vector<TgBot::Chat::Ptr> chats_;
+    std::vector<TgBot::User::Ptr> users_;
+    int32_t nextId_ = 1;
+};
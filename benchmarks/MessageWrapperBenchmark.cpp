@@ -0,0 +1,53 @@
+#include <benchmark/benchmark.h>
+
+#include <MessageWrapper.hpp>
+#include <ParsedCommand.hpp>
+
+#include "MessageGenerator.hpp"
+
+namespace {
+
+// What bot_AddCommand does to every command before authorizing it
+void BM_CommandArguments(benchmark::State& state) {
+    MessageGenerator generator(4, 64);
+    const auto message =
+        generator.command("cmd", generator.text(state.range(0)));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            ParsedCommand::parse(message->text).isFor("some_bot"));
+    }
+}
+
+// What modules do with their arguments
+void BM_ExtraText(benchmark::State& state) {
+    MessageGenerator generator(4, 64);
+    const auto message =
+        generator.command("cmd", generator.text(state.range(0)));
+
+    for (auto _ : state) {
+        MessageWrapperLimited wrapper(message);
+        if (wrapper.hasExtraText()) {
+            benchmark::DoNotOptimize(wrapper.getExtraTextView());
+        }
+    }
+}
+
+// Commands which work on the replied message go up and back
+void BM_SwitchToReply(benchmark::State& state) {
+    MessageGenerator generator(4, 64);
+    const auto message = generator.reply("/cmd", generator.text(64));
+
+    for (auto _ : state) {
+        MessageWrapperLimited wrapper(message);
+        wrapper.switchToReplyToMessage();
+        benchmark::DoNotOptimize(wrapper.getText());
+        wrapper.switchToParent();
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_CommandArguments)->Arg(0)->Arg(64)->Arg(4096);
+BENCHMARK(BM_ExtraText)->Arg(0)->Arg(64)->Arg(4096);
+BENCHMARK(BM_SwitchToReply);
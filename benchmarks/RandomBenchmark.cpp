@@ -0,0 +1,126 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <random>
+#include <random/BufferedEngine.h>
+#include <random/GetRandomEngine.h>
+#include <random/KernelRandEngine.h>
+#include <random/RDRandEngine.h>
+#include <random/RandomNumberGenerator.h>
+#include <random/XoshiroEngine.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int kDiceMax = 6;
+
+// What the StdCpp backend used to do for every number
+struct LegacyStdCppEngine {
+    using result_type = std::mt19937::result_type;
+    static constexpr result_type min() { return std::mt19937::min(); }
+    static constexpr result_type max() { return std::mt19937::max(); }
+    result_type operator()() const {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        return gen();
+    }
+};
+
+#ifdef GETRANDOM_MAYBE_SUPPORTED
+// One syscall per number, like the kernel backend used to
+struct UnbufferedGetRandomEngine {
+    using result_type = uint64_t;
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+    result_type operator()() const {
+        result_type val = 0;
+        getrandom_source::read(&val, sizeof(val));
+        return val;
+    }
+};
+#endif
+
+// A dice roll per iteration, straight from an engine
+template <typename Engine>
+void BM_EngineDice(benchmark::State& state, Engine engine) {
+    std::uniform_int_distribution<int> dist(1, kDiceMax);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(dist(engine));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// The public API, with whatever backend it picked
+void BM_Generate(benchmark::State& state) {
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(RandomNumberGenerator::generate(1, kDiceMax));
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(std::string(RandomNumberGenerator::backendName()));
+}
+
+// Args: count
+void BM_GenerateN(benchmark::State& state) {
+    std::vector<random_return_type> out(state.range(0));
+    for (auto _ : state) {
+        RandomNumberGenerator::generateN(out, 1, kDiceMax);
+        benchmark::DoNotOptimize(out.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+// Args: count
+void BM_Shuffle(benchmark::State& state) {
+    std::vector<std::string> strings(state.range(0));
+    for (size_t i = 0; i < strings.size(); ++i) {
+        strings[i] = std::to_string(i);
+    }
+    for (auto _ : state) {
+        RandomNumberGenerator::shuffleArray(strings);
+        benchmark::DoNotOptimize(strings.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+const bool kRegistered = [] {
+    benchmark::RegisterBenchmark("BM_EngineDice/legacy_mt19937",
+                                 BM_EngineDice<LegacyStdCppEngine>,
+                                 LegacyStdCppEngine{});
+    benchmark::RegisterBenchmark("BM_EngineDice/xoshiro256pp",
+                                 BM_EngineDice<xoshiro256pp_engine>,
+                                 xoshiro256pp_engine(std::random_device()()));
+#ifdef GETRANDOM_MAYBE_SUPPORTED
+    benchmark::RegisterBenchmark("BM_EngineDice/getrandom_unbuffered",
+                                 BM_EngineDice<UnbufferedGetRandomEngine>,
+                                 UnbufferedGetRandomEngine{});
+    benchmark::RegisterBenchmark(
+        "BM_EngineDice/getrandom_buffered",
+        BM_EngineDice<buffered_engine<getrandom_source>>,
+        buffered_engine<getrandom_source>{});
+#endif
+#ifdef RDRAND_MAYBE_SUPPORTED
+    if (__builtin_cpu_supports("rdrnd")) {
+        benchmark::RegisterBenchmark("BM_EngineDice/rdrand",
+                                     BM_EngineDice<rdrand_engine>,
+                                     rdrand_engine{});
+    }
+#endif
+#ifdef KERNELRAND_MAYBE_SUPPORTED
+    // Hardware RNG devices can be very slow, only a few iterations
+    if (kernel_rand_engine::getInstance()->isSupported()) {
+        benchmark::RegisterBenchmark(
+            "BM_EngineDice/hwrng_buffered",
+            BM_EngineDice<buffered_engine<kernel_rand_source, 8>>,
+            buffered_engine<kernel_rand_source, 8>{})
+            ->Iterations(64);
+    }
+#endif
+    return true;
+}();
+
+}  // namespace
+
+BENCHMARK(BM_Generate);
+BENCHMARK(BM_GenerateN)->Arg(1)->Arg(64)->Arg(4096);
+BENCHMARK(BM_Shuffle)->Arg(8)->Arg(1024);
@@ -0,0 +1,54 @@
+#include <RegEXHandler.h>
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include "MessageGenerator.hpp"
+
+namespace {
+
+struct DiscardingRegexHandler : RegexHandlerBase {
+    void onRegexProcessed(const Message::Ptr& /*from*/,
+                          const std::string& processedData) override {
+        benchmark::DoNotOptimize(processedData.data());
+    }
+};
+
+// A sed command on a replied message of a given length.
+// Args: text length
+void BM_RegexCommand(benchmark::State& state, const std::string& command) {
+    MessageGenerator generator(1, 1);
+    DiscardingRegexHandler handler;
+    const auto message = generator.message(command);
+    const auto text = generator.text(state.range(0));
+
+    for (auto _ : state) {
+        handler.processRegEXCommand(message, text);
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+// Not a sed command at all, what most messages are
+void BM_RegexNotACommand(benchmark::State& state) {
+    MessageGenerator generator(1, 1);
+    DiscardingRegexHandler handler;
+    const auto message = generator.message(64);
+    const auto text = generator.text(64);
+
+    for (auto _ : state) {
+        handler.processRegEXCommand(message, text);
+    }
+}
+
+}  // namespace
+
+BENCHMARK_CAPTURE(BM_RegexCommand, replace, std::string("s/a[b-e]/xy/g"))
+    ->Arg(64)
+    ->Arg(4096);
+BENCHMARK_CAPTURE(BM_RegexCommand, replace_icase, std::string("s/A+/b/gi"))
+    ->Arg(64)
+    ->Arg(4096);
+BENCHMARK_CAPTURE(BM_RegexCommand, delete_lines, std::string("/^[a-m]/d"))
+    ->Arg(64)
+    ->Arg(4096);
+BENCHMARK(BM_RegexNotACommand);
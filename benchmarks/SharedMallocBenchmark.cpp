@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+
+#include <SharedMalloc.hpp>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+struct Payload {
+    int64_t id;
+    char text[256];
+};
+
+// Args: size
+void BM_SharedMallocCreate(benchmark::State& state) {
+    for (auto _ : state) {
+        SharedMalloc data(static_cast<size_t>(state.range(0)));
+        benchmark::DoNotOptimize(data.get());
+    }
+}
+
+// get() hands out a child holding a reference, on every call
+void BM_SharedMallocGet(benchmark::State& state) {
+    const SharedMalloc data(static_cast<size_t>(64));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(data.get());
+    }
+}
+
+// A struct in and out, like socket commands are
+void BM_SharedMallocRoundTrip(benchmark::State& state) {
+    Payload in{};
+    Payload out{};
+    std::strcpy(in.text, "Hello");
+
+    for (auto _ : state) {
+        SharedMalloc data(in);
+        data.assignTo(out);
+        benchmark::DoNotOptimize(out);
+    }
+}
+
+// Args: size
+void BM_SharedMallocRealloc(benchmark::State& state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        SharedMalloc data(size);
+        data->size = size * 2;
+        data->alloc();
+        benchmark::DoNotOptimize(data.get());
+    }
+}
+
+}  // namespace
+
+BENCHMARK(BM_SharedMallocCreate)->Arg(64)->Arg(4096)->Arg(1 << 20);
+BENCHMARK(BM_SharedMallocGet);
+BENCHMARK(BM_SharedMallocRoundTrip);
+BENCHMARK(BM_SharedMallocRealloc)->Arg(64)->Arg(4096)->Arg(1 << 20);
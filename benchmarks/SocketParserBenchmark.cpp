@@ -0,0 +1,59 @@
+#include <benchmark/benchmark.h>
+
+#include <SharedMalloc.hpp>
+#include <TgBotSocket_Export.hpp>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#include <impl/bot/TgBotPacketParser.hpp>
+
+namespace {
+
+using TgBotSocket::Packet;
+
+// A header and its data as read from the socket, checksums included.
+// The socket reads themselves are not measured.
+// Args: data size
+void BM_ParsePacket(benchmark::State& state) {
+    const auto size = static_cast<uint32_t>(state.range(0));
+    const std::vector<char> payload(size, 'x');
+    const Packet packet(TgBotSocket::Command::CMD_WRITE_MSG_TO_CHAT_ID,
+                        payload.data(), size);
+    std::optional<SharedMalloc> header(SharedMalloc(packet.header));
+    std::optional<SharedMalloc> data(SharedMalloc(static_cast<size_t>(size)));
+    std::memcpy(data->get(), payload.data(), size);
+
+    for (auto _ : state) {
+        std::optional<Packet> parsed;
+        if (TgBotSocketParser::handle_PacketHeader(header, parsed) !=
+                TgBotSocketParser::HandleState::Ok ||
+            TgBotSocketParser::handle_Packet(data, parsed) !=
+                TgBotSocketParser::HandleState::Ok) {
+            state.SkipWithError("Packet was not accepted");
+            break;
+        }
+        benchmark::DoNotOptimize(parsed->data.get());
+    }
+    state.SetBytesProcessed(state.iterations() * (Packet::hdr_sz + size));
+}
+
+// What a client does to send one
+// Args: data size
+void BM_BuildPacket(benchmark::State& state) {
+    const auto size = static_cast<uint32_t>(state.range(0));
+    const std::vector<char> payload(size, 'x');
+
+    for (auto _ : state) {
+        Packet packet(TgBotSocket::Command::CMD_WRITE_MSG_TO_CHAT_ID,
+                      payload.data(), size);
+        benchmark::DoNotOptimize(packet.toSocketData().get());
+    }
+    state.SetBytesProcessed(state.iterations() * (Packet::hdr_sz + size));
+}
+
+}  // namespace
+
+BENCHMARK(BM_ParsePacket)->Arg(64)->Arg(4096)->Arg(1 << 20);
+BENCHMARK(BM_BuildPacket)->Arg(64)->Arg(4096)->Arg(1 << 20);
@@ -0,0 +1,41 @@
+#include <SpamBlock.h>
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "MessageGenerator.hpp"
+
+namespace {
+
+// The base only detects, taking no action on what it finds
+struct DetectOnlySpamBlock : SpamBlockBase {};
+
+// A burst of messages buffered, then the scan over them.
+// Args: messages, chats, users
+void BM_SpamBlockBurst(benchmark::State& state) {
+    const auto messages = static_cast<size_t>(state.range(0));
+    MessageGenerator generator(state.range(1), state.range(2));
+    DetectOnlySpamBlock spamBlock;
+    std::vector<Message::Ptr> burst;
+
+    // Some repeated, like spam is
+    for (size_t i = 0; i < messages; ++i) {
+        burst.emplace_back(i % 4 == 0 ? generator.message("spam")
+                                      : generator.message(48));
+    }
+    for (auto _ : state) {
+        for (const auto& message : burst) {
+            spamBlock.addMessage(message);
+        }
+        spamBlock.runFunction();
+    }
+    state.SetItemsProcessed(state.iterations() * messages);
+}
+
+}  // namespace
+
+BENCHMARK(BM_SpamBlockBurst)
+    ->Args({64, 1, 8})
+    ->Args({1024, 4, 64})
+    ->Args({8192, 16, 512});
@@ -0,0 +1,42 @@
+#####################################################################
+############ Bot functions' Benchmarks (google benchmark) ###########
+#################### Creates the benchmark target ###################
+find_package(benchmark QUIET)
+if (benchmark_FOUND)
+  message(STATUS "Google Benchmark Present")
+  set(BENCH_SRC_LIST
+    benchmarks/BenchmarkMain.cpp
+    benchmarks/DatabaseBenchmark.cpp
+    benchmarks/ImageKernelsBenchmark.cpp
+    benchmarks/MessageWrapperBenchmark.cpp
+    benchmarks/RandomBenchmark.cpp
+    benchmarks/RegexHandlerBenchmark.cpp
+    benchmarks/SharedMallocBenchmark.cpp
+    benchmarks/SpamBlockBenchmark.cpp
+  )
+  extend_set_if(BENCH_SRC_LIST CURL_FOUND benchmarks/HttpClientBenchmark.cpp)
+  extend_set_if(BENCH_SRC_LIST USE_UNIX_SOCKETS
+    benchmarks/SocketParserBenchmark.cpp)
+  add_executable_san(${PROJECT_BENCH_NAME} ${BENCH_SRC_LIST})
+  target_link_libraries(${PROJECT_BENCH_NAME}
+    benchmark::benchmark TgBotImgProc ${PROJECT_NAME})
+  if (CURL_FOUND)
+    # The HTTPS mock server
+    target_link_libraries(${PROJECT_BENCH_NAME}
+      httplib::httplib OpenSSL::SSL OpenSSL::Crypto)
+  endif()
+
+  # Results as JSON, to compare commits with benchmark's tools/compare.py
+  set(BENCH_JSON_OUT ${CMAKE_BINARY_DIR}/${PROJECT_BENCH_NAME}.json
+    CACHE FILEPATH "Where the bench_json target writes its results")
+  add_custom_target(bench_json
+    COMMAND ${PROJECT_BENCH_NAME}
+      --benchmark_out=${BENCH_JSON_OUT} --benchmark_out_format=json
+      --benchmark_repetitions=5 --benchmark_report_aggregates_only=true
+    DEPENDS ${PROJECT_BENCH_NAME}
+    COMMENT "Running benchmarks, results in ${BENCH_JSON_OUT}"
+    USES_TERMINAL)
+else()
+  message(STATUS "Google Benchmark not found, not building benchmarks")
+endif()
+#####################################################################
@@ -10,8 +10,24 @@ add_executable_san(${PROJECT_TEST_NAME}
   tests/TryParseTest.cpp
   tests/SharedMallocTest.cpp
   tests/ConstexprStringCatTest.cpp
+  tests/RandomNumberGeneratorTest.cpp
+  tests/TimerWheelTest.cpp
+  tests/ChatTimersTest.cpp
+  tests/ApiSchedulerTest.cpp
+  tests/FileCacheTest.cpp
+  tests/StickerSetCacheTest.cpp
+  tests/PopenWdtTest.cpp
+  tests/CompileCacheTest.cpp
+  tests/ImageKernelsTest.cpp
+  tests/InitSchedulerTest.cpp
+  tests/BotProfileSyncTest.cpp
+  tests/MetricsTest.cpp
+  tests/TracingTest.cpp
+  tests/ReplayHttpClientTest.cpp
+  tests/CommandRouterTest.cpp
 )
 target_include_directories(${PROJECT_TEST_NAME} PRIVATE ${gtest_INCLUDE_DIR} ${gmock_INCLUDE_DIR})
-target_link_libraries(${PROJECT_TEST_NAME} gtest gmock ${PROJECT_NAME} TgBotLogInit)
+target_link_libraries(${PROJECT_TEST_NAME} gtest gmock ${PROJECT_NAME} TgBotImgProc
+  TgBotLogInit)
 add_test(NAME ${PROJECT_TEST_NAME} COMMAND ${PROJECT_TEST_NAME})
 #####################################################################
\ No newline at end of file
@@ -30,6 +30,9 @@ endif()
 
 add_library_san(TgBotImgProc SHARED
     ${TGBOTPNG_SOURCES}
+    src/imagep/ImageKernels.cpp
+    src/imagep/ImageParallel.cpp
+    src/imagep/ImagePBase.cpp
     src/imagep/ImageProcAll.cpp)
     
 target_compile_definitions(TgBotImgProc PRIVATE ${TGBOTPNG_FLAGS})
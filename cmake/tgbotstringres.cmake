@@ -8,7 +8,10 @@ target_include_directories(TgBotStringRes PRIVATE ${LIBXML2_INCLUDE_DIR})
 add_executable_san(StringResCompiler src/stringres/StringResCompiler.cpp)
 target_link_libraries(StringResCompiler TgBotStringRes TgBotLogInit)
 
-set(STRINGRES_XML ${CMAKE_SOURCE_DIR}/resources/strings/en-US.xml)
+# The first one is the default locale
+set(STRINGRES_XML
+  ${CMAKE_SOURCE_DIR}/resources/strings/en-US.xml
+  ${CMAKE_SOURCE_DIR}/resources/strings/fr-FR.xml)
 set(STRINGRES_GENHDR_DIR ${CMAKE_BINARY_DIR}/src/stringres/)
 set(STRINGRES_GENHDR ${STRINGRES_GENHDR_DIR}/resources.gen.h)
 set(STRINGRES_COMPILER ${CMAKE_BINARY_DIR}/bin/StringResCompiler)
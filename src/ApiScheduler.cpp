@@ -0,0 +1,373 @@
+#include <ApiScheduler.hpp>
+#include <absl/log/log.h>
+#include <tgbot/TgException.h>
+
+#include <algorithm>
+#include <charconv>
+#include <iterator>
+#include <string_view>
+
+namespace {
+
+constexpr int kTooManyRequests = 429;
+// Chats are forgotten once idle, checked when there are this many
+constexpr size_t kPruneChats = 1024;
+
+// Whether this thread is one of the workers
+thread_local bool tIsWorker = false;
+
+std::exception_ptr stoppedError() {
+    return std::make_exception_ptr(TgBot::TgException(
+        "API scheduler is stopped", TgBot::TgException::ErrorCode::Undefined));
+}
+
+// Until a bucket with tokens has one
+ApiScheduler::Clock::duration tokenWait(const double tokens,
+                                        const double rate) {
+    return std::chrono::duration_cast<ApiScheduler::Clock::duration>(
+        std::chrono::duration<double>((1 - tokens) / rate));
+}
+
+}  // namespace
+
+ApiScheduler::Limits ApiScheduler::Limits::unlimited() {
+    // Finite, so the buckets' arithmetic stays well defined
+    constexpr double kUnlimited = 1e12;
+    Limits limits;
+    limits.globalPerSecond = kUnlimited;
+    limits.chatPerSecond = kUnlimited;
+    limits.chatBurst = kUnlimited;
+    return limits;
+}
+
+ApiScheduler::ApiScheduler() : ApiScheduler(Limits{}) {}
+
+ApiScheduler::ApiScheduler(Limits limits)
+    : limits_(limits),
+      tokens_(limits.globalPerSecond),
+      refilled_(Clock::now()) {}
+
+ApiScheduler::~ApiScheduler() { stop(); }
+
+std::future<ApiScheduler::Message::Ptr> ApiScheduler::edit(
+    const ChatId chat, const MessageId message,
+    std::function<Message::Ptr()> fn) {
+    if (!tIsWorker) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!stopped_) {
+            // Only the last one, merging with an edit queued before other
+            // requests would show the chat things out of order
+            ChatQueue& queue = chatLocked(chat, Clock::now());
+            if (!queue.requests.empty() &&
+                queue.requests.back()->edited == message) {
+                auto& request = queue.requests.back();
+                request->editFn = std::move(fn);
+                return request->editWaiters.emplace_back().get_future();
+            }
+        }
+    }
+    auto request = std::make_unique<Request>();
+    request->edited = message;
+    request->editFn = std::move(fn);
+    auto future = request->editWaiters.emplace_back().get_future();
+    enqueue(chat, std::move(request));
+    return future;
+}
+
+void ApiScheduler::enqueue(const std::optional<ChatId> chat,
+                           std::unique_ptr<Request> request) {
+    if (tIsWorker) {
+        // Waiting for it in the queue could take all the workers
+        try {
+            send(request.get());
+        } catch (...) {
+            fail(request.get(), std::current_exception());
+        }
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stopped_) {
+        lock.unlock();
+        fail(request.get(), stoppedError());
+        return;
+    }
+    startLocked();
+    ++queued_;
+    if (chat) {
+        ChatQueue& queue = chatLocked(*chat, Clock::now());
+        queue.requests.emplace_back(std::move(request));
+        if (!queue.waiting) {
+            queue.waiting = true;
+            waiting_.emplace_back(*chat);
+        }
+    } else {
+        global_.requests.emplace_back(std::move(request));
+    }
+    lock.unlock();
+    wakeup_.notify_one();
+}
+
+void ApiScheduler::stop() {
+    std::vector<std::unique_ptr<Request>> dropped;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (stopped_) {
+            return;
+        }
+        stopped_ = true;
+        for (auto& [chat, queue] : chats_) {
+            std::ranges::move(queue.requests, std::back_inserter(dropped));
+            queue.requests.clear();
+            queue.waiting = false;
+        }
+        std::ranges::move(global_.requests, std::back_inserter(dropped));
+        global_.requests.clear();
+        waiting_.clear();
+        queued_ -= dropped.size();
+    }
+    wakeup_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+    if (!dropped.empty()) {
+        LOG(WARNING) << "Dropping " << dropped.size() << " unsent requests";
+    }
+    for (auto& request : dropped) {
+        fail(request.get(), stoppedError());
+    }
+}
+
+size_t ApiScheduler::queued() const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return queued_;
+}
+
+std::optional<std::chrono::seconds> ApiScheduler::retryAfter(
+    const std::exception& e) {
+    constexpr std::string_view kRetryAfter = "retry after ";
+    const auto* tgError = dynamic_cast<const TgBot::TgException*>(&e);
+
+    if (tgError == nullptr ||
+        static_cast<int>(tgError->errorCode) != kTooManyRequests) {
+        return std::nullopt;
+    }
+    // "Too Many Requests: retry after 5", the parameters aren't kept
+    const std::string_view what = e.what();
+    int seconds = 1;
+    if (const auto pos = what.find(kRetryAfter); pos != what.npos) {
+        const char* begin = what.data() + pos + kRetryAfter.size();
+        std::from_chars(begin, what.data() + what.size(), seconds);
+    }
+    return std::chrono::seconds(std::max(seconds, 1));
+}
+
+void ApiScheduler::logOrRethrow(const std::string_view what,
+                                const std::exception& e) {
+    if (retryAfter(e)) {
+        throw;
+    }
+    LOG(WARNING) << "Cannot " << what << ": " << e.what();
+}
+
+void ApiScheduler::startLocked() {
+    if (!workers_.empty()) {
+        return;
+    }
+    for (size_t i = 0; i < std::max<size_t>(limits_.workers, 1); ++i) {
+        workers_.emplace_back(&ApiScheduler::workerFn, this);
+    }
+}
+
+ApiScheduler::ChatQueue& ApiScheduler::chatLocked(
+    const ChatId chat, const Clock::time_point now) {
+    if (chats_.size() >= kPruneChats && !chats_.contains(chat)) {
+        // Idle with a full bucket, they'd start out the same
+        for (auto it = chats_.begin(); it != chats_.end();) {
+            ChatQueue& queue = it->second;
+            refill(&queue.tokens, &queue.refilled, limits_.chatPerSecond,
+                   limits_.chatBurst, now);
+            if (queue.requests.empty() && !queue.sending &&
+                queue.tokens >= limits_.chatBurst && queue.pausedUntil <= now) {
+                it = chats_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    auto [it, inserted] = chats_.try_emplace(chat);
+    if (inserted) {
+        it->second.tokens = limits_.chatBurst;
+        it->second.refilled = now;
+    }
+    return it->second;
+}
+
+std::unique_ptr<ApiScheduler::Request> ApiScheduler::takeLocked(
+    ChatQueue** queueOut, std::optional<ChatId>* chat,
+    Clock::time_point* wakeAt) {
+    const auto now = Clock::now();
+    *wakeAt = Clock::time_point::max();
+
+    refill(&tokens_, &refilled_, limits_.globalPerSecond,
+           limits_.globalPerSecond, now);
+    if (tokens_ < 1) {
+        if (!waiting_.empty() || !global_.requests.empty()) {
+            *wakeAt = now + tokenWait(tokens_, limits_.globalPerSecond);
+        }
+        return nullptr;
+    }
+    const bool globalReady =
+        !global_.requests.empty() && global_.pausedUntil <= now;
+    if (!global_.requests.empty() && !globalReady) {
+        *wakeAt = global_.pausedUntil;
+    }
+    if (globalReady && globalTurn_) {
+        return takeGlobalLocked(queueOut, chat);
+    }
+    for (size_t i = waiting_.size(); i > 0; --i) {
+        const ChatId id = waiting_.front();
+        waiting_.pop_front();
+        ChatQueue& queue = chats_.at(id);
+        if (queue.sending) {
+            // Its next request can go once this one is done
+            waiting_.emplace_back(id);
+            continue;
+        }
+        refill(&queue.tokens, &queue.refilled, limits_.chatPerSecond,
+               limits_.chatBurst, now);
+        auto readyAt = queue.pausedUntil;
+        if (queue.tokens < 1) {
+            readyAt = std::max(
+                readyAt, now + tokenWait(queue.tokens, limits_.chatPerSecond));
+        }
+        if (readyAt > now) {
+            *wakeAt = std::min(*wakeAt, readyAt);
+            waiting_.emplace_back(id);
+            continue;
+        }
+        auto request = std::move(queue.requests.front());
+        queue.requests.pop_front();
+        queue.tokens -= 1;
+        tokens_ -= 1;
+        queue.sending = true;
+        if (queue.requests.empty()) {
+            queue.waiting = false;
+        } else {
+            waiting_.emplace_back(id);
+        }
+        globalTurn_ = true;
+        *queueOut = &queue;
+        *chat = id;
+        return request;
+    }
+    if (globalReady) {
+        return takeGlobalLocked(queueOut, chat);
+    }
+    return nullptr;
+}
+
+std::unique_ptr<ApiScheduler::Request> ApiScheduler::takeGlobalLocked(
+    ChatQueue** queueOut, std::optional<ChatId>* chat) {
+    auto request = std::move(global_.requests.front());
+    global_.requests.pop_front();
+    tokens_ -= 1;
+    globalTurn_ = false;
+    *queueOut = &global_;
+    chat->reset();
+    return request;
+}
+
+void ApiScheduler::refill(double* tokens, Clock::time_point* refilled,
+                          const double rate, const double burst,
+                          const Clock::time_point now) const {
+    const std::chrono::duration<double> elapsed = now - *refilled;
+    *tokens = std::min(burst, *tokens + elapsed.count() * rate);
+    *refilled = now;
+}
+
+void ApiScheduler::send(Request* request) {
+    if (request->edited != 0) {
+        const auto result = request->editFn();
+        for (auto& waiter : request->editWaiters) {
+            waiter.set_value(result);
+        }
+    } else {
+        request->send();
+    }
+}
+
+void ApiScheduler::fail(Request* request, const std::exception_ptr& e) {
+    if (request->edited != 0) {
+        for (auto& waiter : request->editWaiters) {
+            waiter.set_exception(e);
+        }
+    } else {
+        request->fail(e);
+    }
+}
+
+void ApiScheduler::workerFn() {
+    tIsWorker = true;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopped_) {
+        ChatQueue* queue = nullptr;
+        std::optional<ChatId> chat;
+        Clock::time_point wakeAt;
+        auto request = takeLocked(&queue, &chat, &wakeAt);
+        if (!request) {
+            if (wakeAt == Clock::time_point::max()) {
+                wakeup_.wait(lock);
+            } else {
+                wakeup_.wait_until(lock, wakeAt);
+            }
+            continue;
+        }
+        lock.unlock();
+
+        std::exception_ptr error;
+        std::optional<std::chrono::seconds> pause;
+        try {
+            send(request.get());
+        } catch (const std::exception& e) {
+            error = std::current_exception();
+            pause = retryAfter(e);
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        queue->sending = false;
+        if (pause && request->retries < limits_.maxRetries && !stopped_) {
+            if (chat) {
+                LOG(WARNING) << "Chat " << *chat
+                             << " is rate limited, retrying in "
+                             << pause->count() << "s";
+            } else {
+                LOG(WARNING) << "Global lane is rate limited, retrying in "
+                             << pause->count() << "s";
+            }
+            ++request->retries;
+            queue->pausedUntil = Clock::now() + *pause;
+            queue->requests.emplace_front(std::move(request));
+            if (chat && !queue->waiting) {
+                queue->waiting = true;
+                waiting_.emplace_back(*chat);
+            }
+        } else {
+            --queued_;
+        }
+        // The chat's next request may be ready
+        wakeup_.notify_all();
+        if (request) {
+            lock.unlock();
+            if (error) {
+                fail(request.get(), error);
+            }
+            request.reset();
+            lock.lock();
+        }
+    }
+}
+
+DECLARE_CLASS_INST(ApiScheduler);
@@ -1,11 +1,30 @@
 #include <BotReplyMessage.h>
+#include <ConfigManager.h>
 
+#include <ApiScheduler.hpp>
+#include <FileCache.hpp>
+#include <Tracing.hpp>
+#include <filesystem>
 #include <memory>
 
 #include "tgbot/types/Message.h"
 #include "tgbot/types/ReplyParameters.h"
 
 namespace {
+// Sends through the scheduler, and waits for the result
+template <typename Fn>
+Message::Ptr sendQueued(const ChatId chat, Fn fn) {
+    const Tracing::Span span("send queued");
+    return ApiScheduler::getInstance()
+        ->submit(chat,
+                 [context = Tracing::current(), fn = std::move(fn)] {
+                     const Tracing::Resume resume(context);
+                     const Tracing::Span call("telegram api");
+                     return fn();
+                 })
+        .get();
+}
+
 Message::Ptr _bot_sendReplyMessage(const Bot &bot, const Message::Ptr &message,
                                    const std::string &text,
                                    const MessageId replyToMsg = 0,
@@ -16,8 +35,10 @@ Message::Ptr _bot_sendReplyMessage(const Bot &bot, const Message::Ptr &message,
     params->chatId = message->chat->id;
     params->messageId = replyToMsg == 0 ? message->messageId : replyToMsg;
 
-    return bot.getApi().sendMessage(message->chat->id, text, nullptr, params,
-                                    nullptr, parsemode);
+    return sendQueued(message->chat->id, [&] {
+        return bot.getApi().sendMessage(message->chat->id, text, nullptr,
+                                        params, nullptr, parsemode);
+    });
 }
 
 TgBot::ReplyParameters::Ptr createFromReplyMsg(
@@ -57,40 +78,104 @@ Message::Ptr bot_sendReplyMessageHTML(const Bot &bot,
 
 Message::Ptr bot_editMessage(const Bot &bot, const Message::Ptr &message,
                              const std::string &text) {
-    return bot.getApi().editMessageText(text, message->chat->id,
-                                        message->messageId);
+    return bot_editMessage(bot, message->chat->id, message->messageId, text);
 }
 
 Message::Ptr bot_editMessage(const Bot &bot, const ChatId chatid,
                              const MessageId message, const std::string &text) {
-    return bot.getApi().editMessageText(text, chatid, message);
+    // Merged with a queued edit of the message, the newest text wins
+    auto edited = ApiScheduler::getInstance()->edit(chatid, message, [&] {
+        return bot.getApi().editMessageText(text, chatid, message);
+    });
+    return edited.get();
 }
 
 Message::Ptr bot_sendMessage(const Bot &bot, const ChatId chatid,
                              const std::string &text) {
-    return bot.getApi().sendMessage(chatid, text);
+    return sendQueued(chatid,
+                      [&] { return bot.getApi().sendMessage(chatid, text); });
 }
 
 Message::Ptr bot_sendSticker(const Bot &bot, const ChatId &chatid,
                              Sticker::Ptr sticker,
                              const Message::Ptr &replyTo) {
-    return bot.getApi().sendSticker(chatid, sticker->fileId,
-                                    createFromReplyMsg(replyTo));
+    return sendQueued(chatid, [&] {
+        return bot.getApi().sendSticker(chatid, sticker->fileId,
+                                        createFromReplyMsg(replyTo));
+    });
 }
 
 Message::Ptr bot_sendSticker(const Bot &bot, const ChatId &chat,
                              Sticker::Ptr sticker) {
-    return bot.getApi().sendSticker(chat, sticker->fileId);
+    return sendQueued(
+        chat, [&] { return bot.getApi().sendSticker(chat, sticker->fileId); });
+}
+
+Message::Ptr bot_sendSticker(const Bot &bot, const ChatId &chat,
+                             const std::string &fileId,
+                             const Message::Ptr &replyTo) {
+    return sendQueued(chat, [&] {
+        return bot.getApi().sendSticker(chat, fileId,
+                                        createFromReplyMsg(replyTo));
+    });
 }
 
 Message::Ptr bot_sendAnimation(const Bot &bot, const ChatId &chat,
                                Animation::Ptr gif,
                                const Message::Ptr &replyTo) {
-    return bot.getApi().sendSticker(chat, gif->fileId,
-                                    createFromReplyMsg(replyTo));
+    return sendQueued(chat, [&] {
+        return bot.getApi().sendSticker(chat, gif->fileId,
+                                        createFromReplyMsg(replyTo));
+    });
 }
 
 Message::Ptr bot_sendAnimation(const Bot &bot, const ChatId &chat,
                                Animation::Ptr gif) {
-    return bot.getApi().sendSticker(chat, gif->fileId);
+    return sendQueued(
+        chat, [&] { return bot.getApi().sendSticker(chat, gif->fileId); });
+}
+
+namespace {
+// Files aren't tied to a chat, they go in the scheduler's global lane
+class BotFileSource : public FileCache::Source {
+   public:
+    explicit BotFileSource(const Bot &bot) : bot_(bot) {}
+
+    std::optional<std::string> getFilePath(const std::string &fileId) override {
+        const auto file = ApiScheduler::getInstance()
+                              ->submitGlobal([this, &fileId] {
+                                  return bot_.getApi().getFile(fileId);
+                              })
+                              .get();
+        if (!file) {
+            return std::nullopt;
+        }
+        return file->filePath;
+    }
+    std::string download(const std::string &filePath) override {
+        return ApiScheduler::getInstance()
+            ->submitGlobal([this, &filePath] {
+                return bot_.getApi().downloadFile(filePath);
+            })
+            .get();
+    }
+
+   private:
+    const Bot &bot_;
+};
+}  // namespace
+
+std::shared_ptr<const std::string> bot_downloadFile(
+    const Bot &bot, const std::string &fileId,
+    const std::string &fileUniqueId) {
+    static FileCache cache = [&bot] {
+        const auto directory =
+            ConfigManager::snapshot()
+                ->getPath(ConfigManager::Configs::FILE_CACHE_DIR)
+                .value_or(std::filesystem::temp_directory_path() /
+                          "tgbot_files");
+        return FileCache(directory, std::make_shared<BotFileSource>(bot),
+                         FileCache::Limits{});
+    }();
+    return cache.get(fileId, fileUniqueId);
 }
@@ -0,0 +1,183 @@
+#include <BotProfileSync.hpp>
+#include <absl/log/log.h>
+
+#include <exception>
+#include <fstream>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+namespace {
+
+// FNV-1a, stable across builds unlike std::hash
+class Hasher {
+   public:
+    // With its length, so fields can't run into each other
+    Hasher& add(const std::string_view data) {
+        addBytes(std::to_string(data.size()) + ':');
+        addBytes(data);
+        return *this;
+    }
+    // Never 0, which stands for nothing
+    [[nodiscard]] uint64_t get() const { return hash_ == 0 ? 1 : hash_; }
+
+   private:
+    void addBytes(const std::string_view data) {
+        for (const unsigned char c : data) {
+            hash_ ^= c;
+            hash_ *= 1099511628211ULL;
+        }
+    }
+    uint64_t hash_ = 14695981039346656037ULL;
+};
+
+}  // namespace
+
+BotProfileSync::BotProfileSync(std::filesystem::path stateFile,
+                               std::shared_ptr<Sink> sink, Scheduler scheduler,
+                               const std::chrono::milliseconds debounce)
+    : stateFile_(std::move(stateFile)),
+      sink_(std::move(sink)),
+      scheduler_(std::move(scheduler)),
+      debounce_(debounce) {
+    loadState();
+}
+
+void BotProfileSync::setCommands(std::vector<Command> commands) {
+    Hasher hasher;
+    for (const auto& command : commands) {
+        hasher.add(command.command).add(command.description);
+    }
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        commands_ = std::move(commands);
+    }
+    changed(kCommands, hasher.get());
+}
+
+void BotProfileSync::setDescription(std::string description) {
+    const auto hash = Hasher().add(description).get();
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        description_ = std::move(description);
+    }
+    changed(kDescription, hash);
+}
+
+void BotProfileSync::setShortDescription(std::string description) {
+    const auto hash = Hasher().add(description).get();
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        shortDescription_ = std::move(description);
+    }
+    changed(kShortDescription, hash);
+}
+
+void BotProfileSync::changed(const Part part, const uint64_t hash) {
+    uint64_t generation = 0;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (wanted_[part] == hash) {
+            return;
+        }
+        wanted_[part] = hash;
+        generation = ++generation_;
+    }
+    scheduler_(debounce_, [this, generation] {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            if (generation != generation_) {
+                // Changed again since, that change's flush does it
+                return;
+            }
+        }
+        flush();
+    });
+}
+
+void BotProfileSync::flush() {
+    const std::lock_guard<std::mutex> flushLock(flushMutex_);
+    std::array<uint64_t, kPartCount> sending{};
+    std::vector<Command> commands;
+    std::string description;
+    std::string shortDescription;
+
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        for (int part = 0; part < kPartCount; ++part) {
+            if (wanted_[part] != 0 && wanted_[part] != sent_[part]) {
+                sending[part] = wanted_[part];
+            }
+        }
+        commands = commands_;
+        description = description_;
+        shortDescription = shortDescription_;
+    }
+
+    for (int part = 0; part < kPartCount; ++part) {
+        if (sending[part] == 0) {
+            continue;
+        }
+        try {
+            switch (part) {
+                case kCommands:
+                    sink_->setCommands(commands);
+                    break;
+                case kDescription:
+                    sink_->setDescription(description);
+                    break;
+                case kShortDescription:
+                    sink_->setShortDescription(shortDescription);
+                    break;
+            }
+        } catch (const std::exception& e) {
+            // Left as not sent, the next change or restart tries again
+            LOG(ERROR) << "Cannot update bot " << kPartNames[part] << ": "
+                       << e.what();
+            continue;
+        }
+        LOG(INFO) << "Updated bot " << kPartNames[part];
+        const std::lock_guard<std::mutex> lock(mutex_);
+        sent_[part] = sending[part];
+        saveStateLocked();
+    }
+}
+
+void BotProfileSync::loadState() {
+    std::ifstream file(stateFile_);
+    std::string name;
+    uint64_t hash = 0;
+
+    while (file >> name >> std::hex >> hash) {
+        for (int part = 0; part < kPartCount; ++part) {
+            if (name == kPartNames[part]) {
+                sent_[part] = hash;
+            }
+        }
+    }
+}
+
+void BotProfileSync::saveStateLocked() const {
+    auto temp = stateFile_;
+    temp += ".part";
+    std::error_code ec;
+    {
+        std::ofstream file(temp, std::ios::trunc);
+        for (int part = 0; part < kPartCount; ++part) {
+            if (sent_[part] != 0) {
+                file << kPartNames[part] << ' ' << std::hex << sent_[part]
+                     << '\n';
+            }
+        }
+        if (!file) {
+            LOG(WARNING) << "Cannot write " << temp;
+            return;
+        }
+    }
+    std::filesystem::rename(temp, stateFile_, ec);
+    if (ec) {
+        LOG(WARNING) << "Cannot write " << stateFile_ << ": " << ec.message();
+    }
+}
+
+DECLARE_CLASS_INST(BotProfileSync);
@@ -0,0 +1,237 @@
+#include <ChatTimers.hpp>
+#include <internal/_std_chrono_templates.h>
+
+#include <algorithm>
+#include <cmath>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr std::string_view kTimerEnded = "Timer ended";
+
+std::string timeLeft(const ChatTimers::Clock::duration left) {
+    return to_string(std::chrono::ceil<std::chrono::seconds>(left));
+}
+
+}  // namespace
+
+ChatTimers::ChatTimers(std::shared_ptr<Api> api, TimerWheel& wheel,
+                       Limits limits)
+    : api_(std::move(api)),
+      wheel_(wheel),
+      limits_(limits),
+      tokens_(limits.requestsPerSecond),
+      refilled_(Clock::now()) {}
+
+ChatTimers::~ChatTimers() {
+    std::vector<TimerWheel::TimerId> events;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+        for (const auto& [chat, timer] : timers_) {
+            events.emplace_back(timer.event);
+        }
+        events.emplace_back(flushEvent_);
+    }
+    // Not under mutex_, the callbacks take it
+    for (const auto event : events) {
+        wheel_.cancel(event);
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    flushDone_.wait(lock, [this] { return !flushing_; });
+}
+
+ChatTimers::StartResult ChatTimers::start(
+    const ChatId chat, const std::chrono::milliseconds duration) {
+    uint32_t serial = 0;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (closing_) {
+            return StartResult::kFailed;
+        }
+        if (timers_.contains(chat)) {
+            return StartResult::kAlreadyRunning;
+        }
+        if (timers_.size() >= limits_.maxTimers) {
+            return StartResult::kTooManyTimers;
+        }
+        // Reserves the chat while the message is being sent
+        serial = ++nextSerial_;
+        timers_[chat].serial = serial;
+    }
+
+    const MessageId message =
+        api_->sendMessage(chat, "Timer starting: " + timeLeft(duration));
+    const bool pinned = message != 0 && api_->pinMessage(chat, message);
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    auto it = timers_.find(chat);
+    if (it == timers_.end() || it->second.serial != serial) {
+        // Stopped while we were sending, end it right away
+        if (message != 0) {
+            endings_.push_back({chat, message, pinned, false});
+            scheduleFlushLocked();
+        }
+        return StartResult::kStopped;
+    }
+    if (message == 0) {
+        timers_.erase(it);
+        return StartResult::kFailed;
+    }
+    const auto now = Clock::now();
+    Timer& timer = it->second;
+    timer.message = message;
+    timer.pinned = pinned;
+    timer.end = now + duration;
+    scheduleEventLocked(chat, &timer, now);
+    return StartResult::kStarted;
+}
+
+bool ChatTimers::stop(const ChatId chat) {
+    TimerWheel::TimerId event = TimerWheel::kInvalidTimer;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        auto it = timers_.find(chat);
+        if (it == timers_.end()) {
+            return false;
+        }
+        const Timer& timer = it->second;
+        event = timer.event;
+        if (timer.message != 0) {
+            endings_.push_back({chat, timer.message, timer.pinned, false});
+            scheduleFlushLocked();
+        }
+        timers_.erase(it);
+    }
+    // If it's firing right now, it won't find the timer anymore
+    wheel_.cancel(event);
+    return true;
+}
+
+size_t ChatTimers::active() const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return timers_.size();
+}
+
+void ChatTimers::scheduleEventLocked(const ChatId chat, Timer* timer,
+                                     const Clock::time_point now) {
+    const auto untilEnd =
+        std::chrono::ceil<std::chrono::milliseconds>(timer->end - now);
+    const auto serial = timer->serial;
+    timer->event = wheel_.schedule(std::min(limits_.editInterval, untilEnd),
+                                   [this, chat, serial] {
+                                       onEvent(chat, serial);
+                                   });
+}
+
+void ChatTimers::onEvent(const ChatId chat, const uint32_t serial) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (closing_) {
+        return;
+    }
+    auto it = timers_.find(chat);
+    if (it == timers_.end() || it->second.serial != serial) {
+        return;
+    }
+    Timer& timer = it->second;
+    const auto now = Clock::now();
+    timer.event = TimerWheel::kInvalidTimer;
+    if (now >= timer.end) {
+        endings_.push_back({chat, timer.message, timer.pinned, true});
+        timers_.erase(it);
+    } else {
+        if (!timer.editQueued) {
+            timer.editQueued = true;
+            edits_.push_back({chat, serial});
+        }
+        scheduleEventLocked(chat, &timer, now);
+    }
+    scheduleFlushLocked();
+}
+
+void ChatTimers::scheduleFlushLocked() {
+    if (closing_ || flushEvent_ != TimerWheel::kInvalidTimer ||
+        (endings_.empty() && edits_.empty())) {
+        return;
+    }
+    refillLocked(Clock::now());
+    // Wait until there is budget for one request
+    std::chrono::milliseconds delay(0);
+    if (tokens_ < 1) {
+        delay = std::chrono::milliseconds(static_cast<int64_t>(
+            std::ceil((1 - tokens_) * 1000 / limits_.requestsPerSecond)));
+    }
+    flushEvent_ = wheel_.schedule(delay, [this] { flush(); });
+}
+
+void ChatTimers::refillLocked(const Clock::time_point now) {
+    const double rate = limits_.requestsPerSecond;
+    const std::chrono::duration<double> elapsed = now - refilled_;
+    tokens_ = std::min(rate, tokens_ + elapsed.count() * rate);
+    refilled_ = now;
+}
+
+void ChatTimers::flush() {
+    struct EditRequest {
+        ChatId chat;
+        MessageId message;
+        std::string text;
+    };
+    std::vector<Ending> endings;
+    std::vector<EditRequest> edits;
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        flushEvent_ = TimerWheel::kInvalidTimer;
+        if (closing_) {
+            return;
+        }
+        const auto now = Clock::now();
+        refillLocked(now);
+
+        // An ending is never split, it may overdraw the budget a little
+        while (tokens_ >= 1 && !endings_.empty()) {
+            const Ending& ending = endings_.front();
+            tokens_ -= 1 + static_cast<int>(ending.announce) +
+                       static_cast<int>(ending.pinned);
+            endings.emplace_back(ending);
+            endings_.pop_front();
+        }
+        while (tokens_ >= 1 && !edits_.empty()) {
+            const Edit edit = edits_.front();
+            edits_.pop_front();
+            auto it = timers_.find(edit.chat);
+            if (it == timers_.end() || it->second.serial != edit.serial) {
+                continue;
+            }
+            Timer& timer = it->second;
+            timer.editQueued = false;
+            tokens_ -= 1;
+            edits.push_back(
+                {edit.chat, timer.message, timeLeft(timer.end - now)});
+        }
+        flushing_ = true;
+        scheduleFlushLocked();
+    }
+
+    for (const auto& ending : endings) {
+        api_->editMessage(ending.chat, ending.message,
+                          std::string(kTimerEnded));
+        if (ending.announce) {
+            api_->announce(ending.chat, std::string(kTimerEnded));
+        }
+        if (ending.pinned) {
+            api_->unpinMessage(ending.chat, ending.message);
+        }
+    }
+    for (const auto& edit : edits) {
+        api_->editMessage(edit.chat, edit.message, edit.text);
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        flushing_ = false;
+    }
+    flushDone_.notify_all();
+}
@@ -0,0 +1,126 @@
+#include <Authorization.h>
+
+#include <CommandRouter.hpp>
+#include <ParsedCommand.hpp>
+#include <Tracing.hpp>
+#include <utility>
+
+CommandRouter::CommandRouter() {
+    tables_.emplace_back(std::make_unique<const Table>());
+    current_.store(tables_.back().get(), std::memory_order_release);
+}
+
+void CommandRouter::install(Bot& bot) {
+    std::call_once(installed_, [this, &bot] {
+        // No command has a handler of its own in tgbot, so all come here
+        bot.getEvents().onUnknownCommand(
+            [this, &bot](const Message::Ptr& message) {
+                static const std::string myName =
+                    bot.getApi().getMe()->username;
+                dispatch(bot, message, myName);
+            });
+    });
+}
+
+void CommandRouter::add(const std::string& command, command_callback_t fn,
+                        const bool enforced) {
+    auto route = std::make_unique<Route>();
+    route->command = command;
+    route->spanName = "/" + command;
+    route->fn = std::move(fn);
+    route->authflags = AuthContext::Flags::REQUIRE_USER;
+    if (!enforced) {
+        route->authflags |= AuthContext::Flags::PERMISSIVE;
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    auto next = std::make_unique<Table>(*current_.load());
+    (*next)[command] = route.get();
+    routes_.emplace_back(std::move(route));
+    tables_.emplace_back(std::move(next));
+    current_.store(tables_.back().get(), std::memory_order_release);
+}
+
+bool CommandRouter::setEnabled(const std::string_view command,
+                               const bool enabled) {
+    auto* route = find(command);
+    if (route == nullptr) {
+        return false;
+    }
+    route->enabled.store(enabled, std::memory_order_relaxed);
+    return true;
+}
+
+std::optional<bool> CommandRouter::isEnabled(
+    const std::string_view command) const {
+    if (const auto* route = find(command)) {
+        return route->enabled.load(std::memory_order_relaxed);
+    }
+    return std::nullopt;
+}
+
+std::optional<CommandRouter::Stats> CommandRouter::stats(
+    const std::string_view command) const {
+    const auto* route = find(command);
+    if (route == nullptr) {
+        return std::nullopt;
+    }
+    return Stats{
+        route->command, route->enabled.load(std::memory_order_relaxed),
+        route->calls.value(), route->denied.value(),
+        std::chrono::microseconds(route->micros.value())};
+}
+
+bool CommandRouter::dispatch(Bot& bot, const Message::Ptr& message,
+                             const std::string_view username) const {
+    static auto& commands =
+        Metrics::counter("tgbot_commands_total", "Commands received");
+    static auto& denied = Metrics::counter(
+        "tgbot_commands_denied_total", "Commands refused by authorization");
+    static auto& authLatency = Metrics::histogram(
+        "tgbot_command_auth_seconds", "Time spent authorizing commands");
+    static auto& latency = Metrics::histogram("tgbot_command_seconds",
+                                              "Time spent running commands");
+
+    const auto parsed = ParsedCommand::parse(message->text);
+    if (!parsed.isCommand() || !parsed.isFor(username)) {
+        return false;
+    }
+    auto* route = find(parsed.command);
+    if (route == nullptr || !route->enabled.load(std::memory_order_relaxed)) {
+        return false;
+    }
+
+    commands.add();
+    route->calls.add();
+    bool authorized = false;
+    {
+        const Tracing::Span span("auth");
+        const Metrics::ScopedTimer timer(authLatency);
+        authorized =
+            AuthContext::getInstance()->isAuthorized(message, route->authflags);
+    }
+    if (!authorized) {
+        denied.add();
+        route->denied.add();
+        return true;
+    }
+
+    const Tracing::Span span(route->spanName);
+    const Metrics::ScopedTimer timer(latency);
+    const auto start = std::chrono::steady_clock::now();
+    route->fn(bot, message);
+    const auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    route->micros.add(static_cast<uint64_t>(micros.count()));
+    return true;
+}
+
+CommandRouter::Route* CommandRouter::find(
+    const std::string_view command) const {
+    const auto* table = current_.load(std::memory_order_acquire);
+    const auto it = table->find(command);
+    return it != table->end() ? it->second : nullptr;
+}
+
+DECLARE_CLASS_INST(CommandRouter);
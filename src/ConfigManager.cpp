@@ -2,7 +2,11 @@
 #include <absl/log/log.h>
 
 #include <StringToolsExt.hpp>
+#include <atomic>
 #include <boost/program_options.hpp>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
@@ -13,6 +17,9 @@
 #include <optional>
 #include <ostream>
 #include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
 
 #include "CompileTimeStringConcat.hpp"
 
@@ -94,6 +101,14 @@ struct ConfigBackendBoostPOBase : public ConfigBackendBase {
             AddOption<std::string, Configs::SOCKET_BACKEND>(desc);
             AddOption<std::string, Configs::SELECTOR>(desc);
             AddOption<std::string, Configs::LOCALE>(desc);
+            AddOption<std::string, Configs::IMAGE_THREADS>(desc);
+            AddOption<std::string, Configs::IMAGE_MIN_PIXELS>(desc);
+            AddOption<std::string, Configs::FILE_CACHE_DIR>(desc);
+            AddOption<std::string, Configs::COMPILE_CACHE_DIR>(desc);
+            AddOption<std::string, Configs::TRACE_FILE>(desc);
+            AddOption<std::string, Configs::TRACE_SAMPLE_RATE>(desc);
+            AddOption<std::string, Configs::REPLAY_FILE>(desc);
+            AddOption<std::string, Configs::REPLAY_SPEED>(desc);
         });
         return desc;
     }
@@ -234,34 +249,35 @@ enum class Passes {
 
 namespace details {
 
-std::vector<std::unique_ptr<ConfigBackendBase>> &getAvailableBackends() {
-    static std::vector<std::unique_ptr<ConfigBackendBase>> backends;
-    static std::once_flag status;
-    std::call_once(status, [] {
-        auto cmdline = std::make_unique<ConfigBackendCmdline>();
-        if (cmdline->load()) {
-            backends.emplace_back(std::move(cmdline));
-        }
-        auto env = std::make_unique<ConfigBackendEnv>();
-        if (env->load()) {
-            backends.emplace_back(std::move(env));
-        }
-        auto file = std::make_unique<ConfigBackendFile>();
-        if (file->load()) {
-            backends.emplace_back(std::move(file));
-        }
-        DLOG(INFO) << "Loaded " << backends.size() << " config sources";
-    });
+using Backends = std::vector<std::unique_ptr<ConfigBackendBase>>;
+
+// Set from the SIGHUP handler, so it must not need construction
+std::atomic<bool> reloadRequested = false;
+std::mutex reloadMutex;
+// Only held to copy or swap the current snapshot, never while reloading
+std::mutex currentMutex;
+
+Backends loadBackends() {
+    Backends backends;
+    auto cmdline = std::make_unique<ConfigBackendCmdline>();
+    if (cmdline->load()) {
+        backends.emplace_back(std::move(cmdline));
+    }
+    auto env = std::make_unique<ConfigBackendEnv>();
+    if (env->load()) {
+        backends.emplace_back(std::move(env));
+    }
+    auto file = std::make_unique<ConfigBackendFile>();
+    if (file->load()) {
+        backends.emplace_back(std::move(file));
+    }
+    DLOG(INFO) << "Loaded " << backends.size() << " config sources";
     return backends;
 }
 
-}  // namespace details
-
-std::optional<std::string> getVariable(Configs config) {
+std::optional<std::string> resolve(const Backends &backends, Configs config) {
     Passes p = Passes::INIT;
-    std::string outvalue;
     std::string name = array_helpers::find(kConfigsMap, config)->second;
-    auto const &backends = details::getAvailableBackends();
     name.resize(strlen(name.c_str()));
 
     p = Passes::FIND_OVERRIDE;
@@ -300,6 +316,171 @@ std::optional<std::string> getVariable(Configs config) {
     return std::nullopt;
 }
 
+std::shared_ptr<const Snapshot> makeSnapshot() {
+    const auto backends = loadBackends();
+    Snapshot::Values values;
+
+    for (int i = 0; i < static_cast<int>(Configs::MAX); ++i) {
+        values.at(i) = resolve(backends, static_cast<Configs>(i));
+    }
+    return std::make_shared<const Snapshot>(std::move(values));
+}
+
+// Copy or swap it with currentMutex held
+std::shared_ptr<const Snapshot> &current() {
+    static std::shared_ptr<const Snapshot> current = [] {
+        const std::lock_guard<std::mutex> lock(reloadMutex);
+        return makeSnapshot();
+    }();
+    return current;
+}
+
+std::optional<std::chrono::milliseconds> parseDuration(std::string_view value) {
+    using namespace std::chrono;
+    long long count = 0;
+
+    const auto *end = value.data() + value.size();
+    const auto [ptr, ec] = std::from_chars(value.data(), end, count);
+    const std::string_view unit(ptr, end);
+
+    if (ec != std::errc() || count < 0) {
+        return std::nullopt;
+    }
+    if (unit == "ms") {
+        return milliseconds(count);
+    } else if (unit.empty() || unit == "s") {
+        return seconds(count);
+    } else if (unit == "m") {
+        return minutes(count);
+    } else if (unit == "h") {
+        return hours(count);
+    }
+    return std::nullopt;
+}
+
+template <typename T>
+std::optional<T> parseNumber(std::string_view value) {
+    T out{};
+    const auto *end = value.data() + value.size();
+    const auto [ptr, ec] = std::from_chars(value.data(), end, out);
+    if (ec != std::errc() || ptr != end) {
+        return std::nullopt;
+    }
+    return out;
+}
+
+}  // namespace details
+
+Snapshot::Snapshot(Values values)
+    : Snapshot(std::move(values), [] {
+          Types types{};
+          for (const auto &[config, type] : kConfigsTypeMap) {
+              types.at(static_cast<int>(config)) = type;
+          }
+          return types;
+      }()) {}
+
+Snapshot::Snapshot(Values values, const Types &types)
+    : values_(std::move(values)) {
+    for (int i = 0; i < static_cast<int>(Configs::MAX); ++i) {
+        parse(static_cast<Configs>(i), types.at(i));
+    }
+}
+
+void Snapshot::parse(Configs config, ConfigType type) {
+    const auto &value = get(config);
+    auto &parsed = parsed_.at(static_cast<int>(config));
+
+    if (!value) {
+        return;
+    }
+    switch (type) {
+        case ConfigType::STRING:
+            return;
+        case ConfigType::PATH:
+            parsed = std::filesystem::path(*value).make_preferred();
+            return;
+        case ConfigType::COUNT:
+            if (const auto count =
+                    details::parseNumber<std::uint64_t>(*value)) {
+                parsed = *count;
+                return;
+            }
+            break;
+        case ConfigType::REAL:
+            if (const auto real = details::parseNumber<double>(*value)) {
+                parsed = *real;
+                return;
+            }
+            break;
+        case ConfigType::DURATION:
+            if (const auto duration = details::parseDuration(*value)) {
+                parsed = *duration;
+                return;
+            }
+            break;
+    }
+    warnInvalid(config);
+}
+
+std::optional<std::filesystem::path> Snapshot::getPath(Configs config) const {
+    const auto &value = parsed_.at(static_cast<int>(config));
+    if (const auto *path = std::get_if<std::filesystem::path>(&value)) {
+        return *path;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::chrono::milliseconds> Snapshot::getDuration(
+    Configs config) const {
+    const auto &value = parsed_.at(static_cast<int>(config));
+    if (const auto *duration = std::get_if<std::chrono::milliseconds>(&value)) {
+        return *duration;
+    }
+    return std::nullopt;
+}
+
+void Snapshot::warnInvalid(Configs config) const {
+    if (warned_.at(static_cast<int>(config)).exchange(true)) {
+        return;
+    }
+    LOG(WARNING) << "Invalid "
+                 << kConfigsMap.at(static_cast<int>(config)).second.c << ": "
+                 << SingleQuoted(*get(config));
+}
+
+std::shared_ptr<const Snapshot> snapshot() {
+    // Checked first, the exchange would make readers contend
+    if (details::reloadRequested.load(std::memory_order_relaxed) &&
+        details::reloadRequested.exchange(false)) {
+        reload();
+    }
+    auto &current = details::current();
+    const std::lock_guard<std::mutex> lock(details::currentMutex);
+    return current;
+}
+
+void reload() {
+    // Before the lock, the first snapshot is made under it
+    auto &current = details::current();
+    // Reloads are serialized from reading the sources to publishing, so a
+    // slower one can't publish older values over a newer one
+    const std::lock_guard<std::mutex> lock(details::reloadMutex);
+    auto next = details::makeSnapshot();
+    {
+        const std::lock_guard<std::mutex> swapLock(details::currentMutex);
+        current.swap(next);
+    }
+    // next is the previous snapshot now, freed here unless a reader holds it
+    next.reset();
+    LOG(INFO) << "Reloaded config";
+}
+
+void requestReload() { details::reloadRequested = true; }
+
+std::optional<std::string> getVariable(Configs config) {
+    return snapshot()->get(config);
+}
 void serializeHelpToOStream(std::ostream &out) {
     out << ConfigBackendCmdline::getTgBotOptionsDesc() << std::endl;
 }
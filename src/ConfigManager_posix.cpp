@@ -8,6 +8,7 @@ void ConfigManager::setVariable(Configs config, const std::string &value) {
         ConfigManager::kConfigsMap.at(static_cast<int>(config)).second;
     setenv(var.c_str(), value.c_str(), 1);
 #endif
+    reload();
 }
 
 bool ConfigManager::getEnv(const std::string &name, std::string &value) {
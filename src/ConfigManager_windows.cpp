@@ -10,6 +10,7 @@ void ConfigManager::setVariable(Configs config, const std::string &value_) {
         ConfigManager::kConfigsMap.at(static_cast<int>(config)).second;
     CStringLifetime value = value_;
     SetEnvironmentVariable(key, value);
+    reload();
 }
 
 bool ConfigManager::getEnv(const std::string &name, std::string &value) {
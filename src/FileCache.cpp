@@ -0,0 +1,314 @@
+#include <FileCache.hpp>
+#include <absl/log/log.h>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Beyond that, expired download paths are dropped
+constexpr size_t kMaxCachedPaths = 4096;
+// Of files being written, they are renamed once complete
+constexpr std::string_view kPartialSuffix = ".part";
+
+// fileUniqueIds are URL safe base64, anything else isn't used as a file name
+bool isValidKey(const std::string& key) {
+    constexpr size_t kMaxKeyLength = 128;
+    return !key.empty() && key.size() <= kMaxKeyLength &&
+           std::ranges::all_of(key, [](const char c) {
+               return std::isalnum(static_cast<unsigned char>(c)) != 0 ||
+                      c == '-' || c == '_';
+           });
+}
+
+// Runs fn when it goes out of scope, however that happens
+template <typename Fn>
+class ScopeExit {
+   public:
+    explicit ScopeExit(Fn fn) : fn_(std::move(fn)) {}
+    ~ScopeExit() { fn_(); }
+    ScopeExit(const ScopeExit&) = delete;
+    ScopeExit& operator=(const ScopeExit&) = delete;
+
+   private:
+    Fn fn_;
+};
+
+}  // namespace
+
+FileCache::FileCache(std::filesystem::path directory,
+                     std::shared_ptr<Source> source, Limits limits)
+    : directory_(std::move(directory)),
+      source_(std::move(source)),
+      limits_(limits) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory_, ec);
+    if (ec) {
+        LOG(WARNING) << "Cannot create file cache directory " << directory_
+                     << ": " << ec.message();
+    }
+    loadIndex();
+}
+
+void FileCache::loadIndex() {
+    using std::filesystem::file_time_type;
+    std::vector<std::tuple<file_time_type, std::string, uint64_t>> files;
+    std::error_code ec;
+
+    for (const auto& entry :
+         std::filesystem::directory_iterator(directory_, ec)) {
+        const auto name = entry.path().filename().string();
+        if (!entry.is_regular_file(ec)) {
+            continue;
+        }
+        if (name.ends_with(kPartialSuffix)) {
+            // Left over from a crash
+            std::filesystem::remove(entry.path(), ec);
+            continue;
+        }
+        if (isValidKey(name)) {
+            files.emplace_back(entry.last_write_time(ec), name,
+                               entry.file_size(ec));
+        }
+    }
+    // Newest first, they go to the front of the LRU
+    std::ranges::sort(files, std::greater<>());
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [time, name, size] : files) {
+        diskLru_.emplace_back(name);
+        disk_.emplace(name, DiskEntry{size, std::prev(diskLru_.end())});
+        diskBytes_ += size;
+    }
+    addToDiskLocked({}, 0);
+    LOG(INFO) << "File cache " << directory_ << ": " << disk_.size()
+              << " files, " << diskBytes_ << " bytes";
+}
+
+FileCache::Data FileCache::get(const std::string& fileId,
+                               const std::string& fileUniqueId) {
+    const std::string& key = fileUniqueId;
+    if (!isValidKey(key)) {
+        return download(fileId);
+    }
+
+    std::promise<Data> loaded;
+    bool onDisk = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (auto it = memory_.find(key); it != memory_.end()) {
+            memoryLru_.splice(memoryLru_.begin(), memoryLru_, it->second.lru);
+            if (auto disk = disk_.find(key); disk != disk_.end()) {
+                diskLru_.splice(diskLru_.begin(), diskLru_, disk->second.lru);
+            }
+            ++stats_.memoryHits;
+            return it->second.data;
+        }
+        if (auto it = loading_.find(key); it != loading_.end()) {
+            const auto loading = it->second;
+            lock.unlock();
+            return loading.get();
+        }
+        loading_.emplace(key, loaded.get_future().share());
+        onDisk = disk_.contains(key);
+    }
+    // If the load throws, its waiters get nullptr, and the next get()
+    // loads the file again instead of waiting on it forever
+    bool settled = false;
+    const ScopeExit settle([&] {
+        if (settled) {
+            return;
+        }
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            loading_.erase(key);
+        }
+        loaded.set_value(nullptr);
+    });
+
+    Data data;
+    if (onDisk) {
+        data = readFromDisk(key);
+    }
+    const bool fromDisk = data != nullptr;
+    bool written = false;
+    if (!fromDisk) {
+        data = download(fileId);
+        written = data && writeToDisk(key, *data);
+    }
+
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (fromDisk) {
+            if (auto it = disk_.find(key); it != disk_.end()) {
+                diskLru_.splice(diskLru_.begin(), diskLru_, it->second.lru);
+            }
+            ++stats_.diskHits;
+        } else if (onDisk) {
+            // Gone from the directory
+            removeFromDiskLocked(key);
+        }
+        if (written) {
+            addToDiskLocked(key, data->size());
+        }
+        if (data) {
+            addToMemoryLocked(key, data);
+        }
+        loading_.erase(key);
+    }
+    settled = true;
+    loaded.set_value(data);
+    return data;
+}
+
+std::optional<std::string> FileCache::filePath(const std::string& fileId) {
+    const auto now = Clock::now();
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (auto it = paths_.find(fileId); it != paths_.end()) {
+            if (it->second.expires > now) {
+                return it->second.path;
+            }
+            paths_.erase(it);
+        }
+    }
+
+    std::optional<std::string> path;
+    try {
+        path = source_->getFilePath(fileId);
+    } catch (const std::exception& e) {
+        LOG(WARNING) << "Cannot get file " << fileId << ": " << e.what();
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.pathLookups;
+    if (path) {
+        if (paths_.size() >= kMaxCachedPaths) {
+            std::erase_if(paths_, [now](const auto& entry) {
+                return entry.second.expires <= now;
+            });
+        }
+        if (paths_.size() < kMaxCachedPaths) {
+            paths_.insert_or_assign(
+                fileId, CachedPath{*path, now + limits_.filePathTtl});
+        }
+    }
+    return path;
+}
+
+FileCache::Stats FileCache::stats() const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+FileCache::Data FileCache::readFromDisk(const std::string& key) const {
+    const auto path = directory_ / key;
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return nullptr;
+    }
+    std::string contents{std::istreambuf_iterator<char>(file),
+                         std::istreambuf_iterator<char>()};
+    if (file.bad()) {
+        return nullptr;
+    }
+    // For the order of the index on restart
+    std::error_code ec;
+    std::filesystem::last_write_time(
+        path, std::filesystem::file_time_type::clock::now(), ec);
+    return std::make_shared<const std::string>(std::move(contents));
+}
+
+bool FileCache::writeToDisk(const std::string& key,
+                            const std::string& contents) {
+    const auto path = directory_ / key;
+    auto partial = path;
+    partial += kPartialSuffix;
+    std::error_code ec;
+    {
+        std::ofstream file(partial, std::ios::binary | std::ios::trunc);
+        file.write(contents.data(),
+                   static_cast<std::streamsize>(contents.size()));
+        if (!file) {
+            LOG(WARNING) << "Cannot write " << partial;
+            file.close();
+            std::filesystem::remove(partial, ec);
+            return false;
+        }
+    }
+    std::filesystem::rename(partial, path, ec);
+    if (ec) {
+        LOG(WARNING) << "Cannot rename " << partial << ": " << ec.message();
+        std::filesystem::remove(partial, ec);
+        return false;
+    }
+    return true;
+}
+
+void FileCache::addToDiskLocked(const std::string& key, const uint64_t size) {
+    if (!key.empty()) {
+        removeFromDiskLocked(key);
+        diskLru_.emplace_front(key);
+        disk_.emplace(key, DiskEntry{size, diskLru_.begin()});
+        diskBytes_ += size;
+    }
+    std::error_code ec;
+    while (diskBytes_ > limits_.diskBytes && !diskLru_.empty()) {
+        const std::string oldest = diskLru_.back();
+        removeFromDiskLocked(oldest);
+        std::filesystem::remove(directory_ / oldest, ec);
+    }
+}
+
+void FileCache::removeFromDiskLocked(const std::string& key) {
+    auto it = disk_.find(key);
+    if (it == disk_.end()) {
+        return;
+    }
+    diskBytes_ -= it->second.size;
+    diskLru_.erase(it->second.lru);
+    disk_.erase(it);
+}
+
+void FileCache::addToMemoryLocked(const std::string& key, const Data& data) {
+    if (data->size() > limits_.memoryFileBytes || memory_.contains(key)) {
+        return;
+    }
+    memoryLru_.emplace_front(key);
+    memory_.emplace(key, MemoryEntry{data, memoryLru_.begin()});
+    memoryBytes_ += data->size();
+    while (memoryBytes_ > limits_.memoryBytes) {
+        auto it = memory_.find(memoryLru_.back());
+        memoryBytes_ -= it->second.data->size();
+        memory_.erase(it);
+        memoryLru_.pop_back();
+    }
+}
+
+FileCache::Data FileCache::download(const std::string& fileId) {
+    const auto path = filePath(fileId);
+    if (!path) {
+        return nullptr;
+    }
+    try {
+        auto contents = source_->download(*path);
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            ++stats_.downloads;
+        }
+        return std::make_shared<const std::string>(std::move(contents));
+    } catch (const std::exception& e) {
+        LOG(WARNING) << "Cannot download file " << fileId << ": " << e.what();
+        // Its path may have expired early
+        const std::lock_guard<std::mutex> lock(mutex_);
+        paths_.erase(fileId);
+        return nullptr;
+    }
+}
@@ -98,4 +98,13 @@ bool GitData::Fill(GitData *data) {
     return rc;
 }
 
-bool GitData::Fill() { return Fill(this); }
\ No newline at end of file
+bool GitData::Fill() { return Fill(this); }
+
+const GitData &GitData::get() {
+    static const GitData data = [] {
+        GitData data;
+        Fill(&data);
+        return data;
+    }();
+    return data;
+}
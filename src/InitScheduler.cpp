@@ -0,0 +1,101 @@
+#include "initcalls/InitScheduler.hpp"
+
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "DurationPoint.hpp"
+
+InitScheduler::Task InitScheduler::add(std::string name,
+                                       const std::vector<Task>& dependencies,
+                                       std::function<void()> fn) {
+    const Task task = nodes_.size();
+
+    nodes_.push_back({std::move(name), std::move(fn)});
+    for (const auto dependency : dependencies) {
+        CHECK_LT(dependency, task) << "Depends on a task added after it";
+        nodes_[dependency].dependents.emplace_back(task);
+        ++nodes_[task].pending;
+    }
+    return task;
+}
+
+std::vector<InitScheduler::Timing> InitScheduler::run(unsigned threads) {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<Task> ready;
+    size_t done = 0;
+    std::exception_ptr error;
+
+    for (Task task = 0; task < nodes_.size(); ++task) {
+        if (nodes_[task].pending == 0) {
+            ready.emplace_back(task);
+        }
+    }
+    const auto worker = [&] {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cv.wait(lock,
+                    [&] { return !ready.empty() || done == nodes_.size(); });
+            if (ready.empty()) {
+                return;
+            }
+            const Task task = ready.front();
+            auto& node = nodes_[task];
+            bool failed = node.skipped;
+            ready.pop_front();
+
+            if (!node.skipped) {
+                lock.unlock();
+                auto dp = DurationPoint();
+                try {
+                    node.fn();
+                } catch (...) {
+                    failed = true;
+                    LOG(ERROR) << node.name << " failed";
+                    const std::lock_guard<std::mutex> errorLock(mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                }
+                node.duration = dp.get();
+                lock.lock();
+            }
+            for (const auto dependent : node.dependents) {
+                nodes_[dependent].skipped |= failed;
+                if (--nodes_[dependent].pending == 0) {
+                    ready.emplace_back(dependent);
+                }
+            }
+            ++done;
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    threads = std::max(1U, threads);
+    threads = std::min<size_t>(threads, std::max<size_t>(1, nodes_.size()));
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    std::vector<Timing> timings;
+    for (const auto& node : nodes_) {
+        timings.push_back({node.name, node.duration});
+    }
+    return timings;
+}
@@ -25,6 +25,53 @@ void ManagedThread::runWith(thread_function fn) {
     };
 }
 
+void ManagedThread::runAfter(const std::chrono::milliseconds delay,
+                             thread_function fn) {
+    switch (state) {
+        case ControlState::STOPPED_PREMATURE:
+        case ControlState::STOPPED_BY_STOP_CMD:
+            reset();
+            [[fallthrough]];
+        case ControlState::UNINITIALIZED:
+            state = ControlState::RUNNING;
+            timerId = ThreadManager::getInstance()->timers().schedule(
+                delay, [this, fn = std::move(fn)] {
+                    fn();
+                    onFunctionReturned();
+                });
+            break;
+        case ControlState::RUNNING:
+            LOG(WARNING) << "Thread is already running: " << mgr_priv.usage.str
+                         << " controller";
+            break;
+    };
+}
+
+void ManagedThread::runPeriodic(const std::chrono::milliseconds period,
+                                periodic_function fn) {
+    switch (state) {
+        case ControlState::STOPPED_PREMATURE:
+        case ControlState::STOPPED_BY_STOP_CMD:
+            reset();
+            [[fallthrough]];
+        case ControlState::UNINITIALIZED:
+            state = ControlState::RUNNING;
+            timerId = ThreadManager::getInstance()->timers().schedulePeriodic(
+                period, [this, fn = std::move(fn)] {
+                    if (kRun && fn()) {
+                        return true;
+                    }
+                    onFunctionReturned();
+                    return false;
+                });
+            break;
+        case ControlState::RUNNING:
+            LOG(WARNING) << "Thread is already running: " << mgr_priv.usage.str
+                         << " controller";
+            break;
+    };
+}
+
 void ManagedThread::setPreStopFunction(prestop_function fn) {
     switch (state) {
         case ControlState::UNINITIALIZED:
@@ -47,8 +94,13 @@ void ManagedThread::stop() {
             state = ControlState::STOPPED_BY_STOP_CMD;
             [[fallthrough]];
         case ControlState::STOPPED_PREMATURE:
-            if (threadP->joinable()) threadP->join();
+            if (threadP && threadP->joinable()) threadP->join();
             threadP.reset();
+            if (timerId != TimerWheel::kInvalidTimer) {
+                // Waits for the callback, if it is running
+                ThreadManager::getInstance()->timers().cancel(timerId);
+                timerId = TimerWheel::kInvalidTimer;
+            }
             break;
         default:
             break;
@@ -79,6 +131,10 @@ void ManagedThread::reset() {
 
 void ManagedThread::_threadFn(thread_function fn) {
     fn();
+    onFunctionReturned();
+}
+
+void ManagedThread::onFunctionReturned() {
     if (kRun) {
         LOG(INFO) << mgr_priv.usage.str
                   << " controller ended before stop command";
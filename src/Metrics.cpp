@@ -0,0 +1,192 @@
+#include <Metrics.hpp>
+#include <absl/log/check.h>
+#include <absl/log/log.h>
+
+#include <bit>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+namespace Metrics {
+
+namespace {
+
+enum class Type { Counter, Gauge, Histogram };
+
+struct Family {
+    std::string name;
+    std::string help;
+    Type type;
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+    std::unique_ptr<Histogram> histogram;
+};
+
+class Registry {
+   public:
+    Family& get(const std::string_view name, const std::string_view help,
+                const Type type) {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& family : families_) {
+            if (family->name == name) {
+                CHECK(family->type == type)
+                    << "Metric " << name << " registered as another type";
+                return *family;
+            }
+        }
+        auto family = std::make_unique<Family>(
+            Family{std::string(name), std::string(help), type});
+        switch (type) {
+            case Type::Counter:
+                family->counter = std::make_unique<Counter>();
+                break;
+            case Type::Gauge:
+                family->gauge = std::make_unique<Gauge>();
+                break;
+            case Type::Histogram:
+                family->histogram = std::make_unique<Histogram>();
+                break;
+        }
+        families_.emplace_back(std::move(family));
+        return *families_.back();
+    }
+
+    std::string serialize() const;
+
+   private:
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<Family>> families_;
+};
+
+// Never destroyed, hot paths keep references to the metrics in statics
+Registry& registry() {
+    static auto* registry = new Registry();
+    return *registry;
+}
+
+void serializeHistogram(std::ostream& out, const Family& family) {
+    constexpr double kSecondsPerMicro = 1e-6;
+    const auto snapshot = family.histogram->snapshot();
+    size_t last = 0;
+    uint64_t cumulative = 0;
+
+    for (size_t bucket = 0; bucket < Histogram::kBuckets; ++bucket) {
+        if (snapshot.counts[bucket] != 0) {
+            last = bucket;
+        }
+    }
+    // One line per power of two is enough for Prometheus
+    for (size_t bucket = 0; bucket <= last; ++bucket) {
+        cumulative += snapshot.counts[bucket];
+        if (bucket % Histogram::kSubBuckets == Histogram::kSubBuckets - 1 ||
+            bucket == last) {
+            out << family.name << "_bucket{le=\""
+                << Histogram::upperBound(bucket) * kSecondsPerMicro << "\"} "
+                << cumulative << '\n';
+        }
+    }
+    out << family.name << "_bucket{le=\"+Inf\"} " << snapshot.count << '\n';
+    out << family.name << "_sum " << snapshot.sum * kSecondsPerMicro << '\n';
+    out << family.name << "_count " << snapshot.count << '\n';
+}
+
+std::string Registry::serialize() const {
+    std::ostringstream out;
+    const std::lock_guard<std::mutex> lock(mutex_);
+
+    for (const auto& family : families_) {
+        out << "# HELP " << family->name << ' ' << family->help << '\n';
+        switch (family->type) {
+            case Type::Counter:
+                out << "# TYPE " << family->name << " counter\n"
+                    << family->name << ' ' << family->counter->value() << '\n';
+                break;
+            case Type::Gauge:
+                out << "# TYPE " << family->name << " gauge\n"
+                    << family->name << ' ' << family->gauge->value() << '\n';
+                break;
+            case Type::Histogram:
+                out << "# TYPE " << family->name << " histogram\n";
+                serializeHistogram(out, *family);
+                break;
+        }
+    }
+    return out.str();
+}
+
+}  // namespace
+
+size_t detail::shardIndex() {
+    static std::atomic<size_t> next = 0;
+    thread_local const size_t index =
+        next.fetch_add(1, std::memory_order_relaxed) % kShards;
+    return index;
+}
+
+uint64_t Counter::value() const {
+    uint64_t sum = 0;
+    for (const auto& shard : shards_) {
+        sum += shard.value.load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+size_t Histogram::bucketOf(const uint64_t micros) {
+    if (micros < kSubBuckets) {
+        return micros;
+    }
+    const int exponent = std::bit_width(micros) - 1;
+    if (exponent >= kMaxBits) {
+        return kBuckets - 1;
+    }
+    const int shift = exponent - kSubBucketBits;
+    const size_t sub = (micros >> shift) & (kSubBuckets - 1);
+    return (shift + 1) * kSubBuckets + sub;
+}
+
+uint64_t Histogram::upperBound(const size_t bucket) {
+    if (bucket < kSubBuckets) {
+        return bucket + 1;
+    }
+    const size_t shift = bucket / kSubBuckets - 1;
+    const uint64_t sub = bucket % kSubBuckets;
+    return (kSubBuckets + sub + 1) << shift;
+}
+
+void Histogram::record(const uint64_t micros) {
+    auto& shard = shards_[detail::shardIndex()];
+    shard.counts[bucketOf(micros)].fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(micros, std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::snapshot() const {
+    Snapshot snapshot;
+    for (const auto& shard : shards_) {
+        for (size_t bucket = 0; bucket < kBuckets; ++bucket) {
+            const auto count =
+                shard.counts[bucket].load(std::memory_order_relaxed);
+            snapshot.counts[bucket] += count;
+            snapshot.count += count;
+        }
+        snapshot.sum += shard.sum.load(std::memory_order_relaxed);
+    }
+    return snapshot;
+}
+
+Counter& counter(const std::string_view name, const std::string_view help) {
+    return *registry().get(name, help, Type::Counter).counter;
+}
+
+Gauge& gauge(const std::string_view name, const std::string_view help) {
+    return *registry().get(name, help, Type::Gauge).gauge;
+}
+
+Histogram& histogram(const std::string_view name,
+                     const std::string_view help) {
+    return *registry().get(name, help, Type::Histogram).histogram;
+}
+
+std::string serialize() { return registry().serialize(); }
+
+}  // namespace Metrics
@@ -0,0 +1,226 @@
+#include <PooledCurlHttpClient.hpp>
+#include <absl/log/log.h>
+
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+
+// How long the thread sleeps without a wakeup, curl's timers aside
+constexpr int kPollTimeoutMs = 1000;
+// Idle easy handles kept for reuse, more are freed
+constexpr size_t kMaxIdleHandles = 32;
+
+size_t writeToString(char* data, size_t size, size_t nmemb, void* userp) {
+    static_cast<std::string*>(userp)->append(data, size * nmemb);
+    return size * nmemb;
+}
+
+}  // namespace
+
+struct PooledCurlHttpClient::Transfer {
+    CURL* easy = nullptr;
+    curl_mime* mime = nullptr;
+    std::string response;
+    char error[CURL_ERROR_SIZE] = {};
+    CURLcode result = CURLE_OK;
+    bool done = false;
+    std::condition_variable finished;
+};
+
+PooledCurlHttpClient::PooledCurlHttpClient()
+    : PooledCurlHttpClient(Options{}) {}
+
+PooledCurlHttpClient::PooledCurlHttpClient(Options options)
+    : options_(std::move(options)) {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    multi_ = curl_multi_init();
+    curl_multi_setopt(multi_, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS,
+                      options_.maxHostConnections);
+    // Connections and DNS are cached by the multi handle already
+    share_ = curl_share_init();
+    curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+    thread_ = std::thread(&PooledCurlHttpClient::threadFn, this);
+}
+
+PooledCurlHttpClient::~PooledCurlHttpClient() {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    curl_multi_wakeup(multi_);
+    thread_.join();
+    for (auto* easy : idle_) {
+        curl_easy_cleanup(easy);
+    }
+    curl_multi_cleanup(multi_);
+    curl_share_cleanup(share_);
+    curl_global_cleanup();
+}
+
+std::string PooledCurlHttpClient::makeRequest(
+    const TgBot::Url& url, const std::vector<TgBot::HttpReqArg>& args) const {
+    Transfer transfer;
+    CURL* easy = takeHandle();
+    transfer.easy = easy;
+
+    std::string target = url.protocol + "://" + url.host + url.path;
+    if (args.empty()) {
+        target += "?" + url.query;
+    } else {
+        transfer.mime = curl_mime_init(easy);
+        for (const auto& arg : args) {
+            curl_mimepart* part = curl_mime_addpart(transfer.mime);
+            curl_mime_data(part, arg.value.c_str(), arg.value.size());
+            curl_mime_type(part, arg.mimeType.c_str());
+            curl_mime_name(part, arg.name.c_str());
+            if (arg.isFile) {
+                curl_mime_filename(part, arg.fileName.c_str());
+            }
+        }
+        curl_easy_setopt(easy, CURLOPT_MIMEPOST, transfer.mime);
+    }
+    curl_easy_setopt(easy, CURLOPT_URL, target.c_str());
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeToString);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer.response);
+    curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, transfer.error);
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, &transfer);
+    curl_easy_setopt(easy, CURLOPT_SHARE, share_);
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(easy, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(easy, CURLOPT_CONNECTTIMEOUT,
+                     static_cast<long>(options_.connectTimeout.count()));
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT, static_cast<long>(_timeout));
+    if (options_.http2) {
+        curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        // Wait for a connection which may multiplex, rather than open one
+        curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+    }
+    if (!options_.caInfo.empty()) {
+        curl_easy_setopt(easy, CURLOPT_CAINFO, options_.caInfo.c_str());
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (stopped_) {
+            transfer.result = CURLE_ABORTED_BY_CALLBACK;
+        } else {
+            queued_.emplace_back(&transfer);
+            curl_multi_wakeup(multi_);
+            transfer.finished.wait(lock, [&transfer] { return transfer.done; });
+        }
+    }
+
+    long connects = 0;
+    curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &connects);
+    connectionsOpened_ += connects;
+    curl_mime_free(transfer.mime);
+    returnHandle(easy);
+
+    if (transfer.result != CURLE_OK) {
+        std::string message = "curl error: ";
+        message += curl_easy_strerror(transfer.result);
+        if (transfer.error[0] != '\0') {
+            message += std::string(": ") + transfer.error;
+        }
+        throw std::runtime_error(message);
+    }
+    return std::move(transfer.response);
+}
+
+size_t PooledCurlHttpClient::connectionsOpened() const {
+    return connectionsOpened_;
+}
+
+CURL* PooledCurlHttpClient::takeHandle() const {
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (!idle_.empty()) {
+            CURL* easy = idle_.back();
+            idle_.pop_back();
+            return easy;
+        }
+    }
+    return curl_easy_init();
+}
+
+void PooledCurlHttpClient::returnHandle(CURL* easy) const {
+    // Keeps nothing but the caches, which live in the multi handle anyway
+    curl_easy_reset(easy);
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        if (idle_.size() < kMaxIdleHandles) {
+            idle_.emplace_back(easy);
+            return;
+        }
+    }
+    curl_easy_cleanup(easy);
+}
+
+void PooledCurlHttpClient::finish(Transfer* transfer,
+                                  const CURLcode result) const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    transfer->result = result;
+    transfer->done = true;
+    // Under the lock, the caller frees transfer as soon as it sees done
+    transfer->finished.notify_one();
+}
+
+void PooledCurlHttpClient::threadFn() {
+    std::unordered_set<Transfer*> running;
+    std::vector<Transfer*> added;
+
+    while (true) {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            if (stopped_) {
+                break;
+            }
+            added.swap(queued_);
+        }
+        for (auto* transfer : added) {
+            const CURLMcode code =
+                curl_multi_add_handle(multi_, transfer->easy);
+            if (code != CURLM_OK) {
+                LOG(ERROR) << "Cannot add transfer: "
+                           << curl_multi_strerror(code);
+                finish(transfer, CURLE_FAILED_INIT);
+            } else {
+                running.emplace(transfer);
+            }
+        }
+        added.clear();
+
+        int active = 0;
+        curl_multi_perform(multi_, &active);
+        int left = 0;
+        while (CURLMsg* msg = curl_multi_info_read(multi_, &left)) {
+            if (msg->msg != CURLMSG_DONE) {
+                continue;
+            }
+            CURL* easy = msg->easy_handle;
+            const CURLcode result = msg->data.result;
+            Transfer* transfer = nullptr;
+            curl_easy_getinfo(easy, CURLINFO_PRIVATE, &transfer);
+            curl_multi_remove_handle(multi_, easy);
+            running.erase(transfer);
+            finish(transfer, result);
+        }
+        curl_multi_poll(multi_, nullptr, 0, kPollTimeoutMs, nullptr);
+    }
+
+    // Stopped, fail what is left
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        added.swap(queued_);
+    }
+    for (auto* transfer : running) {
+        curl_multi_remove_handle(multi_, transfer->easy);
+        added.emplace_back(transfer);
+    }
+    for (auto* transfer : added) {
+        finish(transfer, CURLE_ABORTED_BY_CALLBACK);
+    }
+}
@@ -9,6 +9,7 @@
 #include <string>
 
 #include "InstanceClassBase.hpp"
+#include "Tracing.hpp"
 
 using std::regex_constants::ECMAScript;
 using std::regex_constants::format_first_only;
@@ -110,8 +111,11 @@ OptionalWrapper<std::string> RegexHandlerBase::doRegexDeleteCommand(
 void RegexHandlerBase::processRegEXCommand(const Message::Ptr& srcstr,
                                            const std::string& dststr) {
     OptionalWrapper<std::string> ret;
-    ret |= doRegexReplaceCommand(srcstr, dststr);
-    ret |= doRegexDeleteCommand(srcstr, dststr);
+    {
+        const Tracing::Span span("regex");
+        ret |= doRegexReplaceCommand(srcstr, dststr);
+        ret |= doRegexDeleteCommand(srcstr, dststr);
+    }
     if (ret) {
         onRegexProcessed(srcstr, *ret);
     }
@@ -0,0 +1,294 @@
+#include <ReplayHttpClient.hpp>
+
+#include <absl/log/log.h>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace {
+
+// Fields of an Update which hold a message with a date
+constexpr std::array<const char*, 4> kMessageFields = {
+    "message", "edited_message", "channel_post", "edited_channel_post"};
+// Methods which return an array
+constexpr std::array<std::string_view, 4> kListMethods = {
+    "getMyCommands", "getChatAdministrators", "getForumTopicIconStickers",
+    "getGameHighScores"};
+
+rapidjson::Value* messageOf(rapidjson::Document& update) {
+    for (const auto* field : kMessageFields) {
+        const auto it = update.FindMember(field);
+        if (it != update.MemberEnd() && it->value.IsObject()) {
+            return &it->value;
+        }
+    }
+    return nullptr;
+}
+
+int64_t nowSeconds() {
+    return std::chrono::duration_cast<std::chrono::seconds>(
+               std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+std::string okResponse(const std::string_view result) {
+    std::string out = R"({"ok":true,"result":)";
+    out += result;
+    out += '}';
+    return out;
+}
+
+std::string argOf(const std::vector<TgBot::HttpReqArg>& args,
+                  const std::string_view name) {
+    for (const auto& arg : args) {
+        if (arg.name == name) {
+            return arg.value;
+        }
+    }
+    return {};
+}
+
+int64_t chatIdOf(const std::vector<TgBot::HttpReqArg>& args) {
+    const auto value = argOf(args, "chat_id");
+    int64_t id = 0;
+    std::from_chars(value.data(), value.data() + value.size(), id);
+    return id;
+}
+
+ReplayHttpClient::Clock::duration percentile(
+    const std::vector<ReplayHttpClient::Clock::duration>& sorted,
+    const double fraction) {
+    if (sorted.empty()) {
+        return {};
+    }
+    const auto rank = static_cast<size_t>(
+        std::ceil(fraction * static_cast<double>(sorted.size())));
+    return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+}
+
+double toMillis(const ReplayHttpClient::Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+}  // namespace
+
+double ReplayHttpClient::Report::updatesPerSecond() const {
+    const double seconds = std::chrono::duration<double>(elapsed).count();
+    return seconds > 0 ? static_cast<double>(updates) / seconds : 0;
+}
+
+ReplayHttpClient::ReplayHttpClient(const std::filesystem::path& file,
+                                   const double speed,
+                                   FinishedCallback onFinished)
+    : speed_(speed), onFinished_(std::move(onFinished)) {
+    std::ifstream in(file);
+    std::string line;
+    size_t lineNumber = 0;
+
+    if (!in) {
+        LOG(ERROR) << "Cannot open replay file " << file;
+        return;
+    }
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        rapidjson::Document update;
+        update.Parse(line.c_str());
+        if (update.HasParseError() || !update.IsObject()) {
+            LOG(WARNING) << "Skipping line " << lineNumber << " of " << file
+                         << ", it is not an Update";
+            continue;
+        }
+        int64_t date = 0;
+        if (const auto* message = messageOf(update);
+            message != nullptr && message->HasMember("date") &&
+            (*message)["date"].IsInt64()) {
+            date = (*message)["date"].GetInt64();
+        }
+        updates_.push_back({std::move(line), date});
+    }
+    LOG(INFO) << "Replaying " << updates_.size() << " updates from " << file;
+    if (speed_ > 0) {
+        LOG(INFO) << "At " << speed_ << " times their recorded pace";
+    } else {
+        LOG(INFO) << "As fast as the bot takes them";
+    }
+}
+
+std::string ReplayHttpClient::makeRequest(
+    const TgBot::Url& url, const std::vector<TgBot::HttpReqArg>& args) const {
+    // Downloads are under /file/bot<token>/, methods under /bot<token>/
+    const bool download = url.path.starts_with("/file/");
+    const auto method = url.path.substr(url.path.rfind('/') + 1);
+
+    if (!download && method == "getUpdates") {
+        return nextUpdates();
+    }
+    const auto start = Clock::now();
+    auto response =
+        download ? std::string() : okResponse(fakeResult(method, args));
+    const auto latency = Clock::now() - start;
+    {
+        const std::lock_guard<std::mutex> lock(callsMutex_);
+        calls_[download ? "downloadFile" : method].emplace_back(latency);
+    }
+    return response;
+}
+
+std::string ReplayHttpClient::nextUpdates() const {
+    const auto now = Clock::now();
+
+    if (next_ == 0) {
+        start_ = now;
+    } else if (next_ <= updates_.size()) {
+        latencies_.emplace_back(now - lastServed_);
+    }
+    if (next_ >= updates_.size()) {
+        if (next_++ == updates_.size()) {
+            Report report;
+            auto sorted = latencies_;
+            std::ranges::sort(sorted);
+            report.updates = updates_.size();
+            report.elapsed = now - start_;
+            report.p50 = percentile(sorted, 0.5);
+            report.p99 = percentile(sorted, 0.99);
+            report.max = sorted.empty() ? Clock::duration{} : sorted.back();
+            {
+                const std::lock_guard<std::mutex> lock(callsMutex_);
+                for (const auto& [method, latencies] : calls_) {
+                    auto sortedCalls = latencies;
+                    std::ranges::sort(sortedCalls);
+                    report.calls[method] = {sortedCalls.size(),
+                                            percentile(sortedCalls, 0.5),
+                                            percentile(sortedCalls, 0.99),
+                                            sortedCalls.back()};
+                }
+            }
+            onFinished_(report);
+        } else {
+            // Like a long poll with nothing new, without spinning
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+        return okResponse("[]");
+    }
+
+    const auto& recorded = updates_[next_];
+    const auto first = updates_.front().date;
+    if (speed_ > 0 && first != 0 && recorded.date != 0) {
+        const std::chrono::duration<double> offset(
+            static_cast<double>(recorded.date - first) / speed_);
+        std::this_thread::sleep_until(
+            start_ + std::chrono::duration_cast<Clock::duration>(offset));
+    }
+
+    rapidjson::Document update;
+    update.Parse(recorded.json.c_str());
+    // In order, whatever they were when recorded
+    rapidjson::Value updateId(static_cast<int64_t>(next_) + 1);
+    update.RemoveMember("update_id");
+    update.AddMember("update_id", updateId, update.GetAllocator());
+    if (auto* message = messageOf(update);
+        message != nullptr && message->HasMember("date")) {
+        (*message)["date"].SetInt64(nowSeconds());
+    }
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    update.Accept(writer);
+
+    ++next_;
+    lastServed_ = Clock::now();
+    return okResponse("[" + std::string(buffer.GetString()) + "]");
+}
+
+std::string ReplayHttpClient::fakeResult(
+    const std::string& method,
+    const std::vector<TgBot::HttpReqArg>& args) const {
+    const auto message = [&] {
+        rapidjson::StringBuffer buffer;
+        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+        const auto text = argOf(args, "text");
+        writer.StartObject();
+        writer.Key("message_id");
+        writer.Int(nextMessageId_++);
+        writer.Key("date");
+        writer.Int64(nowSeconds());
+        writer.Key("chat");
+        writer.StartObject();
+        writer.Key("id");
+        writer.Int64(chatIdOf(args));
+        writer.Key("type");
+        writer.String("supergroup");
+        writer.EndObject();
+        writer.Key("from");
+        writer.StartObject();
+        writer.Key("id");
+        writer.Int64(1);
+        writer.Key("is_bot");
+        writer.Bool(true);
+        writer.Key("first_name");
+        writer.String("Replay");
+        writer.EndObject();
+        if (!text.empty()) {
+            writer.Key("text");
+            writer.String(text.c_str(),
+                          static_cast<rapidjson::SizeType>(text.size()));
+        }
+        writer.EndObject();
+        return std::string(buffer.GetString());
+    };
+
+    if (method == "getMe") {
+        return R"({"id":1,"is_bot":true,"first_name":"Replay",)"
+               R"("username":"replay_bot"})";
+    }
+    if (method == "getChat") {
+        return R"({"id":)" + std::to_string(chatIdOf(args)) +
+               R"(,"type":"supergroup","title":"Replay"})";
+    }
+    if (method == "getFile") {
+        return R"({"file_id":"replay","file_unique_id":"replay",)"
+               R"("file_size":0,"file_path":"replay"})";
+    }
+    if (method == "copyMessage") {
+        return R"({"message_id":)" + std::to_string(nextMessageId_++) + "}";
+    }
+    if (method == "sendMediaGroup") {
+        return "[" + message() + "]";
+    }
+    if (method.starts_with("send") || method.starts_with("edit") ||
+        method == "forwardMessage") {
+        return message();
+    }
+    if (std::ranges::find(kListMethods, method) != kListMethods.end()) {
+        return "[]";
+    }
+    return "true";
+}
+
+std::ostream& operator<<(std::ostream& out,
+                         const ReplayHttpClient::Report& report) {
+    out << "Replayed " << report.updates << " updates in " << std::fixed
+        << std::setprecision(2)
+        << std::chrono::duration<double>(report.elapsed).count() << "s, "
+        << report.updatesPerSecond() << " updates/s. Latency p50 "
+        << toMillis(report.p50) << "ms, p99 " << toMillis(report.p99)
+        << "ms, max " << toMillis(report.max) << "ms. API calls:";
+    for (const auto& [method, calls] : report.calls) {
+        out << ' ' << method << '=' << calls.count << " (p50 "
+            << toMillis(calls.p50) << "ms, p99 " << toMillis(calls.p99)
+            << "ms)";
+    }
+    return out;
+}
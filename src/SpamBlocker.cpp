@@ -7,7 +7,9 @@
 #include <internal/_tgbot.h>
 #include <tgbot/types/Chat.h>
 
+#include <ApiScheduler.hpp>
 #include <InstanceClassBase.hpp>
+#include <Metrics.hpp>
 #include <algorithm>
 #include <memory>
 #include <mutex>
@@ -15,7 +17,6 @@
 #include "ManagedThreads.hpp"
 #include "Types.h"
 
-using std::chrono_literals::operator""s;
 using TgBot::ChatPermissions;
 
 template <class Container, class Type>
@@ -63,6 +64,9 @@ bool SpamBlockBase::isEntryOverThreshold(PerChatHandle::const_reference t,
 
 void SpamBlockBase::_logSpamDetectCommon(PerChatHandle::const_reference t,
                                          const char *name) {
+    static auto &detected = Metrics::counter(
+        "tgbot_spam_detected_total", "Users caught by the spam filters");
+    detected.add();
     LOG(INFO) << "Spam detected for user " << UserPtr_toString(t.first)
               << ", filtered by " << name;
 }
@@ -107,33 +111,37 @@ void SpamBlockBase::spamDetectFunc(OneChatIterator handle) {
     takeAction(handle, MaxMsgMap, sMaxMsgThreshold, "MaxMsg");
 }
 
+void SpamBlockBase::run() {
+    runPeriodic(kScanInterval, [this] {
+        runFunction();
+        return true;
+    });
+}
+
 void SpamBlockBase::runFunction() {
-    while (kRun) {
-        {
-            const std::lock_guard<std::mutex> _(buffer_m);
-            if (buffer_sub.size() > 0) {
-                auto its = buffer_sub.begin();
-                const CStringLifetime chatName = ChatPtr_toString(its->first);
-                while (its != buffer_sub.end()) {
-                    const auto it = findChatIt(
-                        buffer, [](const auto &it) { return it.first; },
-                        its->first);
-                    if (it == buffer.end()) {
-                        its = buffer_sub.erase(its);
-                        continue;
-                    }
-                    if (its->second >= sSpamDetectThreshold) {
-                        LOG(INFO) << "Launching spamdetect for chat "
-                                  << std::quoted(chatName.get());
-                        spamDetectFunc(it);
-                    }
-                    buffer.erase(it);
-                    its->second = 0;
-                    ++its;
-                }
+    static auto &latency = Metrics::histogram(
+        "tgbot_spam_scan_seconds", "Time spent scanning buffered messages");
+    const Metrics::ScopedTimer timer(latency);
+    const std::lock_guard<std::mutex> _(buffer_m);
+    if (buffer_sub.size() > 0) {
+        auto its = buffer_sub.begin();
+        const CStringLifetime chatName = ChatPtr_toString(its->first);
+        while (its != buffer_sub.end()) {
+            const auto it = findChatIt(
+                buffer, [](const auto &it) { return it.first; }, its->first);
+            if (it == buffer.end()) {
+                its = buffer_sub.erase(its);
+                continue;
+            }
+            if (its->second >= sSpamDetectThreshold) {
+                LOG(INFO) << "Launching spamdetect for chat "
+                          << std::quoted(chatName.get());
+                spamDetectFunc(it);
             }
+            buffer.erase(it);
+            its->second = 0;
+            ++its;
         }
-        delayUnlessStop(10s);
     }
 }
 
@@ -227,35 +235,47 @@ void SpamBlockManager::_deleteAndMuteCommon(const OneChatIterator &handle,
                                             const char *name, const bool mute) {
     // Initial set - all false set
     static auto perms = std::make_shared<ChatPermissions>();
+    static auto &mutes =
+        Metrics::counter("tgbot_spam_mutes_total", "Spammers muted");
     if (isEntryOverThreshold(t, threshold)) {
         const CStringLifetime userstr = UserPtr_toString(t.first);
         const CStringLifetime chatstr = ChatPtr_toString(handle->first);
 
         _logSpamDetectCommon(t, name);
 
-        bot_sendMessage(_bot, handle->first->id,
-                        "Spam detected @" + t.first->username);
+        // Queued, the scan doesn't wait for them
+        const auto scheduler = ApiScheduler::getInstance();
+        const ChatId chatId = handle->first->id;
+        const std::string text = "Spam detected @" + t.first->username;
+        scheduler->submit(
+            chatId, ApiScheduler::logged("send spam warning",
+                                         [&bot = _bot, chatId, text] {
+                                             bot.getApi().sendMessage(chatId,
+                                                                      text);
+                                         }));
         std::vector<MessageId> message_ids;
         std::ranges::for_each(t.second, [&message_ids](auto &&messageIn) {
             message_ids.emplace_back(messageIn->messageId);
         });
-        try {
-            _bot.getApi().deleteMessages(handle->first->id, message_ids);
-        } catch (const TgBot::TgException &e) {
-            DLOG(INFO) << "Error deleting message: " << e.what();
-        }
+        scheduler->submit(
+            chatId, ApiScheduler::logged(
+                        "delete spam", [&bot = _bot, chatId, message_ids] {
+                            bot.getApi().deleteMessages(chatId, message_ids);
+                        }));
         if (mute) {
+            mutes.add();
             LOG(INFO) << "Try mute user " << userstr.get() << " in chat "
                       << chatstr.get();
-            try {
-                _bot.getApi().restrictChatMember(
-                    handle->first->id, t.first->id, perms,
-                    to_secs(kMuteDuration).count());
-            } catch (const TgBot::TgException &e) {
-                LOG(WARNING)
-                    << "Cannot mute user " << userstr.get() << " in chat "
-                    << chatstr.get() << ": " << e.what();
-            }
+            scheduler->submit(
+                chatId,
+                ApiScheduler::logged(
+                    std::string("mute user ") + userstr.get() + " in chat " +
+                        chatstr.get(),
+                    [&bot = _bot, chatId, userId = t.first->id] {
+                        bot.getApi().restrictChatMember(
+                            chatId, userId, perms,
+                            to_secs(kMuteDuration).count());
+                    }));
         }
     }
 }
@@ -265,8 +285,8 @@ void SpamBlockManager::doInitCall() {
         [](const Bot &bot, const Message::Ptr &message) {
             static auto spamMgr =
                 ThreadManager::getInstance()
-                    ->createController<ThreadManager::Usage::SPAMBLOCK_THREAD,
-                                       SpamBlockManager>(std::cref(bot));
+                    ->createController<ThreadManager::Usage::SPAMBLOCK_THREAD>(
+                        std::cref(bot));
             spamMgr->addMessage(message);
         });
 }
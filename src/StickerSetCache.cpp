@@ -0,0 +1,131 @@
+#include <StickerSetCache.hpp>
+#include <absl/log/log.h>
+
+#include <exception>
+#include <utility>
+
+StickerSetCache::StickerSetCache(std::shared_ptr<Source> source,
+                                 Executor executor, Limits limits)
+    : source_(std::move(source)),
+      executor_(std::move(executor)),
+      limits_(limits) {}
+
+StickerSetCache::SetPtr StickerSetCache::get(const std::string& name) {
+    const auto now = Clock::now();
+    SetPtr cached;
+    bool stale = false;
+    std::promise<SetPtr> fetched;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        auto it = sets_.find(name);
+        if (it != sets_.end() && now - it->second.fetched < limits_.maxAge) {
+            Entry& entry = it->second;
+            lru_.splice(lru_.begin(), lru_, entry.lru);
+            ++stats_.hits;
+            if (now - entry.fetched >= limits_.ttl && !entry.refreshing) {
+                entry.refreshing = true;
+                ++stats_.staleHits;
+                stale = true;
+            }
+            cached = entry.set;
+        } else {
+            ++stats_.misses;
+            if (auto it = fetching_.find(name); it != fetching_.end()) {
+                ++stats_.sharedMisses;
+                const auto fetching = it->second;
+                lock.unlock();
+                return fetching.get();
+            }
+            fetching_.emplace(name, fetched.get_future().share());
+        }
+    }
+    if (cached) {
+        if (stale) {
+            // Ends the refresh when the task is destroyed, whether it was
+            // run or dropped, so a later hit can start another one
+            const std::shared_ptr<const std::string> pending(
+                new std::string(name), [this](const std::string* name) {
+                    endRefresh(*name);
+                    delete name;
+                });
+            try {
+                executor_([this, pending] { refresh(*pending); });
+            } catch (const std::exception& e) {
+                LOG(WARNING) << "Cannot refresh sticker set " << name << ": "
+                             << e.what();
+            }
+        }
+        return cached;
+    }
+
+    // Not under the lock, a failure here is the caller's to report, and
+    // the waiters'
+    SetPtr set;
+    try {
+        set = std::make_shared<const Set>(source_->fetch(name));
+    } catch (...) {
+        {
+            const std::lock_guard<std::mutex> lock(mutex_);
+            fetching_.erase(name);
+        }
+        fetched.set_exception(std::current_exception());
+        throw;
+    }
+    {
+        const std::lock_guard<std::mutex> lock(mutex_);
+        storeLocked(name, set);
+        fetching_.erase(name);
+    }
+    fetched.set_value(set);
+    return set;
+}
+
+StickerSetCache::Stats StickerSetCache::stats() const {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void StickerSetCache::refresh(const std::string& name) {
+    SetPtr set;
+    try {
+        set = std::make_shared<const Set>(source_->fetch(name));
+    } catch (const std::exception& e) {
+        LOG(WARNING) << "Cannot refresh sticker set " << name << ": "
+                     << e.what();
+    } catch (...) {
+        LOG(WARNING) << "Cannot refresh sticker set " << name;
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    ++stats_.refreshes;
+    if (set) {
+        storeLocked(name, std::move(set));
+    } else {
+        // Served as it is until the next stale hit tries again
+        ++stats_.failures;
+    }
+}
+
+void StickerSetCache::endRefresh(const std::string& name) {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    if (auto it = sets_.find(name); it != sets_.end()) {
+        it->second.refreshing = false;
+    }
+}
+
+void StickerSetCache::storeLocked(const std::string& name, SetPtr set) {
+    const auto now = Clock::now();
+    if (auto it = sets_.find(name); it != sets_.end()) {
+        it->second.set = std::move(set);
+        it->second.fetched = now;
+        it->second.refreshing = false;
+        lru_.splice(lru_.begin(), lru_, it->second.lru);
+        return;
+    }
+    lru_.emplace_front(name);
+    sets_.emplace(name, Entry{std::move(set), now, false, lru_.begin()});
+    while (sets_.size() > limits_.maxSets) {
+        sets_.erase(lru_.back());
+        lru_.pop_back();
+    }
+}
@@ -1,29 +1,41 @@
 #include <ManagedThreads.hpp>
-#include <mutex>
+#include <timer_wheel.h>
 
 #include "InstanceClassBase.hpp"
 
-void ThreadManager::destroyController(const Usage usage, bool deleteIt) {
-    static std::array<std::mutex, static_cast<int>(Usage::MAX)> kPerUsageLocks;
-    const std::scoped_lock lk(kPerUsageLocks[static_cast<int>(usage)], mControllerLock);
-    auto it = kControllers.find(usage);
-    if (it != kControllers.end() && it->second) {
-        DLOG(INFO) << "Stopping: " << it->second->mgr_priv.usage.str
+void ThreadManager::destroyController(const Usage usage) {
+    // Whoever takes it out of the slot stops it, so it's stopped only once
+    auto ctrl = kControllers[static_cast<size_t>(usage)].exchange(nullptr);
+    if (ctrl) {
+        DLOG(INFO) << "Stopping: " << ctrl->mgr_priv.usage.str
                    << " controller";
-        it->second->stop();
-        it->second.reset();
-        if (deleteIt) kControllers.erase(it);
+        ctrl->stop();
         DLOG(INFO) << "Stopped!";
     }
 }
 
 void ThreadManager::destroyManager() {
-    std::unique_lock<std::shared_mutex> lk(mControllerLock);
-    std::ranges::for_each(kControllers, [this, &lk](const auto& e) {
-        lk.unlock();
-        destroyController(e.first, false);
-        lk.lock();
-    });
+    kIsUnderStopAll = true;
+    for (size_t i = 0; i < kControllers.size(); ++i) {
+        destroyController(static_cast<Usage>(i));
+    }
+    kTimers.stop();
+}
+
+extern "C" {
+
+timer_wheel_id_t timer_wheel_schedule(const uint32_t delay_ms,
+                                      timer_wheel_callback_t callback,
+                                      void *arg) {
+    return ThreadManager::getInstance()->timers().schedule(
+        std::chrono::milliseconds(delay_ms),
+        [callback, arg] { callback(arg); });
 }
 
-DECLARE_CLASS_INST(ThreadManager);
\ No newline at end of file
+bool timer_wheel_cancel(const timer_wheel_id_t id) {
+    return ThreadManager::getInstance()->timers().cancel(id);
+}
+
+}  // extern "C"
+
+DECLARE_CLASS_INST(ThreadManager);
@@ -4,10 +4,13 @@
 #include <internal/_std_chrono_templates.h>
 #include <internal/_tgbot.h>
 
+#include <ApiScheduler.hpp>
 #include <ManagedThreads.hpp>
 #include <MessageWrapper.hpp>
 #include <chrono>
 #include <cmath>
+#include <exception>
+#include <utility>
 
 bool TimerCommandManager::parseTimerArguments(const Bot &bot,
                                               const Message::Ptr &message,
@@ -36,10 +39,6 @@ bool TimerCommandManager::parseTimerArguments(const Bot &bot,
         wrapper.sendMessageOnExit("Send or reply to a time, in hhmmss format");
         return false;
     }
-    if (isactive) {
-        wrapper.sendMessageOnExit("Timer is already running");
-        return false;
-    }
     const char *c_str = msg.c_str();
     std::vector<int> numbercache;
     for (size_t i = 0; i <= msg.size(); i++) {
@@ -124,65 +123,102 @@ bool TimerCommandManager::parseTimerArguments(const Bot &bot,
     return true;
 }
 
-void TimerCommandManager::TimerThreadFn(const Bot &bot, Message::Ptr message,
-                                        std::chrono::seconds timer) {
-    isactive = true;
-    while (timer > 0s && kRun) {
-        std::this_thread::sleep_for(1s);
-        if (timer.count() % TIMER_CONFIG_SEC == 0) {
-            bot_editMessage(bot, message, to_string(timer));
+namespace {
+
+// Sends the timers' requests with the bot, errors are only logged
+struct BotTimerApi : ChatTimers::Api {
+    explicit BotTimerApi(const Bot &bot) : bot(bot) {}
+
+    MessageId sendMessage(ChatId chat, const std::string &text) override {
+        try {
+            return bot_sendMessage(bot, chat, text)->messageId;
+        } catch (const std::exception &e) {
+            LOG(WARNING) << "Cannot send timer message: " << e.what();
+            return 0;
         }
-        timer -= 1s;
     }
-    bot_editMessage(bot, message, "Timer ended");
-    if (sendendmsg) {
-        bot_sendMessage(bot, message->chat->id, "Timer ended");
+    bool pinMessage(ChatId chat, MessageId message) override {
+        try {
+            ApiScheduler::getInstance()
+                ->submit(chat,
+                         [&] { bot.getApi().pinChatMessage(chat, message); })
+                .get();
+            return true;
+        } catch (const std::exception &e) {
+            LOG(WARNING) << "Cannot pin timer message: " << e.what();
+            return false;
+        }
+    }
+
+    // Queued without waiting, the wheel's thread must not block on them
+    void announce(ChatId chat, const std::string &text) override {
+        ApiScheduler::getInstance()->submit(
+            chat, ApiScheduler::logged("send timer message",
+                                       [&bot = bot, chat, text] {
+                                           bot.getApi().sendMessage(chat, text);
+                                       }));
+    }
+    void editMessage(ChatId chat, MessageId message,
+                     const std::string &text) override {
+        ApiScheduler::getInstance()->edit(
+            chat, message,
+            ApiScheduler::logged(
+                "edit timer message", [&bot = bot, chat, message, text] {
+                    return bot.getApi().editMessageText(text, chat, message);
+                }));
     }
-    if (botcanpin) {
-        bot.getApi().unpinChatMessage(message->chat->id, message->messageId);
+    void unpinMessage(ChatId chat, MessageId message) override {
+        ApiScheduler::getInstance()->submit(
+            chat, ApiScheduler::logged(
+                      "unpin timer message", [&bot = bot, chat, message] {
+                          bot.getApi().unpinChatMessage(chat, message);
+                      }));
     }
-    isactive = false;
+
+    const Bot &bot;
+};
+
+}  // namespace
+
+ChatTimers &TimerCommandManager::getTimers(const Bot &bot) {
+    std::call_once(timersOnce, [this, &bot] {
+        ChatTimers::Limits limits;
+        limits.editInterval = std::chrono::seconds(TIMER_CONFIG_SEC);
+        timers = std::make_unique<ChatTimers>(
+            std::make_shared<BotTimerApi>(bot),
+            ThreadManager::getInstance()->timers(), limits);
+    });
+    return *timers;
 }
 
 void TimerCommandManager::startTimer(const Bot &bot, const Message::Ptr &msg) {
     std::chrono::seconds parsedTime(0);
 
-    if (parseTimerArguments(bot, msg, parsedTime)) {
-        message = bot_sendMessage(bot, msg->chat->id,
-                                  "Timer starting: " + to_string(parsedTime));
-        botcanpin = true;
-        try {
-            bot.getApi().pinChatMessage(message->chat->id, message->messageId);
-        } catch (const TgBot::TgException &) {
-            LOG(WARNING) << "Cannot pin msg!";
-            botcanpin = false;
-        }
-        setPreStopFunction(TimerCommandManager::Timerstop);
-        runWith([this, capture0 = std::cref(bot), parsedTime] {
-            TimerThreadFn(capture0, message, parsedTime);
-        });
+    if (!parseTimerArguments(bot, msg, parsedTime)) {
+        return;
+    }
+    switch (getTimers(bot).start(msg->chat->id, parsedTime)) {
+        case ChatTimers::StartResult::kStarted:
+        case ChatTimers::StartResult::kStopped:
+            break;
+        case ChatTimers::StartResult::kAlreadyRunning:
+            bot_sendReplyMessage(bot, msg, "Timer is already running");
+            break;
+        case ChatTimers::StartResult::kTooManyTimers:
+            bot_sendReplyMessage(bot, msg, "Too many timers running");
+            break;
+        case ChatTimers::StartResult::kFailed:
+            bot_sendReplyMessage(bot, msg, "Cannot start timer");
+            break;
     }
 }
 
 void TimerCommandManager::stopTimer(const Bot &bot, const Message::Ptr &msg) {
     std::string text;
-    if (isactive) {
-        const bool allowed = message->chat == msg->chat;
-        sendendmsg = !allowed;
-        if (allowed) {
-            stop();
-            text = "Stopped successfully";
-        } else {
-            text = "Timer is running on other group.";
-        }
+    if (getTimers(bot).stop(msg->chat->id)) {
+        text = "Stopped successfully";
     } else {
         text = "Timer is not running";
     }
     bot_sendReplyMessage(bot, msg, text);
 }
-
-void TimerCommandManager::Timerstop(ManagedThread *thiz) {
-    if (dynamic_cast<TimerCommandManager *>(thiz)->isactive) {
-        LOG(INFO) << "Canceling timer and cleaning up...";
-    }
-}
@@ -0,0 +1,272 @@
+#include <TimerWheel.hpp>
+#include <absl/log/log.h>
+
+#include <algorithm>
+#include <bit>
+#include <exception>
+#include <utility>
+
+namespace {
+
+constexpr int levelShift(const int level) {
+    return TimerWheel::kSlotBits * level;
+}
+
+// Ticks covered by the whole wheel
+constexpr uint64_t kWheelSpan = uint64_t{1}
+                                << levelShift(TimerWheel::kLevels);
+
+}  // namespace
+
+TimerWheel::TimerWheel() : epoch_(Clock::now()) {}
+
+TimerWheel::~TimerWheel() { stop(); }
+
+TimerWheel::TimerId TimerWheel::schedule(const std::chrono::milliseconds delay,
+                                         Callback fn) {
+    return add(std::max<int64_t>(delay.count(), 0), 0,
+               [fn = std::move(fn)] {
+                   fn();
+                   return false;
+               });
+}
+
+TimerWheel::TimerId TimerWheel::schedulePeriodic(
+    const std::chrono::milliseconds period, PeriodicCallback fn) {
+    const uint64_t ticks = std::max<int64_t>(period.count(), 1);
+    return add(ticks, ticks, std::move(fn));
+}
+
+TimerWheel::TimerId TimerWheel::add(const uint64_t delayTicks,
+                                    const uint64_t periodTicks,
+                                    PeriodicCallback fn) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) {
+        LOG(WARNING) << "Timer wheel is stopped, not scheduling";
+        return kInvalidTimer;
+    }
+    if (!thread_.joinable()) {
+        thread_ = std::thread(&TimerWheel::threadFn, this);
+    }
+    auto timer = std::make_unique<Timer>();
+    timer->id = ++nextId_;
+    // Round up, so it never fires early. That also keeps it off the current
+    // tick, which was already processed.
+    timer->expires = std::max(ticksNow() + delayTicks + 1, now_ + 1);
+    timer->period = periodTicks;
+    timer->fn = std::move(fn);
+    link(timer.get());
+    const bool earlier = timer->expires < wakeAt_;
+    const TimerId id = timer->id;
+    timers_.emplace(id, std::move(timer));
+    if (earlier) {
+        wakeup_.notify_one();
+    }
+    return id;
+}
+
+bool TimerWheel::cancel(const TimerId id) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (id == kInvalidTimer) {
+        return false;
+    }
+    if (id == running_) {
+        runningCancelled_ = true;
+        if (std::this_thread::get_id() != thread_.get_id()) {
+            callbackDone_.wait(lock, [this, id] { return running_ != id; });
+        }
+        return true;
+    }
+    auto it = timers_.find(id);
+    if (it == timers_.end()) {
+        return false;
+    }
+    unlink(it->second.get());
+    timers_.erase(it);
+    return true;
+}
+
+void TimerWheel::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+        wakeup_.notify_one();
+    }
+    if (thread_.joinable()) {
+        if (std::this_thread::get_id() == thread_.get_id()) {
+            LOG(ERROR) << "Timer wheel can't be stopped from its own callback";
+            return;
+        }
+        thread_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    levels_ = {};
+    timers_.clear();
+}
+
+size_t TimerWheel::pending() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return timers_.size();
+}
+
+uint64_t TimerWheel::ticksNow() const {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() -
+                                                                 epoch_)
+        .count();
+}
+
+void TimerWheel::link(Timer* timer) {
+    // Only timers moving down from an upper level can be due on now_ itself,
+    // they land in the slot advanceTo() is about to fire.
+    const uint64_t delta = timer->expires - now_;
+    uint64_t expires = timer->expires;
+    int level = 0;
+    while (level < kLevels - 1 && delta >> levelShift(level + 1) != 0) {
+        ++level;
+    }
+    if (delta >= kWheelSpan) {
+        // Too far out, park it in the furthest slot. It comes back up to
+        // the top level from there, until it fits.
+        expires = now_ + kWheelSpan - 1;
+    }
+    const size_t slot = (expires >> levelShift(level)) & (kSlots - 1);
+    auto& wheel = levels_[level];
+
+    timer->level = level;
+    timer->slot = slot;
+    timer->prev = nullptr;
+    timer->next = wheel.heads[slot];
+    if (timer->next != nullptr) {
+        timer->next->prev = timer;
+    }
+    wheel.heads[slot] = timer;
+    wheel.occupied |= uint64_t{1} << slot;
+}
+
+void TimerWheel::unlink(Timer* timer) {
+    if (timer->level < 0) {
+        return;
+    }
+    auto& wheel = levels_[timer->level];
+    if (timer->prev != nullptr) {
+        timer->prev->next = timer->next;
+    } else {
+        wheel.heads[timer->slot] = timer->next;
+    }
+    if (timer->next != nullptr) {
+        timer->next->prev = timer->prev;
+    }
+    if (wheel.heads[timer->slot] == nullptr) {
+        wheel.occupied &= ~(uint64_t{1} << timer->slot);
+    }
+    timer->prev = timer->next = nullptr;
+    timer->level = -1;
+}
+
+bool TimerWheel::nextEvent(uint64_t* tick) const {
+    bool found = false;
+    for (int level = 0; level < kLevels; ++level) {
+        const uint64_t occupied = levels_[level].occupied;
+        if (occupied == 0) {
+            continue;
+        }
+        // A slot is handled when the tick reaches its start. Slots are
+        // relative to the current one, the next slot is the closest.
+        const int shift = levelShift(level);
+        const uint64_t base = (now_ >> shift) + 1;
+        const auto ahead = static_cast<uint64_t>(
+            std::countr_zero(std::rotr(occupied, static_cast<int>(base))));
+        const uint64_t event = (base + ahead) << shift;
+        if (!found || event < *tick) {
+            *tick = event;
+            found = true;
+        }
+    }
+    return found;
+}
+
+void TimerWheel::advanceTo(const uint64_t tick, std::vector<TimerId>* due) {
+    now_ = tick;
+    // Upper levels first, they may move timers into the lower slots handled
+    // on this same tick.
+    for (int level = kLevels - 1; level > 0; --level) {
+        const int shift = levelShift(level);
+        if ((tick & ((uint64_t{1} << shift) - 1)) != 0) {
+            continue;
+        }
+        auto& wheel = levels_[level];
+        const size_t slot = (tick >> shift) & (kSlots - 1);
+        Timer* timer = std::exchange(wheel.heads[slot], nullptr);
+        wheel.occupied &= ~(uint64_t{1} << slot);
+        while (timer != nullptr) {
+            Timer* next = timer->next;
+            link(timer);
+            timer = next;
+        }
+    }
+    auto& wheel = levels_[0];
+    const size_t slot = tick & (kSlots - 1);
+    Timer* timer = std::exchange(wheel.heads[slot], nullptr);
+    wheel.occupied &= ~(uint64_t{1} << slot);
+    while (timer != nullptr) {
+        due->emplace_back(timer->id);
+        timer->level = -1;
+        timer = timer->next;
+    }
+}
+
+void TimerWheel::threadFn() {
+    std::vector<TimerId> due;
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stopped_) {
+        uint64_t tick = 0;
+        if (!nextEvent(&tick)) {
+            wakeAt_ = UINT64_MAX;
+            wakeup_.wait(lock);
+            continue;
+        }
+        if (tick > ticksNow()) {
+            wakeAt_ = tick;
+            wakeup_.wait_until(lock, epoch_ + std::chrono::milliseconds(tick));
+            continue;
+        }
+        wakeAt_ = tick;
+        advanceTo(tick, &due);
+
+        for (const TimerId id : due) {
+            auto it = timers_.find(id);
+            if (stopped_ || it == timers_.end()) {
+                // Cancelled by an earlier callback
+                continue;
+            }
+            Timer* timer = it->second.get();
+            running_ = id;
+            runningCancelled_ = false;
+            lock.unlock();
+            bool again = false;
+            try {
+                again = timer->fn();
+            } catch (const std::exception& e) {
+                // Every other timer shares this thread, keep it running
+                LOG(ERROR) << "Timer " << id << " threw: " << e.what();
+            } catch (...) {
+                LOG(ERROR) << "Timer " << id << " threw";
+            }
+            lock.lock();
+            running_ = kInvalidTimer;
+            if (again && timer->period != 0 && !runningCancelled_ &&
+                !stopped_) {
+                // Skip the runs we're late for, if any
+                const uint64_t late = ticksNow() - timer->expires;
+                timer->expires +=
+                    (late / timer->period + 1) * timer->period;
+                link(timer);
+            } else {
+                timers_.erase(id);
+            }
+            callbackDone_.notify_all();
+        }
+        due.clear();
+    }
+}
@@ -0,0 +1,270 @@
+#include <Tracing.hpp>
+#include <absl/log/log.h>
+
+#include <Metrics.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace Tracing {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t kRingSize = 1024;
+constexpr size_t kMaxName = 39;
+constexpr auto kFlushInterval = std::chrono::seconds(1);
+
+struct Event {
+    std::array<char, kMaxName + 1> name;
+    uint64_t trace;
+    int64_t start;  // In microseconds since the epoch
+    int64_t duration;
+};
+
+// Written by its thread only, read by the writer only
+struct Ring {
+    explicit Ring(const uint32_t tid) : tid(tid) {}
+
+    const uint32_t tid;
+    std::array<Event, kRingSize> events;
+    std::atomic<size_t> head = 0;  // Next to write
+    std::atomic<size_t> tail = 0;  // Next to read
+    std::atomic<bool> exited = false;
+};
+
+struct Rings {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Ring>> list;
+    uint32_t nextTid = 1;
+};
+
+struct Writer {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::thread thread;
+    bool running = false;
+    bool stopping = false;
+    std::ofstream file;
+    bool first = true;
+};
+
+// Both never destroyed, threads may end spans while the process exits
+Rings& rings() {
+    static auto* rings = new Rings();
+    return *rings;
+}
+
+Writer& writer() {
+    static auto* writer = new Writer();
+    return *writer;
+}
+
+const Clock::time_point kEpoch = Clock::now();
+std::atomic<double> currentRate = 0;
+std::atomic<uint64_t> nextTrace = 1;
+
+// Marks the thread's ring for removal once it is written
+struct RingHolder {
+    ~RingHolder() {
+        if (ring) {
+            ring->exited.store(true, std::memory_order_release);
+        }
+    }
+    std::shared_ptr<Ring> ring;
+};
+
+struct Root {
+    std::string_view name;
+    Clock::time_point start;
+};
+
+thread_local Context threadContext;
+thread_local Root threadRoot;
+thread_local RingHolder holder;
+
+Ring& threadRing() {
+    if (!holder.ring) {
+        auto& all = rings();
+        const std::lock_guard<std::mutex> lock(all.mutex);
+        holder.ring = std::make_shared<Ring>(all.nextTid++);
+        all.list.emplace_back(holder.ring);
+    }
+    return *holder.ring;
+}
+
+int64_t microsSinceEpoch(const Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time -
+                                                                 kEpoch)
+        .count();
+}
+
+void record(const std::string_view name, const uint64_t trace,
+            const Clock::time_point start, const Clock::time_point end) {
+    static auto& dropped = Metrics::counter(
+        "tgbot_trace_spans_dropped_total",
+        "Spans dropped because their thread's buffer was full");
+    auto& ring = threadRing();
+    const size_t head = ring.head.load(std::memory_order_relaxed);
+
+    if (head - ring.tail.load(std::memory_order_acquire) == kRingSize) {
+        dropped.add();
+        return;
+    }
+    auto& event = ring.events[head % kRingSize];
+    const size_t length = std::min(name.size(), kMaxName);
+    std::copy_n(name.data(), length, event.name.data());
+    event.name[length] = '\0';
+    event.trace = trace;
+    event.start = microsSinceEpoch(start);
+    event.duration = microsSinceEpoch(end) - event.start;
+    ring.head.store(head + 1, std::memory_order_release);
+}
+
+void writeEvent(Writer& out, const uint32_t tid, const Event& event) {
+    out.file << (out.first ? "" : ",\n") << R"({"name":")";
+    out.first = false;
+    for (const char* c = event.name.data(); *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out.file << '\\';
+        }
+        out.file << (static_cast<unsigned char>(*c) < ' ' ? ' ' : *c);
+    }
+    out.file << R"(","ph":"X","ts":)" << event.start
+             << R"(,"dur":)" << event.duration << R"(,"pid":1,"tid":)" << tid
+             << R"(,"args":{"trace":)" << event.trace << "}}";
+}
+
+// Only called by one thread at a time, the writer or stop()
+void drain(Writer& out) {
+    std::vector<std::shared_ptr<Ring>> list;
+    {
+        auto& all = rings();
+        const std::lock_guard<std::mutex> lock(all.mutex);
+        list = all.list;
+    }
+    for (const auto& ring : list) {
+        // Read first, what it pushed before exiting is written below
+        const bool exited = ring->exited.load(std::memory_order_acquire);
+        const size_t head = ring->head.load(std::memory_order_acquire);
+        size_t tail = ring->tail.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail) {
+            writeEvent(out, ring->tid, ring->events[tail % kRingSize]);
+        }
+        ring->tail.store(tail, std::memory_order_release);
+        if (exited) {
+            auto& all = rings();
+            const std::lock_guard<std::mutex> lock(all.mutex);
+            std::erase(all.list, ring);
+        }
+    }
+    out.file.flush();
+}
+
+void writerThread() {
+    auto& out = writer();
+    std::unique_lock<std::mutex> lock(out.mutex);
+    while (!out.stopping) {
+        out.cv.wait_for(lock, kFlushInterval, [&out] { return out.stopping; });
+        drain(out);
+    }
+}
+
+}  // namespace
+
+bool start(const std::filesystem::path& file, const double sampleRate) {
+    auto& out = writer();
+    const std::lock_guard<std::mutex> lock(out.mutex);
+    if (out.running) {
+        return false;
+    }
+    out.file.open(file, std::ios::trunc);
+    if (!out.file) {
+        LOG(ERROR) << "Cannot open trace file " << file;
+        return false;
+    }
+    // The JSON array format, which may be left unterminated on a crash
+    out.file << "[\n";
+    out.first = true;
+    out.stopping = false;
+    out.running = true;
+    out.thread = std::thread(writerThread);
+    currentRate.store(std::clamp(sampleRate, 0.0, 1.0),
+                      std::memory_order_relaxed);
+    LOG(INFO) << "Tracing " << sampleRate * 100 << "% of updates to " << file;
+    return true;
+}
+
+void stop() {
+    auto& out = writer();
+    currentRate.store(0, std::memory_order_relaxed);
+    {
+        const std::lock_guard<std::mutex> lock(out.mutex);
+        if (!out.running) {
+            return;
+        }
+        out.stopping = true;
+    }
+    out.cv.notify_one();
+    out.thread.join();
+
+    const std::lock_guard<std::mutex> lock(out.mutex);
+    drain(out);
+    out.file << "\n]\n";
+    out.file.close();
+    out.running = false;
+}
+
+void beginTrace(const std::string_view name) {
+    thread_local std::minstd_rand random(std::random_device{}());
+    const double rate = currentRate.load(std::memory_order_relaxed);
+
+    endTrace();
+    if (rate <= 0 ||
+        (rate < 1 && std::uniform_real_distribution<>()(random) >= rate)) {
+        return;
+    }
+    threadContext.trace = nextTrace.fetch_add(1, std::memory_order_relaxed);
+    threadRoot = {name, Clock::now()};
+}
+
+void endTrace() {
+    if (threadContext.trace == 0 || threadRoot.name.empty()) {
+        return;
+    }
+    record(threadRoot.name, threadContext.trace, threadRoot.start,
+           Clock::now());
+    threadContext = {};
+    threadRoot = {};
+}
+
+Context current() { return threadContext; }
+
+Span::Span(const std::string_view name)
+    : name_(name), trace_(threadContext.trace) {
+    if (trace_ != 0) {
+        start_ = Clock::now();
+    }
+}
+
+Span::~Span() {
+    if (trace_ != 0) {
+        record(name_, trace_, start_, Clock::now());
+    }
+}
+
+Resume::Resume(const Context context) : previous_(threadContext) {
+    threadContext = context;
+}
+
+Resume::~Resume() { threadContext = previous_; }
+
+}  // namespace Tracing
@@ -10,7 +10,6 @@ struct CommandModule : TgBot::BotCommand {
     enum Flags { None = 0, Enforced = 1 << 0, HideDescription = 1 << 1 };
     command_callback_t fn;
     unsigned int flags{};
-    bool isLoaded = false;
 
     [[nodiscard]] constexpr bool isEnforced() const {
         return (flags & Enforced) != 0;
@@ -33,7 +32,7 @@ struct CommandModuleManager : BotInitCall {
 
     /**
      * Updates the list of bot commands based on the currently loaded
-     * CommandModules.
+     * CommandModules. The list is sent by BotProfileSync, later.
      * @param bot The Bot instance to update the commands for.
      */
     static void updateBotCommands(const Bot &bot);
@@ -1,6 +1,9 @@
 
+#include <BotProfileSync.hpp>
+#include <CommandRouter.hpp>
 #include <StringResManager.hpp>
 #include <boost/algorithm/string/trim.hpp>
+#include <utility>
 
 #include "CommandModule.h"
 
@@ -16,21 +19,19 @@ std::string CommandModuleManager::getLoadedModulesString() {
     return outbuf;
 }
 
-void CommandModuleManager::updateBotCommands(const Bot &bot) {
-    std::vector<TgBot::BotCommand::Ptr> buffer;
+void CommandModuleManager::updateBotCommands(const Bot & /*bot*/) {
+    const auto router = CommandRouter::getInstance();
+    std::vector<BotProfileSync::Command> commands;
     for (const auto &cmd : loadedModules) {
-        if (!cmd.isHideDescription()) {
-            auto onecommand = std::make_shared<CommandModule>(cmd);
+        if (router->isEnabled(cmd.command).value_or(false) &&
+            !cmd.isHideDescription()) {
+            auto description = cmd.description;
             if (cmd.isEnforced()) {
-                onecommand->description += " " + GETSTR_BRACE(OWNER);
+                description += " " + GETSTR_BRACE(OWNER);
             }
-            buffer.emplace_back(onecommand);
+            commands.push_back({cmd.command, std::move(description)});
         }
     }
-    try {
-        bot.getApi().setMyCommands(buffer);
-    } catch (const TgBot::TgException &e) {
-        LOG(ERROR) << GETSTR_IS(ERROR_UPDATING_BOT_COMMANDS) << e.what()
-                   << std::endl;
-    }
+    // Sent in the background, and only if it changed
+    BotProfileSync::getInstance()->setCommands(std::move(commands));
 }
@@ -27,7 +27,7 @@ static void AliveCommandFn(const Bot& bot, const Message::Ptr message) {
 
     std::call_once(once, [&bot] {
         std::string commandmodules;
-        GitData data;
+        const auto& data = GitData::get();
 
         const std::string modules = cat("commandmodules");
         const std::string commitid = cat("commitid");
@@ -36,7 +36,6 @@ static void AliveCommandFn(const Bot& bot, const Message::Ptr message) {
         const std::string botname = cat("botname");
         const std::string botusername = cat("botusername");
 
-        GitData::Fill(&data);
         version = ResourceManager::getInstance()->getResource("about.html");
 
         boost::replace_all(version, modules,
@@ -1,6 +1,7 @@
+#include <CommandRouter.hpp>
 #include <MessageWrapper.hpp>
-#include <algorithm>
 #include <boost/algorithm/string/split.hpp>
+#include <sstream>
 
 #include "BotAddCommand.h"
 #include "BotReplyMessage.h"
@@ -10,37 +11,52 @@
 
 namespace {
 void handle_reload(Bot& bot, MessageWrapper& wrapper, std::string command) {
-    auto it = std::ranges::find_if(
-        CommandModuleManager::loadedModules,
-        [&command](const CommandModule& e) { return e.command == command; });
-    if (it == CommandModuleManager::loadedModules.end()) {
+    const auto router = CommandRouter::getInstance();
+    const auto enabled = router->isEnabled(command);
+    if (!enabled) {
         wrapper.sendMessageOnExit("Command not found to reload");
         return;
     }
-    if (it->isLoaded) {
+    if (*enabled) {
         wrapper.sendMessageOnExit("Command already loaded");
         return;
     }
-    bot_AddCommand(bot, it->command, it->fn, it->isEnforced());
+    router->setEnabled(command, true);
+    CommandModuleManager::updateBotCommands(bot);
     wrapper.sendMessageOnExit("Command reloaded");
 }
 
 void handle_unload(Bot& bot, MessageWrapper& wrapper, std::string command) {
-    auto it = std::ranges::find_if(
-        CommandModuleManager::loadedModules,
-        [&command](const CommandModule& e) { return e.command == command; });
-    if (it == CommandModuleManager::loadedModules.end()) {
+    const auto router = CommandRouter::getInstance();
+    const auto enabled = router->isEnabled(command);
+    if (!enabled) {
         wrapper.sendMessageOnExit("Command not found to unload");
         return;
     }
-    if (!it->isLoaded) {
+    if (!*enabled) {
         wrapper.sendMessageOnExit("Command not loaded");
         return;
     }
-    bot_RemoveCommand(bot, it->command);
-    it->isLoaded = false;
+    router->setEnabled(command, false);
+    CommandModuleManager::updateBotCommands(bot);
     wrapper.sendMessageOnExit("Command unloaded");
 }
+
+void handle_stats(MessageWrapper& wrapper, const std::string& command) {
+    const auto stats = CommandRouter::getInstance()->stats(command);
+    if (!stats) {
+        wrapper.sendMessageOnExit("Command not found");
+        return;
+    }
+    std::stringstream ss;
+    ss << "/" << stats->command << (stats->enabled ? "" : " (unloaded)")
+       << ": " << stats->calls << " calls, " << stats->denied << " denied";
+    if (stats->calls > stats->denied) {
+        ss << ", " << stats->time.count() / (stats->calls - stats->denied)
+           << "us on average";
+    }
+    wrapper.sendMessageOnExit(ss.str());
+}
 }  // namespace
 
 void CmdCommandFn(Bot& bot, const TgBot::Message::Ptr& message) {
@@ -50,7 +66,8 @@ void CmdCommandFn(Bot& bot, const TgBot::Message::Ptr& message) {
 
         boost::split(args, wrapper.getExtraText(), isWhitespace);
         if (args.size() != 2) {
-            wrapper.sendMessageOnExit("Usage: /cmd <command> <reload|unload>");
+            wrapper.sendMessageOnExit(
+                "Usage: /cmd <command> <reload|unload|stats>");
             return;
         }
         const auto& command = args[0];
@@ -59,6 +76,8 @@ void CmdCommandFn(Bot& bot, const TgBot::Message::Ptr& message) {
             handle_reload(bot, wrapper, command);
         } else if (action == "unload") {
             handle_unload(bot, wrapper, command);
+        } else if (action == "stats") {
+            handle_stats(wrapper, command);
         } else {
             wrapper.sendMessageOnExit(GETSTR_IS(UNKNOWN_ACTION) + action);
         }
@@ -67,7 +86,7 @@ void CmdCommandFn(Bot& bot, const TgBot::Message::Ptr& message) {
 
 void loadcmd_cmd(CommandModule& module) {
     module.command = "cmd";
-    module.description = "unload/reload a command";
+    module.description = "unload/reload a command, or show its stats";
     module.flags = CommandModule::Flags::Enforced;
     module.fn = CmdCommandFn;
 }
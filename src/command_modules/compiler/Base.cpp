@@ -4,6 +4,8 @@
 
 #include <DurationPoint.hpp>
 #include <StringResManager.hpp>
+#include <algorithm>
+#include <atomic>
 #include <boost/algorithm/string/replace.hpp>
 #include <boost/algorithm/string/trim.hpp>
 #include <chrono>
@@ -13,17 +15,21 @@
 #include <libos/libfs.hpp>
 #include <mutex>
 #include <ostream>
-#include <thread>
 
 #include "CompilerInTelegram.h"
 #include "StringToolsExt.hpp"
 #include "popen_wdt/popen_wdt.h"
 
-using std::chrono_literals::operator""ms;
 using std::chrono::duration_cast;
 using std::chrono::high_resolution_clock;
 using std::chrono::milliseconds;
 
+namespace {
+// popen_watchdog_read() returns what is there, up to that much at once
+constexpr size_t kReadChunk = 4096;
+constexpr uint64_t kCompileCacheBytes = 64 << 20;
+}  // namespace
+
 void CompilerInTg::appendExtArgs(std::stringstream &cmd,
                                  std::string extraargs_in,
                                  std::stringstream &result_out) {
@@ -39,10 +45,18 @@ void CompilerInTg::appendExtArgs(std::stringstream &cmd,
 
 void CompilerInTg::runCommand(const Message::Ptr &message, std::string cmd,
                               std::stringstream &res, bool use_wdt) {
-    bool hasmore = false;
-    int count = 0;
-    std::array<char, BASH_READ_BUF> buf = {};
-    size_t buf_len = 0;
+    const auto result = executeCommand(message, std::move(cmd), use_wdt);
+    if (result.started) {
+        formatResult(res, result);
+    }
+}
+
+CompilerInTg::CommandResult CompilerInTg::executeCommand(
+    const Message::Ptr &message, std::string cmd, bool use_wdt,
+    const std::filesystem::path &workDir) {
+    CommandResult result;
+    std::array<char, kReadChunk> buf = {};
+    int len = 0;
     popen_watchdog_data_t *p_wdt_data = nullptr;
 
     boost::replace_all(cmd, std::string(1, '"'), "\\\"");
@@ -50,45 +64,39 @@ void CompilerInTg::runCommand(const Message::Ptr &message, std::string cmd,
     LOG(INFO) << __func__ << ": +++";
     onFailed(message, ErrorType::START_COMPILER);
     LOG(INFO) << GETSTR_IS(COMMAND) << SingleQuoted(cmd);
+    const auto workDirString = workDir.string();
 
     auto dp = DurationPoint();
 
     if (popen_watchdog_init(&p_wdt_data)) {
         p_wdt_data->command = cmd.c_str();
+        if (!workDir.empty()) {
+            p_wdt_data->working_dir = workDirString.c_str();
+        }
         p_wdt_data->watchdog_enabled = use_wdt;
 
         if (!popen_watchdog_start(&p_wdt_data)) {
             onFailed(message, ErrorType::POPEN_WDT_FAILED);
-            return;
+            return result;
         }
-        while (popen_watchdog_read(&p_wdt_data, buf.data(), buf.size() - 1)) {
-            if (buf_len < BASH_MAX_BUF) {
-                res << buf.data();
-                buf_len += strlen(buf.data());
-            } else {
-                hasmore = true;
+        result.started = true;
+        // Read until it exits, past the cap only to let it finish writing
+        while ((len = popen_watchdog_read(&p_wdt_data, buf.data(),
+                                          buf.size())) > 0) {
+            const size_t room = BASH_MAX_BUF - result.output.size();
+            if (static_cast<size_t>(len) > room) {
+                result.truncated = true;
             }
-            buf.fill(0);
-            count++;
-            std::this_thread::sleep_for(50ms);
-        }
-        if (count == 0) {
-            res << EMPTY << std::endl;
-        }
-        res << std::endl;
-        if (hasmore) {
-            res << "-> " << GETSTR(TRUNCATED) << std::endl;
+            result.output.append(buf.data(), std::min<size_t>(len, room));
         }
 
         if (popen_watchdog_activated(&p_wdt_data)) {
-            res << WDT_BITE_STR;
+            result.timedOut = true;
         } else {
-            double millis =
+            result.seconds =
                 std::chrono::duration_cast<std::chrono::duration<double>>(
                     dp.get())
                     .count();
-            res << "-> It took " << std::fixed << std::setprecision(3) << millis
-                << " seconds" << std::endl;
             if (use_wdt) {
                 popen_watchdog_stop(&p_wdt_data);
             }
@@ -96,6 +104,69 @@ void CompilerInTg::runCommand(const Message::Ptr &message, std::string cmd,
         popen_watchdog_destroy(&p_wdt_data);
         LOG(INFO) << __func__ << ": ---";
     }
+    return result;
+}
+
+void CompilerInTg::formatResult(std::stringstream &res,
+                                const CommandResult &result,
+                                const bool cached) {
+    if (result.output.empty()) {
+        res << EMPTY << std::endl;
+    }
+    res << result.output << std::endl;
+    if (result.truncated) {
+        res << "-> " << GETSTR(TRUNCATED) << std::endl;
+    }
+
+    if (result.timedOut) {
+        res << WDT_BITE_STR;
+    } else if (cached) {
+        res << "-> Cached, from an earlier identical request" << std::endl;
+    } else {
+        res << "-> It took " << std::fixed << std::setprecision(3)
+            << result.seconds << " seconds" << std::endl;
+    }
+}
+
+CompileCache &CompilerInTg::compileCache() {
+    static CompileCache cache = [] {
+        // Not the shared temp directory, anybody could plant binaries there
+        auto directory = ConfigManager::snapshot()->getPath(
+            ConfigManager::Configs::COMPILE_CACHE_DIR);
+        if (!directory) {
+            directory = FS::getPathForType(FS::PathType::HOME) / ".cache" /
+                        "tgbot_compile";
+        }
+        return CompileCache(*directory, kCompileCacheBytes);
+    }();
+    return cache;
+}
+
+CompilerWorkDir::CompilerWorkDir() {
+    static std::atomic_uint counter;
+    const auto root = std::filesystem::temp_directory_path() / "tgbot_compile";
+    const auto stamp = std::chrono::system_clock::now().time_since_epoch();
+    std::error_code ec;
+
+    std::filesystem::create_directories(root, ec);
+    // Other instances of the bot may use the same directory
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        auto dir = root / (std::to_string(stamp.count()) + "-" +
+                           std::to_string(counter++));
+        if (std::filesystem::create_directory(dir, ec)) {
+            path_ = std::move(dir);
+            return;
+        }
+    }
+    LOG(ERROR) << "Cannot create a work directory in " << root << ": "
+               << ec.message();
+}
+
+CompilerWorkDir::~CompilerWorkDir() {
+    std::error_code ec;
+    if (valid()) {
+        std::filesystem::remove_all(path_, ec);
+    }
 }
 
 static std::optional<std::string> findCommandExe(const std::string &command) {
@@ -107,7 +178,8 @@ static std::optional<std::string> findCommandExe(const std::string &command) {
         if (it.has_value()) {
             paths = StringTools::split(it.value(), FS::path_env_delimiter);
         } else {
-            throw std::runtime_error(GETSTR(ERROR_PATH_CANNOT_BE_EMPTY));
+            throw std::runtime_error(
+                std::string(GETSTR(ERROR_PATH_CANNOT_BE_EMPTY)));
         }
     });
     std::filesystem::path exePath(command);
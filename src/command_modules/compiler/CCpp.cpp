@@ -1,6 +1,8 @@
 #include "CompilerInTelegram.h"
 #include <libos/libfs.hpp>
 #include <StringResManager.hpp>
+#include <filesystem>
+#include <optional>
 
 void CompilerInTgForCCppImpl::onResultReady(const Message::Ptr& who,
                                             const std::string& text) {
@@ -13,26 +15,70 @@ void CompilerInTgForCCppImpl::onFailed(const Message::Ptr& who,
 
 void CompilerInTgForCCpp::run(const Message::Ptr& message) {
     std::string extraargs;
+    std::string source;
     std::stringstream cmd, resultbuf;
 #ifdef WINDOWS_BUILD
-    const char aoutname[] = "./a.exe";
+    const char aoutname[] = "a.exe";
 #else
-    const char aoutname[] = "./a.out";
+    const char aoutname[] = "a.out";
 #endif
 
-    if (verifyParseWrite(message, extraargs)) {
-        cmd << cmdPrefix.string() << SPACE << extraargs << SPACE << outfile;
+    if (!verifyParse(message, extraargs, source)) {
+        return;
+    }
+    CompilerWorkDir dir;
+    if (!dir.valid()) {
+        onFailed(message, ErrorType::FILE_WRITE_FAILED);
+        return;
+    }
+    auto& cache = compileCache();
+    const CompileCache::Key key{cmdPrefix.string(), extraargs, source};
+    const auto cached = cache.find(key);
+    const auto aout = dir.path() / aoutname;
+    bool hasBinary = false;
 
-        resultbuf << GETSTR_IS(COMPILE_TIME) << std::endl;
-        runCommand(message, cmd.str(), resultbuf);
-        resultbuf << std::endl;
+    resultbuf << GETSTR_IS(COMPILE_TIME) << std::endl;
+    if (cached) {
+        formatResult(resultbuf,
+                     CommandResult{.output = cached->diagnostics,
+                                   .truncated = cached->diagnosticsTruncated},
+                     true);
+        hasBinary = cached->hasBinary &&
+                    (cached->output || cache.copyBinary(key, aout));
+    } else {
+        if (!writeSource(message, dir, source)) {
+            return;
+        }
+        cmd << cmdPrefix.string() << SPACE << extraargs << SPACE
+            << (dir.path() / outfile).string() << " -o " << aout.string();
+        const auto compiled = executeCommand(message, cmd.str());
+        if (!compiled.started) {
+            return;
+        }
+        formatResult(resultbuf, compiled);
+        hasBinary = std::filesystem::exists(aout);
+        if (!compiled.timedOut) {
+            cache.store(key, compiled.output, compiled.truncated,
+                        hasBinary ? std::optional(aout) : std::nullopt);
+        }
+    }
+    resultbuf << std::endl;
 
-        if (FS::exists(aoutname)) {
-            resultbuf << GETSTR_IS(RUN_TIME) << std::endl;
-            runCommand(message, aoutname, resultbuf);
-            std::filesystem::remove(aoutname);
+    if (hasBinary) {
+        resultbuf << GETSTR_IS(RUN_TIME) << std::endl;
+        if (cached && cached->output) {
+            formatResult(resultbuf,
+                         CommandResult{.output = *cached->output,
+                                       .truncated = cached->outputTruncated},
+                         true);
+        } else if (const auto ran = executeCommand(message, aout.string(),
+                                                   true, dir.path());
+                   ran.started) {
+            formatResult(resultbuf, ran);
+            if (!ran.timedOut) {
+                cache.recordRun(key, ran.output, ran.truncated);
+            }
         }
-        onResultReady(message, resultbuf.str());
-        std::filesystem::remove(outfile);
     }
-}
\ No newline at end of file
+    onResultReady(message, resultbuf.str());
+}
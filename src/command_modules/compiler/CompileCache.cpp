@@ -0,0 +1,329 @@
+#include "CompileCache.hpp"
+
+#include <absl/log/log.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <random>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#ifdef WINDOWS_BUILD
+#include <process.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Files of an entry directory
+constexpr std::string_view kKeyFile = "key";
+constexpr std::string_view kDiagnosticsFile = "diagnostics";
+constexpr std::string_view kBinaryFile = "binary";
+// Output of the first run, until a second one says if it varies
+constexpr std::string_view kOutputFile = "output";
+constexpr std::string_view kSameFile = "same";
+constexpr std::string_view kVariesFile = "varies";
+// Present if the output or the diagnostics were cut
+constexpr std::string_view kDiagnosticsTruncatedFile = "diagnostics.truncated";
+constexpr std::string_view kOutputTruncatedFile = "output.truncated";
+// Entries being written, renamed once complete. Followed by the pid of
+// the process writing them.
+constexpr std::string_view kTempPrefix = "tmp.";
+
+// The fields, each with its length, so they can't run into each other
+std::string serialize(const CompileCache::Key& key) {
+    std::string out;
+    for (const auto* field : {&key.compiler, &key.flags, &key.source}) {
+        out += std::to_string(field->size());
+        out += ':';
+        out += *field;
+    }
+    return out;
+}
+
+// FNV-1a, stable across builds unlike std::hash. Entries keep their whole
+// key, so a collision is a miss and not a wrong result.
+std::string hashOf(const std::string& data) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char c : data) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    char hex[17];
+    std::snprintf(hex, sizeof(hex), "%016llx",
+                  static_cast<unsigned long long>(hash));
+    return hex;
+}
+
+std::optional<std::string> readFile(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return std::nullopt;
+    }
+    return std::string{std::istreambuf_iterator<char>(file),
+                       std::istreambuf_iterator<char>()};
+}
+
+bool writeFile(const fs::path& path, const std::string_view contents) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    return static_cast<bool>(file);
+}
+
+int processId() {
+#ifdef WINDOWS_BUILD
+    return _getpid();
+#else
+    return static_cast<int>(::getpid());
+#endif
+}
+
+// Makes directory if it is missing, only accessible to this user, and checks
+// that it still is: someone else could have made it first
+bool makePrivateDirectory(const fs::path& directory) {
+    std::error_code ec;
+    fs::create_directories(directory.parent_path(), ec);
+#ifdef WINDOWS_BUILD
+    // In the user's profile, which only they can access
+    fs::create_directory(directory, ec);
+    return fs::is_directory(directory, ec);
+#else
+    if (::mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) {
+        LOG(ERROR) << "Cannot create " << directory << ": "
+                   << std::strerror(errno);
+        return false;
+    }
+    struct stat info {};
+    if (::lstat(directory.c_str(), &info) != 0 || !S_ISDIR(info.st_mode)) {
+        LOG(ERROR) << directory << " is not a directory";
+        return false;
+    }
+    if (info.st_uid != ::geteuid()) {
+        LOG(ERROR) << directory << " is owned by user " << info.st_uid
+                   << ", not by the bot's";
+        return false;
+    }
+    if ((info.st_mode & (S_IRWXG | S_IRWXO)) != 0) {
+        LOG(ERROR) << directory << " is accessible to other users, mode "
+                   << std::oct << (info.st_mode & 0777) << std::dec;
+        return false;
+    }
+    return true;
+#endif
+}
+
+uint64_t sizeOf(const fs::path& directory) {
+    uint64_t size = 0;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec)) {
+        if (entry.is_regular_file(ec)) {
+            size += entry.file_size(ec);
+        }
+    }
+    return size;
+}
+
+}  // namespace
+
+CompileCache::CompileCache(fs::path directory, const uint64_t maxBytes)
+    : directory_(std::move(directory)), maxBytes_(maxBytes) {
+    std::error_code ec;
+    std::vector<std::tuple<fs::file_time_type, std::string, uint64_t>> found;
+
+    usable_ = makePrivateDirectory(directory_);
+    if (!usable_) {
+        LOG(ERROR) << "Compile cache is disabled";
+        return;
+    }
+    const auto pidPrefix =
+        std::string(kTempPrefix) + std::to_string(processId()) + ".";
+    char random[9];
+    std::snprintf(random, sizeof(random), "%08x", std::random_device{}());
+    tempPrefix_ = pidPrefix + random + ".";
+
+    for (const auto& entry : fs::directory_iterator(directory_, ec)) {
+        const auto name = entry.path().filename().string();
+        if (name.starts_with(pidPrefix)) {
+            // Left over by a process which crashed, with the pid we have
+            // now. Those of other pids may be in use by another bot.
+            fs::remove_all(entry.path(), ec);
+        } else if (name.starts_with(kTempPrefix)) {
+            continue;
+        } else if (entry.is_directory(ec)) {
+            found.emplace_back(entry.last_write_time(ec), name,
+                               sizeOf(entry.path()));
+        }
+    }
+    // Newest first, they go to the front of the LRU
+    std::ranges::sort(found, std::greater<>());
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [time, name, size] : found) {
+        lru_.emplace_back(name);
+        entries_.emplace(name, Slot{size, std::prev(lru_.end())});
+        totalBytes_ += size;
+    }
+    evictLocked();
+}
+
+std::optional<CompileCache::Entry> CompileCache::find(const Key& key) {
+    if (!usable_) {
+        return std::nullopt;
+    }
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const auto dir = findLocked(key);
+    if (!dir) {
+        return std::nullopt;
+    }
+    Entry entry;
+    entry.diagnostics = readFile(*dir / kDiagnosticsFile).value_or("");
+    entry.diagnosticsTruncated = fs::exists(*dir / kDiagnosticsTruncatedFile);
+    entry.hasBinary = fs::exists(*dir / kBinaryFile);
+    if (fs::exists(*dir / kSameFile)) {
+        entry.output = readFile(*dir / kOutputFile);
+        entry.outputTruncated = fs::exists(*dir / kOutputTruncatedFile);
+    }
+    return entry;
+}
+
+bool CompileCache::copyBinary(const Key& key, const fs::path& file) {
+    if (!usable_) {
+        return false;
+    }
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const auto dir = findLocked(key);
+    std::error_code ec;
+    if (!dir ||
+        !fs::copy_file(*dir / kBinaryFile, file,
+                       fs::copy_options::overwrite_existing, ec)) {
+        return false;
+    }
+    fs::permissions(file, fs::perms::owner_all, fs::perm_options::add, ec);
+    return !ec;
+}
+
+void CompileCache::store(const Key& key, const std::string& diagnostics,
+                         const bool diagnosticsTruncated,
+                         const std::optional<fs::path>& binary) {
+    if (!usable_) {
+        return;
+    }
+    const auto serialized = serialize(key);
+    const auto name = hashOf(serialized);
+    std::error_code ec;
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const auto temp =
+        directory_ / (tempPrefix_ + std::to_string(++tempCounter_));
+    fs::remove_all(temp, ec);
+    fs::create_directory(temp, ec);
+    bool written = !ec && writeFile(temp / kKeyFile, serialized) &&
+                   writeFile(temp / kDiagnosticsFile, diagnostics);
+    if (written && diagnosticsTruncated) {
+        written = writeFile(temp / kDiagnosticsTruncatedFile, "");
+    }
+    if (written && binary) {
+        written = fs::copy_file(*binary, temp / kBinaryFile, ec);
+    }
+    if (written) {
+        removeLocked(name);
+        fs::rename(temp, directory_ / name, ec);
+        written = !ec;
+    }
+    if (!written) {
+        LOG(WARNING) << "Cannot store compile result in " << directory_;
+        fs::remove_all(temp, ec);
+        return;
+    }
+    lru_.emplace_front(name);
+    entries_.emplace(name, Slot{0, lru_.begin()});
+    updateSizeLocked(name);
+    evictLocked();
+}
+
+void CompileCache::recordRun(const Key& key, const std::string& output,
+                             const bool truncated) {
+    if (!usable_) {
+        return;
+    }
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const auto dir = findLocked(key);
+    if (!dir || fs::exists(*dir / kSameFile) ||
+        fs::exists(*dir / kVariesFile)) {
+        return;
+    }
+    std::error_code ec;
+    if (const auto first = readFile(*dir / kOutputFile)) {
+        if (*first == output &&
+            fs::exists(*dir / kOutputTruncatedFile) == truncated) {
+            writeFile(*dir / kSameFile, "");
+        } else {
+            writeFile(*dir / kVariesFile, "");
+            fs::remove(*dir / kOutputFile, ec);
+            fs::remove(*dir / kOutputTruncatedFile, ec);
+        }
+    } else {
+        writeFile(*dir / kOutputFile, output);
+        if (truncated) {
+            writeFile(*dir / kOutputTruncatedFile, "");
+        }
+    }
+    updateSizeLocked(dir->filename().string());
+    evictLocked();
+}
+
+std::optional<fs::path> CompileCache::findLocked(const Key& key) {
+    const auto serialized = serialize(key);
+    const auto name = hashOf(serialized);
+    const auto it = entries_.find(name);
+    if (it == entries_.end()) {
+        return std::nullopt;
+    }
+    auto dir = directory_ / name;
+    if (readFile(dir / kKeyFile) != serialized) {
+        return std::nullopt;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second.lru);
+    // For the order of the index on restart
+    std::error_code ec;
+    fs::last_write_time(dir, fs::file_time_type::clock::now(), ec);
+    return dir;
+}
+
+void CompileCache::updateSizeLocked(const std::string& name) {
+    auto& slot = entries_.at(name);
+    totalBytes_ -= slot.size;
+    slot.size = sizeOf(directory_ / name);
+    totalBytes_ += slot.size;
+}
+
+void CompileCache::removeLocked(const std::string& name) {
+    std::error_code ec;
+    fs::remove_all(directory_ / name, ec);
+    const auto it = entries_.find(name);
+    if (it == entries_.end()) {
+        return;
+    }
+    totalBytes_ -= it->second.size;
+    lru_.erase(it->second.lru);
+    entries_.erase(it);
+}
+
+void CompileCache::evictLocked() {
+    while (totalBytes_ > maxBytes_ && !lru_.empty()) {
+        removeLocked(lru_.back());
+    }
+}
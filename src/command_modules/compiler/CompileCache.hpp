@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Results of earlier compiles, on disk, keyed by what was compiled.
+ *
+ * An entry has the compiler's output and the binary it made, if any. The
+ * output of a program is only served from here once two runs of it printed
+ * the same, so programs which print the time or random numbers still run
+ * every time. Entries are evicted least recently used first, past maxBytes
+ * in total, and the directory is indexed again on startup.
+ *
+ * Binaries from here are run, so the directory must be private: owned by
+ * the bot's user with no access for others. The cache is disabled if it
+ * isn't, and every lookup misses.
+ */
+class CompileCache {
+   public:
+    struct Key {
+        std::string compiler;
+        std::string flags;
+        std::string source;
+    };
+    struct Entry {
+        std::string diagnostics;
+        // Whether the compiler printed more than diagnostics
+        bool diagnosticsTruncated = false;
+        bool hasBinary = false;
+        // Set once the program is known to print the same on every run
+        std::optional<std::string> output;
+        bool outputTruncated = false;
+    };
+
+    CompileCache(std::filesystem::path directory, uint64_t maxBytes);
+
+    // False if the directory couldn't be made private, see above
+    [[nodiscard]] bool usable() const { return usable_; }
+
+    std::optional<Entry> find(const Key& key);
+    // Copies key's binary to file, as an executable
+    bool copyBinary(const Key& key, const std::filesystem::path& file);
+    // Adds or replaces the entry of key, with a copy of binary if given
+    void store(const Key& key, const std::string& diagnostics,
+               bool diagnosticsTruncated,
+               const std::optional<std::filesystem::path>& binary);
+    // The output of a run of key's program, see Entry::output
+    void recordRun(const Key& key, const std::string& output,
+                   bool truncated);
+
+   private:
+    struct Slot {
+        uint64_t size;
+        std::list<std::string>::iterator lru;
+    };
+
+    // The entry directory of key, if it has one. Touches it in the LRU.
+    std::optional<std::filesystem::path> findLocked(const Key& key);
+    void updateSizeLocked(const std::string& name);
+    void removeLocked(const std::string& name);
+    void evictLocked();
+
+    const std::filesystem::path directory_;
+    const uint64_t maxBytes_;
+    bool usable_ = false;
+    // "tmp.<pid>.<random>.", the prefix of this instance's temporary entries.
+    // Other processes may share the directory.
+    std::string tempPrefix_;
+
+    std::mutex mutex_;
+    // Front is the most recently used
+    std::list<std::string> lru_;
+    std::unordered_map<std::string, Slot> entries_;
+    uint64_t totalBytes_ = 0;
+    unsigned tempCounter_ = 0;
+};
@@ -3,10 +3,12 @@
 #include <tgbot/Bot.h>
 #include <tgbot/types/Message.h>
 
+#include <filesystem>
 #include <sstream>
 #include <string>
 
 #include "BotClassBase.h"
+#include "CompileCache.hpp"
 #include "command_modules/CommandModule.h"
 
 using TgBot::Bot;
@@ -73,6 +75,40 @@ struct CompilerInTg {
     void runCommand(const Message::Ptr& message, std::string cmd,
                     std::stringstream& res, bool use_wdt = true);
 
+    struct CommandResult {
+        std::string output;
+        bool started = false;
+        bool truncated = false;
+        bool timedOut = false;
+        double seconds = 0;
+    };
+
+    /**
+     * @brief Executes a command, like runCommand(), but returns its result.
+     *
+     * @param message The message that triggered the command.
+     * @param cmd The command to be executed.
+     * @param use_wdt Whether to use the watchdog to time out the command.
+     * @param workDir The directory to run it in, the bot's if empty.
+     * @return The output of the command, capped at BASH_MAX_BUF.
+     */
+    CommandResult executeCommand(const Message::Ptr& message, std::string cmd,
+                                 bool use_wdt = true,
+                                 const std::filesystem::path& workDir = {});
+
+    /**
+     * @brief Writes a result of executeCommand() as runCommand() does.
+     *
+     * @param res The buffer to write to.
+     * @param result The result to write.
+     * @param cached Whether the output is from the compile cache.
+     */
+    static void formatResult(std::stringstream& res,
+                             const CommandResult& result, bool cached = false);
+
+    // Results shared by all compilers, see CompileCache
+    static CompileCache& compileCache();
+
     constexpr static const char SPACE = ' ';
     constexpr static const char EMPTY[] = "(empty)";
 };
@@ -85,13 +121,41 @@ struct CompilerInTgForBash : CompilerInTg {
     void run(const Message::Ptr& message) override;
 };
 
+// A directory of its own for a request, removed with what is in it
+class CompilerWorkDir {
+   public:
+    CompilerWorkDir();
+    ~CompilerWorkDir();
+    CompilerWorkDir(const CompilerWorkDir&) = delete;
+    CompilerWorkDir& operator=(const CompilerWorkDir&) = delete;
+
+    [[nodiscard]] const std::filesystem::path& path() const { return path_; }
+    [[nodiscard]] bool valid() const { return !path_.empty(); }
+
+   private:
+    std::filesystem::path path_;
+};
+
 struct CompilerInTgForGeneric : CompilerInTg {
     explicit CompilerInTgForGeneric(const std::filesystem::path& _cmdPrefix,
                                     const std::string& _outfile)
         : CompilerInTg(), cmdPrefix(_cmdPrefix), outfile(_outfile) {}
     std::filesystem::path cmdPrefix;
+    // Name of the source file, in the request's work directory
     std::string outfile;
-    bool verifyParseWrite(const Message::Ptr& message, std::string& extraargs);
+    /**
+     * @brief Gets the code and the extra arguments from a request.
+     *
+     * @param message The message who sent the request.
+     * @param extraargs Set to the extra text of the command, if any.
+     * @param source Set to the code, the text of the replied-to message.
+     * @return Whether there was code, onFailed() is called if not.
+     */
+    bool verifyParse(const Message::Ptr& message, std::string& extraargs,
+                     std::string& source);
+    // Writes source to outfile in dir, onFailed() is called on failure
+    bool writeSource(const Message::Ptr& message, const CompilerWorkDir& dir,
+                     const std::string& source);
     virtual ~CompilerInTgForGeneric() = default;
     virtual void run(const Message::Ptr& message) override;
 };
@@ -1,28 +1,38 @@
 #include "CompilerInTelegram.h"
 #include <MessageWrapper.hpp>
 #include <filesystem>
+#include <fstream>
 
-// Verify, Parse, Write
-bool CompilerInTgForGeneric::verifyParseWrite(const Message::Ptr& message,
-                                              std::string& extraargs) {
+bool CompilerInTgForGeneric::verifyParse(const Message::Ptr& message,
+                                         std::string& extraargs,
+                                         std::string& source) {
     MessageWrapperLimited wrapper(message);
     if (wrapper.hasExtraText()) {
         extraargs = wrapper.getExtraText();
     }
     if (message->replyToMessage && !message->replyToMessage->text.empty()) {
-        std::ofstream file(outfile);
-        if (file.fail()) {
-            onFailed(message, ErrorType::FILE_WRITE_FAILED);
-            return false;
-        }
-        file << message->replyToMessage->text;
-        file.close();
+        source = message->replyToMessage->text;
         return true;
     }
     onFailed(message, ErrorType::MESSAGE_VERIFICATION_FAILED);
     return false;
 }
 
+bool CompilerInTgForGeneric::writeSource(const Message::Ptr& message,
+                                         const CompilerWorkDir& dir,
+                                         const std::string& source) {
+    if (dir.valid()) {
+        std::ofstream file(dir.path() / outfile);
+        file << source;
+        file.close();
+        if (!file.fail()) {
+            return true;
+        }
+    }
+    onFailed(message, ErrorType::FILE_WRITE_FAILED);
+    return false;
+}
+
 void CompilerInTgForGenericImpl::onResultReady(const Message::Ptr& message,
                                                const std::string& text) {
     CompilerInTgHelper::onResultReady(_bot, message, text);
@@ -35,12 +45,39 @@ void CompilerInTgForGenericImpl::onFailed(const Message::Ptr& who,
 
 void CompilerInTgForGeneric::run(const Message::Ptr &message) {
     std::string extargs;
+    std::string source;
     std::stringstream cmd, res;
 
-    if (verifyParseWrite(message, outfile)) {
-        cmd << cmdPrefix.string() << SPACE << outfile;
-        runCommand(message, cmd.str(), res);
+    if (!verifyParse(message, extargs, source)) {
+        return;
+    }
+    auto &cache = compileCache();
+    const CompileCache::Key key{cmdPrefix.string(), {}, source};
+    const auto cached = cache.find(key);
+    if (cached && cached->output) {
+        formatResult(res,
+                     CommandResult{.output = *cached->output,
+                                   .truncated = cached->outputTruncated},
+                     true);
         onResultReady(message, res.str());
-        std::filesystem::remove(outfile);
+        return;
+    }
+
+    CompilerWorkDir dir;
+    if (!writeSource(message, dir, source)) {
+        return;
+    }
+    cmd << cmdPrefix.string() << SPACE << (dir.path() / outfile).string();
+    const auto result = executeCommand(message, cmd.str(), true, dir.path());
+    if (!result.started) {
+        return;
+    }
+    formatResult(res, result);
+    onResultReady(message, res.str());
+    if (!result.timedOut) {
+        if (!cached) {
+            cache.store(key, {}, false, std::nullopt);
+        }
+        cache.recordRun(key, result.output, result.truncated);
     }
 }
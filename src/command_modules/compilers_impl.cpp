@@ -27,7 +27,8 @@ void GOModuleCallback(const Bot &bot, const Message::Ptr &message,
     goCompiler.run(message);
 }
 void NoCompilerCommandStub(const Bot &bot, const Message::Ptr &message) {
-    bot_sendReplyMessage(bot, message, GETSTR(NOT_SUPPORTED_IN_CURRENT_HOST));
+    bot_sendReplyMessage(bot, message,
+                         std::string(GETSTR(NOT_SUPPORTED_IN_CURRENT_HOST)));
 }
 void loadCompilerGeneric(CommandModule &module, ProgrammingLangs lang,
                          std::string_view name,
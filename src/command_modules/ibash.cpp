@@ -25,6 +25,81 @@
 
 using std::chrono_literals::operator""s;
 
+struct IBashExitTimeoutThread : ManagedThread {
+    void run() {
+        runAfter(std::chrono::seconds(SLEEP_SECONDS), [this] {
+            if (childpid > 0 && kill(childpid, 0) == 0) {
+                LOG(WARNING) << "Process " << childpid
+                             << " misbehaving, using SIGTERM";
+                killpg(childpid, SIGTERM);
+            }
+        });
+    }
+    pid_t childpid;
+    explicit IBashExitTimeoutThread(pid_t childpid) : childpid(childpid) {}
+};
+
+struct IBashUpdateOutputThread : ManagedThreadRunnable, BotClassBase {
+    void runFunction() override {
+        PollSelector selector;
+
+        selector.init();
+        selector.setTimeout(100s);
+        selector.enableTimeout(true);
+        selector.add(
+            readfd,
+            [this]() {
+                std::lock_guard<std::mutex> lock(m_buffer);
+                auto len = read(readfd, buffer.data() + offset, BASH_READ_BUF);
+                if (len < 0) {
+                    PLOG(ERROR) << "Failed to read from pipe";
+                    kRun = false;
+                } else {
+                    offset += len;
+                    if (offset + BASH_READ_BUF > BASH_MAX_BUF) {
+                        LOG(INFO) << "Buffer overflow";
+                        kRun = false;
+                    }
+                }
+            },
+            Selector::Mode::READ);
+        while (kRun) {
+            switch (selector.poll()) {
+                case Selector::SelectorPollResult::OK:
+                    bot_editMessage(_bot, message, buffer.data());
+                    selector.reinit();
+                    break;
+                case Selector::SelectorPollResult::FAILED:
+                    LOG(ERROR) << "Failed to read from pipe";
+                    kRun = false;
+                    break;
+                case Selector::SelectorPollResult::TIMEOUT:
+                    LOG(INFO) << "Timeout";
+                    kRun = false;
+                    break;
+            };
+        }
+    }
+    void onNewCommand(const std::string& command) {
+        std::lock_guard<std::mutex> lock(m_buffer);
+        buffer.fill(0);
+
+        std::string header = ("Output of command: " + command + "\n");
+        strcpy(buffer.data(), header.c_str());
+        offset = header.size();
+    }
+    explicit IBashUpdateOutputThread(const Bot& bot, Message::Ptr message,
+                                     int readfd)
+        : BotClassBase(bot), readfd(readfd), message(std::move(message)) {}
+
+   private:
+    int readfd;
+    Message::Ptr message;
+    std::mutex m_buffer;  // Protect below 2
+    size_t offset = 0;
+    std::array<char, BASH_MAX_BUF> buffer{};
+};
+
 struct InteractiveBashContext : BotClassBase {
     // parentToChild { parent write, child stdin }
     // childToParent { parent read, child stdout }
@@ -39,83 +114,6 @@ struct InteractiveBashContext : BotClassBase {
     explicit InteractiveBashContext(const Bot& bot)
         : BotClassBase(bot), ThrMgr(ThreadManager::getInstance()) {}
 
-    struct ExitTimeoutThread : ManagedThreadRunnable {
-        void runFunction() override {
-            if (delayUnlessStop(SLEEP_SECONDS); kRun) {
-                if (context->childpid > 0 && kill(context->childpid, 0) == 0) {
-                    LOG(WARNING) << "Process " << context->childpid
-                                 << " misbehaving, using SIGTERM";
-                    killpg(context->childpid, SIGTERM);
-                }
-            }
-        }
-        InteractiveBashContext* context;
-        explicit ExitTimeoutThread(InteractiveBashContext* context)
-            : context(context) {}
-    };
-
-    struct UpdateOutputThread : ManagedThreadRunnable, BotClassBase {
-        void runFunction() override {
-            PollSelector selector;
-
-            selector.init();
-            selector.setTimeout(100s);
-            selector.enableTimeout(true);
-            selector.add(
-                readfd,
-                [this]() {
-                    std::lock_guard<std::mutex> lock(m_buffer);
-                    auto len =
-                        read(readfd, buffer.data() + offset, BASH_READ_BUF);
-                    if (len < 0) {
-                        PLOG(ERROR) << "Failed to read from pipe";
-                        kRun = false;
-                    } else {
-                        offset += len;
-                        if (offset + BASH_READ_BUF > BASH_MAX_BUF) {
-                            LOG(INFO) << "Buffer overflow";
-                            kRun = false;
-                        }
-                    }
-                },
-                Selector::Mode::READ);
-            while (kRun) {
-                switch (selector.poll()) {
-                    case Selector::SelectorPollResult::OK:
-                        bot_editMessage(_bot, message, buffer.data());
-                        selector.reinit();
-                        break;
-                    case Selector::SelectorPollResult::FAILED:
-                        LOG(ERROR) << "Failed to read from pipe";
-                        kRun = false;
-                        break;
-                    case Selector::SelectorPollResult::TIMEOUT:
-                        LOG(INFO) << "Timeout";
-                        kRun = false;
-                        break;
-                };
-            }
-        }
-        void onNewCommand(const std::string& command) {
-            std::lock_guard<std::mutex> lock(m_buffer);
-            buffer.fill(0);
-
-            std::string header = ("Output of command: " + command + "\n");
-            strcpy(buffer.data(), header.c_str());
-            offset = header.size();
-        }
-        explicit UpdateOutputThread(const Bot& bot, Message::Ptr message,
-                                    int readfd)
-            : BotClassBase(bot), readfd(readfd), message(std::move(message)) {}
-
-       private:
-        int readfd;
-        Message::Ptr message;
-        std::mutex m_buffer;  // Protect below 2
-        size_t offset = 0;
-        std::array<char, BASH_MAX_BUF> buffer{};
-    };
-
     static bool isExitCommand(const std::string& str) {
         static const std::regex kExitCommandRegex(R"(^exit( \d+)?$)");
         return std::regex_match(str, kExitCommandRegex);
@@ -202,10 +200,9 @@ struct InteractiveBashContext : BotClassBase {
             LOG(INFO) << "Open success, child pid: " << childpid;
         }
         auto msg = bot_sendMessage(_bot, chat, "IBash starts...");
-        ThrMgr->getInstance()
-            ->createController<ThreadManager::Usage::IBASH_UPDATE_OUTPUT_THREAD,
-                               UpdateOutputThread>(
-
+        ThrMgr
+            ->createController<
+                ThreadManager::Usage::IBASH_UPDATE_OUTPUT_THREAD>(
                 std::cref(_bot), msg, childToParent.readEnd())
             ->run();
         return true;
@@ -217,12 +214,12 @@ struct InteractiveBashContext : BotClassBase {
             // Write a msg as a fallback if for some reason exit doesnt get
             // written
             auto exitTimeout = ThrMgr->createController<
-                ThreadManager::Usage::IBASH_EXIT_TIMEOUT_THREAD,
-                ExitTimeoutThread>(this);
+                ThreadManager::Usage::IBASH_EXIT_TIMEOUT_THREAD>(childpid);
 
             if (!exitTimeout) {
                 return;
             }
+            exitTimeout->run();
 
             // Try to type exit command
             sendCommandNoCheck("exit 0");
@@ -234,8 +231,7 @@ struct InteractiveBashContext : BotClassBase {
             }
             ThrMgr
                 ->getController<
-                    ThreadManager::Usage::IBASH_UPDATE_OUTPUT_THREAD,
-                    UpdateOutputThread>()
+                    ThreadManager::Usage::IBASH_UPDATE_OUTPUT_THREAD>()
                 ->stop();
             exitTimeout->stop();
             ThrMgr->destroyController(
@@ -266,8 +262,7 @@ struct InteractiveBashContext : BotClassBase {
         }
         ssize_t rc = 0;
         auto outputThread = ThrMgr->getController<
-            ThreadManager::Usage::IBASH_UPDATE_OUTPUT_THREAD,
-            UpdateOutputThread>();
+            ThreadManager::Usage::IBASH_UPDATE_OUTPUT_THREAD>();
         if (!outputThread->isRunning()) {
             LOG(ERROR) << "Output thread is not running, timed out";
             return false;
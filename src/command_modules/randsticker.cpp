@@ -2,10 +2,43 @@
 #include "CommandModule.h"
 #include <random/RandomNumberGenerator.h>
 
+#include <ApiScheduler.hpp>
 #include <MessageWrapper.hpp>
+#include <StickerSetCache.hpp>
 
 using TgBot::StickerSet;
 
+namespace {
+class BotStickerSetSource : public StickerSetCache::Source {
+   public:
+    explicit BotStickerSetSource(const Bot &bot) : bot_(bot) {}
+
+    StickerSetCache::Set fetch(const std::string &name) override {
+        const StickerSet::Ptr stickset = bot_.getApi().getStickerSet(name);
+        StickerSetCache::Set set{stickset->title, {}};
+        set.stickers.reserve(stickset->stickers.size());
+        for (const auto &sticker : stickset->stickers) {
+            set.stickers.emplace_back(sticker->fileId, sticker->emoji);
+        }
+        return set;
+    }
+
+   private:
+    const Bot &bot_;
+};
+
+StickerSetCache &stickerSets(const Bot &bot) {
+    static StickerSetCache cache(
+        std::make_shared<BotStickerSetSource>(bot),
+        // Refreshes aren't sent to a chat, they go in the global lane
+        [](std::function<void()> refresh) {
+            ApiScheduler::getInstance()->submitGlobal(std::move(refresh));
+        },
+        StickerSetCache::Limits{});
+    return cache;
+}
+}  // namespace
+
 static void RandomStickerCommandFn(const Bot &bot, const Message::Ptr& message) {
     MessageWrapper msg(bot, message);
     if (!msg.switchToReplyToMessage("Sticker not found in replied-to message")) {
@@ -15,19 +48,24 @@ static void RandomStickerCommandFn(const Bot &bot, const Message::Ptr& message)
     if (msg.hasSticker()) {
         auto sticker = msg.getSticker();
         random_return_type pos{};
-        StickerSet::Ptr stickset;
+        StickerSetCache::SetPtr stickset;
         std::stringstream ss;
         try {
-            stickset = bot.getApi().getStickerSet(sticker->setName);
+            stickset = stickerSets(bot).get(sticker->setName);
         } catch (const std::exception &e) {
             bot_sendReplyMessage(bot, message, e.what());
             return;
         }
+        if (stickset->stickers.empty()) {
+            bot_sendReplyMessage(bot, message, "Sticker pack is empty");
+            return;
+        }
         pos = RandomNumberGenerator::generate(stickset->stickers.size() - 1);
-        bot_sendSticker(bot, message->chat, stickset->stickers[pos], message);
+        const auto &picked = stickset->stickers[pos];
+        bot_sendSticker(bot, message->chat->id, picked.fileId, message);
 
-        ss << "Sticker idx: " << pos + 1
-           << " emoji: " << stickset->stickers[pos]->emoji << std::endl
+        ss << "Sticker idx: " << pos + 1 << " emoji: " << picked.emoji
+           << std::endl
            << "From pack " << std::quoted(stickset->title);
         bot_sendReplyMessage(bot, message, ss.str());
     }
@@ -38,4 +76,4 @@ void loadcmd_randsticker(CommandModule &module) {
     module.description = "Random sticker from that pack";
     module.flags = CommandModule::Flags::None;
     module.fn = RandomStickerCommandFn;
-}
\ No newline at end of file
+}
@@ -1,5 +1,7 @@
 #include <BotReplyMessage.h>
+#include <ConfigManager.h>
 
+#include <ApiScheduler.hpp>
 #include <MessageWrapper.hpp>
 #include <StringToolsExt.hpp>
 #include <TryParseStr.hpp>
@@ -7,28 +9,51 @@
 #include <boost/algorithm/string/split.hpp>
 #include <cctype>
 #include <database/bot/TgBotDatabaseImpl.hpp>
-#include <filesystem>
+#include <cstdint>
+#include <imagep/ImageParallel.hpp>
 #include <imagep/ImageProcAll.hpp>
 #include <memory>
+#include <span>
 #include <string>
 #include <string_view>
 #include <variant>
+#include <vector>
 
 #include "CommandModule.h"
 
 struct ProcessImageParam {
-    std::filesystem::path srcPath;
-    std::filesystem::path destPath;
+    std::span<const uint8_t> srcData;
+    std::vector<uint8_t> destData;
+    std::string_view destMimeType;
     int rotation;
     bool greyscale;
 };
 
 namespace {
-bool processPhotoFile(ProcessImageParam& param) {
-    ImageProcessingAll procAll(param.srcPath);
-    if (procAll.read()) {
+// Large photos are split across threads, see ImageKernels::parallelFor
+void configureImageThreads() {
+    const auto config = ConfigManager::snapshot();
+    const auto threads =
+        config->getNumber<unsigned>(ConfigManager::Configs::IMAGE_THREADS);
+    const auto minPixels =
+        config->getNumber<size_t>(ConfigManager::Configs::IMAGE_MIN_PIXELS);
+
+    ImageKernels::setParallelism(
+        threads.value_or(0),
+        minPixels.value_or(ImageKernels::kDefaultParallelMinPixels));
+}
+
+bool processPhotoBuffer(ProcessImageParam& param) {
+    ImageProcessingAll procAll;
+    if (procAll.read(param.srcData)) {
         LOG(INFO) << "Successfully read image";
-        switch (procAll.rotate(param.rotation)) {
+        // Both edits are done in a single pass where the backend allows it
+        TransformPipeline pipeline;
+        pipeline.rotate(param.rotation);
+        if (param.greyscale) {
+            pipeline.greyscale();
+        }
+        switch (procAll.transform(pipeline)) {
             case PhotoBase::Result::kErrorInvalidArgument:
                 LOG(ERROR) << "Invalid rotation angle";
                 return false;
@@ -38,21 +63,19 @@ bool processPhotoFile(ProcessImageParam& param) {
             case PhotoBase::Result::kErrorNoData:
                 LOG(ERROR) << "No data available to rotate (internal error)";
                 return false;
+            case PhotoBase::Result::kErrorUnsupportedOperation:
+                LOG(ERROR) << "Unsupported operation (internal error)";
+                return false;
             case PhotoBase::Result::kSuccess:
-                LOG(INFO) << "Successfully rotated image";
+                LOG(INFO) << "Successfully transformed image";
                 break;
         }
-        if (param.greyscale) {
-            procAll.to_greyscale();
-        }
-        return procAll.write(param.destPath);
+        param.destMimeType = procAll.mimeType();
+        return procAll.write(param.destData);
     }
     return false;
 }
 
-constexpr std::string_view kDownloadFile = "inpic.bin";
-constexpr std::string_view kOutputFile = "outpic.png";
-
 void rotateStickerCommand(const Bot& bot, const Message::Ptr message) {
     MessageWrapper wrapper(bot, message);
     std::string extText = wrapper.getExtraText();
@@ -84,6 +107,7 @@ void rotateStickerCommand(const Bot& bot, const Message::Ptr message) {
         greyscale = args[1] == "greyscale";
     }
     std::optional<std::string> fileid;
+    std::string fileUniqueId;
     if (wrapper.hasSticker()) {
         const auto stick = wrapper.getSticker();
         if (stick->isAnimated || stick->isVideo) {
@@ -91,9 +115,12 @@ void rotateStickerCommand(const Bot& bot, const Message::Ptr message) {
                 "Cannot rotate animated or video sticker");
         }
         fileid = stick->fileId;
+        fileUniqueId = stick->fileUniqueId;
     } else if (wrapper.hasPhoto()) {
         // Select the best quality photos available
-        fileid = wrapper.getPhoto().back()->fileId;
+        const auto photo = wrapper.getPhoto().back();
+        fileid = photo->fileId;
+        fileUniqueId = photo->fileUniqueId;
     } else {
         wrapper.sendMessageOnExit("Reply to a sticker or photo");
     }
@@ -102,45 +129,51 @@ void rotateStickerCommand(const Bot& bot, const Message::Ptr message) {
         return;
     }
 
-    const auto file = bot.getApi().getFile(fileid.value());
-    if (!file) {
+    // Download the sticker, or reuse it if it was rotated before
+    const auto buffer = bot_downloadFile(bot, fileid.value(), fileUniqueId);
+    if (!buffer) {
         wrapper.sendMessageOnExit("Failed to download sticker file.");
         return;
     }
-    // Download the sticker
-    std::string buffer = bot.getApi().downloadFile(file->filePath);
-    // Save the sticker to a temporary file
-    std::ofstream ofs(kDownloadFile.data());
-    ofs.write(buffer.data(), buffer.size());
-    ofs.close();
 
     // Round it under 360
     rotation = rotation % PhotoBase::kAngleMax;
 
-    // Process the image
+    // Process the image, all in memory
     ProcessImageParam params{};
-    params.srcPath = kDownloadFile.data();
+    params.srcData = {reinterpret_cast<const uint8_t*>(buffer->data()),
+                      buffer->size()};
     params.greyscale = greyscale;
     params.rotation = rotation;
-    params.destPath = kOutputFile.data();
 
-    if (processPhotoFile(params)) {
-        const auto infile =
-            TgBot::InputFile::fromFile(params.destPath.string(), "image/png");
+    if (processPhotoBuffer(params)) {
+        const auto infile = std::make_shared<TgBot::InputFile>();
+        const auto& mimeType = params.destMimeType;
+        infile->data.assign(params.destData.begin(), params.destData.end());
+        infile->mimeType = mimeType;
+        // e.g. image/png -> rotated.png
+        infile->fileName =
+            "rotated." + std::string(mimeType.substr(mimeType.find('/') + 1));
         const auto replyParams = std::make_shared<TgBot::ReplyParameters>();
         replyParams->messageId = message->messageId;
         replyParams->chatId = message->chat->id;
-        if (wrapper.hasSticker()) {
-            bot.getApi().sendSticker(wrapper.getChatId(), infile, replyParams);
-        } else if (wrapper.hasPhoto()) {
-            bot.getApi().sendPhoto(wrapper.getChatId(), infile,
-                                   "Rotated picture", replyParams);
-        }
+        const bool sticker = wrapper.hasSticker();
+        const auto chat = wrapper.getChatId();
+        // Through the chat's lane, and waited for as the other replies are
+        ApiScheduler::getInstance()
+            ->submit(chat,
+                     [&] {
+                         if (sticker) {
+                             return bot.getApi().sendSticker(chat, infile,
+                                                             replyParams);
+                         }
+                         return bot.getApi().sendPhoto(
+                             chat, infile, "Rotated picture", replyParams);
+                     })
+            .get();
     } else {
         wrapper.sendMessageOnExit("Unknown image type, or processing failed");
     }
-    std::filesystem::remove(params.srcPath);  // Delete the temporary file
-    std::filesystem::remove(params.destPath);
 }
 }  // namespace
 
@@ -149,4 +182,5 @@ void loadcmd_rotatepic(CommandModule& module) {
     module.description = "Rotate a sticker";
     module.flags = CommandModule::Flags::None;
     module.fn = rotateStickerCommand;
+    configureImageThreads();
 }
@@ -1,27 +1,29 @@
 #include <BotReplyMessage.h>
 #include <tgbot/tools/StringTools.h>
 
+#include <ApiScheduler.hpp>
 #include <MessageWrapper.hpp>
 #include <TryParseStr.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <functional>
-#include <thread>
 
 #include "CommandModule.h"
 #include "StringToolsExt.hpp"
 
 constexpr int MAX_SPAM_COUNT = 10;
-constexpr auto kSpamDelayTime = std::chrono::milliseconds(700);
 
 namespace {
 
-void for_count(int count, const std::function<void(void)>& callback) {
+// Queues the sends, the scheduler spaces them out in the chat. The bot_*
+// calls in callback run right away, on the scheduler's thread.
+void for_count(const ChatId chat, int count,
+               const std::function<void(void)>& callback) {
+    const auto scheduler = ApiScheduler::getInstance();
     if (count > MAX_SPAM_COUNT) {
         count = MAX_SPAM_COUNT;
     }
     for (int i = 0; i < count; ++i) {
-        callback();
-        std::this_thread::sleep_for(kSpamDelayTime);
+        scheduler->submit(chat, ApiScheduler::logged("send spam", callback));
     }
 }
 void try_parse_spamcnt(const std::string& data, int& count) {
@@ -51,17 +53,18 @@ static void SpamCommandFn(const Bot& bot, const Message::Ptr& message) {
             spamable = true;
             try_parse_spamcnt(wrapper.getExtraText(), count);
             wrapper.switchToReplyToMessage();
+            // The sends run after we return, only the bot outlives us
             if (wrapper.hasSticker()) {
-                fp = [&bot, message, &wrapper, chatid] {
-                    bot_sendSticker(bot, chatid, wrapper.getSticker());
+                fp = [&bot, chatid, sticker = wrapper.getSticker()] {
+                    bot_sendSticker(bot, chatid, sticker);
                 };
             } else if (wrapper.hasAnimation()) {
-                fp = [&bot, message, chatid, &wrapper] {
-                    bot_sendAnimation(bot, chatid, wrapper.getAnimation());
+                fp = [&bot, chatid, gif = wrapper.getAnimation()] {
+                    bot_sendAnimation(bot, chatid, gif);
                 };
             } else if (wrapper.hasText()) {
-                fp = [&bot, message, chatid, &wrapper] {
-                    bot_sendMessage(bot, chatid, wrapper.getText());
+                fp = [&bot, chatid, text = wrapper.getText()] {
+                    bot_sendMessage(bot, chatid, text);
                 };
             } else {
                 wrapper.sendMessageOnExit(
@@ -77,8 +80,8 @@ static void SpamCommandFn(const Bot& bot, const Message::Ptr& message) {
         if (commands.size() == 2) {
             try_parse_spamcnt(commands[0], spamData.first);
             spamData.second = commands[1];
-            fp = [&bot, message, spamData] {
-                bot_sendMessage(bot, message->chat->id, spamData.second);
+            fp = [&bot, chatid = message->chat->id, spamData] {
+                bot_sendMessage(bot, chatid, spamData.second);
             };
             count = spamData.first;
             spamable = true;
@@ -90,7 +93,7 @@ static void SpamCommandFn(const Bot& bot, const Message::Ptr& message) {
             "Send a pair of spam count and message to spam");
     }
     if (spamable) {
-        for_count(count, fp);
+        for_count(message->chat->id, count, fp);
     }
 }
 
@@ -1,34 +1,22 @@
 #include <TimerImpl.h>
 
-#include <ManagedThreads.hpp>
-
 #include "CommandModule.h"
 
+namespace {
+// Its timers are on the shared wheel, which may still run them while the
+// bot exits, so it is never destroyed
+TimerCommandManager &manager() {
+    static auto* const instance = new TimerCommandManager();
+    return *instance;
+}
+}  // namespace
+
 static void TimerStartCommandFn(const Bot &bot, const Message::Ptr message) {
-    const auto tm = ThreadManager::getInstance();
-    auto ctrl = tm->createController<ThreadManager::Usage::TIMER_THREAD,
-                                     TimerCommandManager>();
-    if (ctrl) {
-        ctrl->startTimer(bot, message);
-    } else {
-        ctrl = tm->getController<ThreadManager::Usage::TIMER_THREAD, TimerCommandManager>();
-        CHECK(ctrl) << "Timer should be gettable";
-        ctrl->startTimer(bot, message);
-    }
+    manager().startTimer(bot, message);
 }
 
 static void TimerStopCommandFn(const Bot &bot, const Message::Ptr message) {
-    const auto tm = ThreadManager::getInstance();
-    auto ctrl = tm->getController<ThreadManager::Usage::TIMER_THREAD,
-                                     TimerCommandManager>();
-    if (ctrl) {
-        ctrl->stopTimer(bot, message);
-    } else {
-        ctrl = tm->createController<ThreadManager::Usage::TIMER_THREAD, TimerCommandManager>();
-        CHECK(ctrl) << "Timer should be gettable";
-        ctrl->stopTimer(bot, message);
-        tm->destroyController(ThreadManager::Usage::TIMER_THREAD);
-    }
+    manager().stopTimer(bot, message);
 }
 
 void loadcmd_starttimer(CommandModule &module) {
@@ -43,4 +31,4 @@ void loadcmd_stoptimer(CommandModule &module) {
     module.description = "Stop timer of the bot";
     module.flags = CommandModule::Flags::Enforced;
     module.fn = TimerStopCommandFn;
-}
\ No newline at end of file
+}
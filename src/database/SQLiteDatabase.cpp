@@ -5,6 +5,8 @@
 #include <absl/log/check.h>
 #include <absl/log/log.h>
 
+#include <Metrics.hpp>
+#include <Tracing.hpp>
 #include <array>
 #include <cstdint>
 #include <fstream>
@@ -47,6 +49,21 @@ void PrintStackTrace() {
     }
 }
 
+// sqlite3_step(), timed, with errors counted
+int stepStatement(sqlite3_stmt* stmt) {
+    static auto& latency = Metrics::histogram(
+        "tgbot_db_query_seconds", "Time spent stepping SQLite statements");
+    static auto& errors = Metrics::counter("tgbot_db_errors_total",
+                                           "SQLite statements which failed");
+    const Tracing::Span span("sqlite3_step");
+    const Metrics::ScopedTimer timer(latency);
+    const int ret = sqlite3_step(stmt);
+    if (ret != SQLITE_ROW && ret != SQLITE_DONE) {
+        errors.add();
+    }
+    return ret;
+}
+
 }  // namespace
 void SQLiteDatabase::Helper::logInvalidState(
     const std::source_location& location, SQLiteDatabase::Helper::State state) {
@@ -241,7 +258,7 @@ SQLiteDatabase::Helper::execAndGetRow() {
     }
 
     state = State::EXECUTED;
-    switch (sqlite3_step(stmt)) {
+    switch (stepStatement(stmt)) {
         case SQLITE_ROW: {
             Row row{shared_from_this(), stmt};
             return row;
@@ -259,7 +276,7 @@ bool SQLiteDatabase::Helper::execute() {
         return false;
     }
 
-    switch (sqlite3_step(stmt)) {
+    switch (stepStatement(stmt)) {
         case SQLITE_DONE:
         case SQLITE_ROW:
             return true;
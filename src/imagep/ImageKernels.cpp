@@ -0,0 +1,762 @@
+#include "ImageKernels.hpp"
+
+#include <absl/log/log.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "ImageParallel.hpp"
+
+// SSE2 and NEON are part of the baseline of x86_64 and aarch64, so they are
+// used unconditionally. SSE4.1 and AVX2 kernels are compiled with function
+// level target attributes and picked at runtime.
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define IMAGEKERNELS_X86
+#include <immintrin.h>
+#define IMAGEKERNELS_TARGET(x) __attribute__((target(x)))
+#elif defined(__ARM_NEON)
+#define IMAGEKERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace ImageKernels {
+
+namespace {
+
+// BT.601 luma weights scaled by 256, they add up to 256.
+constexpr uint32_t kWeightR = 77;
+constexpr uint32_t kWeightG = 150;
+constexpr uint32_t kWeightB = 29;
+
+// 64x64 pixels of RGBA is 16KiB, a source and a destination tile fit in L1.
+constexpr size_t kTileSize = 64;
+
+constexpr size_t tileCount(size_t size) {
+    return (size + kTileSize - 1) / kTileSize;
+}
+
+inline uint8_t luma(const uint8_t* px) {
+    return static_cast<uint8_t>(
+        (kWeightR * px[0] + kWeightG * px[1] + kWeightB * px[2] + 128) >> 8);
+}
+
+void greyscale_scalar(uint8_t* data, size_t pixels, size_t channels) {
+    for (size_t i = 0; i < pixels; ++i, data += channels) {
+        data[0] = data[1] = data[2] = luma(data);
+    }
+}
+
+#ifdef IMAGEKERNELS_X86
+IMAGEKERNELS_TARGET("sse4.1")
+inline __m128i luma4_sse41(__m128i rgbx) {
+    const __m128i weights = _mm_setr_epi16(kWeightR, kWeightG, kWeightB, 0,
+                                           kWeightR, kWeightG, kWeightB, 0);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(rgbx, zero), weights);
+    const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(rgbx, zero), weights);
+    const __m128i sum =
+        _mm_add_epi32(_mm_hadd_epi32(lo, hi), _mm_set1_epi32(128));
+    // Luma of each pixel, in the low byte of each 32-bit lane
+    return _mm_srli_epi32(sum, 8);
+}
+
+IMAGEKERNELS_TARGET("sse4.1")
+void greyscale_rgba_sse41(uint8_t* data, size_t pixels) {
+    const __m128i spread =
+        _mm_setr_epi8(0, 0, 0, -1, 4, 4, 4, -1, 8, 8, 8, -1, 12, 12, 12, -1);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xFF000000));
+    size_t i = 0;
+    for (; i + 4 <= pixels; i += 4, data += 16) {
+        const __m128i px = _mm_loadu_si128(reinterpret_cast<__m128i*>(data));
+        const __m128i grey = _mm_shuffle_epi8(luma4_sse41(px), spread);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(data),
+                         _mm_blendv_epi8(grey, px, alpha));
+    }
+    greyscale_scalar(data, pixels - i, 4);
+}
+
+IMAGEKERNELS_TARGET("sse4.1")
+void greyscale_rgb_sse41(uint8_t* data, size_t pixels) {
+    // RGB -> RGB0, for 4 pixels in the low 12 bytes
+    const __m128i expand =
+        _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    // 16 grey bytes -> 48 bytes of RGB
+    const __m128i spread0 =
+        _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+    const __m128i spread1 =
+        _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+    const __m128i spread2 =
+        _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15,
+                      15, 15);
+    size_t i = 0;
+    // 16 pixels per iteration, in three 16-byte loads and stores
+    for (; i + 16 <= pixels; i += 16, data += 48) {
+        auto* ptr = reinterpret_cast<__m128i*>(data);
+        const __m128i v0 = _mm_loadu_si128(ptr);
+        const __m128i v1 = _mm_loadu_si128(ptr + 1);
+        const __m128i v2 = _mm_loadu_si128(ptr + 2);
+        const __m128i l0 = luma4_sse41(_mm_shuffle_epi8(v0, expand));
+        const __m128i l1 =
+            luma4_sse41(_mm_shuffle_epi8(_mm_alignr_epi8(v1, v0, 12), expand));
+        const __m128i l2 =
+            luma4_sse41(_mm_shuffle_epi8(_mm_alignr_epi8(v2, v1, 8), expand));
+        const __m128i l3 =
+            luma4_sse41(_mm_shuffle_epi8(_mm_srli_si128(v2, 4), expand));
+        const __m128i grey = _mm_packus_epi16(_mm_packus_epi32(l0, l1),
+                                              _mm_packus_epi32(l2, l3));
+        _mm_storeu_si128(ptr, _mm_shuffle_epi8(grey, spread0));
+        _mm_storeu_si128(ptr + 1, _mm_shuffle_epi8(grey, spread1));
+        _mm_storeu_si128(ptr + 2, _mm_shuffle_epi8(grey, spread2));
+    }
+    greyscale_scalar(data, pixels - i, 3);
+}
+
+IMAGEKERNELS_TARGET("avx2")
+void greyscale_rgba_avx2(uint8_t* data, size_t pixels) {
+    const __m256i weights = _mm256_setr_epi16(
+        kWeightR, kWeightG, kWeightB, 0, kWeightR, kWeightG, kWeightB, 0,
+        kWeightR, kWeightG, kWeightB, 0, kWeightR, kWeightG, kWeightB, 0);
+    const __m256i spread = _mm256_setr_epi8(
+        0, 0, 0, -1, 4, 4, 4, -1, 8, 8, 8, -1, 12, 12, 12, -1, 0, 0, 0, -1, 4,
+        4, 4, -1, 8, 8, 8, -1, 12, 12, 12, -1);
+    const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xFF000000));
+    const __m256i round = _mm256_set1_epi32(128);
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= pixels; i += 8, data += 32) {
+        const __m256i px =
+            _mm256_loadu_si256(reinterpret_cast<__m256i*>(data));
+        // unpack and hadd both work per 128-bit lane, so pixel order is kept
+        const __m256i lo =
+            _mm256_madd_epi16(_mm256_unpacklo_epi8(px, zero), weights);
+        const __m256i hi =
+            _mm256_madd_epi16(_mm256_unpackhi_epi8(px, zero), weights);
+        const __m256i sum = _mm256_srli_epi32(
+            _mm256_add_epi32(_mm256_hadd_epi32(lo, hi), round), 8);
+        const __m256i grey = _mm256_shuffle_epi8(sum, spread);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(data),
+                            _mm256_blendv_epi8(grey, px, alpha));
+    }
+    greyscale_rgba_sse41(data, pixels - i);
+}
+#endif  // IMAGEKERNELS_X86
+
+#ifdef IMAGEKERNELS_NEON
+inline uint8x16_t luma16_neon(uint8x16_t r, uint8x16_t g, uint8x16_t b) {
+    const uint8x8_t wr = vdup_n_u8(kWeightR);
+    const uint8x8_t wg = vdup_n_u8(kWeightG);
+    const uint8x8_t wb = vdup_n_u8(kWeightB);
+    uint16x8_t lo = vmull_u8(vget_low_u8(r), wr);
+    lo = vmlal_u8(lo, vget_low_u8(g), wg);
+    lo = vmlal_u8(lo, vget_low_u8(b), wb);
+    uint16x8_t hi = vmull_u8(vget_high_u8(r), wr);
+    hi = vmlal_u8(hi, vget_high_u8(g), wg);
+    hi = vmlal_u8(hi, vget_high_u8(b), wb);
+    // Rounding narrow, (x + 128) >> 8
+    return vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8));
+}
+
+void greyscale_rgba_neon(uint8_t* data, size_t pixels) {
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16, data += 64) {
+        uint8x16x4_t px = vld4q_u8(data);
+        const uint8x16_t grey = luma16_neon(px.val[0], px.val[1], px.val[2]);
+        px.val[0] = px.val[1] = px.val[2] = grey;
+        vst4q_u8(data, px);
+    }
+    greyscale_scalar(data, pixels - i, 4);
+}
+
+void greyscale_rgb_neon(uint8_t* data, size_t pixels) {
+    size_t i = 0;
+    for (; i + 16 <= pixels; i += 16, data += 48) {
+        uint8x16x3_t px = vld3q_u8(data);
+        const uint8x16_t grey = luma16_neon(px.val[0], px.val[1], px.val[2]);
+        px.val[0] = px.val[1] = px.val[2] = grey;
+        vst3q_u8(data, px);
+    }
+    greyscale_scalar(data, pixels - i, 3);
+}
+#endif  // IMAGEKERNELS_NEON
+
+Isa detectIsa() {
+#ifdef IMAGEKERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return Isa::kAVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return Isa::kSSE41;
+    }
+#elif defined(IMAGEKERNELS_NEON)
+    return Isa::kNEON;
+#endif
+    return Isa::kScalar;
+}
+
+// Transposes a 4x4 block of 4-byte pixels.
+// out[k] receives column k of the block, top to bottom.
+inline void transpose4x4_u32(const uint8_t* const rows[4],
+                             uint8_t* const out[4]) {
+#if defined(__SSE2__)
+    auto load = [](const uint8_t* p) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    };
+    const __m128i r0 = load(rows[0]);
+    const __m128i r1 = load(rows[1]);
+    const __m128i r2 = load(rows[2]);
+    const __m128i r3 = load(rows[3]);
+    const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+    const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+    const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+    const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[0]),
+                     _mm_unpacklo_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[1]),
+                     _mm_unpackhi_epi64(t0, t1));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[2]),
+                     _mm_unpacklo_epi64(t2, t3));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out[3]),
+                     _mm_unpackhi_epi64(t2, t3));
+#elif defined(IMAGEKERNELS_NEON)
+    auto load = [](const uint8_t* p) {
+        return vreinterpretq_u32_u8(vld1q_u8(p));
+    };
+    const uint32x4x2_t t01 = vtrnq_u32(load(rows[0]), load(rows[1]));
+    const uint32x4x2_t t23 = vtrnq_u32(load(rows[2]), load(rows[3]));
+    auto store = [](uint8_t* p, uint32x2_t a, uint32x2_t b) {
+        vst1q_u8(p, vreinterpretq_u8_u32(vcombine_u32(a, b)));
+    };
+    store(out[0], vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0]));
+    store(out[1], vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1]));
+    store(out[2], vget_high_u32(t01.val[0]), vget_high_u32(t23.val[0]));
+    store(out[3], vget_high_u32(t01.val[1]), vget_high_u32(t23.val[1]));
+#else
+    for (int k = 0; k < 4; ++k) {
+        for (int j = 0; j < 4; ++j) {
+            memcpy(out[k] + j * 4, rows[j] + k * 4, 4);
+        }
+    }
+#endif
+}
+
+// Copies one pixel of compile time size, so the copy is a single move.
+template <size_t N>
+struct PixelCopy {
+    static constexpr size_t kFixedBpp = N;
+    [[nodiscard]] size_t bpp() const { return N; }
+    void operator()(uint8_t* dst, const uint8_t* src) const {
+        memcpy(dst, src, N);
+    }
+};
+
+struct DynamicPixelCopy {
+    static constexpr size_t kFixedBpp = 0;
+    size_t bpp_;
+    [[nodiscard]] size_t bpp() const { return bpp_; }
+    void operator()(uint8_t* dst, const uint8_t* src) const {
+        memcpy(dst, src, bpp_);
+    }
+};
+
+// The destination image is height x width. For 90 degrees, source column x
+// becomes destination row x read bottom to top. For 270 degrees, it becomes
+// destination row (width - 1 - x), read top to bottom.
+template <bool k90, typename Copy>
+void transposeTile(const uint8_t* src, uint8_t* dst, const size_t width,
+                   const size_t height, const size_t x0, const size_t x1,
+                   const size_t y0, const size_t y1, Copy copy) {
+    const size_t bpp = copy.bpp();
+    // Walks a source column, so the destination row is written linearly
+    const auto copyColumn = [&](size_t x, size_t yBegin, size_t yEnd) {
+        const size_t dstRow = k90 ? x : width - 1 - x;
+        for (size_t y = yBegin; y < yEnd; ++y) {
+            const size_t dstCol = k90 ? height - 1 - y : y;
+            copy(dst + (dstRow * height + dstCol) * bpp,
+                 src + (y * width + x) * bpp);
+        }
+    };
+    size_t x = x0;
+
+    if constexpr (Copy::kFixedBpp == 4) {
+        // 4x4 blocks, going down 4 columns at a time. The source rows are
+        // fed in reverse for 90 degrees, so the transposed columns come out
+        // already reversed.
+        const size_t yBlockEnd = y0 + (y1 - y0) / 4 * 4;
+        for (; x + 4 <= x1; x += 4) {
+            for (size_t y = y0; y < yBlockEnd; y += 4) {
+                const uint8_t* rows[4];
+                uint8_t* out[4];
+                for (size_t j = 0; j < 4; ++j) {
+                    const size_t sy = k90 ? y + 3 - j : y + j;
+                    rows[j] = src + (sy * width + x) * 4;
+                }
+                for (size_t k = 0; k < 4; ++k) {
+                    if constexpr (k90) {
+                        out[k] =
+                            dst + ((x + k) * height + (height - 4 - y)) * 4;
+                    } else {
+                        out[k] = dst + ((width - 1 - x - k) * height + y) * 4;
+                    }
+                }
+                transpose4x4_u32(rows, out);
+            }
+            for (size_t k = 0; k < 4; ++k) {
+                copyColumn(x + k, yBlockEnd, y1);
+            }
+        }
+    }
+    for (; x < x1; ++x) {
+        copyColumn(x, y0, y1);
+    }
+}
+
+// If greyscale is not 0, it is the channel count and each written tile is
+// converted while still in cache.
+template <bool k90, typename Copy>
+void transposeTiled(const uint8_t* src, uint8_t* dst, const size_t width,
+                    const size_t height, Copy copy, const int greyscale = 0) {
+    const size_t bpp = copy.bpp();
+    // Bands of source rows write disjoint destination columns
+    parallelFor(tileCount(height), width * height, [&](size_t b0, size_t b1) {
+        for (size_t y0 = b0 * kTileSize; y0 < height && y0 < b1 * kTileSize;
+             y0 += kTileSize) {
+            const size_t y1 = std::min(y0 + kTileSize, height);
+            for (size_t x0 = 0; x0 < width; x0 += kTileSize) {
+                const size_t x1 = std::min(x0 + kTileSize, width);
+                transposeTile<k90>(src, dst, width, height, x0, x1, y0, y1,
+                                   copy);
+                if (greyscale == 0) {
+                    continue;
+                }
+                for (size_t x = x0; x < x1; ++x) {
+                    const size_t dstRow = k90 ? x : width - 1 - x;
+                    const size_t dstCol = k90 ? height - y1 : y0;
+                    to_greyscale(dst + (dstRow * height + dstCol) * bpp,
+                                 y1 - y0, greyscale);
+                }
+            }
+        }
+    });
+}
+
+// Mirrors one row, into the row it ends up in.
+template <typename Copy>
+void rotate180Row(const uint8_t* srcRow, uint8_t* dstRow, const size_t width,
+                  Copy copy, const int greyscale) {
+    const size_t bpp = copy.bpp();
+    size_t x = 0;
+#if defined(__SSE2__)
+    if constexpr (Copy::kFixedBpp == 4) {
+        for (; x + 4 <= width; x += 4) {
+            const __m128i px = _mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(srcRow + x * 4));
+            _mm_storeu_si128(
+                reinterpret_cast<__m128i*>(dstRow + (width - 4 - x) * 4),
+                _mm_shuffle_epi32(px, _MM_SHUFFLE(0, 1, 2, 3)));
+        }
+    }
+#elif defined(IMAGEKERNELS_NEON)
+    if constexpr (Copy::kFixedBpp == 4) {
+        for (; x + 4 <= width; x += 4) {
+            const uint32x4_t px =
+                vrev64q_u32(vreinterpretq_u32_u8(vld1q_u8(srcRow + x * 4)));
+            vst1q_u8(dstRow + (width - 4 - x) * 4,
+                     vreinterpretq_u8_u32(
+                         vcombine_u32(vget_high_u32(px), vget_low_u32(px))));
+        }
+    }
+#endif
+    for (; x < width; ++x) {
+        copy(dstRow + (width - 1 - x) * bpp, srcRow + x * bpp);
+    }
+    if (greyscale != 0) {
+        to_greyscale(dstRow, width, greyscale);
+    }
+}
+
+template <typename Copy>
+void rotate180(const uint8_t* src, uint8_t* dst, const size_t width,
+               const size_t height, Copy copy, const int greyscale = 0) {
+    const size_t bpp = copy.bpp();
+    parallelFor(height, width * height, [&](size_t yBegin, size_t yEnd) {
+        for (size_t y = yBegin; y < yEnd; ++y) {
+            rotate180Row(src + y * width * bpp,
+                         dst + (height - 1 - y) * width * bpp, width, copy,
+                         greyscale);
+        }
+    });
+}
+
+template <typename Copy>
+bool rotateWith(const uint8_t* src, uint8_t* dst, size_t width, size_t height,
+                int angle, Copy copy, const int greyscale = 0) {
+    switch (angle) {
+        case 90:
+            transposeTiled<true>(src, dst, width, height, copy, greyscale);
+            return true;
+        case 180:
+            rotate180(src, dst, width, height, copy, greyscale);
+            return true;
+        case 270:
+            transposeTiled<false>(src, dst, width, height, copy, greyscale);
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Source coordinates are stepped in 32.32 fixed point along a row.
+constexpr int kFixedShift = 32;
+
+int64_t toFixed(double v) {
+    return std::llround(std::ldexp(v, kFixedShift));
+}
+
+size_t fixedToIndex(int64_t v, size_t size) {
+    return std::clamp<int64_t>(v >> kFixedShift, 0,
+                               static_cast<int64_t>(size) - 1);
+}
+
+struct FixedMap {
+    // Source position of the destination pixel (0, 0)
+    int64_t originX, originY;
+    // Source step for one destination pixel along x and y
+    int64_t dxX, dxY;
+    int64_t dyX, dyY;
+};
+
+// Writes the destination in tiles, so rotated reads stay within a few
+// source rows and columns. Greyscale runs on each tile row right after it
+// is written, while it is still in L1.
+template <typename Copy>
+void executeMap(const uint8_t* src, uint8_t* dst, const size_t srcWidth,
+                const size_t srcHeight, const size_t width,
+                const size_t height, const FixedMap& map, const int greyscale,
+                Copy copy) {
+    const size_t bpp = copy.bpp();
+    // Rotations, flips and crops step by whole pixels along a row. The
+    // samples then stay in bounds, and a pointer increment is enough.
+    ptrdiff_t srcStep = 0;
+    constexpr int64_t kOne = int64_t{1} << kFixedShift;
+    if (std::abs(map.dxX) + std::abs(map.dxY) == kOne &&
+        (map.dxX == 0 || map.dxY == 0)) {
+        srcStep = static_cast<ptrdiff_t>(
+            ((map.dxX >> kFixedShift) +
+             (map.dxY >> kFixedShift) * static_cast<int64_t>(srcWidth)) *
+            static_cast<int64_t>(bpp));
+    }
+    // Writes [x0, x1) of the destination row y
+    const auto mapRow = [&](size_t y, size_t x0, size_t x1) {
+        const auto ix0 = static_cast<int64_t>(x0);
+        const auto iy = static_cast<int64_t>(y);
+        int64_t fx = map.originX + ix0 * map.dxX + iy * map.dyX;
+        int64_t fy = map.originY + ix0 * map.dxY + iy * map.dyY;
+        uint8_t* out = dst + (y * width + x0) * bpp;
+        if (srcStep != 0) {
+            const uint8_t* in = src + (fixedToIndex(fy, srcHeight) * srcWidth +
+                                       fixedToIndex(fx, srcWidth)) *
+                                          bpp;
+            for (size_t x = x0; x < x1; ++x, out += bpp) {
+                copy(out, in);
+                in += srcStep;
+            }
+        } else {
+            for (size_t x = x0; x < x1; ++x, out += bpp) {
+                const size_t sx = fixedToIndex(fx, srcWidth);
+                const size_t sy = fixedToIndex(fy, srcHeight);
+                copy(out, src + (sy * srcWidth + sx) * bpp);
+                fx += map.dxX;
+                fy += map.dxY;
+            }
+        }
+        if (greyscale != 0) {
+            to_greyscale(dst + (y * width + x0) * bpp, x1 - x0, greyscale);
+        }
+    };
+    // Bands of destination rows are independent
+    parallelFor(tileCount(height), width * height, [&](size_t b0, size_t b1) {
+        for (size_t y0 = b0 * kTileSize; y0 < height && y0 < b1 * kTileSize;
+             y0 += kTileSize) {
+            const size_t y1 = std::min(y0 + kTileSize, height);
+            for (size_t x0 = 0; x0 < width; x0 += kTileSize) {
+                const size_t x1 = std::min(x0 + kTileSize, width);
+                for (size_t y = y0; y < y1; ++y) {
+                    mapRow(y, x0, x1);
+                }
+            }
+        }
+    });
+}
+
+}  // namespace
+
+Isa bestIsa() {
+    static const Isa isa = detectIsa();
+    return isa;
+}
+
+bool isSupported(Isa isa) {
+    const Isa best = bestIsa();
+    switch (isa) {
+        case Isa::kScalar:
+            return true;
+        case Isa::kSSE41:
+            return best == Isa::kSSE41 || best == Isa::kAVX2;
+        case Isa::kAVX2:
+        case Isa::kNEON:
+            return best == isa;
+    }
+    return false;
+}
+
+std::string_view isaName(Isa isa) {
+    switch (isa) {
+        case Isa::kScalar:
+            return "scalar";
+        case Isa::kSSE41:
+            return "sse4.1";
+        case Isa::kAVX2:
+            return "avx2";
+        case Isa::kNEON:
+            return "neon";
+    }
+    return "unknown";
+}
+
+bool rotate(const uint8_t* src, uint8_t* dst, size_t width, size_t height,
+            int channels, int angle) {
+    switch (channels) {
+        case 1:
+            return rotateWith(src, dst, width, height, angle, PixelCopy<1>{});
+        case 3:
+            return rotateWith(src, dst, width, height, angle, PixelCopy<3>{});
+        case 4:
+            return rotateWith(src, dst, width, height, angle, PixelCopy<4>{});
+        default:
+            if (channels <= 0) {
+                LOG(ERROR) << "Invalid channel count: " << channels;
+                return false;
+            }
+            return rotateWith(src, dst, width, height, angle,
+                              DynamicPixelCopy{static_cast<size_t>(channels)});
+    }
+}
+
+bool to_greyscale(uint8_t* data, size_t pixels, int channels) {
+    return to_greyscale(data, pixels, channels, bestIsa());
+}
+
+namespace {
+
+// Greyscale blocks processed by one thread at a time
+constexpr size_t kGreyscaleBlock = size_t{1} << 16;
+
+void greyscaleWith(uint8_t* data, size_t pixels, int channels, Isa isa) {
+    switch (isa) {
+#ifdef IMAGEKERNELS_X86
+        case Isa::kAVX2:
+            if (channels == 4) {
+                greyscale_rgba_avx2(data, pixels);
+                return;
+            }
+            // No AVX2 variant for RGB, pixels cross the 128-bit lanes
+            [[fallthrough]];
+        case Isa::kSSE41:
+            if (channels == 4) {
+                greyscale_rgba_sse41(data, pixels);
+            } else {
+                greyscale_rgb_sse41(data, pixels);
+            }
+            return;
+#endif
+#ifdef IMAGEKERNELS_NEON
+        case Isa::kNEON:
+            if (channels == 4) {
+                greyscale_rgba_neon(data, pixels);
+            } else {
+                greyscale_rgb_neon(data, pixels);
+            }
+            return;
+#endif
+        default:
+            greyscale_scalar(data, pixels, channels);
+            return;
+    }
+}
+
+}  // namespace
+
+bool to_greyscale(uint8_t* data, size_t pixels, int channels, Isa isa) {
+    if (channels != 3 && channels != 4) {
+        return false;
+    }
+    if (!isSupported(isa)) {
+        isa = Isa::kScalar;
+    }
+    const size_t blocks = (pixels + kGreyscaleBlock - 1) / kGreyscaleBlock;
+    if (blocks <= 1) {
+        // The tiled kernels convert short rows, skip the pool for those
+        greyscaleWith(data, pixels, channels, isa);
+        return true;
+    }
+    parallelFor(blocks, pixels, [&](size_t b0, size_t b1) {
+        const size_t begin = b0 * kGreyscaleBlock;
+        const size_t end = std::min(b1 * kGreyscaleBlock, pixels);
+        greyscaleWith(data + begin * channels, end - begin, channels, isa);
+    });
+    return true;
+}
+
+PixelBuffer& threadArena() {
+    thread_local PixelBuffer arena;
+    return arena;
+}
+
+TransformPlan::TransformPlan(size_t width, size_t height)
+    : map_{0, 0, 1, 0, 0, 1},
+      srcWidth_(width),
+      srcHeight_(height),
+      width_(width),
+      height_(height) {}
+
+void TransformPlan::compose(const Affine& step) {
+    const Affine cur = map_;
+    map_.originX =
+        cur.originX + step.originX * cur.dxX + step.originY * cur.dyX;
+    map_.originY =
+        cur.originY + step.originX * cur.dxY + step.originY * cur.dyY;
+    map_.dxX = step.dxX * cur.dxX + step.dxY * cur.dyX;
+    map_.dxY = step.dxX * cur.dxY + step.dxY * cur.dyY;
+    map_.dyX = step.dyX * cur.dxX + step.dyY * cur.dyX;
+    map_.dyY = step.dyX * cur.dxY + step.dyY * cur.dyY;
+}
+
+bool TransformPlan::rotate(int angle) {
+    const auto w = static_cast<double>(width_);
+    const auto h = static_cast<double>(height_);
+    switch (angle) {
+        case 0:
+        case 360:
+            return true;
+        case 90:
+            // The new top right corner was the old top left
+            compose({0, h, 0, -1, 1, 0});
+            break;
+        case 180:
+            compose({w, h, -1, 0, 0, -1});
+            rotation_ = (rotation_ + angle) % 360;
+            return true;
+        case 270:
+            compose({w, 0, 0, 1, -1, 0});
+            break;
+        default:
+            return false;
+    }
+    rotation_ = (rotation_ + angle) % 360;
+    std::swap(width_, height_);
+    return true;
+}
+
+void TransformPlan::flip(bool horizontal) {
+    const auto w = static_cast<double>(width_);
+    const auto h = static_cast<double>(height_);
+    rotationOnly_ = false;
+    if (horizontal) {
+        compose({w, 0, -1, 0, 0, 1});
+    } else {
+        compose({0, h, 1, 0, 0, -1});
+    }
+}
+
+bool TransformPlan::crop(size_t x, size_t y, size_t width, size_t height) {
+    if (width == 0 || height == 0 || x >= width_ || y >= height_ ||
+        width > width_ - x || height > height_ - y) {
+        return false;
+    }
+    rotationOnly_ = false;
+    compose({static_cast<double>(x), static_cast<double>(y), 1, 0, 0, 1});
+    width_ = width;
+    height_ = height;
+    return true;
+}
+
+bool TransformPlan::resize(size_t width, size_t height) {
+    if (width == 0 || height == 0) {
+        return false;
+    }
+    rotationOnly_ = false;
+    compose({0, 0,
+             static_cast<double>(width_) / static_cast<double>(width), 0, 0,
+             static_cast<double>(height_) / static_cast<double>(height)});
+    width_ = width;
+    height_ = height;
+    return true;
+}
+
+void TransformPlan::greyscale() { greyscale_ = true; }
+
+bool TransformPlan::isIdentity() const {
+    return width_ == srcWidth_ && height_ == srcHeight_ && map_.originX == 0 &&
+           map_.originY == 0 && map_.dxX == 1 && map_.dxY == 0 &&
+           map_.dyX == 0 && map_.dyY == 1;
+}
+
+bool TransformPlan::execute(const uint8_t* src, uint8_t* dst,
+                            int channels) const {
+    if (channels <= 0 || (greyscale_ && channels != 3 && channels != 4)) {
+        LOG(ERROR) << "Unsupported channel count: " << channels;
+        return false;
+    }
+    const int grey = greyscale_ ? channels : 0;
+    if (rotationOnly_ && rotation_ != 0) {
+        // The rotation kernels are faster than sampling, and can do the
+        // greyscale conversion tile by tile too.
+        switch (channels) {
+            case 1:
+                return rotateWith(src, dst, srcWidth_, srcHeight_, rotation_,
+                                  PixelCopy<1>{}, grey);
+            case 3:
+                return rotateWith(src, dst, srcWidth_, srcHeight_, rotation_,
+                                  PixelCopy<3>{}, grey);
+            case 4:
+                return rotateWith(src, dst, srcWidth_, srcHeight_, rotation_,
+                                  PixelCopy<4>{}, grey);
+            default:
+                return rotateWith(
+                    src, dst, srcWidth_, srcHeight_, rotation_,
+                    DynamicPixelCopy{static_cast<size_t>(channels)}, grey);
+        }
+    }
+    // Sample at pixel centers, the mapping works on pixel edges
+    const FixedMap map{
+        toFixed(map_.originX + (map_.dxX + map_.dyX) / 2),
+        toFixed(map_.originY + (map_.dxY + map_.dyY) / 2),
+        toFixed(map_.dxX),
+        toFixed(map_.dxY),
+        toFixed(map_.dyX),
+        toFixed(map_.dyY),
+    };
+    switch (channels) {
+        case 1:
+            executeMap(src, dst, srcWidth_, srcHeight_, width_, height_, map,
+                       grey, PixelCopy<1>{});
+            break;
+        case 3:
+            executeMap(src, dst, srcWidth_, srcHeight_, width_, height_, map,
+                       grey, PixelCopy<3>{});
+            break;
+        case 4:
+            executeMap(src, dst, srcWidth_, srcHeight_, width_, height_, map,
+                       grey, PixelCopy<4>{});
+            break;
+        default:
+            executeMap(src, dst, srcWidth_, srcHeight_, width_, height_, map,
+                       grey, DynamicPixelCopy{static_cast<size_t>(channels)});
+            break;
+    }
+    return true;
+}
+
+}  // namespace ImageKernels
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+/**
+ * @brief Pixel kernels shared by the PhotoBase backends.
+ *
+ * All buffers are tightly packed, 8 bits per channel, in RGB(A) order.
+ */
+namespace ImageKernels {
+
+enum class Isa {
+    kScalar,
+    kSSE41,
+    kAVX2,
+    kNEON,
+};
+
+/**
+ * @brief Returns the best instruction set usable on this CPU.
+ *
+ * Detected once, on the first call.
+ */
+[[nodiscard]] Isa bestIsa();
+
+/**
+ * @brief Returns whether kernels for the given instruction set can run here.
+ */
+[[nodiscard]] bool isSupported(Isa isa);
+
+[[nodiscard]] std::string_view isaName(Isa isa);
+
+/**
+ * @brief Rotates an image clockwise, into a separate buffer.
+ *
+ * 90 and 270 degree rotations are transposes done in cache sized tiles, so
+ * both the source and the destination are walked mostly linearly.
+ *
+ * @param[in] src Source pixels, width * height * channels bytes.
+ * @param[out] dst Destination pixels, same size as src. Must not overlap src.
+ * @param[in] width Width of the source image.
+ * @param[in] height Height of the source image.
+ * @param[in] channels Bytes per pixel.
+ * @param[in] angle One of 90, 180 or 270.
+ *
+ * @return false if the angle is not supported, true otherwise.
+ */
+bool rotate(const uint8_t* src, uint8_t* dst, size_t width, size_t height,
+            int channels, int angle);
+
+/**
+ * @brief Converts RGB or RGBA pixels to greyscale, in place.
+ *
+ * Uses the BT.601 luma weights in 8-bit fixed point. Alpha is preserved.
+ *
+ * @param[in,out] data The pixels.
+ * @param[in] pixels Number of pixels in data.
+ * @param[in] channels 3 for RGB, 4 for RGBA.
+ *
+ * @return false if the channel count is not supported, true otherwise.
+ */
+bool to_greyscale(uint8_t* data, size_t pixels, int channels);
+
+/**
+ * @brief Same as above, but forces an instruction set.
+ *
+ * Falls back to the scalar kernel if isa is not supported.
+ */
+bool to_greyscale(uint8_t* data, size_t pixels, int channels, Isa isa);
+
+/**
+ * @brief A pixel buffer which remembers its capacity, so it can be reused.
+ */
+struct PixelBuffer {
+    std::unique_ptr<uint8_t[]> data;
+    size_t capacity = 0;
+
+    // Grows the buffer if needed. The contents are not kept.
+    void reserve(size_t size) {
+        if (capacity < size) {
+            data = std::make_unique_for_overwrite<uint8_t[]>(size);
+            capacity = size;
+        }
+    }
+};
+
+/**
+ * @brief Per-thread scratch buffer for transform outputs.
+ *
+ * Backends swap it with their own pixel buffer after a transform, so the
+ * previous image's memory is reused by the next request on this thread.
+ */
+PixelBuffer& threadArena();
+
+/**
+ * @brief Rotations, flips, crops, resizes and greyscale, fused in one pass.
+ *
+ * The geometric steps are composed into a single mapping from destination
+ * pixels back to the source, so the whole plan reads the source and writes
+ * the destination once. Resizing samples the nearest pixel.
+ */
+class TransformPlan {
+   public:
+    TransformPlan(size_t width, size_t height);
+
+    // Clockwise, one of 0, 90, 180, 270 or 360. false otherwise.
+    bool rotate(int angle);
+    void flip(bool horizontal);
+    // false if the rectangle is empty or not inside the current image.
+    bool crop(size_t x, size_t y, size_t width, size_t height);
+    // false if any dimension is 0.
+    bool resize(size_t width, size_t height);
+    void greyscale();
+
+    // Output dimensions, after the steps so far.
+    [[nodiscard]] size_t width() const { return width_; }
+    [[nodiscard]] size_t height() const { return height_; }
+    // Whether the pixels don't move at all, greyscale aside.
+    [[nodiscard]] bool isIdentity() const;
+    [[nodiscard]] bool hasGreyscale() const { return greyscale_; }
+
+    /**
+     * @brief Runs the plan.
+     *
+     * @param[in] src The source pixels, as given to the constructor.
+     * @param[out] dst width() * height() * channels bytes, must not overlap.
+     * @param[in] channels Bytes per pixel.
+     *
+     * @return false if the channel count is not supported, true otherwise.
+     */
+    bool execute(const uint8_t* src, uint8_t* dst, int channels) const;
+
+   private:
+    // Maps a pixel center in the current image to one in the source, as
+    // source = origin + x * dx + y * dy.
+    struct Affine {
+        double originX, originY;
+        double dxX, dxY;
+        double dyX, dyY;
+    };
+    // The step's mapping from new to current coordinates, composed after ours
+    void compose(const Affine& step);
+
+    Affine map_;
+    size_t srcWidth_;
+    size_t srcHeight_;
+    size_t width_;
+    size_t height_;
+    // Clockwise, as long as only rotate() was used
+    int rotation_ = 0;
+    bool rotationOnly_ = true;
+    bool greyscale_ = false;
+};
+
+}  // namespace ImageKernels
@@ -0,0 +1,88 @@
+#include "ImagePBase.hpp"
+
+#include "ImageKernels.hpp"
+
+PhotoBase::Result PhotoBase::transform(const TransformPipeline& pipeline) {
+    const auto view = pixels();
+    if (!view) {
+        for (const auto& step : pipeline.steps) {
+            const Result result = applyStep(step);
+            if (result != Result::kSuccess) {
+                return result;
+            }
+        }
+        return Result::kSuccess;
+    }
+    if (view->data == nullptr) {
+        LOG(ERROR) << "No image data to transform";
+        return Result::kErrorNoData;
+    }
+
+    ImageKernels::TransformPlan plan(view->width, view->height);
+    for (const auto& step : pipeline.steps) {
+        using Type = TransformPipeline::Step::Type;
+        switch (step.type) {
+            case Type::kRotate:
+                if (!plan.rotate(step.angle)) {
+                    LOG(WARNING) << "Cannot handle angle: " << step.angle;
+                    return Result::kErrorUnsupportedAngle;
+                }
+                break;
+            case Type::kFlip:
+                plan.flip(step.horizontal);
+                break;
+            case Type::kCrop:
+                if (!plan.crop(step.x, step.y, step.width, step.height)) {
+                    LOG(ERROR) << "Invalid crop: " << step.width << "x"
+                               << step.height << " at " << step.x << ","
+                               << step.y;
+                    return Result::kErrorInvalidArgument;
+                }
+                break;
+            case Type::kResize:
+                if (!plan.resize(step.width, step.height)) {
+                    LOG(ERROR) << "Invalid size: " << step.width << "x"
+                               << step.height;
+                    return Result::kErrorInvalidArgument;
+                }
+                break;
+            case Type::kGreyscale:
+                if (view->channels == 3 || view->channels == 4) {
+                    plan.greyscale();
+                } else {
+                    LOG(WARNING) << "Image does not have enough color "
+                                    "channels to convert to grayscale.";
+                }
+                break;
+        }
+    }
+
+    if (plan.isIdentity()) {
+        // Nothing moves, so there is no need for a second buffer
+        if (plan.hasGreyscale()) {
+            ImageKernels::to_greyscale(view->data, view->width * view->height,
+                                       view->channels);
+        }
+        return Result::kSuccess;
+    }
+    auto& arena = ImageKernels::threadArena();
+    arena.reserve(plan.width() * plan.height() * view->channels);
+    if (!plan.execute(view->data, arena.data.get(), view->channels)) {
+        return Result::kErrorInvalidArgument;
+    }
+    adoptPixels(arena, plan.width(), plan.height());
+    return Result::kSuccess;
+}
+
+PhotoBase::Result PhotoBase::applyStep(const TransformPipeline::Step& step) {
+    switch (step.type) {
+        case TransformPipeline::Step::Type::kRotate:
+            return rotate_image(step.angle);
+        case TransformPipeline::Step::Type::kGreyscale:
+            to_greyscale();
+            return Result::kSuccess;
+        default:
+            LOG(WARNING) << "Unsupported transform step for " << version();
+            return Result::kErrorUnsupportedOperation;
+    }
+}
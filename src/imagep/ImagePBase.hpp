@@ -2,7 +2,71 @@
 
 #include <absl/log/log.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "ImageKernels.hpp"
+
+/**
+ * @brief A list of edits to apply to an image, in order.
+ *
+ * Built with the chaining methods, and run with PhotoBase::transform().
+ */
+struct TransformPipeline {
+    struct Step {
+        enum class Type {
+            kRotate,
+            kFlip,
+            kCrop,
+            kResize,
+            kGreyscale,
+        };
+        Type type;
+        // kRotate: in degrees, as for PhotoBase::rotate_image()
+        int angle = 0;
+        // kFlip: mirror left to right if true, top to bottom otherwise
+        bool horizontal = false;
+        // kCrop: the rectangle to keep. kResize: only width and height
+        size_t x = 0;
+        size_t y = 0;
+        size_t width = 0;
+        size_t height = 0;
+    };
+
+    TransformPipeline& rotate(int angle) {
+        steps.push_back({.type = Step::Type::kRotate, .angle = angle});
+        return *this;
+    }
+    TransformPipeline& flip(bool horizontal) {
+        steps.push_back({.type = Step::Type::kFlip, .horizontal = horizontal});
+        return *this;
+    }
+    TransformPipeline& crop(size_t x, size_t y, size_t width, size_t height) {
+        steps.push_back({.type = Step::Type::kCrop,
+                         .x = x,
+                         .y = y,
+                         .width = width,
+                         .height = height});
+        return *this;
+    }
+    TransformPipeline& resize(size_t width, size_t height) {
+        steps.push_back(
+            {.type = Step::Type::kResize, .width = width, .height = height});
+        return *this;
+    }
+    TransformPipeline& greyscale() {
+        steps.push_back({.type = Step::Type::kGreyscale});
+        return *this;
+    }
+
+    std::vector<Step> steps;
+};
 
 /**
  * @brief Base class for photo manipulation.
@@ -22,15 +86,30 @@ struct PhotoBase {
         kErrorUnsupportedAngle,
         kErrorInvalidArgument,
         kErrorNoData,
+        kErrorUnsupportedOperation,
     };
 
+    /**
+     * @brief Reads an image from an encoded in-memory buffer.
+     *
+     * @param[in] buffer The encoded image.
+     * @return True if the image was successfully read, false otherwise.
+     */
+    virtual bool read(std::span<const uint8_t> buffer) = 0;
+
     /**
      * @brief Reads an image from the specified file.
      *
      * @param[in] filename The path to the image file.
      * @return True if the image was successfully read, false otherwise.
      */
-    virtual bool read(const std::filesystem::path& filename) = 0;
+    bool read(const std::filesystem::path& filename) {
+        std::vector<uint8_t> buffer;
+        if (!readFile(filename, buffer)) {
+            return false;
+        }
+        return read(buffer);
+    }
 
     /**
      * @brief Rotates the image by the specified angle.
@@ -57,13 +136,54 @@ struct PhotoBase {
      */
     virtual void to_greyscale() = 0;
 
+    /**
+     * @brief Applies all steps of a pipeline.
+     *
+     * Backends exposing their pixels get the whole pipeline in a single pass
+     * over the image, written into a per-thread buffer that is recycled
+     * across calls. Other backends run the steps one by one.
+     *
+     * @param[in] pipeline The steps to apply.
+     * @return kSuccess, or the error of the first step that failed. The image
+     * is unchanged unless the steps run one by one.
+     */
+    Result transform(const TransformPipeline& pipeline);
+
+    /**
+     * @brief Encodes the image into an in-memory buffer.
+     *
+     * The format is the one of the backend, see mimeType().
+     *
+     * @param[out] buffer The encoded image, replaces any previous contents.
+     * @return True if the image was successfully encoded, false otherwise.
+     */
+    virtual bool write(std::vector<uint8_t>& buffer) = 0;
+
     /**
      * @brief Writes the image to the specified file.
      *
      * @param[in] filename The path to the image file.
      * @return True if the image was successfully written, false otherwise.
      */
-    virtual bool write(const std::filesystem::path& filename) = 0;
+    bool write(const std::filesystem::path& filename) {
+        std::vector<uint8_t> buffer;
+        if (!write(buffer)) {
+            return false;
+        }
+        std::ofstream ofs(filename, std::ios::binary);
+        if (!ofs) {
+            LOG(ERROR) << "Can't open file " << filename << " for writing";
+            return false;
+        }
+        ofs.write(reinterpret_cast<const char*>(buffer.data()),
+                  static_cast<std::streamsize>(buffer.size()));
+        return ofs.good();
+    }
+
+    /**
+     * @brief The MIME type of what write() produces.
+     */
+    [[nodiscard]] virtual std::string_view mimeType() const = 0;
 
     /**
      * @brief Destructor for the photo manipulation base class.
@@ -71,22 +191,64 @@ struct PhotoBase {
     virtual ~PhotoBase() = default;
 
     /**
-     * @brief Creates a unique_ptr that will automatically close the given FILE*
-     * when it goes out of scope.
-     *
-     * @param file The FILE* to be closed when the unique_ptr goes out of scope.
+     * @brief Reads a whole file into memory.
      *
-     * @return A unique_ptr that will automatically close the given FILE* when
-     * it goes out of scope.
+     * @param[in] filename The path to the file.
+     * @param[out] buffer The contents of the file.
+     * @return True if the file was successfully read, false otherwise.
      */
-    static auto createFileCloser(FILE* file) {
-        return std::unique_ptr<FILE, void (*)(FILE*)>(
-            file, [](FILE* f) { fclose(f); });
+    static bool readFile(const std::filesystem::path& filename,
+                         std::vector<uint8_t>& buffer) {
+        std::ifstream ifs(filename, std::ios::binary | std::ios::ate);
+        if (!ifs) {
+            LOG(ERROR) << "Can't open file " << filename << " for reading";
+            return false;
+        }
+        buffer.resize(static_cast<size_t>(ifs.tellg()));
+        ifs.seekg(0);
+        ifs.read(reinterpret_cast<char*>(buffer.data()),
+                 static_cast<std::streamsize>(buffer.size()));
+        return ifs.good();
     }
 
     [[nodiscard]] virtual std::string version() const = 0;
 
    protected:
+    struct PixelView {
+        uint8_t* data;
+        size_t width;
+        size_t height;
+        int channels;
+    };
+
+    /**
+     * @brief The decoded pixels, tightly packed, for the fused transforms.
+     *
+     * @return std::nullopt if the backend keeps its pixels elsewhere, which
+     * makes transform() fall back to applyStep().
+     */
+    virtual std::optional<PixelView> pixels() { return std::nullopt; }
+
+    /**
+     * @brief Takes over the transformed pixels.
+     *
+     * Implementations swap the buffer with their own, so the old pixels go
+     * back to the caller for reuse.
+     *
+     * @param[in,out] buffer The new pixels, with the same channel count.
+     * @param[in] width The new width.
+     * @param[in] height The new height.
+     */
+    virtual void adoptPixels(ImageKernels::PixelBuffer& buffer, size_t width,
+                             size_t height) {}
+
+    /**
+     * @brief Applies a single step, for backends without pixels().
+     *
+     * Handles rotation and greyscale, and nothing else by default.
+     */
+    virtual Result applyStep(const TransformPipeline::Step& step);
+
     /**
      * @brief Rotates the image by the specified angle.
      *
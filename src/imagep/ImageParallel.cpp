@@ -0,0 +1,192 @@
+#include "ImageParallel.hpp"
+
+#include <absl/log/log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ImageKernels {
+
+namespace {
+
+// Set on pool threads, nested parallelFor calls run inline there so a
+// worker never waits on work queued behind itself.
+thread_local bool tIsPoolThread = false;
+
+// One parallelFor call. Workers that start after all ranges are taken
+// only touch this, which is kept alive by the shared_ptr.
+struct Job {
+    const std::function<void(size_t, size_t)>* fn;
+    size_t count;
+    size_t grain;
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+
+    // Takes ranges until none are left
+    void run() {
+        for (;;) {
+            const size_t begin = next.fetch_add(grain);
+            if (begin >= count) {
+                return;
+            }
+            const size_t end = std::min(begin + grain, count);
+            (*fn)(begin, end);
+            if (done.fetch_add(end - begin) + (end - begin) == count) {
+                done.notify_all();
+            }
+        }
+    }
+};
+
+class ThreadPool {
+   public:
+    explicit ThreadPool(unsigned threads) {
+        workers_.reserve(threads);
+        for (unsigned i = 0; i < threads; ++i) {
+            workers_.emplace_back([this] { workerMain(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        // jthreads join here
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    [[nodiscard]] size_t size() const { return workers_.size(); }
+
+    void post(const std::shared_ptr<Job>& job, unsigned copies) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (unsigned i = 0; i < copies; ++i) {
+                queue_.push_back(job);
+            }
+        }
+        if (copies == 1) {
+            cv_.notify_one();
+        } else {
+            cv_.notify_all();
+        }
+    }
+
+   private:
+    void workerMain() {
+        tIsPoolThread = true;
+        for (;;) {
+            std::shared_ptr<Job> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return stopping_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                job = std::move(queue_.front());
+                queue_.pop_front();
+            }
+            job->run();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::shared_ptr<Job>> queue_;
+    bool stopping_ = false;
+    std::vector<std::jthread> workers_;
+};
+
+struct PoolState {
+    std::mutex mutex;
+    std::shared_ptr<ThreadPool> pool;
+    unsigned threads = 0;
+    size_t minPixels = kDefaultParallelMinPixels;
+};
+
+PoolState& state() {
+    static PoolState state;
+    return state;
+}
+
+unsigned resolveThreads(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    return threads;
+}
+
+}  // namespace
+
+void setParallelism(unsigned threads, size_t minPixels) {
+    auto& s = state();
+    std::shared_ptr<ThreadPool> old;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (resolveThreads(threads) != resolveThreads(s.threads)) {
+            // Recreated lazily, with the new size
+            old = std::move(s.pool);
+        }
+        s.threads = threads;
+        s.minPixels = minPixels;
+    }
+    LOG(INFO) << "Image processing threads: " << resolveThreads(threads)
+              << ", from " << minPixels << " pixels";
+}
+
+unsigned parallelism() {
+    auto& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return resolveThreads(s.threads);
+}
+
+void parallelFor(size_t count, size_t pixels,
+                 const std::function<void(size_t, size_t)>& fn) {
+    if (count == 0) {
+        return;
+    }
+    std::shared_ptr<ThreadPool> pool;
+    if (count > 1 && !tIsPoolThread) {
+        auto& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        const unsigned threads = resolveThreads(s.threads);
+        if (threads > 1 && pixels >= s.minPixels) {
+            if (!s.pool) {
+                // The caller is one of the threads
+                s.pool = std::make_shared<ThreadPool>(threads - 1);
+            }
+            pool = s.pool;
+        }
+    }
+    if (!pool) {
+        fn(0, count);
+        return;
+    }
+
+    const auto helpers =
+        static_cast<unsigned>(std::min<size_t>(pool->size(), count - 1));
+    auto job = std::make_shared<Job>();
+    job->fn = &fn;
+    job->count = count;
+    // A few ranges per thread, so a slow one doesn't hold up the rest
+    job->grain = std::max<size_t>(1, count / ((helpers + 1) * 4));
+    pool->post(job, helpers);
+    job->run();
+
+    // Ranges taken by the workers may still be running
+    for (size_t done = job->done.load(); done != count;
+         done = job->done.load()) {
+        job->done.wait(done);
+    }
+}
+
+}  // namespace ImageKernels
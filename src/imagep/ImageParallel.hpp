@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * @brief The thread pool the image kernels split large images on.
+ *
+ * The pool is shared by all images and created on first use.
+ */
+namespace ImageKernels {
+
+// Images with fewer pixels than this are processed on the calling thread.
+constexpr size_t kDefaultParallelMinPixels = 1 << 20;
+
+/**
+ * @brief Configures the shared pool.
+ *
+ * Can be called at any time, calls already running keep the old pool.
+ *
+ * @param[in] threads Threads working on one image, the caller included. 0
+ * means one per core, 1 disables the pool.
+ * @param[in] minPixels Images below this size stay single threaded.
+ */
+void setParallelism(unsigned threads,
+                    size_t minPixels = kDefaultParallelMinPixels);
+
+/**
+ * @brief Threads working on one image, the caller included.
+ */
+[[nodiscard]] unsigned parallelism();
+
+/**
+ * @brief Runs fn over [0, count), split across the pool.
+ *
+ * fn is called with disjoint [begin, end) ranges and must be safe to call
+ * concurrently. The caller takes part, and returns once every range is done.
+ * Runs everything on the calling thread if the pool is disabled, if pixels
+ * is below the threshold, or if called from a pool thread.
+ *
+ * @param[in] count Number of work items.
+ * @param[in] pixels Pixels covered by all items, compared to the threshold.
+ * @param[in] fn The work.
+ */
+void parallelFor(size_t count, size_t pixels,
+                 const std::function<void(size_t, size_t)>& fn);
+
+}  // namespace ImageKernels
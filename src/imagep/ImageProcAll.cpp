@@ -1,38 +1,91 @@
 #include "ImageProcAll.hpp"
 
+#include <algorithm>
+#include <array>
 #include <filesystem>
 
 #include "imagep/ImagePBase.hpp"
 
 ImageProcessingAll::ImageProcessingAll(std::filesystem::path filename)
-    : _filename(std::move(filename)) {
-#ifdef HAVE_OPENCV
-    impls.emplace_back(std::make_unique<OpenCVImage>());
-#endif
+    : _filename(std::move(filename)) {}
+
+ImageProcessingAll::Format ImageProcessingAll::detectFormat(
+    std::span<const uint8_t> buffer) {
+    constexpr std::array<uint8_t, 3> kJPEGMagic = {0xFF, 0xD8, 0xFF};
+    constexpr std::array<uint8_t, 8> kPNGMagic = {0x89, 'P',  'N',  'G',
+                                                  '\r', '\n', 0x1A, '\n'};
+    constexpr std::array<uint8_t, 4> kRIFFMagic = {'R', 'I', 'F', 'F'};
+    constexpr std::array<uint8_t, 4> kWebPMagic = {'W', 'E', 'B', 'P'};
+    constexpr size_t kWebPMagicOffset = 8;
+
+    const auto startsWith = [buffer](size_t offset, const auto& magic) {
+        return buffer.size() >= offset + magic.size() &&
+               std::ranges::equal(buffer.subspan(offset, magic.size()), magic);
+    };
+
+    if (startsWith(0, kJPEGMagic)) {
+        return Format::kJPEG;
+    }
+    if (startsWith(0, kPNGMagic)) {
+        return Format::kPNG;
+    }
+    if (startsWith(0, kRIFFMagic) && startsWith(kWebPMagicOffset, kWebPMagic)) {
+        return Format::kWebP;
+    }
+    return Format::kUnknown;
+}
+
+std::unique_ptr<PhotoBase> ImageProcessingAll::createForFormat(Format format) {
+    // Prefer the dedicated library, and let OpenCV handle the rest.
+    switch (format) {
+        case Format::kJPEG:
 #ifdef HAVE_LIBJPEG
-    impls.emplace_back(std::make_unique<JPEGImage>());
+            return std::make_unique<JPEGImage>();
+#else
+            break;
 #endif
+        case Format::kPNG:
 #ifdef HAVE_LIBPNG
-    impls.emplace_back(std::make_unique<PngImage>());
+            return std::make_unique<PngImage>();
+#else
+            break;
 #endif
+        case Format::kWebP:
 #ifdef HAVE_LIBWEBP
-    impls.emplace_back(std::make_unique<WebPImage>());
+            return std::make_unique<WebPImage>();
+#else
+            break;
+#endif
+        case Format::kUnknown:
+            break;
+    }
+#ifdef HAVE_OPENCV
+    return std::make_unique<OpenCVImage>();
+#else
+    return nullptr;
 #endif
 }
 
 bool ImageProcessingAll::read() {
-    for (auto& impl : impls) {
-        if (impl->read(_filename)) {
-            // We found the backend suitable. Select one and dealloc others.
-            _impl = std::move(impl);
-            impls.clear();
+    std::vector<uint8_t> buffer;
+    if (!PhotoBase::readFile(_filename, buffer)) {
+        return false;
+    }
+    return read(buffer);
+}
 
-            LOG(INFO) << "Using implementation: " << _impl->version();
-            return true;
-        }
+bool ImageProcessingAll::read(std::span<const uint8_t> buffer) {
+    _impl = createForFormat(detectFormat(buffer));
+    if (!_impl) {
+        LOG(INFO) << "No backend was suitable to read";
+        return false;
     }
-    LOG(INFO) << "No backend was suitable to read";
-    return false;
+    LOG(INFO) << "Using implementation: " << _impl->version();
+    if (!_impl->read(buffer)) {
+        _impl.reset();
+        return false;
+    }
+    return true;
 }
 
 PhotoBase::Result ImageProcessingAll::rotate(int angle) {
@@ -53,6 +106,17 @@ void ImageProcessingAll::to_greyscale() {
     _impl->to_greyscale();
 }
 
+PhotoBase::Result ImageProcessingAll::transform(
+    const TransformPipeline& pipeline) {
+    if (!_impl) {
+        LOG(ERROR) << "No backend selected for transform";
+        return PhotoBase::Result::kErrorNoData;
+    }
+    DLOG(INFO) << "Calling impl->transform with " << pipeline.steps.size()
+               << " steps";
+    return _impl->transform(pipeline);
+}
+
 bool ImageProcessingAll::write(const std::filesystem::path& filename) {
     if (!_impl) {
         LOG(ERROR) << "No backend selected for writing";
@@ -64,4 +128,20 @@ bool ImageProcessingAll::write(const std::filesystem::path& filename) {
     }
     DLOG(INFO) << "Calling impl->write with filename: " << filename;
     return _impl->write(filename);
-}
\ No newline at end of file
+}
+
+bool ImageProcessingAll::write(std::vector<uint8_t>& buffer) {
+    if (!_impl) {
+        LOG(ERROR) << "No backend selected for writing";
+        return false;
+    }
+    DLOG(INFO) << "Calling impl->write into memory";
+    return _impl->write(buffer);
+}
+
+std::string_view ImageProcessingAll::mimeType() const {
+    if (!_impl) {
+        return {};
+    }
+    return _impl->mimeType();
+}
@@ -1,6 +1,10 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
 
 #ifdef HAVE_OPENCV
 #include "ImageProcOpenCV.hpp"
@@ -17,15 +21,34 @@
 #include "imagep/ImagePBase.hpp"
 
 struct ImageProcessingAll {
+    enum class Format {
+        kUnknown,
+        kJPEG,
+        kPNG,
+        kWebP,
+    };
+
+    /**
+     * @brief Detects the format of an encoded image from its magic bytes.
+     */
+    static Format detectFormat(std::span<const uint8_t> buffer);
+
     bool read();
+    bool read(std::span<const uint8_t> buffer);
     PhotoBase::Result rotate(int angle);
     void to_greyscale();
+    PhotoBase::Result transform(const TransformPipeline& pipeline);
     bool write(const std::filesystem::path& filename);
+    bool write(std::vector<uint8_t>& buffer);
+    // MIME type of what write() produces, empty if nothing was read.
+    [[nodiscard]] std::string_view mimeType() const;
 
+    ImageProcessingAll() = default;
     explicit ImageProcessingAll(std::filesystem::path filename);
 
    private:
+    static std::unique_ptr<PhotoBase> createForFormat(Format format);
+
     std::filesystem::path _filename;
-    std::vector<std::unique_ptr<PhotoBase>> impls;
     std::unique_ptr<PhotoBase> _impl;
-};
\ No newline at end of file
+};
@@ -1,16 +1,33 @@
 #include "ImageProcOpenCV.hpp"
 #include <opencv2/core/utility.hpp>
 
-bool OpenCVImage::read(const std::filesystem::path& filename) {
-    image = cv::imread(filename.string(), cv::IMREAD_UNCHANGED);
+#include "ImageKernels.hpp"
+
+bool OpenCVImage::read(std::span<const uint8_t> buffer) {
+    // imdecode only reads from the Mat, the const_cast is safe.
+    const cv::Mat encoded(1, static_cast<int>(buffer.size()), CV_8UC1,
+                          const_cast<uint8_t*>(buffer.data()));
+    image = cv::imdecode(encoded, cv::IMREAD_UNCHANGED);
     if (image.empty()) {
-        LOG(ERROR) << "Error reading image: " << filename;
+        LOG(ERROR) << "Error decoding image";
         return false;
     }
     return true;
 }
 
 OpenCVImage::Result OpenCVImage::_rotate_image(int angle) {
+    // Right angles on 8-bit images don't need an affine warp
+    if ((angle == kAngle90 || angle == kAngle180 || angle == kAngle270) &&
+        image.depth() == CV_8U && image.isContinuous()) {
+        const bool swapped = angle != kAngle180;
+        cv::Mat rotated(swapped ? image.cols : image.rows,
+                        swapped ? image.rows : image.cols, image.type());
+        ImageKernels::rotate(image.data, rotated.data, image.cols, image.rows,
+                             image.channels(), angle);
+        image = rotated;
+        return Result::kSuccess;
+    }
+
     // Make it clockwise
     angle = kAngleMax - angle;
 
@@ -43,14 +60,52 @@ void OpenCVImage::to_greyscale() {
     }
 }
 
-bool OpenCVImage::write(const std::filesystem::path& filename) {
-    if (!cv::imwrite(filename.string(), image)) {
-        LOG(INFO) << "Error writing image: " << filename;
+OpenCVImage::Result OpenCVImage::applyStep(
+    const TransformPipeline::Step& step) {
+    switch (step.type) {
+        case TransformPipeline::Step::Type::kFlip:
+            // 1 flips around the y axis, 0 around the x axis
+            cv::flip(image, image, step.horizontal ? 1 : 0);
+            return Result::kSuccess;
+        case TransformPipeline::Step::Type::kCrop: {
+            const cv::Rect rect(static_cast<int>(step.x),
+                                static_cast<int>(step.y),
+                                static_cast<int>(step.width),
+                                static_cast<int>(step.height));
+            if (rect.empty() || (rect & cv::Rect({}, image.size())) != rect) {
+                LOG(ERROR) << "Invalid crop: " << rect;
+                return Result::kErrorInvalidArgument;
+            }
+            image = image(rect).clone();
+            return Result::kSuccess;
+        }
+        case TransformPipeline::Step::Type::kResize:
+            if (step.width == 0 || step.height == 0) {
+                LOG(ERROR) << "Invalid size: " << step.width << "x"
+                           << step.height;
+                return Result::kErrorInvalidArgument;
+            }
+            // Nearest neighbour, like the fused transforms of the others
+            cv::resize(image, image,
+                       cv::Size(static_cast<int>(step.width),
+                                static_cast<int>(step.height)),
+                       0, 0, cv::INTER_NEAREST);
+            return Result::kSuccess;
+        default:
+            return PhotoBase::applyStep(step);
+    }
+}
+
+bool OpenCVImage::write(std::vector<uint8_t>& buffer) {
+    if (!cv::imencode(".png", image, buffer)) {
+        LOG(INFO) << "Error encoding image";
         return false;
     }
     return true;
 }
 
+std::string_view OpenCVImage::mimeType() const { return "image/png"; }
+
 std::string OpenCVImage::version() const {
     return "OpenCV version: " + cv::getVersionString();
 }
\ No newline at end of file
@@ -15,12 +15,19 @@ class OpenCVImage : public PhotoBase {
     OpenCVImage() noexcept = default;
     ~OpenCVImage() override = default;
 
-    bool read(const std::filesystem::path& filename) override;
+    using PhotoBase::read;
+    using PhotoBase::write;
+
+    bool read(std::span<const uint8_t> buffer) override;
     Result _rotate_image(int angle) override;
     void to_greyscale() override;
-    bool write(const std::filesystem::path& filename) override;
+    bool write(std::vector<uint8_t>& buffer) override;
+    std::string_view mimeType() const override;
     std::string version() const override;
 
+   protected:
+    Result applyStep(const TransformPipeline::Step& step) override;
+
    private:
     cv::Mat image;
 };
\ No newline at end of file
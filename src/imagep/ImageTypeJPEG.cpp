@@ -5,10 +5,10 @@
 #include <cstdio>
 #include <jpeglib.h>
 // clang-format on
-#include <absl/log/check.h>
 #include <absl/log/log.h>
 
 #include <cstring>
+#include "ImageKernels.hpp"
 #include "ImageTypeJPEG.hpp"
 #include <memory>
 
@@ -32,14 +32,7 @@ jpegimg_output_message(j_common_ptr cinfo) {
     LOG(ERROR) << "libjpeg: " << buffer.data();
 }
 
-bool JPEGImage::read(const std::filesystem::path& filename) {
-    FILE* infile = fopen(filename.string().c_str(), "rb");
-    if (infile == nullptr) {
-        LOG(ERROR) << "Error opening file: " << filename;
-        return false;
-    }
-    const auto autoCloser = createFileCloser(infile);
-
+bool JPEGImage::read(std::span<const uint8_t> buffer) {
     jpeg_decompress_struct cinfo{};
     jpegimg_error_mgr jerr{};
 
@@ -60,7 +53,9 @@ bool JPEGImage::read(const std::filesystem::path& filename) {
         return false;
     }
 
-    jpeg_stdio_src(&cinfo, infile);
+    // Older libjpeg versions take a non-const buffer, but never write to it
+    jpeg_mem_src(&cinfo, const_cast<unsigned char*>(buffer.data()),
+                 buffer.size());
     jpeg_read_header(&cinfo, TRUE);
     jpeg_start_decompress(&cinfo);
 
@@ -69,12 +64,11 @@ bool JPEGImage::read(const std::filesystem::path& filename) {
     num_channels = cinfo.output_components;
 
     size_t row_stride = width * num_channels;
-    image_data =
-        std::make_unique<unsigned char[]>(width * height * num_channels);
+    image_data.reserve(width * height * num_channels);
     std::array<unsigned char*, 1> rowptr{};
 
     while (cinfo.output_scanline < height) {
-        rowptr[0] = &image_data[(cinfo.output_scanline) * row_stride];
+        rowptr[0] = &image_data.data[(cinfo.output_scanline) * row_stride];
         jpeg_read_scanlines(&cinfo, rowptr.data(), 1);
     }
 
@@ -87,7 +81,7 @@ bool JPEGImage::read(const std::filesystem::path& filename) {
 JPEGImage::Result JPEGImage::_rotate_image(int angle) {
     size_t new_width = 0;
     size_t new_height = 0;
-    std::unique_ptr<unsigned char[]> new_image_data = nullptr;
+    ImageKernels::PixelBuffer new_image_data;
 
     switch (angle) {
         case kAngle90:
@@ -107,37 +101,9 @@ JPEGImage::Result JPEGImage::_rotate_image(int angle) {
             return Result::kErrorUnsupportedAngle;
     }
 
-    new_image_data = std::make_unique<unsigned char[]>(new_width * new_height *
-                                                       num_channels);
-    for (size_t y = 0; y < height; ++y) {
-        for (size_t x = 0; x < width; ++x) {
-            for (int c = 0; c < num_channels; ++c) {
-                switch (angle) {
-                    case kAngle90:
-                        new_image_data[(x * new_width + (new_width - y - 1)) *
-                                           num_channels +
-                                       c] =
-                            image_data[(y * width + x) * num_channels + c];
-                        break;
-                    case kAngle180:
-                        new_image_data[((new_height - y - 1) * new_width +
-                                        (new_width - x - 1)) *
-                                           num_channels +
-                                       c] =
-                            image_data[(y * width + x) * num_channels + c];
-                        break;
-                    case kAngle270:
-                        new_image_data[((new_height - x - 1) * new_width + y) *
-                                           num_channels +
-                                       c] =
-                            image_data[(y * width + x) * num_channels + c];
-                        break;
-                    default:
-                        CHECK(false);
-                }
-            }
-        }
-    }
+    new_image_data.reserve(new_width * new_height * num_channels);
+    ImageKernels::rotate(image_data.data.get(), new_image_data.data.get(),
+                         width, height, num_channels, angle);
 
     image_data = std::move(new_image_data);
     width = new_width;
@@ -153,27 +119,24 @@ void JPEGImage::to_greyscale() {
         return;
     }
 
-    for (size_t i = 0; i < width * height * num_channels; i += num_channels) {
-        const auto grey = static_cast<unsigned char>(0.299 * image_data[i] +
-                                                     0.587 * image_data[i + 1] +
-                                                     0.114 * image_data[i + 2]);
-        image_data[i] = image_data[i + 1] = image_data[i + 2] = grey;
-    }
+    ImageKernels::to_greyscale(image_data.data.get(), width * height,
+                               num_channels);
 }
 
-bool JPEGImage::write(const std::filesystem::path& filename) {
-    FILE* outfile = fopen(filename.string().c_str(), "wb");
-    if (outfile == nullptr) {
-        LOG(ERROR) << "Error opening file: " << filename;
+bool JPEGImage::write(std::vector<uint8_t>& buffer) {
+    if (image_data.data == nullptr) {
+        LOG(ERROR) << "No image data to write";
         return false;
     }
 
     jpeg_compress_struct cinfo{};
     jpeg_error_mgr jerr{};
+    unsigned char* outbuffer = nullptr;
+    unsigned long outsize = 0;
 
     cinfo.err = jpeg_std_error(&jerr);
     jpeg_create_compress(&cinfo);
-    jpeg_stdio_dest(&cinfo, outfile);
+    jpeg_mem_dest(&cinfo, &outbuffer, &outsize);
 
     cinfo.image_width = width;
     cinfo.image_height = height;
@@ -188,17 +151,31 @@ bool JPEGImage::write(const std::filesystem::path& filename) {
     std::array<unsigned char*, 1> rowptr{};
 
     while (cinfo.next_scanline < height) {
-        rowptr[0] = &image_data[cinfo.next_scanline * row_stride];
+        rowptr[0] = &image_data.data[cinfo.next_scanline * row_stride];
         jpeg_write_scanlines(&cinfo, rowptr.data(), 1);
     }
 
     jpeg_finish_compress(&cinfo);
     jpeg_destroy_compress(&cinfo);
-    fclose(outfile);
 
+    buffer.assign(outbuffer, outbuffer + outsize);
+    free(outbuffer);
     return true;
 }
 
+std::optional<PhotoBase::PixelView> JPEGImage::pixels() {
+    return PixelView{image_data.data.get(), width, height, num_channels};
+}
+
+void JPEGImage::adoptPixels(ImageKernels::PixelBuffer& buffer,
+                            size_t new_width, size_t new_height) {
+    std::swap(image_data, buffer);
+    width = new_width;
+    height = new_height;
+}
+
+std::string_view JPEGImage::mimeType() const { return "image/jpeg"; }
+
 #define _STR(x) #x
 #define STR(x) _STR(x)
 #define LIBJPEG_TURBO_VERSION_STR STR(LIBJPEG_TURBO_VERSION)
@@ -13,14 +13,23 @@ class JPEGImage : public PhotoBase {
     JPEGImage() noexcept = default;
     ~JPEGImage() override = default;
 
-    bool read(const std::filesystem::path& filename) override;
+    using PhotoBase::read;
+    using PhotoBase::write;
+
+    bool read(std::span<const uint8_t> buffer) override;
     Result _rotate_image(int angle) override;
     void to_greyscale() override;
-    bool write(const std::filesystem::path& filename) override;
+    bool write(std::vector<uint8_t>& buffer) override;
+    std::string_view mimeType() const override;
     std::string version() const override;
 
+   protected:
+    std::optional<PixelView> pixels() override;
+    void adoptPixels(ImageKernels::PixelBuffer& buffer, size_t width,
+                     size_t height) override;
+
    private:
-    std::unique_ptr<unsigned char[]> image_data;
+    ImageKernels::PixelBuffer image_data;
     size_t width{};
     size_t height{};
     int num_channels{};
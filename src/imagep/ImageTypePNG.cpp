@@ -5,8 +5,12 @@
 #include <pngconf.h>
 
 #include <cstddef>
-#include <filesystem>
+#include <cstring>
+#include <span>
 #include <string>
+#include <vector>
+
+#include "ImageKernels.hpp"
 
 #if (PNG_LIBPNG_VER < 10500)
 #define png_longjmp_fn(png, val) longjmp(png->jmpbuf, val);
@@ -24,25 +28,39 @@ void absl_error_fn(png_structp png_ptr, png_const_charp error_message) {
     LOG(ERROR) << "libpng: " << error_message;
     png_longjmp_fn(png_ptr, 1);
 }
+
+struct MemoryReader {
+    std::span<const uint8_t> buffer;
+    std::size_t offset = 0;
+};
+
+void read_from_memory(png_structp png_ptr, png_bytep data, png_size_t length) {
+    auto* reader = static_cast<MemoryReader*>(png_get_io_ptr(png_ptr));
+    if (reader->buffer.size() - reader->offset < length) {
+        png_error(png_ptr, "Read past the end of the buffer");
+    }
+    memcpy(data, reader->buffer.data() + reader->offset, length);
+    reader->offset += length;
+}
+
+void write_to_memory(png_structp png_ptr, png_bytep data, png_size_t length) {
+    auto* buffer = static_cast<std::vector<uint8_t>*>(png_get_io_ptr(png_ptr));
+    buffer->insert(buffer->end(), data, data + length);
+}
+
+void flush_memory(png_structp /*png_ptr*/) {}
 }  // namespace
 
-bool PngImage::read(const std::filesystem::path& filename) {
-    FILE* fp = nullptr;
+bool PngImage::read(std::span<const uint8_t> buffer) {
     png_structp png = nullptr;
     png_infop info = nullptr;
+    MemoryReader reader{buffer};
 
     if (contains_data) {
         LOG(WARNING) << "Already contains data, ignore";
         return false;
     }
 
-    fp = fopen(filename.string().c_str(), "rb");
-    if (fp == nullptr) {
-        LOG(ERROR) << "Can't open file " << filename << " for reading";
-        return false;
-    }
-    const auto fileCloser = createFileCloser(fp);
-
     png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr,
                                  nullptr);
     if (png == nullptr) {
@@ -64,7 +82,7 @@ bool PngImage::read(const std::filesystem::path& filename) {
         return false;
     }
 
-    png_init_io(png, fp);
+    png_set_read_fn(png, &reader, read_from_memory);
     png_read_info(png, info);
 
     width = png_get_image_width(png, info);
@@ -96,10 +114,11 @@ bool PngImage::read(const std::filesystem::path& filename) {
         png_set_gray_to_rgb(png);
     }
     png_read_update_info(png, info);
+    // The transforms above always give 8-bit RGBA
+    color_type = png_get_color_type(png, info);
+    bit_depth = png_get_bit_depth(png, info);
 
-    for (int y = 0; y < height; y++) {
-        refmem.add(png_get_rowbytes(png, info));
-    }
+    refmem.allocate(png_get_rowbytes(png, info), height);
 
     png_read_image(png, refmem.data());
 
@@ -115,40 +134,8 @@ void PngImage::to_greyscale() {
         return;
     }
     LOG(INFO) << "Converting image to greyscale";
-    for (int y = 0; y < height; y++) {
-        png_bytep row = refmem[y];
-        for (int x = 0; x < width; x++) {
-            png_bytep px = &(row[x * 4]);
-            const auto gray = static_cast<uint8_t>(
-                0.299 * px[0] + 0.587 * px[1] + 0.114 * px[2]);
-            px[0] = px[1] = px[2] = gray;
-        }
-    }
-}
-
-void PngImage::rotate_image_impl(int new_width, int new_height,
-                                 transform_fn_t transform) {
-    PngImage src = *this;
-
-    width = new_width;
-    height = new_height;
-    color_type = src.color_type;
-    bit_depth = src.bit_depth;
-
-    for (int y = 0; y < height; y++) {
-        refmem.add(static_cast<size_t>(width) * 4);
-    }
-
-    for (ptrdiff_t y = 0; y < src.height; y++) {
-        for (ptrdiff_t x = 0; x < src.width; x++) {
-            ptrdiff_t dst_x = 0;
-            ptrdiff_t dst_y = 0;
-            transform(src.width, src.height, dst_x, dst_y, x, y);
-            png_bytep src_pixel = &src.refmem[y][x * 4];
-            png_bytep dst_pixel = &refmem[dst_y][dst_x * 4];
-            memcpy(dst_pixel, src_pixel, 4);
-        }
-    }
+    ImageKernels::to_greyscale(refmem.pixels(),
+                               static_cast<size_t>(width) * height, 4);
 }
 
 PngImage::Result PngImage::_rotate_image(int angle) {
@@ -157,33 +144,18 @@ PngImage::Result PngImage::_rotate_image(int angle) {
         return Result::kErrorNoData;
     }
 
+    png_uint_32 new_width = 0;
+    png_uint_32 new_height = 0;
+
     switch (angle) {
         case kAngle90:
-            rotate_image_impl(
-                height, width,
-                [](png_uint_32 src_width, png_uint_32 src_height,
-                   ptrdiff_t& dst_x, ptrdiff_t& dst_y, int x, int y) {
-                    dst_x = src_height - 1 - y;
-                    dst_y = x;
-                });
+        case kAngle270:
+            new_width = height;
+            new_height = width;
             break;
         case kAngle180:
-            rotate_image_impl(
-                width, height,
-                [](png_uint_32 src_width, png_uint_32 src_height,
-                   ptrdiff_t& dst_x, ptrdiff_t& dst_y, int x, int y) {
-                    dst_x = src_width - 1 - x;
-                    dst_y = src_height - 1 - y;
-                });
-            break;
-        case kAngle270:
-            rotate_image_impl(
-                height, width,
-                [](png_uint_32 src_width, png_uint_32 src_height,
-                   ptrdiff_t& dst_x, ptrdiff_t& dst_y, int x, int y) {
-                    dst_x = y;
-                    dst_y = src_width - 1 - x;
-                });
+            new_width = width;
+            new_height = height;
             break;
         case kAngleMin:
             // Noop
@@ -192,12 +164,19 @@ PngImage::Result PngImage::_rotate_image(int angle) {
             LOG(WARNING) << "libPNG cannot handle angle: " << angle;
             return Result::kErrorUnsupportedAngle;
     }
+
+    PngRefMem rotated;
+    rotated.allocate(static_cast<size_t>(new_width) * 4, new_height);
+    ImageKernels::rotate(refmem.pixels(), rotated.pixels(), width, height, 4,
+                         angle);
+    refmem = std::move(rotated);
+    width = new_width;
+    height = new_height;
     LOG(INFO) << "New dimensions: " << width << "x" << height;
     return Result::kSuccess;
 }
 
-bool PngImage::write(const std::filesystem::path& filename) {
-    FILE* fp = nullptr;
+bool PngImage::write(std::vector<uint8_t>& buffer) {
     png_structp png = nullptr;
     png_infop info = nullptr;
 
@@ -205,13 +184,7 @@ bool PngImage::write(const std::filesystem::path& filename) {
         LOG(ERROR) << "No image data to write";
         return false;
     }
-
-    fp = fopen(filename.string().c_str(), "wb");
-    if (fp == nullptr) {
-        LOG(ERROR) << "Can't open file " << filename << " for writing";
-        return false;
-    }
-    const auto fileCloser = createFileCloser(fp);
+    buffer.clear();
 
     png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr,
                                   nullptr);
@@ -232,7 +205,7 @@ bool PngImage::write(const std::filesystem::path& filename) {
         return false;
     }
 
-    png_init_io(png, fp);
+    png_set_write_fn(png, &buffer, write_to_memory, flush_memory);
 
     if (setjmp(png_jmpbuf(png))) {
         LOG(ERROR) << "Error during writing header";
@@ -266,4 +239,20 @@ bool PngImage::write(const std::filesystem::path& filename) {
     return true;
 }
 
+std::optional<PhotoBase::PixelView> PngImage::pixels() {
+    if (!contains_data) {
+        return PixelView{};
+    }
+    return PixelView{refmem.pixels(), width, height, 4};
+}
+
+void PngImage::adoptPixels(ImageKernels::PixelBuffer& buffer, size_t new_width,
+                           size_t new_height) {
+    refmem.adopt(buffer, new_width * 4, new_height);
+    width = new_width;
+    height = new_height;
+}
+
+std::string_view PngImage::mimeType() const { return "image/png"; }
+
 std::string PngImage::version() const { return PNG_LIBPNG_VER_STRING; }
\ No newline at end of file
@@ -14,28 +14,32 @@ struct PngImage : PhotoBase {
     PngImage() noexcept = default;
     ~PngImage() override = default;
 
-    struct MiniSharedMalloc {
-        MiniSharedMalloc(std::size_t size) : data(malloc(size)) {}
-        MiniSharedMalloc() = default;
-        ~MiniSharedMalloc() {
-            if (data)  // Only free if data is not nullptr.
-                free(data);
-        }
-        void* data = nullptr;
-    };
-
+    // All rows live in a single buffer, so the image kernels can process it
+    // in one go. libpng gets the row pointers into it.
     struct PngRefMem {
-        void add(std::size_t size) {
-            auto m = std::make_shared<MiniSharedMalloc>(size);
-            mallocs.emplace_back(m);
-            row_data.emplace_back(static_cast<png_bytep>(m->data));
+        void allocate(std::size_t rowbytes, std::size_t rows) {
+            buffer.reserve(rowbytes * rows);
+            updateRows(rowbytes, rows);
+        }
+        // Takes the pixels from other, and gives it the previous ones.
+        void adopt(ImageKernels::PixelBuffer& other, std::size_t rowbytes,
+                   std::size_t rows) {
+            std::swap(buffer, other);
+            updateRows(rowbytes, rows);
         }
-        void resize(std::size_t size) { row_data.resize(size); }
         [[nodiscard]] png_bytepp data() { return row_data.data(); }
+        [[nodiscard]] png_bytep pixels() { return buffer.data.get(); }
         png_bytep& operator[](std::size_t size) { return row_data[size]; }
 
        private:
-        std::vector<std::shared_ptr<MiniSharedMalloc>> mallocs;
+        void updateRows(std::size_t rowbytes, std::size_t rows) {
+            row_data.resize(rows);
+            for (std::size_t y = 0; y < rows; ++y) {
+                row_data[y] = buffer.data.get() + y * rowbytes;
+            }
+        }
+
+        ImageKernels::PixelBuffer buffer;
         std::vector<png_bytep> row_data;
     } refmem;
 
@@ -43,18 +47,20 @@ struct PngImage : PhotoBase {
     png_byte color_type{}, bit_depth{};
     bool contains_data = false;
 
+    using PhotoBase::read;
+    using PhotoBase::write;
+
     /**
-     * @brief Reads a PNG image from the specified file path.
+     * @brief Reads a PNG image from memory.
      *
-     * @param filename The path to the PNG image file.
+     * @param buffer The encoded PNG image.
      *
      * @return True if the image was successfully read, false otherwise.
      */
-    bool read(const std::filesystem::path& filename) override;
+    bool read(std::span<const uint8_t> buffer) override;
 
     /**
-     * @brief Rotates the image with the specified new dimensions and
-     * transformation function.
+     * @brief Rotates the image by the specified angle.
      *
      * @param angle The angle of rotation.
      *
@@ -69,30 +75,19 @@ struct PngImage : PhotoBase {
     void to_greyscale() override;
 
     /**
-     * @brief Writes the image to the specified file path.
+     * @brief Encodes the image as PNG into memory.
      *
-     * @param filename The path to write the image to.
+     * @param buffer The buffer to write the image to.
      *
      * @return True if the image was successfully written, false otherwise.
      */
-    bool write(const std::filesystem::path& filename) override;
+    bool write(std::vector<uint8_t>& buffer) override;
 
+    std::string_view mimeType() const override;
     std::string version() const override;
-    
-   private:
-    using transform_fn_t =
-        std::function<void(png_uint_32 src_width, png_uint_32 src_height,
-                           ptrdiff_t& dst_x, ptrdiff_t& dst_y, int x, int y)>;
 
-    /**
-     * @brief Rotates the image with the specified new dimensions and
-     * transformation function.
-     *
-     * @param new_width The new width of the image.
-     * @param new_height The new height of the image.
-     * @param transform A function that takes the source coordinates and
-     * transforms them to the destination coordinates.
-     */
-    void rotate_image_impl(int new_width, int new_height,
-                           transform_fn_t transform);
+   protected:
+    std::optional<PixelView> pixels() override;
+    void adoptPixels(ImageKernels::PixelBuffer& buffer, size_t width,
+                     size_t height) override;
 };
\ No newline at end of file
@@ -11,17 +11,20 @@ class WebPImage : public PhotoBase {
     WebPImage() noexcept = default;
     ~WebPImage() override = default;
 
+    using PhotoBase::read;
+    using PhotoBase::write;
+
     /**
-     * @brief Reads an image from the specified file path.
+     * @brief Reads an image from memory.
      *
-     * This function reads an image from the specified file path and stores it
-     * in the object's internal data.
+     * This function decodes the WebP image in the buffer and stores it in the
+     * object's internal data.
      *
-     * @param filename The path to the image file.
+     * @param buffer The encoded WebP image.
      *
      * @return True if the image is successfully read, false otherwise.
      */
-    bool read(const std::filesystem::path& filename) override;
+    bool read(std::span<const uint8_t> buffer) override;
 
     /**
      * @brief Rotates the image by the specified angle in degrees.
@@ -39,27 +42,32 @@ class WebPImage : public PhotoBase {
     /**
      * @brief Converts the image to grayscale.
      *
-     * This function converts the image to grayscale by averaging the RGB values
-     * of each pixel. The internal data of the image is updated accordingly.
+     * This function converts the image to grayscale using the luma of each
+     * pixel. The internal data of the image is updated accordingly.
      */
     void to_greyscale() override;
 
     /**
-     * @brief Writes the image to the specified file path.
+     * @brief Encodes the image as WebP into memory.
      *
-     * This function writes the image to the specified file path. The internal
-     * data of the image is saved to the file.
+     * This function encodes the internal data of the image into the buffer.
      *
-     * @param filename The path to the image file.
+     * @param buffer The buffer to write the image to.
      *
      * @return True if the image is successfully written, false otherwise.
      */
-    bool write(const std::filesystem::path& filename) override;
+    bool write(std::vector<uint8_t>& buffer) override;
 
+    std::string_view mimeType() const override;
     std::string version() const override;
 
+   protected:
+    std::optional<PixelView> pixels() override;
+    void adoptPixels(ImageKernels::PixelBuffer& buffer, size_t width,
+                     size_t height) override;
+
    private:
     long width_{};
     long height_{};
-    std::unique_ptr<uint8_t[]> data_;
+    ImageKernels::PixelBuffer data_;
 };
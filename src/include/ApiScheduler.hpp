@@ -0,0 +1,212 @@
+#pragma once
+
+#include <Types.h>
+#include <tgbot/types/Message.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "InstanceClassBase.hpp"
+
+/**
+ * @brief The queue all outgoing Telegram API requests go through.
+ *
+ * Requests are sent by a small pool of threads, within a bot-wide and a
+ * per-chat token bucket, so bursts are spread out instead of running into
+ * Telegram's flood limits. Requests of one chat are sent one at a time, in
+ * the order they were submitted. A request failing with "Too Many Requests"
+ * pauses its chat for the retry_after Telegram asked for, and is retried.
+ *
+ * Requests which aren't sent to a chat, like getFile, go in a global lane:
+ * they only take from the bot-wide bucket, and any number of them are sent
+ * at once. The lane and the chats take turns.
+ *
+ * An edit of a message whose edit is the last queued request of the chat
+ * replaces it, and both of their futures get the result of the last one.
+ */
+class ApiScheduler : public InstanceClassBase<ApiScheduler> {
+   public:
+    using Clock = std::chrono::steady_clock;
+    using Message = TgBot::Message;
+
+    struct Limits {
+        // Telegram allows about 30 messages per second overall
+        double globalPerSecond = 30;
+        // And about one per second in a chat, short bursts are tolerated
+        double chatPerSecond = 1;
+        double chatBurst = 3;
+        size_t workers = 4;
+        // Of one request, for "Too Many Requests" errors only
+        int maxRetries = 3;
+
+        // No rates, for when the requests don't reach Telegram. Requests
+        // of a chat are still sent in order.
+        static Limits unlimited();
+    };
+
+    ApiScheduler();
+    explicit ApiScheduler(Limits limits);
+    ~ApiScheduler();
+    ApiScheduler(const ApiScheduler&) = delete;
+    ApiScheduler& operator=(const ApiScheduler&) = delete;
+
+    /**
+     * @brief Queues fn, an API call for chat.
+     *
+     * Called from a request being sent, fn runs right away.
+     *
+     * @return The future of fn's result, or of the exception it threw.
+     */
+    template <typename Fn>
+    std::future<std::invoke_result_t<Fn&>> submit(ChatId chat, Fn fn) {
+        auto future = std::future<std::invoke_result_t<Fn&>>();
+        auto request = makeRequest(std::move(fn), &future);
+        enqueue(chat, std::move(request));
+        return future;
+    }
+
+    // Queues fn, an API call which isn't for a chat, in the global lane
+    template <typename Fn>
+    std::future<std::invoke_result_t<Fn&>> submitGlobal(Fn fn) {
+        auto future = std::future<std::invoke_result_t<Fn&>>();
+        auto request = makeRequest(std::move(fn), &future);
+        enqueue(std::nullopt, std::move(request));
+        return future;
+    }
+
+    /**
+     * @brief Queues fn, an edit of message in chat.
+     *
+     * If the last request queued for chat edits the same message, fn
+     * replaces it.
+     */
+    std::future<Message::Ptr> edit(ChatId chat, MessageId message,
+                                   std::function<Message::Ptr()> fn);
+
+    // Fails all queued requests and joins the threads. submit() fails
+    // right away afterwards.
+    void stop();
+
+    // Number of requests not sent yet, the ones being sent included
+    [[nodiscard]] size_t queued() const;
+
+    // The retry_after of a "Too Many Requests" error, if e is one
+    static std::optional<std::chrono::seconds> retryAfter(
+        const std::exception& e);
+
+    /**
+     * @brief Wraps fn, a request nobody waits for, to only log its failures.
+     *
+     * "Too Many Requests" is thrown on, so the scheduler retries it. A
+     * failed request returns a value initialized result.
+     *
+     * @param what What fn does, for the log: "Cannot <what>: <error>".
+     */
+    template <typename Fn>
+    static auto logged(std::string what, Fn fn) {
+        using R = std::invoke_result_t<Fn&>;
+        return [what = std::move(what), fn = std::move(fn)]() mutable -> R {
+            try {
+                return fn();
+            } catch (const std::exception& e) {
+                logOrRethrow(what, e);
+            }
+            if constexpr (!std::is_void_v<R>) {
+                return R{};
+            }
+        };
+    }
+
+   private:
+    struct Request {
+        // Sends the request and fulfills its future. Throws on failure.
+        std::function<void()> send;
+        std::function<void(std::exception_ptr)> fail;
+        // Of edits, which can be merged, 0 otherwise
+        MessageId edited = 0;
+        std::function<Message::Ptr()> editFn;
+        std::vector<std::promise<Message::Ptr>> editWaiters;
+        int retries = 0;
+    };
+    struct ChatQueue {
+        std::deque<std::unique_ptr<Request>> requests;
+        double tokens;
+        Clock::time_point refilled;
+        // Set from retry_after
+        Clock::time_point pausedUntil;
+        bool sending = false;
+        // Whether it is in waiting_
+        bool waiting = false;
+    };
+
+    template <typename Fn, typename R = std::invoke_result_t<Fn&>>
+    static std::unique_ptr<Request> makeRequest(Fn fn, std::future<R>* future) {
+        auto promise = std::make_shared<std::promise<R>>();
+        *future = promise->get_future();
+        auto request = std::make_unique<Request>();
+        request->send = [promise, fn = std::move(fn)]() mutable {
+            if constexpr (std::is_void_v<R>) {
+                fn();
+                promise->set_value();
+            } else {
+                promise->set_value(fn());
+            }
+        };
+        request->fail = [promise](std::exception_ptr e) {
+            promise->set_exception(std::move(e));
+        };
+        return request;
+    }
+
+    // To chat's queue, or to the global lane without one
+    void enqueue(std::optional<ChatId> chat, std::unique_ptr<Request> request);
+    // Starts the workers on the first request
+    void startLocked();
+    ChatQueue& chatLocked(ChatId chat, Clock::time_point now);
+    // Takes the next request which can be sent now, from queue, of chat
+    // unless it is the global lane. If there is none, sets wakeAt to when
+    // there may be one.
+    std::unique_ptr<Request> takeLocked(ChatQueue** queue,
+                                        std::optional<ChatId>* chat,
+                                        Clock::time_point* wakeAt);
+    std::unique_ptr<Request> takeGlobalLocked(ChatQueue** queue,
+                                              std::optional<ChatId>* chat);
+    void refill(double* tokens, Clock::time_point* refilled, double rate,
+                double burst, Clock::time_point now) const;
+    static void send(Request* request);
+    static void fail(Request* request, const std::exception_ptr& e);
+    void workerFn();
+    // Called from the handler of e
+    static void logOrRethrow(std::string_view what, const std::exception& e);
+
+    const Limits limits_;
+    mutable std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::unordered_map<ChatId, ChatQueue> chats_;
+    // Chats with queued requests, in the order they are served
+    std::deque<ChatId> waiting_;
+    // Only its requests and pausedUntil are used
+    ChatQueue global_;
+    // Whether the global lane goes before the chats next time
+    bool globalTurn_ = true;
+    size_t queued_ = 0;
+    double tokens_;
+    Clock::time_point refilled_;
+    bool stopped_ = false;
+    std::vector<std::thread> workers_;
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "InstanceClassBase.hpp"
+
+/**
+ * @brief Keeps the bot's command menu and descriptions up to date, later.
+ *
+ * Setting a part of the profile only records it, and schedules a flush
+ * after debounce, so a burst of changes is sent once and startup doesn't
+ * wait for the Bot API. A flush sends the parts which differ from what was
+ * last sent. Hashes of what was sent are kept in stateFile, so a restart
+ * with the same commands and descriptions sends nothing.
+ */
+class BotProfileSync : public InstanceClassBase<BotProfileSync> {
+   public:
+    struct Command {
+        std::string command;
+        std::string description;
+    };
+
+    // Where the profile goes, the Bot API outside of tests
+    struct Sink {
+        virtual ~Sink() = default;
+        // These throw on failure, like TgBot::Api
+        virtual void setCommands(const std::vector<Command>& commands) = 0;
+        virtual void setDescription(const std::string& description) = 0;
+        virtual void setShortDescription(const std::string& description) = 0;
+    };
+    // Runs fn after delay, on another thread. The sync must outlive it.
+    using Scheduler =
+        std::function<void(std::chrono::milliseconds, std::function<void()>)>;
+
+    static constexpr auto kDefaultDebounce = std::chrono::seconds(2);
+
+    BotProfileSync(std::filesystem::path stateFile, std::shared_ptr<Sink> sink,
+                   Scheduler scheduler,
+                   std::chrono::milliseconds debounce = kDefaultDebounce);
+
+    void setCommands(std::vector<Command> commands);
+    void setDescription(std::string description);
+    void setShortDescription(std::string description);
+
+    // Sends what changed now, instead of after the debounce
+    void flush();
+
+   private:
+    enum Part { kCommands, kDescription, kShortDescription, kPartCount };
+    static constexpr std::array<const char*, kPartCount> kPartNames = {
+        "commands", "description", "shortDescription"};
+
+    // Records a part's new hash, and schedules a flush if it changed
+    void changed(Part part, uint64_t hash);
+    void loadState();
+    void saveStateLocked() const;
+
+    const std::filesystem::path stateFile_;
+    const std::shared_ptr<Sink> sink_;
+    const Scheduler scheduler_;
+    const std::chrono::milliseconds debounce_;
+
+    // Only one flush sends at a time
+    std::mutex flushMutex_;
+    mutable std::mutex mutex_;
+    std::vector<Command> commands_;
+    std::string description_;
+    std::string shortDescription_;
+    // Hashes of what was set and of what was last sent, 0 for none
+    std::array<uint64_t, kPartCount> wanted_{};
+    std::array<uint64_t, kPartCount> sent_{};
+    // Flushes scheduled for an older generation are dropped
+    uint64_t generation_ = 0;
+};
@@ -4,6 +4,7 @@
 #include <tgbot/Bot.h>
 #include <tgbot/types/Message.h>
 
+#include <memory>
 #include <string>
 
 using TgBot::Animation;
@@ -87,6 +88,10 @@ extern Message::Ptr bot_sendSticker(const Bot &bot, const ChatId &chatid,
 extern Message::Ptr bot_sendSticker(const Bot &bot, const ChatId &chat,
                                     Sticker::Ptr sticker);
 
+extern Message::Ptr bot_sendSticker(const Bot &bot, const ChatId &chat,
+                                    const std::string &fileId,
+                                    const Message::Ptr &replyTo);
+
 extern Message::Ptr bot_sendAnimation(const Bot &bot, const ChatId &chat,
                                       Animation::Ptr gif,
                                       const Message::Ptr &replyTo);
@@ -94,6 +99,18 @@ extern Message::Ptr bot_sendAnimation(const Bot &bot, const ChatId &chat,
 extern Message::Ptr bot_sendAnimation(const Bot &bot, const ChatId &chat,
                                       Animation::Ptr gif);
 
+/**
+ * @brief downloads a file, through a cache shared by the whole bot
+ *
+ * @param bot the bot object
+ * @param fileId the id of the file to download
+ * @param fileUniqueId the unique id of the file, to cache it with
+ * @return the file contents, or nullptr if it couldn't be downloaded
+ */
+extern std::shared_ptr<const std::string> bot_downloadFile(
+    const Bot &bot, const std::string &fileId,
+    const std::string &fileUniqueId);
+
 static inline Message::Ptr bot_sendAnimation(const Bot &bot,
                                              const Chat::Ptr &chat,
                                              Animation::Ptr gif) {
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <Types.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "TimerWheel.hpp"
+
+/**
+ * @brief Countdown timers, at most one per chat, shown in a pinned message.
+ *
+ * A timer is a fixed size entry with a single pending event on a
+ * TimerWheel, so thousands of them share the wheel's thread. Updates of the
+ * message are coalesced: a timer asks for an edit at most once every
+ * editInterval, and an edit which is still queued isn't queued again, it
+ * shows the time left when it is sent. Queued requests go out from the
+ * wheel within a bot-wide budget, endings before edits.
+ */
+class ChatTimers {
+   public:
+    using Clock = TimerWheel::Clock;
+
+    // The API calls the timers make. They must not throw.
+    struct Api {
+        virtual ~Api() = default;
+        // These two are called by start(), and wait for the result.
+        // Returns the id of the sent message, 0 on failure.
+        virtual MessageId sendMessage(ChatId chat, const std::string& text) = 0;
+        virtual bool pinMessage(ChatId chat, MessageId message) = 0;
+        // These are called from the wheel's thread, so they only queue the
+        // request and return
+        virtual void announce(ChatId chat, const std::string& text) = 0;
+        virtual void editMessage(ChatId chat, MessageId message,
+                                 const std::string& text) = 0;
+        virtual void unpinMessage(ChatId chat, MessageId message) = 0;
+    };
+
+    struct Limits {
+        // Minimum time between two edits of one timer
+        std::chrono::milliseconds editInterval = std::chrono::seconds(5);
+        // Bot-wide, Telegram allows about 30 messages per second
+        int requestsPerSecond = 20;
+        size_t maxTimers = 16384;
+    };
+
+    enum class StartResult {
+        kStarted,
+        kAlreadyRunning,
+        kTooManyTimers,
+        kFailed,
+        // Stopped while its message was being sent
+        kStopped,
+    };
+
+    ChatTimers(std::shared_ptr<Api> api, TimerWheel& wheel, Limits limits);
+    // Drops all timers, without touching their messages
+    ~ChatTimers();
+    ChatTimers(const ChatTimers&) = delete;
+    ChatTimers& operator=(const ChatTimers&) = delete;
+
+    // Sends and pins the timer's message, then counts down in it
+    StartResult start(ChatId chat, std::chrono::milliseconds duration);
+    // Ends the timer in chat early. false if there is none.
+    bool stop(ChatId chat);
+    [[nodiscard]] size_t active() const;
+
+   private:
+    struct Timer {
+        Clock::time_point end;
+        TimerWheel::TimerId event = TimerWheel::kInvalidTimer;
+        uint32_t serial = 0;
+        MessageId message = 0;  // 0 while the start message is being sent
+        bool pinned = false;
+        bool editQueued = false;
+    };
+    struct Ending {
+        ChatId chat;
+        MessageId message;
+        bool pinned;
+        bool announce;  // Also send a separate message
+    };
+    struct Edit {
+        ChatId chat;
+        uint32_t serial;  // Of the timer which asked for it
+    };
+
+    // Schedules the timer's next edit, or its end if that comes first
+    void scheduleEventLocked(ChatId chat, Timer* timer, Clock::time_point now);
+    void onEvent(ChatId chat, uint32_t serial);
+    // Schedules a flush, if there is something queued and none is pending
+    void scheduleFlushLocked();
+    void refillLocked(Clock::time_point now);
+    void flush();
+
+    const std::shared_ptr<Api> api_;
+    TimerWheel& wheel_;
+    const Limits limits_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<ChatId, Timer> timers_;
+    std::deque<Ending> endings_;
+    std::deque<Edit> edits_;
+    uint32_t nextSerial_ = 0;
+    // Request budget, refilled at limits_.requestsPerSecond
+    double tokens_;
+    Clock::time_point refilled_;
+    TimerWheel::TimerId flushEvent_ = TimerWheel::kInvalidTimer;
+    // Set by the destructor, nothing new is scheduled after that
+    bool closing_ = false;
+    // Whether a flush is sending requests, the destructor waits for it
+    bool flushing_ = false;
+    std::condition_variable flushDone_;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <BotAddCommand.h>
+#include <tgbot/Bot.h>
+#include <tgbot/types/Message.h>
+
+#include <Metrics.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "InstanceClassBase.hpp"
+
+using TgBot::Bot;
+using TgBot::Message;
+
+/**
+ * @brief Runs every command of the bot, from a single handler.
+ *
+ * A command is parsed once, looked up by name in a hash table, checked for
+ * its @target and authorized, then run. The table never changes once
+ * published: adding a command publishes a copy with it, so lookups don't
+ * lock. Disabling a command flips a flag of its route and keeps it in the
+ * table, so it is enabled again as cheaply. Each route counts its calls,
+ * its refusals and the time spent in it.
+ */
+class CommandRouter : public InstanceClassBase<CommandRouter> {
+   public:
+    struct Stats {
+        std::string command;
+        bool enabled;
+        uint64_t calls;
+        uint64_t denied;
+        std::chrono::microseconds time;
+    };
+
+    CommandRouter();
+
+    // Routes bot's commands here, once
+    void install(Bot& bot);
+
+    // Adds command, or replaces it, enabled
+    void add(const std::string& command, command_callback_t fn,
+             bool enforced);
+    // False if there is no such command
+    bool setEnabled(std::string_view command, bool enabled);
+    [[nodiscard]] std::optional<bool> isEnabled(std::string_view command) const;
+    [[nodiscard]] std::optional<Stats> stats(std::string_view command) const;
+
+    /**
+     * @brief Runs the command of message, if it is one and is for username.
+     *
+     * @return False if the message wasn't routed to a command, true if it
+     * was, authorized or not.
+     */
+    bool dispatch(Bot& bot, const Message::Ptr& message,
+                  std::string_view username) const;
+
+   private:
+    struct Route {
+        std::string command;
+        // Name of its trace spans, "/command"
+        std::string spanName;
+        command_callback_t fn;
+        unsigned int authflags;
+        std::atomic<bool> enabled{true};
+        Metrics::Counter calls;
+        Metrics::Counter denied;
+        Metrics::Counter micros;
+    };
+    struct Hash {
+        using is_transparent = void;
+        size_t operator()(const std::string_view key) const noexcept {
+            return std::hash<std::string_view>{}(key);
+        }
+    };
+    using Table =
+        std::unordered_map<std::string, Route*, Hash, std::equal_to<>>;
+
+    [[nodiscard]] Route* find(std::string_view command) const;
+
+    std::once_flag installed_;
+    // Taken by writers only. Routes and tables are never freed, dispatch
+    // may still use any of them.
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<Route>> routes_;
+    std::vector<std::unique_ptr<const Table>> tables_;
+    std::atomic<const Table*> current_;
+};
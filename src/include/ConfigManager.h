@@ -1,7 +1,18 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
 
 #include "CompileTimeStringConcat.hpp"
 #include "EnumArrayHelpers.h"
@@ -21,6 +32,14 @@ enum class Configs {
     SOCKET_BACKEND,
     SELECTOR,
     LOCALE,
+    IMAGE_THREADS,
+    IMAGE_MIN_PIXELS,
+    FILE_CACHE_DIR,
+    COMPILE_CACHE_DIR,
+    TRACE_FILE,
+    TRACE_SAMPLE_RATE,
+    REPLAY_FILE,
+    REPLAY_SPEED,
     MAX
 };
 
@@ -44,7 +63,11 @@ constexpr auto kConfigsMap =
         CONFIG_AND_STR(LOG_FILE), CONFIG_AND_STR(DATABASE_BACKEND),
         CONFIG_AND_STR(HELP), CONFIG_AND_STR(OVERRIDE_CONF),
         CONFIG_AND_STR(SOCKET_BACKEND), CONFIG_AND_STR(SELECTOR),
-        CONFIG_AND_STR(LOCALE));
+        CONFIG_AND_STR(LOCALE), CONFIG_AND_STR(IMAGE_THREADS),
+        CONFIG_AND_STR(IMAGE_MIN_PIXELS), CONFIG_AND_STR(FILE_CACHE_DIR),
+        CONFIG_AND_STR(COMPILE_CACHE_DIR), CONFIG_AND_STR(TRACE_FILE),
+        CONFIG_AND_STR(TRACE_SAMPLE_RATE), CONFIG_AND_STR(REPLAY_FILE),
+        CONFIG_AND_STR(REPLAY_SPEED));
 
 constexpr auto kConfigsAliasMap =
     array_helpers::make<static_cast<int>(Configs::MAX), Configs, const char>(
@@ -54,7 +77,15 @@ constexpr auto kConfigsAliasMap =
         CONFIGALIAS_AND_STR(HELP, 'h'), CONFIGALIAS_AND_STR(OVERRIDE_CONF, 'c'),
         CONFIGALIAS_AND_STR(SOCKET_BACKEND, 's'),
         CONFIGALIAS_AND_STR(SELECTOR, 'u'),
-        CONFIGALIAS_AND_STR(LOCALE, 'l'));
+        CONFIGALIAS_AND_STR(LOCALE, 'l'),
+        CONFIGALIAS_AND_STR(IMAGE_THREADS, 'i'),
+        CONFIGALIAS_AND_STR(IMAGE_MIN_PIXELS, 'm'),
+        CONFIGALIAS_AND_STR(FILE_CACHE_DIR, 'k'),
+        CONFIGALIAS_AND_STR(COMPILE_CACHE_DIR, 'o'),
+        CONFIGALIAS_AND_STR(TRACE_FILE, 'e'),
+        CONFIGALIAS_AND_STR(TRACE_SAMPLE_RATE, 'x'),
+        CONFIGALIAS_AND_STR(REPLAY_FILE, 'y'),
+        CONFIGALIAS_AND_STR(REPLAY_SPEED, 'z'));
 
 constexpr auto kConfigsDescMap =
     array_helpers::make<static_cast<int>(Configs::MAX), Configs, DescStr>(
@@ -67,7 +98,158 @@ constexpr auto kConfigsDescMap =
         DESC_AND_STR(OVERRIDE_CONF, "Override config file"),
         DESC_AND_STR(SOCKET_BACKEND, "Socket backend to use"),
         DESC_AND_STR(SELECTOR, "Selector(poll(2), etc...) backend to use"),
-        DESC_AND_STR(LOCALE, "Locale of the language to use (Current: en,fr)"));
+        DESC_AND_STR(LOCALE, "Locale of the language to use (Current: en,fr)"),
+        DESC_AND_STR(IMAGE_THREADS, "Threads per image (0: all cores)"),
+        DESC_AND_STR(IMAGE_MIN_PIXELS, "Min pixels to use image threads"),
+        DESC_AND_STR(FILE_CACHE_DIR, "Directory to cache downloaded files in"),
+        DESC_AND_STR(COMPILE_CACHE_DIR, "Private directory to cache builds in"),
+        DESC_AND_STR(TRACE_FILE, "Chrome trace file to write update spans to"),
+        DESC_AND_STR(TRACE_SAMPLE_RATE, "Fraction of updates to trace (0-1)"),
+        DESC_AND_STR(REPLAY_FILE, "Recorded updates to replay, offline"),
+        DESC_AND_STR(REPLAY_SPEED, "Replay speed multiplier (0: no waits)"));
+
+// How a configuration is parsed when a snapshot is made
+enum class ConfigType {
+    STRING,
+    PATH,
+    COUNT,     // Non negative integer
+    REAL,      // Floating point number
+    DURATION,  // A number with a unit of ms, s, m or h, seconds if it has none
+};
+
+#define CONFIGTYPE_AND_STR(e, type)                \
+    array_helpers::make_elem<Configs, ConfigType>( \
+        Configs::e, ConfigType::type)
+
+constexpr auto kConfigsTypeMap =
+    array_helpers::make<static_cast<int>(Configs::MAX), Configs, ConfigType>(
+        CONFIGTYPE_AND_STR(TOKEN, STRING), CONFIGTYPE_AND_STR(SRC_ROOT, PATH),
+        CONFIGTYPE_AND_STR(PATH, STRING), CONFIGTYPE_AND_STR(LOG_FILE, PATH),
+        CONFIGTYPE_AND_STR(DATABASE_BACKEND, STRING),
+        CONFIGTYPE_AND_STR(HELP, STRING),
+        CONFIGTYPE_AND_STR(OVERRIDE_CONF, STRING),
+        CONFIGTYPE_AND_STR(SOCKET_BACKEND, STRING),
+        CONFIGTYPE_AND_STR(SELECTOR, STRING),
+        CONFIGTYPE_AND_STR(LOCALE, STRING),
+        CONFIGTYPE_AND_STR(IMAGE_THREADS, COUNT),
+        CONFIGTYPE_AND_STR(IMAGE_MIN_PIXELS, COUNT),
+        CONFIGTYPE_AND_STR(FILE_CACHE_DIR, PATH),
+        CONFIGTYPE_AND_STR(COMPILE_CACHE_DIR, PATH),
+        CONFIGTYPE_AND_STR(TRACE_FILE, PATH),
+        CONFIGTYPE_AND_STR(TRACE_SAMPLE_RATE, REAL),
+        CONFIGTYPE_AND_STR(REPLAY_FILE, PATH),
+        CONFIGTYPE_AND_STR(REPLAY_SPEED, REAL));
+
+/**
+ * Snapshot - Every configuration, resolved from the backends at once.
+ *
+ * A snapshot never changes once made. Reloading makes a new one, so readers
+ * never see half of a reload. Values are parsed as their ConfigType when the
+ * snapshot is made, invalid ones are logged then. The typed getters return
+ * std::nullopt if the configuration is not set, is invalid, or is not of
+ * that type.
+ */
+class Snapshot {
+   public:
+    using Values =
+        std::array<std::optional<std::string>, static_cast<int>(Configs::MAX)>;
+    using Types = std::array<ConfigType, static_cast<int>(Configs::MAX)>;
+
+    // Parsed as kConfigsTypeMap says
+    explicit Snapshot(Values values);
+    Snapshot(Values values, const Types &types);
+
+    [[nodiscard]] const std::optional<std::string> &get(Configs config) const {
+        return values_.at(static_cast<int>(config));
+    }
+
+    // A COUNT or a REAL, std::nullopt if it doesn't fit in T
+    template <typename T>
+        requires std::is_arithmetic_v<T> && (!std::is_same_v<T, bool>)
+    [[nodiscard]] std::optional<T> getNumber(Configs config) const {
+        const auto &value = parsed_.at(static_cast<int>(config));
+        if (const auto *count = std::get_if<std::uint64_t>(&value)) {
+            if constexpr (std::is_integral_v<T>) {
+                if (!std::in_range<T>(*count)) {
+                    return std::nullopt;
+                }
+            }
+            return static_cast<T>(*count);
+        }
+        if constexpr (std::is_floating_point_v<T>) {
+            if (const auto *real = std::get_if<double>(&value)) {
+                return static_cast<T>(*real);
+            }
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] std::optional<std::filesystem::path> getPath(
+        Configs config) const;
+
+    [[nodiscard]] std::optional<std::chrono::milliseconds> getDuration(
+        Configs config) const;
+
+    // One of names, matched case sensitively. A value which is none of them
+    // is logged once per snapshot.
+    template <typename E, size_t N>
+        requires std::is_enum_v<E>
+    [[nodiscard]] std::optional<E> getEnum(
+        Configs config,
+        const std::array<std::pair<E, std::string_view>, N> &names) const {
+        const auto &value = get(config);
+        if (!value) {
+            return std::nullopt;
+        }
+        for (const auto &[e, name] : names) {
+            if (name == *value) {
+                return e;
+            }
+        }
+        warnInvalid(config);
+        return std::nullopt;
+    }
+
+   private:
+    using Parsed =
+        std::variant<std::monostate, std::filesystem::path, std::uint64_t,
+                     double, std::chrono::milliseconds>;
+
+    void parse(Configs config, ConfigType type);
+    void warnInvalid(Configs config) const;
+
+    Values values_;
+    std::array<Parsed, static_cast<int>(Configs::MAX)> parsed_;
+    mutable std::array<std::atomic<bool>, static_cast<int>(Configs::MAX)>
+        warned_{};
+};
+
+/**
+ * snapshot - Function used to get the current configuration.
+ *
+ * The backends are loaded and every configuration is resolved on the first
+ * call. Later calls only copy the pointer under a lock held for that copy,
+ * until a reload.
+ *
+ * @return The current snapshot. Holding it keeps it alive across reloads.
+ */
+std::shared_ptr<const Snapshot> snapshot();
+
+/**
+ * reload - Function used to load the backends again and swap the snapshot.
+ *
+ * Snapshots taken before keep their values. The previous one is freed once
+ * the last reader holding it lets it go.
+ */
+void reload();
+
+/**
+ * requestReload - Function used to reload on the next call to snapshot().
+ *
+ * Only sets a flag, so it is safe to call from a signal handler. SIGHUP calls
+ * it on POSIX.
+ */
+void requestReload();
 
 /**
  * getVariable - Function used to retrieve the value of a specific
@@ -81,6 +263,7 @@ std::optional<std::string> getVariable(Configs config);
 
 /**
  * setVariable - Function used to set the value of a specific configuration.
+ * The environment is updated and the snapshot is reloaded.
  *
  * @param config The configuration for which the value is to be set.
  * @param value The new value to be set for the specified configuration.
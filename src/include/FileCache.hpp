@@ -0,0 +1,113 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief A cache of downloaded Telegram files, keyed by fileUniqueId.
+ *
+ * Files live in a directory, as an LRU with a size cap, and the small ones
+ * are also kept in memory, in a smaller LRU. The directory is indexed again
+ * on startup, so the cache survives restarts. A file requested by several
+ * threads at once is downloaded once.
+ *
+ * getFile results are memoized as well, until their download path expires.
+ */
+class FileCache {
+   public:
+    using Data = std::shared_ptr<const std::string>;
+    using Clock = std::chrono::steady_clock;
+
+    // Where files come from, Telegram's getFile and downloadFile
+    struct Source {
+        virtual ~Source() = default;
+        // The download path of fileId, nullopt if there is no such file
+        virtual std::optional<std::string> getFilePath(
+            const std::string& fileId) = 0;
+        // Throws on failure
+        virtual std::string download(const std::string& filePath) = 0;
+    };
+
+    struct Limits {
+        uint64_t diskBytes = 256 << 20;
+        size_t memoryBytes = 32 << 20;
+        // Bigger files are only kept on disk
+        size_t memoryFileBytes = 2 << 20;
+        // Telegram keeps a download path valid for at least an hour
+        std::chrono::seconds filePathTtl = std::chrono::minutes(55);
+    };
+
+    struct Stats {
+        size_t memoryHits = 0;
+        size_t diskHits = 0;
+        size_t downloads = 0;
+        size_t pathLookups = 0;
+    };
+
+    FileCache(std::filesystem::path directory, std::shared_ptr<Source> source,
+              Limits limits);
+
+    /**
+     * @brief The contents of a file, from the cache if it has them.
+     *
+     * @param fileId The id to download it with, specific to this bot.
+     * @param fileUniqueId The same for the file everywhere, the cache key.
+     * @return The contents, nullptr if it couldn't be downloaded.
+     */
+    Data get(const std::string& fileId, const std::string& fileUniqueId);
+
+    // getFile, memoized until the path expires
+    std::optional<std::string> filePath(const std::string& fileId);
+
+    [[nodiscard]] Stats stats() const;
+
+   private:
+    struct DiskEntry {
+        uint64_t size;
+        std::list<std::string>::iterator lru;
+    };
+    struct MemoryEntry {
+        Data data;
+        std::list<std::string>::iterator lru;
+    };
+    struct CachedPath {
+        std::string path;
+        Clock::time_point expires;
+    };
+
+    // Rebuilds the disk index from the directory, oldest files last used
+    void loadIndex();
+    Data readFromDisk(const std::string& key) const;
+    bool writeToDisk(const std::string& key, const std::string& contents);
+    void addToDiskLocked(const std::string& key, uint64_t size);
+    void removeFromDiskLocked(const std::string& key);
+    void addToMemoryLocked(const std::string& key, const Data& data);
+    // Downloads a file, nullptr on failure
+    Data download(const std::string& fileId);
+
+    const std::filesystem::path directory_;
+    const std::shared_ptr<Source> source_;
+    const Limits limits_;
+
+    mutable std::mutex mutex_;
+    // Front is the most recently used
+    std::list<std::string> diskLru_;
+    std::unordered_map<std::string, DiskEntry> disk_;
+    uint64_t diskBytes_ = 0;
+    std::list<std::string> memoryLru_;
+    std::unordered_map<std::string, MemoryEntry> memory_;
+    size_t memoryBytes_ = 0;
+    // Downloads or disk reads in progress, others wait for them
+    std::unordered_map<std::string, std::shared_future<Data>> loading_;
+    std::unordered_map<std::string, CachedPath> paths_;
+    Stats stats_;
+};
@@ -8,4 +8,14 @@ struct GitData {
     std::filesystem::path gitSrcRoot;
     static bool Fill(GitData *gitData);
     bool Fill(void);
+
+    /**
+     * @brief The repository the bot runs from, filled on first use only.
+     *
+     * Opening the repository walks up the directory tree, so it is done once
+     * for the whole process. Fields which couldn't be found are left empty.
+     *
+     * @return The data, shared by all callers.
+     */
+    static const GitData &get();
 };
\ No newline at end of file
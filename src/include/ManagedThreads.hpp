@@ -3,22 +3,29 @@
 #include <absl/log/check.h>
 #include <absl/log/log.h>
 
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <optional>
-#include <shared_mutex>
 #include <thread>
 #include <type_traits>
-#include <unordered_map>
 #include <utility>
 
 #include "EnumArrayHelpers.h"
 #include "InstanceClassBase.hpp"
+#include "TimerWheel.hpp"
 
 struct ManagedThread;
+struct SocketInterfaceTgBot;
+struct SpamBlockManager;
+struct IBashExitTimeoutThread;
+struct IBashUpdateOutputThread;
+struct NetworkLogSink;
+class TgBotWebServer;
 
 class ThreadManager
     : public InstanceClassBase<ThreadManager> {
@@ -28,7 +35,6 @@ class ThreadManager
     enum class Usage {
         SOCKET_THREAD,
         SOCKET_EXTERNAL_THREAD,
-        TIMER_THREAD,
         SPAMBLOCK_THREAD,
         ERROR_RECOVERY_THREAD,
         IBASH_EXIT_TIMEOUT_THREAD,
@@ -44,7 +50,6 @@ class ThreadManager
         array_helpers::make<static_cast<int>(Usage::MAX), Usage, const char*>(
             USAGE_AND_STR(SOCKET_THREAD),
             USAGE_AND_STR(SOCKET_EXTERNAL_THREAD),
-            USAGE_AND_STR(TIMER_THREAD),
             USAGE_AND_STR(SPAMBLOCK_THREAD),
             USAGE_AND_STR(ERROR_RECOVERY_THREAD),
             USAGE_AND_STR(IBASH_EXIT_TIMEOUT_THREAD),
@@ -57,31 +62,66 @@ class ThreadManager
     constexpr static const char* ThreadUsageToStr() {
         return array_helpers::find(ThreadUsageToStrMap, u)->second;
     }
-    template <Usage usage, class T = ManagedThread, typename... Args>
-        requires std::is_base_of_v<ManagedThread, T>
-    std::shared_ptr<T> createController(Args... args);
 
-    template <Usage usage, class T = ManagedThread>
-        requires std::is_base_of_v<ManagedThread, T>
-    std::shared_ptr<T> getController();
+    // The controller type of a usage, plain ManagedThread unless listed below
+    template <Usage usage>
+    struct ControllerOf {
+        using type = ManagedThread;
+    };
+    template <Usage usage>
+    using controller_t = typename ControllerOf<usage>::type;
+
+    // Returns nullptr if the usage already has a controller
+    template <Usage usage, typename... Args>
+    std::shared_ptr<controller_t<usage>> createController(Args&&... args);
+
+    // Lock-free, returns nullptr if the usage has no controller
+    template <Usage usage>
+    std::shared_ptr<controller_t<usage>> getController();
 
     // Stop all controllers managed by this manager, and shutdown this.
     void destroyManager();
     // Destroy a controller given usage
-    void destroyController(Usage usage, bool deleteIt = true);
+    void destroyController(Usage usage);
+
+    // Shared timers, use these instead of a thread which only sleeps
+    TimerWheel& timers() { return kTimers; }
 
    private:
     std::atomic_bool kIsUnderStopAll = false;
-    std::shared_mutex mControllerLock;
-    std::unordered_map<Usage, controller_type> kControllers;
+    TimerWheel kTimers;
+    // Indexed by usage, a slot only ever holds a controller_t of its usage
+    std::array<std::atomic<controller_type>, static_cast<size_t>(Usage::MAX)>
+        kControllers;
 };
 
+#define USAGE_CONTROLLER(usage, T)                                    \
+    template <>                                                       \
+    struct ThreadManager::ControllerOf<ThreadManager::Usage::usage> { \
+        using type = T;                                               \
+    }
+
+USAGE_CONTROLLER(SOCKET_THREAD, SocketInterfaceTgBot);
+USAGE_CONTROLLER(SOCKET_EXTERNAL_THREAD, SocketInterfaceTgBot);
+USAGE_CONTROLLER(SPAMBLOCK_THREAD, SpamBlockManager);
+USAGE_CONTROLLER(IBASH_EXIT_TIMEOUT_THREAD, IBashExitTimeoutThread);
+USAGE_CONTROLLER(IBASH_UPDATE_OUTPUT_THREAD, IBashUpdateOutputThread);
+USAGE_CONTROLLER(LOGSERVER_THREAD, NetworkLogSink);
+USAGE_CONTROLLER(WEBSERVER_THREAD, TgBotWebServer);
+
+#undef USAGE_CONTROLLER
+
 struct ManagedThread {
     using thread_function = std::function<void(void)>;
     using prestop_function = std::function<void(ManagedThread *)>;
+    using periodic_function = std::function<bool(void)>;
 
     // Set thread function and run - implictly starts the thread as well
     void runWith(thread_function fn);
+    // Run fn once after delay, on the shared timers instead of a thread
+    void runAfter(std::chrono::milliseconds delay, thread_function fn);
+    // Run fn every period on the shared timers, until it returns false
+    void runPeriodic(std::chrono::milliseconds period, periodic_function fn);
     // Set the function called before stopping the thread
     void setPreStopFunction(prestop_function fn);
     // Stop the underlying thread
@@ -124,8 +164,11 @@ struct ManagedThread {
     } state = ControlState::UNINITIALIZED;
 
     void _threadFn(thread_function fn);
+    // Called once the function ran to its end, by itself or stopped
+    void onFunctionReturned();
     void logInvalidState(const char* state);
     std::optional<std::thread> threadP;
+    TimerWheel::TimerId timerId = TimerWheel::kInvalidTimer;
     prestop_function preStop;
 
     struct {
@@ -136,7 +179,6 @@ struct ManagedThread {
         std::unique_lock<std::timed_mutex> lk;
     } timer_mutex;
     struct {
-        size_t sizeOfThis;
         struct {
             // It would'nt be a dangling one
             const char* str;
@@ -155,49 +197,53 @@ struct ManagedThreadRunnable : ManagedThread {
     ~ManagedThreadRunnable() override = default;
 };
 
-template <ThreadManager::Usage usage, class T, typename... Args>
-    requires std::is_base_of_v<ManagedThread, T>
-std::shared_ptr<T> ThreadManager::createController(Args... args) {
+template <ThreadManager::Usage usage, typename... Args>
+std::shared_ptr<ThreadManager::controller_t<usage>>
+ThreadManager::createController(Args&&... args) {
+    using T = controller_t<usage>;
+    static_assert(std::is_base_of_v<ManagedThread, T>);
     const char* usageStr = ThreadUsageToStr<usage>();
-    std::shared_ptr<T> newIt;
+    auto& slot = kControllers[static_cast<size_t>(usage)];
 
-    if (getController<usage, T>()) {
+    if (kIsUnderStopAll) {
+        LOG(WARNING) << "Not creating " << usageStr
+                     << " controller, manager is stopping";
+        return nullptr;
+    }
+    if (slot.load(std::memory_order_acquire)) {
         LOG(ERROR) << usageStr << " controller already exists";
         return nullptr;
     }
-    std::lock_guard<std::shared_mutex> lock(mControllerLock);
 
     DLOG(INFO) << "New allocation: " << usageStr << " controller";
-    if constexpr (sizeof...(args) != 0) {
-        newIt = std::make_shared<T>(std::forward<Args>(args)...);
-    } else {
-        newIt = std::make_shared<T>();
-    }
+    auto newIt = std::make_shared<T>(std::forward<Args>(args)...);
     auto ctrlit = std::static_pointer_cast<ManagedThread>(newIt);
     ctrlit->mgr_priv.usage.str = usageStr;
     ctrlit->mgr_priv.usage.val = usage;
-    ctrlit->mgr_priv.sizeOfThis = sizeof(T);
     CHECK(ctrlit->timer_mutex.lk.owns_lock())
         << usageStr
         << " controller unique_lock is not holding mutex. Probably "
            "constructor is not called.";
-    kControllers[usage] = newIt;
+    // Someone else may have raced us here, then ours is dropped unstarted
+    controller_type expected;
+    if (!slot.compare_exchange_strong(expected, std::move(ctrlit),
+                                      std::memory_order_acq_rel)) {
+        LOG(ERROR) << usageStr << " controller already exists";
+        return nullptr;
+    }
     return newIt;
 }
 
-template <ThreadManager::Usage usage, class T>
-    requires std::is_base_of_v<ManagedThread, T>
-std::shared_ptr<T> ThreadManager::getController() {
-    const char* usageStr = ThreadUsageToStr<usage>();
-    std::lock_guard<std::shared_mutex> lock(mControllerLock);
-    auto it = kControllers.find(usage);
-    if (it == kControllers.end()) {
-        LOG(WARNING) << usageStr << " controller does not exist";
-        return nullptr;
-    }
-    if (it->second->mgr_priv.sizeOfThis != sizeof(T)) {
-        LOG(ERROR) << usageStr << " controller is of wrong type";
+template <ThreadManager::Usage usage>
+std::shared_ptr<ThreadManager::controller_t<usage>>
+ThreadManager::getController() {
+    auto ctrl = kControllers[static_cast<size_t>(usage)].load(
+        std::memory_order_acquire);
+    if (!ctrl) {
+        LOG(WARNING) << ThreadUsageToStr<usage>()
+                     << " controller does not exist";
         return nullptr;
     }
-    return std::static_pointer_cast<T>(it->second);
+    // Only createController<usage>() stores into this slot
+    return std::static_pointer_cast<controller_t<usage>>(std::move(ctrl));
 }
@@ -2,8 +2,10 @@
 #include <tgbot/types/Message.h>
 #include <tgbot/types/Sticker.h>
 
-#include <memory>
+#include <ParsedCommand.hpp>
 #include <optional>
+#include <string>
+#include <string_view>
 #include <utility>
 
 #include "BotClassBase.h"
@@ -15,36 +17,51 @@ using TgBot::Bot;
 // Provides easy access, without bot
 struct MessageWrapperLimited {
     TgBot::Message::Ptr message;
-    std::shared_ptr<MessageWrapperLimited> parent;
 
     [[nodiscard]] ChatId getChatId() const { return message->chat->id; }
     [[nodiscard]] bool hasReplyToMessage() const {
         return message->replyToMessage != nullptr;
     }
-    virtual bool switchToReplyToMessage() noexcept {
+    bool switchToReplyToMessage() noexcept {
         if (message->replyToMessage) {
-            parent = std::make_shared<MessageWrapperLimited>(
-                MessageWrapperLimited(message, parent));
             message = message->replyToMessage;
+            ++depth;
             return true;
         }
         return false;
     }
-    virtual void switchToParent() noexcept {
-        if (parent) {
-            message = parent->message;
-            parent = parent->parent;
+    void switchToParent() noexcept {
+        if (depth == 0) {
+            return;
+        }
+        // Walked down again from the original, so switching allocates nothing
+        --depth;
+        message = original;
+        for (unsigned int i = 0; i < depth; ++i) {
+            message = message->replyToMessage;
         }
     }
 
+    // The command in the text, parsed once per message
+    [[nodiscard]] const ParsedCommand& getCommand() const noexcept {
+        if (parsedFor != message.get()) {
+            parsed = ParsedCommand::parse(message->text);
+            parsedFor = message.get();
+        }
+        return parsed;
+    }
     [[nodiscard]] bool hasExtraText() const noexcept {
-        return firstBlank(message) != std::string::npos;
+        return getCommand().hasArgs;
+    }
+    // Valid as long as the message is
+    [[nodiscard]] std::string_view getExtraTextView() const noexcept {
+        return getCommand().args;
     }
     [[nodiscard]] std::string getExtraText() const noexcept {
-        return message->text.substr(firstBlank(message) + 1);
+        return std::string(getExtraTextView());
     }
     void getExtraText(std::string& extraText) const noexcept {
-        extraText = getExtraText();
+        extraText = getExtraTextView();
     }
     [[nodiscard]] bool hasSticker() const noexcept {
         return message->sticker != nullptr;
@@ -76,74 +93,47 @@ struct MessageWrapperLimited {
         return message->photo;
     }
     explicit MessageWrapperLimited(Message::Ptr message)
-        : message(std::move(message)) {}
+        : message(std::move(message)), original(this->message) {}
 
     virtual ~MessageWrapperLimited() = default;
 
+   protected:
+    // The message the wrapper was made for
+    TgBot::Message::Ptr original;
+
    private:
-    MessageWrapperLimited(Message::Ptr message,
-                          std::shared_ptr<MessageWrapperLimited> parent)
-        : MessageWrapperLimited(std::move(message)) {
-        this->parent = std::move(parent);
-    }
-    [[nodiscard]] static std::string::size_type firstBlank(
-        const TgBot::Message::Ptr& msg) noexcept {
-        return msg->text.find_first_of(" \n\r");
-    }
+    // How many replies down from the original message is
+    unsigned int depth = 0;
+    mutable const TgBot::Message* parsedFor = nullptr;
+    mutable ParsedCommand parsed;
 };
 
 // Simple wrapper for TgBot::Message::Ptr.
 // Provides easy access
 struct MessageWrapper : BotClassBase, MessageWrapperLimited {
-    std::shared_ptr<MessageWrapper> parent;
+    using MessageWrapperLimited::switchToReplyToMessage;
 
-    bool switchToReplyToMessage(const std::string& text) noexcept {
+    bool switchToReplyToMessage(std::string_view text) noexcept {
         if (switchToReplyToMessage()) {
             return true;
         } else {
-            bot_sendReplyMessage(_bot, message, text);
+            bot_sendReplyMessage(_bot, message, std::string(text));
             return false;
         }
     }
-    bool switchToReplyToMessage() noexcept override {
-        if (message->replyToMessage) {
-            parent = std::make_shared<MessageWrapper>(
-                MessageWrapper(_bot, message, parent));
-            message = message->replyToMessage;
-            return true;
-        }
-        return false;
-    }
-    void switchToParent() noexcept override {
-        if (parent) {
-            message = parent->message;
-            parent = parent->parent;
-        }
-    }
 
     explicit MessageWrapper(const Bot& bot, TgBot::Message::Ptr message)
         : BotClassBase(bot), MessageWrapperLimited(std::move(message)) {}
     ~MessageWrapper() noexcept override {
-        Message::Ptr Rmessage;
-        if (parent) {
-            Rmessage = parent->message;
-        } else {
-            Rmessage = message;
-        }
         if (onExitMessage && !onExitMessage->empty()) {
-            bot_sendReplyMessage(_bot, Rmessage, *onExitMessage);
+            bot_sendReplyMessage(_bot, original, *onExitMessage);
         }
     }
-    void sendMessageOnExit(std::string message) noexcept {
-        onExitMessage = std::move(message);
+    void sendMessageOnExit(std::string_view message) noexcept {
+        onExitMessage = std::string(message);
     }
     void sendMessageOnExit() noexcept { onExitMessage = std::nullopt; }
 
    private:
-    MessageWrapper(const Bot& bot, Message::Ptr message,
-                   std::shared_ptr<MessageWrapper> parent)
-        : MessageWrapper(bot, std::move(message)) {
-        this->parent = std::move(parent);
-    }
     std::optional<std::string> onExitMessage;
 };
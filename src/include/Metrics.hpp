@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief Counters, gauges and histograms, served in the Prometheus format.
+ *
+ * Counters and histograms are split in shards, and a thread only adds to
+ * its own with a relaxed atomic, so hot paths never lock or fight over a
+ * cache line. Shards are summed when the metrics are serialized. A metric
+ * is registered once by name, and lives until the process exits, so hot
+ * paths keep a reference to it in a static.
+ */
+namespace Metrics {
+
+constexpr size_t kShards = 8;
+
+namespace detail {
+// The calling thread's shard, threads are spread over them in turn
+size_t shardIndex();
+
+struct alignas(64) Cell {
+    std::atomic<uint64_t> value{0};
+};
+}  // namespace detail
+
+class Counter {
+   public:
+    void add(const uint64_t n = 1) {
+        shards_[detail::shardIndex()].value.fetch_add(
+            n, std::memory_order_relaxed);
+    }
+    [[nodiscard]] uint64_t value() const;
+
+   private:
+    std::array<detail::Cell, kShards> shards_;
+};
+
+// A value which goes up and down. Not sharded, it is set rather than added.
+class Gauge {
+   public:
+    void set(const int64_t value) {
+        value_.store(value, std::memory_order_relaxed);
+    }
+    void add(const int64_t delta) {
+        value_.fetch_add(delta, std::memory_order_relaxed);
+    }
+    [[nodiscard]] int64_t value() const {
+        return value_.load(std::memory_order_relaxed);
+    }
+
+   private:
+    std::atomic<int64_t> value_{0};
+};
+
+/**
+ * @brief Durations in microseconds, with log-linear buckets like HDR
+ * histograms.
+ *
+ * Each power of two is split into kSubBuckets buckets, so a bucket is
+ * within 25% of the values in it. Values past 2^kMaxBits us, about 12 days,
+ * go to the last bucket.
+ */
+class Histogram {
+   public:
+    static constexpr int kSubBucketBits = 2;
+    static constexpr size_t kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kMaxBits = 40;
+    static constexpr size_t kBuckets =
+        (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+
+    struct Snapshot {
+        std::array<uint64_t, kBuckets> counts{};
+        uint64_t count = 0;
+        uint64_t sum = 0;  // In microseconds
+    };
+
+    void record(uint64_t micros);
+    template <typename Rep, typename Period>
+    void record(const std::chrono::duration<Rep, Period> duration) {
+        const auto micros =
+            std::chrono::duration_cast<std::chrono::microseconds>(duration);
+        record(static_cast<uint64_t>(std::max<Rep>(micros.count(), 0)));
+    }
+    [[nodiscard]] Snapshot snapshot() const;
+
+    static size_t bucketOf(uint64_t micros);
+    // Values in bucket are below this
+    static uint64_t upperBound(size_t bucket);
+
+   private:
+    struct alignas(64) Shard {
+        std::array<std::atomic<uint64_t>, kBuckets> counts{};
+        std::atomic<uint64_t> sum{0};
+    };
+    std::array<Shard, kShards> shards_;
+};
+
+// Records how long it lived into a histogram
+class ScopedTimer {
+   public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() {
+        histogram_.record(std::chrono::steady_clock::now() - start_);
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+   private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief The metric called name, registered on the first call.
+ *
+ * Names follow Prometheus, like tgbot_updates_total. Asking for a name
+ * registered as another type is a fatal error.
+ */
+Counter& counter(std::string_view name, std::string_view help);
+Gauge& gauge(std::string_view name, std::string_view help);
+// Exposed in seconds, as Prometheus expects
+Histogram& histogram(std::string_view name, std::string_view help);
+
+// Every metric in the Prometheus text format, for /metrics, which the web
+// server only serves to loopback clients
+std::string serialize();
+
+}  // namespace Metrics
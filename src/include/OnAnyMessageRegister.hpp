@@ -6,12 +6,15 @@
 #include <cstddef>
 #include <functional>
 #include <map>
+#include <mutex>
 #include <vector>
 
 #include "Authorization.h"
 #include "CStringLifetime.h"
 #include "CompileTimeStringConcat.hpp"
 #include "InstanceClassBase.hpp"
+#include "Metrics.hpp"
+#include "Tracing.hpp"
 #include "initcalls/BotInitcall.hpp"
 
 using TgBot::Bot;
@@ -30,6 +33,7 @@ struct OnAnyMessageRegisterer : InstanceClassBase<OnAnyMessageRegisterer>,
      * @param callback The function to be called when any message is received.
      */
     void registerCallback(const callback_type& callback) {
+        const std::lock_guard<std::mutex> lock(mutex);
         callbacks.emplace_back(callback);
     }
 
@@ -41,6 +45,7 @@ struct OnAnyMessageRegisterer : InstanceClassBase<OnAnyMessageRegisterer>,
      * @param token A unique identifier for the callback.
      */
     void registerCallback(const callback_type& callback, const size_t token) {
+        const std::lock_guard<std::mutex> lock(mutex);
         callbacksWithToken[token] = callback;
     }
 
@@ -54,6 +59,7 @@ struct OnAnyMessageRegisterer : InstanceClassBase<OnAnyMessageRegisterer>,
      * successfully unregistered, false otherwise.
      */
     bool unregisterCallback(const size_t token) {
+        const std::lock_guard<std::mutex> lock(mutex);
         auto it = callbacksWithToken.find(token);
         if (it == callbacksWithToken.end()) {
             return false;
@@ -63,7 +69,18 @@ struct OnAnyMessageRegisterer : InstanceClassBase<OnAnyMessageRegisterer>,
     }
 
     void doInitCall(Bot& bot) override {
+        static auto& updates = Metrics::counter(
+            "tgbot_updates_total", "Messages received from Telegram");
+        static auto& latency = Metrics::histogram(
+            "tgbot_update_callbacks_seconds",
+            "Time spent in onAnyMessage callbacks per message");
+
         bot.getEvents().onAnyMessage([this, &bot](const Message::Ptr& message) {
+            updates.add();
+            // Ends with the next update, commands run after this returns
+            Tracing::beginTrace("update");
+            const Tracing::Span span("onAnyMessage callbacks");
+            const Metrics::ScopedTimer timer(latency);
             for (auto& callback : callbacks) {
                 callback(bot, message);
             }
@@ -82,6 +99,8 @@ struct OnAnyMessageRegisterer : InstanceClassBase<OnAnyMessageRegisterer>,
     }
 
    private:
+    // Initcalls register at the same time
+    std::mutex mutex;
     std::vector<callback_type> callbacks;
     std::map<size_t, callback_type> callbacksWithToken;
 };
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string_view>
+
+/**
+ * @brief A message's text split in its command parts, without copying it.
+ *
+ * "/cmd@some_bot extra text" has command "cmd", target "some_bot" and args
+ * "extra text". Args are what follows the first blank, as is. The views
+ * point into the text parsed, which must outlive them.
+ */
+struct ParsedCommand {
+    // Without the leading '/', empty if the text isn't a command
+    std::string_view command;
+    // The bot after '@', empty if there is none
+    std::string_view target;
+    std::string_view args;
+    // Whether there was a blank, args may still be empty
+    bool hasArgs = false;
+
+    [[nodiscard]] static ParsedCommand parse(
+        const std::string_view text) noexcept {
+        ParsedCommand parsed;
+        auto head = text;
+
+        if (const auto blank = text.find_first_of(" \n\r");
+            blank != std::string_view::npos) {
+            head = text.substr(0, blank);
+            parsed.args = text.substr(blank + 1);
+            parsed.hasArgs = true;
+        }
+        if (!head.starts_with('/')) {
+            return parsed;
+        }
+        head.remove_prefix(1);
+        if (const auto at = head.find('@'); at != std::string_view::npos) {
+            parsed.target = head.substr(at + 1);
+            head = head.substr(0, at);
+        }
+        parsed.command = head;
+        return parsed;
+    }
+
+    [[nodiscard]] bool isCommand() const noexcept { return !command.empty(); }
+    // Commands without a target are for every bot in the chat
+    [[nodiscard]] bool isFor(const std::string_view username) const noexcept {
+        return target.empty() || target == username;
+    }
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <curl/curl.h>
+#include <tgbot/net/HttpClient.h>
+#include <tgbot/net/HttpReqArg.h>
+#include <tgbot/net/Url.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief A TgBot::HttpClient which keeps its connections open.
+ *
+ * TgBot::CurlHttpClient makes every request on a fresh connection, so each
+ * API call pays for a TCP and a TLS handshake. Here all requests go through
+ * one curl multi handle, driven by a single thread: connections are kept
+ * alive and reused, TLS sessions are resumed, and with HTTP/2 concurrent
+ * requests share one connection. Callers only block on their own request.
+ */
+class PooledCurlHttpClient : public TgBot::HttpClient {
+   public:
+    struct Options {
+        // Connections to one host. Beyond that, HTTP/1.1 requests wait.
+        long maxHostConnections = 8;
+        // Negotiate HTTP/2 where the server supports it
+        bool http2 = true;
+        std::chrono::seconds connectTimeout{20};
+        // CA bundle to verify the server with, empty for the default one
+        std::string caInfo;
+    };
+
+    PooledCurlHttpClient();
+    explicit PooledCurlHttpClient(Options options);
+    ~PooledCurlHttpClient() override;
+    PooledCurlHttpClient(const PooledCurlHttpClient&) = delete;
+    PooledCurlHttpClient& operator=(const PooledCurlHttpClient&) = delete;
+
+    /**
+     * @brief Sends a request and waits for its response.
+     *
+     * A POST with args as multipart form data, or a GET if there are none.
+     *
+     * @return The response body.
+     * @throws std::runtime_error if the transfer failed.
+     */
+    std::string makeRequest(
+        const TgBot::Url& url,
+        const std::vector<TgBot::HttpReqArg>& args) const override;
+
+    // Number of connections opened so far, reused ones aren't counted
+    [[nodiscard]] size_t connectionsOpened() const;
+
+   private:
+    struct Transfer;
+
+    // An easy handle from the idle ones, or a new one
+    CURL* takeHandle() const;
+    void returnHandle(CURL* easy) const;
+    // Marks transfer finished and wakes its caller
+    void finish(Transfer* transfer, CURLcode result) const;
+    void threadFn();
+
+    const Options options_;
+    CURLM* multi_;
+    // Only used from the thread, so it needs no locking
+    CURLSH* share_;
+
+    mutable std::mutex mutex_;
+    // Requests for the thread to add to multi_
+    mutable std::vector<Transfer*> queued_;
+    mutable std::vector<CURL*> idle_;
+    mutable std::atomic<size_t> connectionsOpened_ = 0;
+    bool stopped_ = false;
+    std::thread thread_;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <tgbot/net/HttpClient.h>
+#include <tgbot/net/HttpReqArg.h>
+#include <tgbot/net/Url.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief A TgBot::HttpClient which replays recorded updates, offline.
+ *
+ * getUpdates is served from a file of Update objects, one JSON per line,
+ * as Telegram sent them. They go out one per call, spaced by their
+ * recorded dates divided by the speed, or as fast as the bot takes them
+ * with a speed of 0. Dates are rewritten to the time they are served, so
+ * the bot's age checks pass. Every other method is answered locally with a
+ * made up result, and counted with the time it took.
+ *
+ * An update's latency is from it being served to the bot asking for the
+ * next one, which is once all of its handlers returned. Once the file is
+ * done, the next getUpdates calls onFinished with the report.
+ */
+class ReplayHttpClient : public TgBot::HttpClient {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Report {
+        struct Calls {
+            size_t count = 0;
+            // Of answering one, locally
+            Clock::duration p50{};
+            Clock::duration p99{};
+            Clock::duration max{};
+        };
+
+        size_t updates = 0;
+        Clock::duration elapsed{};
+        Clock::duration p50{};
+        Clock::duration p99{};
+        Clock::duration max{};
+        // API calls by method, other than getUpdates
+        std::map<std::string, Calls> calls;
+
+        [[nodiscard]] double updatesPerSecond() const;
+    };
+    using FinishedCallback = std::function<void(const Report&)>;
+
+    ReplayHttpClient(const std::filesystem::path& file, double speed,
+                     FinishedCallback onFinished);
+
+    // Number of updates read from the file
+    [[nodiscard]] size_t size() const { return updates_.size(); }
+
+    std::string makeRequest(
+        const TgBot::Url& url,
+        const std::vector<TgBot::HttpReqArg>& args) const override;
+
+   private:
+    struct Recorded {
+        std::string json;
+        int64_t date;  // Of its message, 0 if it has none
+    };
+
+    std::string nextUpdates() const;
+    std::string fakeResult(const std::string& method,
+                           const std::vector<TgBot::HttpReqArg>& args) const;
+
+    const double speed_;
+    const FinishedCallback onFinished_;
+    std::vector<Recorded> updates_;
+
+    // getUpdates is only called by the long poll, on one thread
+    mutable size_t next_ = 0;
+    mutable Clock::time_point start_;
+    mutable Clock::time_point lastServed_;
+    mutable std::vector<Clock::duration> latencies_;
+
+    mutable std::mutex callsMutex_;
+    // Latencies of the calls, by method
+    mutable std::map<std::string, std::vector<Clock::duration>> calls_;
+    mutable std::atomic<int32_t> nextMessageId_ = 1;
+};
+
+std::ostream& operator<<(std::ostream& out,
+                         const ReplayHttpClient::Report& report);
@@ -28,13 +28,14 @@ using TgBot::Chat;
 using TgBot::Message;
 using TgBot::User;
 
-struct SpamBlockBase : ManagedThreadRunnable {
+struct SpamBlockBase : ManagedThread {
     // User and array of message pointers sent by that user
     using PerChatHandle = std::map<User::Ptr, std::vector<Message::Ptr>>;
     // Iterator type of buffer object, which contains <chats <users <msgs>>> map
     using OneChatIterator = std::map<Chat::Ptr, PerChatHandle>::const_iterator;
     using PerChatHandleConstRef = PerChatHandle::const_reference;
-    using ManagedThreadRunnable::ManagedThreadRunnable;
+    using ManagedThread::ManagedThread;
+    constexpr static auto kScanInterval = std::chrono::seconds(10);
     constexpr static int sMaxSameMsgThreshold = 3;
     constexpr static int sMaxMsgThreshold = 5;
     constexpr static int sSpamDetectThreshold = 5;
@@ -45,7 +46,9 @@ struct SpamBlockBase : ManagedThreadRunnable {
                                           const size_t threshold,
                                           const char *name) {};
 
-    void runFunction() override;
+    // Scans the buffered messages every kScanInterval, on the shared timers
+    void run();
+    void runFunction();
     void addMessage(const Message::Ptr &message);
 
     static std::string commonMsgdataFn(const Message::Ptr &m);
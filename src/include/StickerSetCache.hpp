@@ -0,0 +1,99 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Sticker sets by name, with only what is needed to send a sticker.
+ *
+ * getStickerSet returns every sticker of a set with its thumbnail, while
+ * picking one to send needs its fileId only. A set is kept for ttl, and
+ * served as is after that while it is refreshed in the background. Sets not
+ * used for maxAge are fetched again before they are served. Concurrent
+ * misses of a set share a single fetch.
+ */
+class StickerSetCache {
+   public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Sticker {
+        std::string fileId;
+        std::string emoji;
+    };
+    struct Set {
+        std::string title;
+        std::vector<Sticker> stickers;
+    };
+    using SetPtr = std::shared_ptr<const Set>;
+
+    struct Source {
+        virtual ~Source() = default;
+        // Throws on failure, like TgBot::Api::getStickerSet
+        virtual Set fetch(const std::string& name) = 0;
+    };
+    // Runs a refresh later, on another thread, or drops it without running
+    // it. The cache must outlive it.
+    using Executor = std::function<void(std::function<void()>)>;
+
+    struct Limits {
+        std::chrono::seconds ttl = std::chrono::hours(1);
+        std::chrono::seconds maxAge = std::chrono::hours(24);
+        size_t maxSets = 512;
+    };
+
+    struct Stats {
+        size_t hits = 0;
+        // Hits on sets past their ttl, a refresh was started
+        size_t staleHits = 0;
+        size_t misses = 0;
+        // Misses which waited on the fetch of another one
+        size_t sharedMisses = 0;
+        size_t refreshes = 0;
+        size_t failures = 0;
+    };
+
+    StickerSetCache(std::shared_ptr<Source> source, Executor executor,
+                    Limits limits);
+
+    /**
+     * @brief The sticker set named name.
+     *
+     * @return The set, from memory if it was fetched before.
+     * @throws What Source::fetch throws, if the set had to be fetched.
+     */
+    SetPtr get(const std::string& name);
+
+    [[nodiscard]] Stats stats() const;
+
+   private:
+    struct Entry {
+        SetPtr set;
+        Clock::time_point fetched;
+        bool refreshing = false;
+        std::list<std::string>::iterator lru;
+    };
+
+    void refresh(const std::string& name);
+    // Lets the next stale hit of name start a refresh
+    void endRefresh(const std::string& name);
+    void storeLocked(const std::string& name, SetPtr set);
+
+    const std::shared_ptr<Source> source_;
+    const Executor executor_;
+    const Limits limits_;
+
+    mutable std::mutex mutex_;
+    // Front is the most recently used
+    std::list<std::string> lru_;
+    std::unordered_map<std::string, Entry> sets_;
+    std::unordered_map<std::string, std::shared_future<SetPtr>> fetching_;
+    Stats stats_;
+};
@@ -22,6 +22,9 @@ class TgBotWebServerBase {
         static constexpr const std::string_view kAboutPage = "/about.html";
         static constexpr const std::string_view kAPIVotesNode = "/api/votes";
         static constexpr const std::string_view kAPIVotesKey = "votes";
+        // Only answered to loopback clients. A reverse proxy on this host
+        // makes every client local, so it must not forward this path.
+        static constexpr const std::string_view kMetricsNode = "/metrics";
         static constexpr const std::string_view kBindToIp = "0.0.0.0";
         static constexpr const std::string_view kLocalHostname = "localhost";
     };
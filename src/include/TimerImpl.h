@@ -4,26 +4,26 @@
 #include <tgbot/types/Message.h>
 
 #include <chrono>
+#include <memory>
+#include <mutex>
 
-#include "ManagedThreads.hpp"
+#include "ChatTimers.hpp"
 
 using TgBot::Bot;
 using TgBot::Message;
 
-struct TimerCommandManager : ManagedThread {
+// /starttimer and /stoptimer, one timer per chat, all on the shared timers
+struct TimerCommandManager {
     static constexpr int TIMER_CONFIG_SEC = 5;
-    TimerCommandManager() : ManagedThread() {}
-    ~TimerCommandManager() override = default;
 
     void startTimer(const Bot &bot, const Message::Ptr &message);
     void stopTimer(const Bot &bot, const Message::Ptr &message);
-    static void Timerstop(ManagedThread *);
 
    private:
-    void TimerThreadFn(const Bot &bot, Message::Ptr message,
-                       std::chrono::seconds s);
     bool parseTimerArguments(const Bot &bot, const Message::Ptr &message,
                              std::chrono::seconds &out);
-    bool botcanpin = true, sendendmsg = true, isactive = false;
-    Message::Ptr message;
+    // Created with the first command's bot
+    ChatTimers &getTimers(const Bot &bot);
+    std::once_flag timersOnce;
+    std::unique_ptr<ChatTimers> timers;
 };
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Runs one-shot and periodic callbacks, all from a single thread.
+ *
+ * A hierarchical timer wheel with a 1ms tick: kLevels levels of kSlots
+ * slots, each level kSlots times coarser than the one below. Scheduling and
+ * cancelling are O(1), and timers in the upper levels are moved down as
+ * their time comes closer. The thread sleeps until the next tick which has
+ * something to do, so idle timers cost no wakeups.
+ *
+ * Callbacks run on the wheel's thread, so they should be short, and hand
+ * anything long off to another thread.
+ * A callback which throws is logged and doesn't run again.
+ */
+class TimerWheel {
+   public:
+    using Callback = std::function<void()>;
+    // Returns whether it should run again
+    using PeriodicCallback = std::function<bool()>;
+    using TimerId = uint64_t;
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr TimerId kInvalidTimer = 0;
+    static constexpr int kSlotBits = 6;
+    static constexpr size_t kSlots = 1 << kSlotBits;
+    static constexpr int kLevels = 6;
+
+    TimerWheel();
+    ~TimerWheel();
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief Runs fn once, after delay.
+     *
+     * @return An id for cancel(), kInvalidTimer if the wheel is stopped.
+     */
+    TimerId schedule(std::chrono::milliseconds delay, Callback fn);
+
+    /**
+     * @brief Runs fn every period, the first time after one period, until it
+     * returns false.
+     *
+     * If the wheel falls behind, missed runs are skipped, not queued.
+     *
+     * @return An id for cancel(), kInvalidTimer if the wheel is stopped.
+     */
+    TimerId schedulePeriodic(std::chrono::milliseconds period,
+                             PeriodicCallback fn);
+
+    /**
+     * @brief Cancels a timer.
+     *
+     * If its callback is running, waits for it to return, so the callback's
+     * data can be freed right after this. Callbacks may cancel themselves,
+     * that doesn't wait.
+     *
+     * @return true if the timer was still pending or running.
+     */
+    bool cancel(TimerId id);
+
+    // Cancels all timers and joins the thread. schedule() fails afterwards.
+    void stop();
+
+    // Number of timers which haven't fired yet, periodic ones included.
+    [[nodiscard]] size_t pending() const;
+
+   private:
+    struct Timer {
+        TimerId id;
+        uint64_t expires;  // In ticks
+        uint64_t period;   // In ticks, 0 if one-shot
+        PeriodicCallback fn;
+        Timer* prev = nullptr;
+        Timer* next = nullptr;
+        int level = -1;  // -1 if not linked
+        size_t slot = 0;
+    };
+    struct Level {
+        std::array<Timer*, kSlots> heads{};
+        uint64_t occupied = 0;  // Bit per non-empty slot
+    };
+
+    TimerId add(uint64_t delayTicks, uint64_t periodTicks,
+                PeriodicCallback fn);
+    [[nodiscard]] uint64_t ticksNow() const;
+    // Links a timer into its slot, relative to now_
+    void link(Timer* timer);
+    void unlink(Timer* timer);
+    // The next tick with a timer to fire or move down, if there is one
+    [[nodiscard]] bool nextEvent(uint64_t* tick) const;
+    // Moves to tick, and collects the ids of the timers which expire on it
+    void advanceTo(uint64_t tick, std::vector<TimerId>* due);
+    void threadFn();
+
+    mutable std::mutex mutex_;
+    std::condition_variable wakeup_;
+    // Signalled when a callback returns, for cancel()
+    std::condition_variable callbackDone_;
+    std::array<Level, kLevels> levels_;
+    std::unordered_map<TimerId, std::unique_ptr<Timer>> timers_;
+    const Clock::time_point epoch_;
+    uint64_t now_ = 0;  // The last tick processed
+    // The tick the thread sleeps until, so schedule() only wakes it if needed
+    uint64_t wakeAt_ = UINT64_MAX;
+    TimerId nextId_ = kInvalidTimer;
+    // The timer whose callback is running, and whether it was cancelled
+    TimerId running_ = kInvalidTimer;
+    bool runningCancelled_ = false;
+    bool stopped_ = false;
+    std::thread thread_;
+};
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+/**
+ * @brief Spans of the work done for an update, written to a trace file.
+ *
+ * A trace starts when an update is received, and spans opened on the same
+ * thread until it ends are part of it. Work handed to another thread
+ * carries the trace along with Resume. Only a fraction of traces are
+ * recorded, by the sample rate, so tracing can stay on.
+ *
+ * Spans go to a ring buffer of their thread, and a background thread
+ * writes them to a file in the Chrome trace event format, which Perfetto
+ * and chrome://tracing load. Spans are dropped if a buffer fills up before
+ * it is written.
+ */
+namespace Tracing {
+
+// The trace of a thread, 0 if not traced
+struct Context {
+    uint64_t trace = 0;
+};
+
+/**
+ * @brief Starts writing traces to file.
+ *
+ * @param file The trace file, replaced if it exists
+ * @param sampleRate Fraction of traces to record, from 0 to 1
+ *
+ * @return false if it can't be opened or tracing has started already
+ */
+bool start(const std::filesystem::path& file, double sampleRate);
+// Writes what is left and closes the file
+void stop();
+
+/**
+ * @brief Starts a trace on this thread, ending the one running if any.
+ *
+ * name must be a string literal, or outlive the trace.
+ */
+void beginTrace(std::string_view name);
+void endTrace();
+
+[[nodiscard]] Context current();
+
+// Records the time between its construction and destruction
+class Span {
+   public:
+    // name must outlive the span
+    explicit Span(std::string_view name);
+    ~Span();
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+   private:
+    std::string_view name_;
+    uint64_t trace_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// Continues context on this thread, until it is destroyed
+class Resume {
+   public:
+    explicit Resume(Context context);
+    ~Resume();
+    Resume(const Resume&) = delete;
+    Resume& operator=(const Resume&) = delete;
+
+   private:
+    Context previous_;
+};
+
+}  // namespace Tracing
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Runs initcalls on a few threads, each once what it needs is done.
+ *
+ * A task can only depend on tasks added before it, so there are no cycles.
+ * Tasks without a path between them may run at the same time.
+ */
+class InitScheduler {
+   public:
+    using Task = size_t;
+    struct Timing {
+        std::string name;
+        std::chrono::milliseconds duration;
+    };
+
+    Task add(std::string name, const std::vector<Task>& dependencies,
+             std::function<void()> fn);
+
+    /**
+     * @brief Runs every task, returns once all are done.
+     *
+     * If a task throws, the tasks depending on it are skipped, the others
+     * still run, and the first exception is rethrown at the end.
+     *
+     * @param[in] threads Tasks running at once, the caller included.
+     * @return How long each task took, in the order they were added.
+     */
+    std::vector<Timing> run(unsigned threads);
+
+   private:
+    struct Node {
+        std::string name;
+        std::function<void()> fn;
+        std::vector<Task> dependents;
+        size_t pending = 0;  // Dependencies not done yet
+        bool skipped = false;
+        std::chrono::milliseconds duration{};
+    };
+
+    std::vector<Node> nodes_;
+};
@@ -2,6 +2,7 @@
 #include <unistd.h>
 
 #include <array>
+#include <memory>
 
 using pipe_t = std::array<int, 2>;
 
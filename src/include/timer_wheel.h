@@ -0,0 +1,44 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* C interface to the shared timer wheel, see TimerWheel.hpp */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef uint64_t timer_wheel_id_t;
+typedef void (*timer_wheel_callback_t)(void *arg);
+
+/**
+ * @brief Runs callback(arg) once, after delay_ms milliseconds.
+ *
+ * The callback runs on the timer wheel's thread, and should be short.
+ *
+ * @param delay_ms The delay in milliseconds.
+ * @param callback The function to call.
+ * @param arg The argument passed to callback.
+ *
+ * @return An id for timer_wheel_cancel(), 0 on failure.
+ */
+timer_wheel_id_t timer_wheel_schedule(uint32_t delay_ms,
+                                      timer_wheel_callback_t callback,
+                                      void *arg);
+
+/**
+ * @brief Cancels a timer scheduled with timer_wheel_schedule().
+ *
+ * If the callback is running, waits for it to return, so arg can be freed
+ * afterwards. Must not be called with a lock the callback takes.
+ *
+ * @param id The id returned by timer_wheel_schedule().
+ *
+ * @return true if the timer was still pending or running.
+ */
+bool timer_wheel_cancel(timer_wheel_id_t id);
+
+#ifdef __cplusplus
+}
+#endif
@@ -5,6 +5,7 @@
 #include <filesystem>
 
 #include "ConfigManager.h"
+#include "DurationPoint.hpp"
 #include "GitData.h"
 #include "ResourceManager.h"
 
@@ -58,9 +59,56 @@ std::filesystem::path& FS::makeRelativeToCWD(std::filesystem::path& path) {
     return path;
 }
 
+namespace {
+
+// Paths in the source tree, as getPathForType() returns them. Absolute, as
+// they outlive any change of the working directory.
+struct SourcePaths {
+    std::filesystem::path gitRoot;
+    std::filesystem::path resources;
+    std::filesystem::path resourcesSql;
+    std::filesystem::path resourcesWebpage;
+};
+
+std::filesystem::path findSourceRoot() {
+    if (const auto root = ConfigManager::snapshot()->getPath(
+            ConfigManager::Configs::SRC_ROOT)) {
+        LOG(INFO) << "Using source root from SRC_ROOT: " << *root;
+        return *root;
+    }
+    return GitData::get().gitSrcRoot;
+}
+
+const SourcePaths& sourcePaths() {
+    static const SourcePaths paths = [] {
+        const auto finish = [](const std::filesystem::path& path) {
+            return std::filesystem::absolute(path)
+                .lexically_normal()
+                .make_preferred();
+        };
+        auto dp = DurationPoint();
+        SourcePaths paths;
+        const auto root = findSourceRoot();
+
+        if (root.empty()) {
+            LOG(ERROR) << "Could not find the source tree, set SRC_ROOT";
+        } else {
+            paths.gitRoot = finish(root);
+        }
+        paths.resources = finish(root / ResourceManager::kResourceDirname);
+        paths.resourcesSql = finish(paths.resources / "sql");
+        paths.resourcesWebpage = finish(root / "www");
+        LOG(INFO) << "Resolved source paths in " << dp.get().count()
+                  << "ms, later lookups reuse them";
+        return paths;
+    }();
+    return paths;
+}
+
+}  // namespace
+
 std::filesystem::path FS::getPathForType(PathType type) {
     std::filesystem::path path;
-    GitData data;
     bool ok = false;
 
     switch (type) {
@@ -68,16 +116,14 @@ std::filesystem::path FS::getPathForType(PathType type) {
             if (getHomePath(path)) ok = true;
             break;
         case PathType::GIT_ROOT:
-            if (GitData::Fill(&data)) {
-                path = data.gitSrcRoot;
-                ok = true;
-            }
-            break;
+            // Empty without a source tree, which sourcePaths() logged
+            return sourcePaths().gitRoot;
         case PathType::RESOURCES:
-            path = getPathForType(PathType::GIT_ROOT) /
-                   ResourceManager::kResourceDirname;
-            ok = true;
-            break;
+            return sourcePaths().resources;
+        case PathType::RESOURCES_SQL:
+            return sourcePaths().resourcesSql;
+        case PathType::RESOURCES_WEBPAGE:
+            return sourcePaths().resourcesWebpage;
         case PathType::MODULES_INSTALLED:
         case PathType::BUILD_ROOT: {
             int argc = 0;
@@ -89,14 +135,6 @@ std::filesystem::path FS::getPathForType(PathType type) {
             }
             break;
         }
-        case PathType::RESOURCES_SQL:
-            path = getPathForType(PathType::RESOURCES) / "sql";
-            ok = true;
-            break;
-        case PathType::RESOURCES_WEBPAGE:
-            path = getPathForType(PathType::GIT_ROOT) / "www";
-            ok = true;
-            break;
     }
     if (ok) {
         path.make_preferred();
@@ -105,4 +143,4 @@ std::filesystem::path FS::getPathForType(PathType type) {
         LOG(ERROR) << "Could not find path for type " << static_cast<int>(type);
     }
     return path;
-}
\ No newline at end of file
+}
@@ -25,6 +25,11 @@ struct FS {
     /**
      * Returns the path associated with the specified type.
      *
+     * Paths in the source tree are resolved once, on the first call, and
+     * don't change afterwards. They are absolute, so they stay valid if the
+     * working directory changes. The source tree is the SRC_ROOT config if
+     * it is set, or the git repository the bot runs from.
+     *
      * @param type The type of path to retrieve.
      * @return The path, if it exists, or an empty path.
      */
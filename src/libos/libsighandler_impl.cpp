@@ -1,4 +1,6 @@
+#include <ApiScheduler.hpp>
 #include <ManagedThreads.hpp>
+#include <Tracing.hpp>
 #include <database/bot/TgBotDatabaseImpl.hpp>
 #include <mutex>
 
@@ -13,6 +15,8 @@ void defaultSignalHandler(int s) {
 void defaultCleanupFunction() {
     LOG(INFO) << "Exiting";
     ThreadManager::getInstance()->destroyManager();
+    ApiScheduler::getInstance()->stop();
     TgBotDatabaseImpl::getInstance()->unloadDatabase();
+    Tracing::stop();
     LOG(INFO) << "TgBot process exiting, Goodbye!";
 }
\ No newline at end of file
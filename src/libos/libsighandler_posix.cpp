@@ -1,8 +1,15 @@
+#include <ConfigManager.h>
+
 #include <csignal>
 
 #include "libsighandler.h"
 
+static void reloadSignalHandler(int /*sig*/) {
+    ConfigManager::requestReload();
+}
+
 void installSignalHandler() {
     std::signal(SIGINT, defaultSignalHandler);
     std::signal(SIGTERM, defaultSignalHandler);
+    std::signal(SIGHUP, reloadSignalHandler);
 }
@@ -10,18 +10,29 @@
 #include <libos/libsighandler.h>
 
 #include <AbslLogInit.hpp>
+#include <ApiScheduler.hpp>
+#include <BotProfileSync.hpp>
 #include <DurationPoint.hpp>
 #include <LogSinks.hpp>
 #include <ManagedThreads.hpp>
 #include <OnAnyMessageRegister.hpp>
+#include <ReplayHttpClient.hpp>
 #include <StringResManager.hpp>
 #include <TgBotWebpage.hpp>
+#include <Tracing.hpp>
 #include <TryParseStr.hpp>
 #include <boost/algorithm/string/split.hpp>
 #include <chrono>
 #include <database/bot/TgBotDatabaseImpl.hpp>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <initcalls/InitScheduler.hpp>
 #include <memory>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "tgbot/Bot.h"
 
@@ -29,6 +40,12 @@
 #include <RTCommandLoader.h>
 #endif
 
+#ifdef HAVE_CURL
+#include <PooledCurlHttpClient.hpp>
+#else
+#include <tgbot/net/BoostHttpOnlySslClient.h>
+#endif
+
 #ifdef SOCKET_CONNECTION
 #include <ChatObserver.h>
 
@@ -95,12 +112,9 @@ template <typename T, ThreadManager::Usage usage, typename... Args>
     requires(HasInitCaller<T>)
 void createAndDoInitCall(Args... args) {
     const auto mgr = ThreadManager::getInstance();
-    std::shared_ptr<T> inst;
-    if constexpr (sizeof...(args) != 0) {
-        inst = mgr->createController<usage, T>(std::forward<Args...>(args...));
-    } else {
-        inst = mgr->createController<usage, T>();
-    }
+    static_assert(std::is_same_v<T, ThreadManager::controller_t<usage>>,
+                  "T must be the controller type of usage");
+    auto inst = mgr->createController<usage>(std::forward<Args>(args)...);
     inst->initWrapper();
 }
 
@@ -166,13 +180,57 @@ void TgBotApiExHandler(TgBot::Bot& bot, const TgBot::TgException& e) {
         cl->reset();
     }
     if (cl) {
-        cl->runWith([] {
-            std::this_thread::sleep_for(kErrorRecoveryDelay);
+        cl->runAfter(kErrorRecoveryDelay, [] {
             AuthContext::getInstance()->isAuthorized() = true;
         });
     }
 }
 
+// The Bot API end of BotProfileSync
+class BotProfileApi : public BotProfileSync::Sink {
+   public:
+    explicit BotProfileApi(const Bot& bot) : bot_(bot) {}
+
+    void setCommands(
+        const std::vector<BotProfileSync::Command>& commands) override {
+        std::vector<TgBot::BotCommand::Ptr> buffer;
+        for (const auto& [command, description] : commands) {
+            auto onecommand = std::make_shared<TgBot::BotCommand>();
+            onecommand->command = command;
+            onecommand->description = description;
+            buffer.emplace_back(std::move(onecommand));
+        }
+        bot_.getApi().setMyCommands(buffer);
+    }
+    void setDescription(const std::string& description) override {
+        bot_.getApi().setMyDescription(description);
+    }
+    void setShortDescription(const std::string& description) override {
+        bot_.getApi().setMyShortDescription(description);
+    }
+
+   private:
+    const Bot& bot_;
+};
+
+void initBotProfileSync(const Bot& gBot, const std::string& token) {
+    // Not shared by bots running from the same temp directory
+    const auto botId = token.substr(0, token.find(':'));
+    const auto stateFile = std::filesystem::temp_directory_path() /
+                           ("tgbot_profile_" + botId);
+
+    BotProfileSync::initInstance(
+        stateFile, std::make_shared<BotProfileApi>(gBot),
+        [](std::chrono::milliseconds delay, std::function<void()> fn) {
+            // The wheel's thread can't wait for the API, hand it off
+            ThreadManager::getInstance()->timers().schedule(
+                delay, [fn = std::move(fn)] {
+                    // Not for a chat
+                    ApiScheduler::getInstance()->submitGlobal(fn);
+                });
+        });
+}
+
 void initLogging() {
     using namespace ConfigManager;
     static std::optional<LogFileSink> log_sink;
@@ -187,37 +245,124 @@ void initLogging() {
     }
 }
 
-void createAndDoInitCallAll(TgBot::Bot& gBot) {
+void initTracing() {
+    using namespace ConfigManager;
+    const auto config = snapshot();
+
+    if (const auto file = config->getPath(Configs::TRACE_FILE); file) {
+        Tracing::start(
+            *file,
+            config->getNumber<double>(Configs::TRACE_SAMPLE_RATE).value_or(1));
+    }
+}
+
+// Telegram, or the replay file if one is given, which ends with onFinished
+std::unique_ptr<TgBot::HttpClient> createHttpClient(
+    ReplayHttpClient::FinishedCallback onFinished) {
+    using namespace ConfigManager;
+    const auto config = snapshot();
+
+    if (const auto file = config->getPath(Configs::REPLAY_FILE); file) {
+        auto client = std::make_unique<ReplayHttpClient>(
+            *file, config->getNumber<double>(Configs::REPLAY_SPEED).value_or(1),
+            std::move(onFinished));
+        if (client->size() == 0) {
+            LOG(ERROR) << "Nothing to replay in " << *file;
+            return nullptr;
+        }
+        // Nothing reaches Telegram, its limits would only slow the bot down
+        ApiScheduler::initInstance(ApiScheduler::Limits::unlimited());
+        return client;
+    }
+#ifdef HAVE_CURL
+    return std::make_unique<PooledCurlHttpClient>();
+#else
+    return std::make_unique<TgBot::BoostHttpOnlySslClient>();
+#endif
+}
+
+std::vector<InitScheduler::Timing> createAndDoInitCallAll(TgBot::Bot& gBot) {
     constexpr int kWebServerListenPort = 8080;
-    createAndDoInitCall<StringResManager>();
-    createAndDoInitCall<TgBotWebServer, ThreadManager::Usage::WEBSERVER_THREAD>(
-        kWebServerListenPort);
+    InitScheduler scheduler;
+
+    // Used by initcalls running at the same time, which must not race to
+    // create them
+    ThreadManager::getInstance();
+    OnAnyMessageRegisterer::getInstance();
+    ResourceManager::getInstance();
+    TgBotDatabaseImpl::getInstance();
+
+    // Everything may use strings
+    const auto strings = scheduler.add("StringResManager", {}, [] {
+        createAndDoInitCall<StringResManager>();
+    });
+    std::vector<InitScheduler::Task> all{strings};
+    // Registering to the bot's events isn't thread safe, these run in turn
+    std::vector<InitScheduler::Task> commandsDeps{strings};
+
+    all.emplace_back(scheduler.add("TgBotWebServer", {strings}, [] {
+        createAndDoInitCall<TgBotWebServer,
+                            ThreadManager::Usage::WEBSERVER_THREAD>(
+            kWebServerListenPort);
+    }));
 #ifdef RTCOMMAND_LOADER
-    createAndDoInitCall<RTCommandLoader>(gBot);
+    all.emplace_back(scheduler.add("RTCommandLoader", {strings}, [&gBot] {
+        createAndDoInitCall<RTCommandLoader>(gBot);
+    }));
+    commandsDeps.emplace_back(all.back());
 #endif
 #ifdef SOCKET_CONNECTION
-    createAndDoInitCall<NetworkLogSink,
-                        ThreadManager::Usage::LOGSERVER_THREAD>();
-    createAndDoInitCall<SocketInterfaceTgBot>(gBot, gBot, nullptr);
-    createAndDoInitCall<ChatObserver>();
+    all.emplace_back(scheduler.add("NetworkLogSink", {strings}, [] {
+        createAndDoInitCall<NetworkLogSink,
+                            ThreadManager::Usage::LOGSERVER_THREAD>();
+    }));
+    all.emplace_back(scheduler.add("SocketInterfaceTgBot", {strings}, [&gBot] {
+        createAndDoInitCall<SocketInterfaceTgBot>(gBot, gBot, nullptr);
+    }));
+    all.emplace_back(scheduler.add("ChatObserver", {strings}, [] {
+        createAndDoInitCall<ChatObserver>();
+    }));
 #endif
-    createAndDoInitCall<RegexHandler>(gBot);
-    createAndDoInitCall<SpamBlockManager>(gBot);
-    createAndDoInitCall<CommandModuleManager>(gBot);
-    createAndDoInitCall<ResourceManager>();
-    createAndDoInitCall<TgBotDatabaseImpl>();
+    all.emplace_back(scheduler.add("RegexHandler", {strings}, [&gBot] {
+        createAndDoInitCall<RegexHandler>(gBot);
+    }));
+    all.emplace_back(scheduler.add("SpamBlockManager", {strings}, [&gBot] {
+        createAndDoInitCall<SpamBlockManager>(gBot);
+    }));
+    all.emplace_back(scheduler.add("ResourceManager", {strings}, [] {
+        createAndDoInitCall<ResourceManager>();
+    }));
+    commandsDeps.emplace_back(all.back());
+    all.emplace_back(scheduler.add("TgBotDatabaseImpl", {strings}, [] {
+        createAndDoInitCall<TgBotDatabaseImpl>();
+    }));
+    commandsDeps.emplace_back(all.back());
+    // Modules may use resources and the database while loading
+    all.emplace_back(
+        scheduler.add("CommandModuleManager", commandsDeps, [&gBot] {
+            createAndDoInitCall<CommandModuleManager>(gBot);
+        }));
     // Must be last
-    createAndDoInitCall<OnAnyMessageRegisterer>(gBot);
+    scheduler.add("OnAnyMessageRegisterer", all, [&gBot] {
+        createAndDoInitCall<OnAnyMessageRegisterer>(gBot);
+    });
+    return scheduler.run(std::thread::hardware_concurrency());
 }
 
 void onBotInitialized(TgBot::Bot& gBot, DurationPoint& startupDp,
+                      const std::vector<InitScheduler::Timing>& timings,
                       const char* exe) {
     LOG(INFO) << "Subsystems initialized, bot started: " << exe;
     LOG(INFO) << "Started in " << startupDp.get().count() << " milliseconds";
+    for (const auto& [name, duration] : timings) {
+        LOG(INFO) << "- " << name << ": " << duration.count() << "ms";
+    }
 
-    gBot.getApi().setMyDescription(
+    // Sent later, and only if they changed since the last start
+    const auto profile = BotProfileSync::getInstance();
+    profile->setDescription(
         "Royna's telegram bot, written in C++. Go on you can talk to him");
-    gBot.getApi().setMyShortDescription(
+    profile->setShortDescription(
         "One of @roynatech's TgBot C++ project bots. I'm currently hosted on "
 #if BOOST_OS_WINDOWS
         "Windows"
@@ -251,23 +396,37 @@ int main(int argc, char* const* argv) {
     }
 
     token = getVariable(Configs::TOKEN);
+    if (!token && getVariable(Configs::REPLAY_FILE)) {
+        // Never sent anywhere
+        token = "0:replay";
+    }
     if (!token) {
         LOG(ERROR) << "Failed to get TOKEN variable";
         return EXIT_FAILURE;
     }
-
-#ifdef HAVE_CURL
-    TgBot::CurlHttpClient cli;
-    Bot gBot(token.value(), cli);
-#else
-    Bot gBot(token.value());
-#endif
+    initTracing();
+
+    // Set by a replay once it is done, the bot then exits as on a signal
+    std::promise<ReplayHttpClient::Report> replayDone;
+    auto replayed = replayDone.get_future();
+    const auto finished = [&replayed] {
+        return replayed.wait_for(std::chrono::seconds(0)) ==
+               std::future_status::ready;
+    };
+    const auto cli = createHttpClient(
+        [&replayDone](const auto& report) { replayDone.set_value(report); });
+    if (!cli) {
+        return EXIT_FAILURE;
+    }
+    Bot gBot(token.value(), *cli);
 
     // Install signal handlers
     installSignalHandler();
 
+    initBotProfileSync(gBot, token.value());
+
     // Initialize subsystems
-    createAndDoInitCallAll(gBot);
+    const auto initTimings = createAndDoInitCallAll(gBot);
 
 #ifndef WINDOWS_BUILD
     handleRestartCommand(gBot);
@@ -275,17 +434,19 @@ int main(int argc, char* const* argv) {
 
     try {
         // Bot starts
-        onBotInitialized(gBot, startupDp, argv[0]);
+        onBotInitialized(gBot, startupDp, initTimings, argv[0]);
     } catch (...) {
     }
-    while (true) {
+    while (!finished()) {
         try {
             LOG(INFO) << "Bot username: " << gBot.getApi().getMe()->username;
             gBot.getApi().deleteWebhook();
 
             TgLongPoll longPoll(gBot);
-            while (true) {
+            while (!finished()) {
                 longPoll.start();
+                // The trace of the batch's last update
+                Tracing::endTrace();
             }
         } catch (const TgBot::TgException& e) {
             TgBotApiExHandler(gBot, e);
@@ -296,6 +457,8 @@ int main(int argc, char* const* argv) {
             throw;
         }
     }
+    // Only a replay gets here
+    LOG(INFO) << replayed.get();
     defaultCleanupFunction();
-    return EXIT_FAILURE;
+    return EXIT_SUCCESS;
 }
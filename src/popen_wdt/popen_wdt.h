@@ -18,6 +18,8 @@ extern "C" {
 
 typedef struct {
     const char *command;     /* command string */
+    const char *working_dir; /* Directory to run it in, NULL for the
+                                bot's [in] */
     bool watchdog_enabled;   /* Is watchdog enabled? [in] */
     bool watchdog_activated; /* Result callback, stored true if watchdog did the
                                 work [out] */
@@ -58,17 +60,18 @@ void popen_watchdog_stop(popen_watchdog_data_t **data);
 bool popen_watchdog_activated(popen_watchdog_data_t **data);
 
 /**
- * @brief Reads data from the file pointer associated with the popen watchdog.
+ * @brief Reads the command's output, as it comes.
  *
- * This function reads up to 'size' bytes from the file pointer associated with
- * the popen watchdog and stores the data in the provided buffer.
+ * This function waits until the command writes something, and stores up to
+ * 'size' bytes of it in the provided buffer. The buffer isn't NUL terminated.
  *
  * @param data A double pointer to the popen watchdog data.
  * @param buf A pointer to the buffer where the read data will be stored.
- * @param size The maximum number of bytes to read from the file pointer.
- * @return true if data was successfully read, false otherwise.
+ * @param size The maximum number of bytes to read.
+ * @return The number of bytes read, 0 once the command exited and its output
+ * is drained, or the watchdog killed it, -1 on error.
  */
-bool popen_watchdog_read(popen_watchdog_data_t **data, char *buf, int size);
+int popen_watchdog_read(popen_watchdog_data_t **data, char *buf, int size);
 
 /**
  * @brief Cleans up and frees the resources associated with the popen watchdog data.
@@ -1,48 +1,178 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE  // posix_spawn_file_actions_addchdir_np() of glibc, musl
+#endif
+
+#include <errno.h>
 #include <fcntl.h>
 #include <pthread.h>
 #include <signal.h>
+#include <spawn.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/mman.h>
 #include <sys/poll.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <timer_wheel.h>
 #include <unistd.h>
 
 #include "popen_wdt.h"
 
+extern char **environ;
+
 struct popen_wdt_posix_priv {
-    pthread_t wdt_thread;
-    pid_t wdt_pid;
-    int pipefd_r;  // Subprocess' readfd, write end for the child
+    // Only taken by the watchdog and the reading thread, so runs don't
+    // contend with each other
+    pthread_mutex_t mutex;
+    timer_wheel_id_t wdt_timer;
+    pid_t pid;
+    int pipefd_r;  // Non blocking, -1 once it hit EOF
+    int pidfd;     // Readable once the child exits, -1 if unsupported
+    bool exited;
 };
 
-static pthread_mutex_t wdt_mutex = PTHREAD_MUTEX_INITIALIZER;
-
-// Users should hold mutex
 static bool check_popen_wdt_data(popen_watchdog_data_t **data) {
     return data && *data && (*data)->privdata;
 }
 
-static void *watchdog(void *arg) {
-    sleep(SLEEP_SECONDS);
+static int open_pidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+    return (int)syscall(SYS_pidfd_open, pid, 0);
+#else
+    (void)pid;
+    return -1;
+#endif
+}
 
-    pthread_mutex_lock(&wdt_mutex);
+// Runs on the shared timer wheel, SLEEP_SECONDS after the start
+static void watchdog(void *arg) {
     popen_watchdog_data_t *data = (popen_watchdog_data_t *)arg;
     struct popen_wdt_posix_priv *pdata = data->privdata;
 
-    if (kill(pdata->wdt_pid, 0) == 0) {
-        killpg(pdata->wdt_pid, SIGTERM);
+    pthread_mutex_lock(&pdata->mutex);
+    if (!pdata->exited) {
+        killpg(pdata->pid, SIGTERM);
         data->watchdog_activated = true;
     }
-    pthread_mutex_unlock(&wdt_mutex);
-    return NULL;
+    pthread_mutex_unlock(&pdata->mutex);
+}
+
+static void cancel_watchdog(popen_watchdog_data_t **data_in) {
+    timer_wheel_id_t timer = 0;
+    struct popen_wdt_posix_priv *pdata = NULL;
+
+    if (!check_popen_wdt_data(data_in)) {
+        return;
+    }
+    pdata = (*data_in)->privdata;
+    pthread_mutex_lock(&pdata->mutex);
+    timer = pdata->wdt_timer;
+    pdata->wdt_timer = 0;
+    pthread_mutex_unlock(&pdata->mutex);
+    // Not under the mutex, the watchdog may be waiting for it
+    if (timer != 0) {
+        timer_wheel_cancel(timer);
+    }
+}
+
+// A pipe with both ends closed on exec, only the child's stdout and stderr
+// stay open in it. pipe2() is not in POSIX, macOS lacks it.
+static bool make_pipe(int pipefd[2]) {
+    if (pipe(pipefd) == -1) {
+        return false;
+    }
+    if (fcntl(pipefd[0], F_SETFD, FD_CLOEXEC) == -1 ||
+        fcntl(pipefd[1], F_SETFD, FD_CLOEXEC) == -1) {
+        close(pipefd[0]);
+        close(pipefd[1]);
+        return false;
+    }
+    return true;
+}
+
+// Makes the child start in dir. POSIX.1-2024 names it
+// posix_spawn_file_actions_addchdir(), macOS, glibc and musl only have the
+// _np variant of it.
+static bool add_chdir(posix_spawn_file_actions_t *actions, const char *dir) {
+#if defined(__APPLE__) || defined(__linux__)
+    return posix_spawn_file_actions_addchdir_np(actions, dir) == 0;
+#else
+    return posix_spawn_file_actions_addchdir(actions, dir) == 0;
+#endif
+}
+
+// environ, with LC_ALL=C in place of the caller's LC_ALL
+static char **make_child_env(void) {
+    static char lc_all[] = "LC_ALL=C";
+    size_t count = 0;
+    size_t out = 0;
+    char **env = NULL;
+
+    while (environ[count] != NULL) {
+        count++;
+    }
+    env = malloc((count + 2) * sizeof(char *));
+    if (env == NULL) {
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (strncmp(environ[i], "LC_ALL=", strlen("LC_ALL=")) != 0) {
+            env[out++] = environ[i];
+        }
+    }
+    env[out++] = lc_all;
+    env[out] = NULL;
+    return env;
+}
+
+static bool spawn_command(popen_watchdog_data_t *data, int pipefd_w,
+                          pid_t *pid) {
+    posix_spawn_file_actions_t actions;
+    posix_spawnattr_t attr;
+    sigset_t sigs;
+    char **env = NULL;
+    char *const argv[] = {"bash", "-c", (char *)data->command, NULL};
+    int ret = 0;
+
+    env = make_child_env();
+    if (env == NULL) {
+        return false;
+    }
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null",
+                                     O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, pipefd_w, STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&actions, pipefd_w, STDERR_FILENO);
+    if (data->working_dir != NULL &&
+        !add_chdir(&actions, data->working_dir)) {
+        posix_spawn_file_actions_destroy(&actions);
+        free(env);
+        return false;
+    }
+
+    posix_spawnattr_init(&attr);
+    // In a group of its own, for the watchdog to kill it with its children
+    posix_spawnattr_setpgroup(&attr, 0);
+    // Not what the bot blocks or ignores
+    sigemptyset(&sigs);
+    posix_spawnattr_setsigmask(&attr, &sigs);
+    sigaddset(&sigs, SIGPIPE);
+    posix_spawnattr_setsigdefault(&attr, &sigs);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETPGROUP |
+                                        POSIX_SPAWN_SETSIGMASK |
+                                        POSIX_SPAWN_SETSIGDEF);
+
+    ret = posix_spawn(pid, BASH_EXE_PATH, &actions, &attr, argv, env);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+    free(env);
+    return ret == 0;
 }
 
 bool popen_watchdog_start(popen_watchdog_data_t **data_in) {
     popen_watchdog_data_t *data = NULL;
     struct popen_wdt_posix_priv *pdata = NULL;
-    pthread_mutexattr_t mutexattr;
     int pipefd[2];
     pid_t pid = 0;
 
@@ -51,149 +181,174 @@ bool popen_watchdog_start(popen_watchdog_data_t **data_in) {
     }
     data = *data_in;
 
-    if (pipe(pipefd) == -1) {
+    if (!make_pipe(pipefd)) {
         return false;
     }
-
-    pthread_mutexattr_init(&mutexattr);
-    pthread_mutexattr_setpshared(&mutexattr, PTHREAD_PROCESS_SHARED);
-    pthread_mutex_init(&wdt_mutex, &mutexattr);
-    pthread_mutexattr_destroy(&mutexattr);
-
-    if (data->watchdog_enabled) {
-        pdata = mmap(NULL, sizeof(struct popen_wdt_posix_priv),
-                     PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
-        if (pdata == MAP_FAILED) {
-            close(pipefd[0]);
-            close(pipefd[1]);
-            pthread_mutex_destroy(&wdt_mutex);
-            return false;
-        }
-
-        pthread_t watchdog_thread = 0;
-        pthread_create(&watchdog_thread, NULL, &watchdog, data);
-        pdata->wdt_thread = watchdog_thread;
-        data->privdata = pdata;
-    } else {
-        pdata = malloc(sizeof(struct popen_wdt_posix_priv));
-        if (pdata == NULL) {
-            close(pipefd[0]);
-            close(pipefd[1]);
-            pthread_mutex_destroy(&wdt_mutex);
-            return false;
-        }
-        memset(pdata, 0, sizeof(struct popen_wdt_posix_priv));
-        data->privdata = pdata;
-    }
-    pid = fork();
-    if (pid == -1) {
+    pdata = calloc(1, sizeof(struct popen_wdt_posix_priv));
+    if (pdata == NULL) {
         close(pipefd[0]);
         close(pipefd[1]);
-        pthread_mutex_destroy(&wdt_mutex);
-        return NULL;
+        return false;
     }
-
-    if (pid == 0) {
-        setenv("LC_ALL", "C", true);
-        // Child process
-        if (data->watchdog_enabled) {
-            pdata->wdt_pid = getpid();
-        }
+    if (!spawn_command(data, pipefd[1], &pid)) {
         close(pipefd[0]);
-        dup2(pipefd[1], STDOUT_FILENO);
-        dup2(pipefd[1], STDERR_FILENO);
-        close(STDIN_FILENO);
-        setpgid(0, 0);
-        execl(BASH_EXE_PATH, "bash", "-c", data->command, (char *)NULL);
-        _exit(127);  // If execl fails, exit
-    } else {
-        // Parent process
-        pdata->pipefd_r = pipefd[0];
         close(pipefd[1]);
+        free(pdata);
+        return false;
+    }
+    close(pipefd[1]);
+    fcntl(pipefd[0], F_SETFL, fcntl(pipefd[0], F_GETFL) | O_NONBLOCK);
+
+    pthread_mutex_init(&pdata->mutex, NULL);
+    pdata->pid = pid;
+    pdata->pipefd_r = pipefd[0];
+    pdata->pidfd = open_pidfd(pid);
+    data->privdata = pdata;
+    if (data->watchdog_enabled) {
+        pthread_mutex_lock(&pdata->mutex);
+        pdata->wdt_timer =
+            timer_wheel_schedule(SLEEP_SECONDS * 1000, &watchdog, data);
+        pthread_mutex_unlock(&pdata->mutex);
     }
     return true;
 }
 
 void popen_watchdog_stop(popen_watchdog_data_t **data_in) {
-    pthread_mutex_lock(&wdt_mutex);
-
-    if (!check_popen_wdt_data(data_in)) {
-        return;
-    }
-    popen_watchdog_data_t *data = *data_in;
-    struct popen_wdt_posix_priv *pdata = data->privdata;
-
-    if (data->watchdog_enabled) {
-        pthread_cancel(pdata->wdt_thread);
-        pthread_join(pdata->wdt_thread, NULL);
-    }
-    pthread_mutex_unlock(&wdt_mutex);
+    cancel_watchdog(data_in);
 }
 
 void popen_watchdog_destroy(popen_watchdog_data_t **data_in) {
     popen_watchdog_data_t *data = NULL;
     struct popen_wdt_posix_priv *pdata = NULL;
 
-    pthread_mutex_lock(&wdt_mutex);
     if (!check_popen_wdt_data(data_in)) {
-        pthread_mutex_unlock(&wdt_mutex);
         return;
     }
+    // In case it wasn't stopped, it must not fire on freed data
+    cancel_watchdog(data_in);
     data = *data_in;
     pdata = data->privdata;
-    close(pdata->pipefd_r);
-    puts("Note: freeing popen_watchdog_data_t");
-    if (data->watchdog_enabled) {
-        munmap(pdata, sizeof(struct popen_wdt_posix_priv));
-    } else {
-        free(pdata);
+    pthread_mutex_lock(&pdata->mutex);
+    if (!pdata->exited) {
+        // Left early, or it ignored the watchdog's SIGTERM. Not reaped yet,
+        // so the group is still its own.
+        killpg(pdata->pid, SIGKILL);
+        pdata->exited = true;
     }
+    pthread_mutex_unlock(&pdata->mutex);
+    while (waitpid(pdata->pid, NULL, 0) == -1 && errno == EINTR) {
+    }
+    if (pdata->pipefd_r != -1) {
+        close(pdata->pipefd_r);
+    }
+    if (pdata->pidfd != -1) {
+        close(pdata->pidfd);
+    }
+    pthread_mutex_destroy(&pdata->mutex);
+    free(pdata);
     free(data);
-    data = NULL;
-    pthread_mutex_unlock(&wdt_mutex);
-    pthread_mutex_destroy(&wdt_mutex);
     *data_in = NULL;
 }
 
-bool popen_watchdog_read(popen_watchdog_data_t **data, char *buf, int size) {
-    bool ret = false;
+// Reads what the pipe has, 0 on EOF, -1 if there is nothing yet
+static int read_available(struct popen_wdt_posix_priv *pdata, char *buf,
+                          int size) {
+    ssize_t ret = 0;
+
+    do {
+        ret = read(pdata->pipefd_r, buf, size);
+    } while (ret == -1 && errno == EINTR);
+    if (ret > 0) {
+        return (int)ret;
+    }
+    if (ret == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+        close(pdata->pipefd_r);
+        pdata->pipefd_r = -1;
+        return 0;
+    }
+    return -1;
+}
+
+static void set_exited(struct popen_wdt_posix_priv *pdata) {
+    pthread_mutex_lock(&pdata->mutex);
+    pdata->exited = true;
+    pthread_mutex_unlock(&pdata->mutex);
+}
+
+// Waits for the exit without reaping the child. Once it is reaped, its pid
+// may belong to another process, so the watchdog must see it exited first.
+static void wait_exit(struct popen_wdt_posix_priv *pdata) {
+    siginfo_t info;
+
+    while (waitid(P_PID, pdata->pid, &info, WEXITED | WNOWAIT) == -1 &&
+           errno == EINTR) {
+    }
+    set_exited(pdata);
+}
+
+int popen_watchdog_read(popen_watchdog_data_t **data, char *buf, int size) {
     const int one_sec = 1000;
-    struct pollfd fds;
     popen_watchdog_data_t *data_ = NULL;
     struct popen_wdt_posix_priv *pdata = NULL;
+    struct pollfd fds[2];
+    int ret = 0;
 
-    pthread_mutex_lock(&wdt_mutex);
-
-    if (!check_popen_wdt_data(data)) {
-        pthread_mutex_unlock(&wdt_mutex);
-        return ret;
+    if (!check_popen_wdt_data(data) || size <= 0) {
+        return -1;
     }
     data_ = *data;
     pdata = data_->privdata;
-    if (data_->watchdog_activated) {
-        pthread_mutex_unlock(&wdt_mutex);
-        return ret;
-    }
-    fds.events = POLLIN;
-    fds.revents = 0;
-    fds.fd = pdata->pipefd_r;
-    if (poll(&fds, 1,
-             data_->watchdog_enabled ? SLEEP_SECONDS * one_sec : -1) > 0) {
-        ret = read(pdata->pipefd_r, buf, size) > 0;
+
+    while (true) {
+        if (popen_watchdog_activated(data)) {
+            return 0;
+        }
+        if (pdata->pipefd_r != -1) {
+            ret = read_available(pdata, buf, size);
+            if (ret > 0) {
+                return ret;
+            }
+        }
+        if (pdata->exited) {
+            // Its output is drained, what is left is from children of it
+            return 0;
+        }
+        if (pdata->pipefd_r == -1 && pdata->pidfd == -1) {
+            // Nothing to wait on, other than the exit itself. Reaped in
+            // popen_watchdog_destroy().
+            wait_exit(pdata);
+            return 0;
+        }
+
+        fds[0].fd = pdata->pipefd_r;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = pdata->pidfd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        // The watchdog's SIGTERM ends the wait through the pidfd. Waking up
+        // every second is for commands which ignore it.
+        ret = poll(fds, 2, data_->watchdog_enabled ? one_sec : -1);
+        if (ret == -1 && errno != EINTR) {
+            return -1;
+        }
+        if (ret > 0 && fds[1].revents != 0) {
+            // Reaped in popen_watchdog_destroy(), a pidfd stays readable
+            set_exited(pdata);
+        }
     }
-    pthread_mutex_unlock(&wdt_mutex);
-    return ret;
 }
 
 bool popen_watchdog_activated(popen_watchdog_data_t **data) {
+    struct popen_wdt_posix_priv *pdata = NULL;
     bool ret = false;
-    pthread_mutex_lock(&wdt_mutex);
 
     if (!check_popen_wdt_data(data)) {
-        pthread_mutex_unlock(&wdt_mutex);
         return ret;
     }
+    pdata = (*data)->privdata;
+    pthread_mutex_lock(&pdata->mutex);
     ret = (*data)->watchdog_activated;
-    pthread_mutex_unlock(&wdt_mutex);
+    pthread_mutex_unlock(&pdata->mutex);
     return ret;
 }
@@ -168,7 +168,7 @@ bool popen_watchdog_start(popen_watchdog_data_t** wdt_data_in) {
     // Try with default
     success = CreateProcess(NULL, (LPSTR)wdt_data->command, NULL, NULL, TRUE,
                             CREATE_NEW_PROCESS_GROUP | CREATE_SUSPENDED, NULL,
-                            NULL, &si, &pi);
+                            wdt_data->working_dir, &si, &pi);
     POPEN_WDT_DBGLOG("Command is: %s", wdt_data->command);
 
     if (!success) {
@@ -181,7 +181,7 @@ bool popen_watchdog_start(popen_watchdog_data_t** wdt_data_in) {
         // Create process again
         success = CreateProcess(NULL, (LPSTR)buffer, NULL, NULL, TRUE,
                                 CREATE_NEW_PROCESS_GROUP | CREATE_SUSPENDED,
-                                NULL, NULL, &si, &pi);
+                                NULL, wdt_data->working_dir, &si, &pi);
     }
     if (!success) {
         // Still no? abort.
@@ -261,9 +261,9 @@ void popen_watchdog_destroy(popen_watchdog_data_t** data) {
     POPEN_WDT_DBGLOG("Cleanup done");
 }
 
-bool popen_watchdog_read(popen_watchdog_data_t** data, char* buf, int size) {
+int popen_watchdog_read(popen_watchdog_data_t** data, char* buf, int size) {
     if (!check_data_privdata(data)) {
-        return false;
+        return -1;
     }
 
     OVERLAPPED ol = {0};
@@ -273,31 +273,30 @@ bool popen_watchdog_read(popen_watchdog_data_t** data, char* buf, int size) {
     BOOL result = FALSE;
     DWORD waitResult = 0;
     const int one_sec = 1000;
-    BOOL readFileResult = FALSE;
+    int readFileResult = 0;
 
     if ((*data)->watchdog_activated) {
         POPEN_WDT_DBGLOG("watchdog_activated: True, return");
-        return false;
+        return 0;
     }
     ol.hEvent = CreateEvent(NULL, TRUE, FALSE, NULL);
     if (ol.hEvent == NULL) {
         POPEN_WDT_DBGLOG("CreateEvent failed");
-        return false;
+        return -1;
     }
     POPEN_WDT_DBGLOG("ReadFile is being called");
     result = ReadFile(pdata->read_hdl, buf, size, &bytesRead, &ol);
     if (!result && GetLastError() != ERROR_IO_PENDING) {
         POPEN_WDT_DBGLOG("ReadFile failed");
         CloseHandle(ol.hEvent);
-        return false;
+        return 0;
     }
     waitResult = WaitForSingleObject(
         ol.hEvent, data_->watchdog_enabled ? SLEEP_SECONDS * one_sec : INFINITE);
     switch (waitResult) {
         case WAIT_OBJECT_0:
             if (GetOverlappedResult(pdata->read_hdl, &ol, &bytesRead, FALSE)) {
-                buf[bytesRead] = '\0';  // Null-terminate the string
-                readFileResult = TRUE;
+                readFileResult = (int)bytesRead;
             } else {
                 POPEN_WDT_DBGLOG("GetOverlappedResult failed.");
             }
@@ -309,8 +308,8 @@ bool popen_watchdog_read(popen_watchdog_data_t** data, char* buf, int size) {
             POPEN_WDT_DBGLOG("Unexpected result from WaitForSingleObject.");
             break;
     }
-    POPEN_WDT_DBGLOG("Ret: %s, bytesRead: %lu",
-                     readFileResult ? "true" : "false", bytesRead);
+    POPEN_WDT_DBGLOG("Ret: %d, bytesRead: %lu", readFileResult, bytesRead);
+    CloseHandle(ol.hEvent);
     return readFileResult;
 }
 
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <absl/log/log.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+/**
+ * @brief Serves random numbers from a buffer, refilled in one read.
+ *
+ * For entropy sources where every read is a syscall. Not thread safe, meant
+ * to be used as a thread_local.
+ *
+ * @tparam Source Has bool read(void* buf, size_t len), filling all of buf.
+ * @tparam kWords Buffer size in 64-bit words, 4KiB by default.
+ */
+template <typename Source, size_t kWords = 512>
+class buffered_engine {
+   public:
+    using result_type = uint64_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    explicit buffered_engine(Source source = {}) : source_(std::move(source)) {}
+
+    result_type operator()() {
+        if (pos_ == kWords) {
+            refill();
+        }
+        return buffer_[pos_++];
+    }
+
+    void fill(std::span<uint64_t> out) {
+        const size_t buffered = std::min(out.size(), kWords - pos_);
+        std::copy_n(buffer_.begin() + pos_, buffered, out.begin());
+        pos_ += buffered;
+        out = out.subspan(buffered);
+        if (out.size() >= kWords) {
+            // Too large for the buffer, read it directly
+            read(out.data(), out.size_bytes());
+        } else if (!out.empty()) {
+            refill();
+            std::copy_n(buffer_.begin(), out.size(), out.begin());
+            pos_ = out.size();
+        }
+    }
+
+   private:
+    void refill() {
+        read(buffer_.data(), sizeof(buffer_));
+        pos_ = 0;
+    }
+
+    void read(void* buf, size_t len) {
+        if (!source_.read(buf, len)) {
+            LOG(ERROR) << "Failed to refill the random buffer";
+        }
+    }
+
+    Source source_;
+    std::array<uint64_t, kWords> buffer_{};
+    size_t pos_ = kWords;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#ifdef __linux__
+
+#include <absl/log/log.h>
+#include <sys/random.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#define GETRANDOM_MAYBE_SUPPORTED
+
+// The kernel's CSPRNG, through getrandom(2). Use with buffered_engine.
+struct getrandom_source {
+    static bool isSupported() {
+        uint64_t data = 0;
+        return getrandom(&data, sizeof(data), GRND_NONBLOCK) == sizeof(data);
+    }
+
+    // Large reads may be cut short by signals, continue where it stopped
+    static bool read(void* buf, size_t len) {
+        auto* out = static_cast<uint8_t*>(buf);
+        while (len > 0) {
+            const ssize_t rc = getrandom(out, len, 0);
+            if (rc < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                PLOG(ERROR) << "getrandom failed";
+                return false;
+            }
+            out += rc;
+            len -= rc;
+        }
+        return true;
+    }
+};
+#endif
@@ -12,25 +12,32 @@
 #include <InstanceClassBase.hpp>
 #include <array>
 #include <cerrno>
+#include <cstddef>
 #include <cstdint>
 #include <iomanip>
 #include <mutex>
 
 #define KERNELRAND_MAYBE_SUPPORTED
 
+// The kernel's interface to the hardware RNG. Every read is a syscall, use
+// it through buffered_engine<kernel_rand_source>.
 struct kernel_rand_engine : InstanceClassBase<kernel_rand_engine> {
-    using result_type = uint32_t;
-
-    static constexpr result_type min() { return 0; }
-    static constexpr result_type max() { return UINT32_MAX; }
-
-    result_type operator()() const {
-        result_type val = 0;
-        ssize_t rc = 0;
-
-        rc = read(fd, &val, sizeof(val));
-        if (rc < 0) PLOG(ERROR) << "Failed to read data from HWRNG device";
-        return val;
+    // Fills all of buf, the device may return less than asked
+    bool read(void* buf, size_t len) const {
+        auto* out = static_cast<uint8_t*>(buf);
+        while (len > 0) {
+            const ssize_t rc = ::read(fd, out, len);
+            if (rc <= 0) {
+                if (rc < 0 && errno == EINTR) {
+                    continue;
+                }
+                PLOG(ERROR) << "Failed to read data from HWRNG device";
+                return false;
+            }
+            out += rc;
+            len -= rc;
+        }
+        return true;
     }
     kernel_rand_engine() { isSupported(); }
     ~kernel_rand_engine() { closeFd(fd); }
@@ -52,7 +59,7 @@ struct kernel_rand_engine : InstanceClassBase<kernel_rand_engine> {
                 } else {
                     // Test read some bytes
                     int data = 0;
-                    ret = read(fd, &data, sizeof(data));
+                    ret = ::read(fd, &data, sizeof(data));
                     if (ret != sizeof(data)) {
                         PLOG(ERROR) << "Reading from hwrng device failed";
                         closeFd(fd);
@@ -82,4 +89,10 @@ struct kernel_rand_engine : InstanceClassBase<kernel_rand_engine> {
     };
     int fd = kInvalidFD;
 };
+
+struct kernel_rand_source {
+    static bool read(void* buf, size_t len) {
+        return kernel_rand_engine::getInstance()->read(buf, len);
+    }
+};
 #endif
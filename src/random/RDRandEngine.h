@@ -4,10 +4,12 @@
 
 #define RDRAND_MAYBE_SUPPORTED
 
+#include <absl/log/log.h>
 #include <cpuid.h>
 #include <immintrin.h>
 
-#include <random>
+#include <cstdint>
+#include <span>
 
 #ifndef BIT_SET
 #define BIT_SET(x, n) ((x) & (1 << n))
@@ -15,16 +17,48 @@
 
 class rdrand_engine {
    public:
-    using result_type = uint32_t;
+    using result_type = uint64_t;
 
     static constexpr result_type min() { return 0; }
-    static constexpr result_type max() { return UINT32_MAX; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    // Intel's DRNG guide: a healthy unit fails 10 retries in a row with
+    // negligible probability, so more than that means it is broken.
+    static constexpr int kRetries = 10;
 
     result_type operator()() const {
-        result_type val;
-        while (!_rdrand32_step(&val)) {
-        }  // retry until success
+        result_type val = 0;
+        if (!step(&val)) {
+            LOG(ERROR) << "RDRAND failed " << kRetries << " times in a row";
+        }
         return val;
     }
+
+    void fill(std::span<uint64_t> out) const {
+        for (auto& value : out) {
+            value = (*this)();
+        }
+    }
+
+   private:
+    static bool step(result_type* val) {
+        for (int i = 0; i < kRetries; ++i) {
+#ifdef __x86_64__
+            unsigned long long v = 0;
+            if (_rdrand64_step(&v) != 0) {
+                *val = v;
+                return true;
+            }
+#else
+            unsigned int lo = 0;
+            unsigned int hi = 0;
+            if (_rdrand32_step(&lo) != 0 && _rdrand32_step(&hi) != 0) {
+                *val = (static_cast<uint64_t>(hi) << 32) | lo;
+                return true;
+            }
+#endif
+        }
+        return false;
+    }
 };
 #endif
@@ -3,170 +3,96 @@
 #include <absl/log/log.h>
 
 #include <BackendChooser.hpp>
-#include <algorithm>
-#include <cassert>
 #include <iomanip>
-#include <memory>
 #include <random>
 #include <string_view>
 
+#include "BufferedEngine.h"
+#include "GetRandomEngine.h"
 #include "InstanceClassBase.hpp"
 #include "KernelRandEngine.h"
 #include "RDRandEngine.h"
+#include "XoshiroEngine.h"
 
 using return_type = random_return_type;
 
 /**
  * @brief      Base class for random number generators.
  *
- * This class provides an interface for random number generators. It defines
- * functions for generating random numbers and shuffling containers. The
+ * A backend only produces uniformly distributed 64-bit values. Ranges and
+ * shuffles are built on top of it, see RandomNumberGenerator.h. The
  * isSupported() function can be used to determine if a particular RNG is
  * available on the system.
  *
- * @tparam     random_return_type  The type of random numbers generated by the
- *                                 RNG.
+ * Backends are shared by all threads, per thread state is thread_local.
  */
 struct RNGBase {
     /**
-     * @brief      Determines if the RNG is isSupported on the system.
+     * @brief      Determines if the RNG is supported on the system.
      *
-     * @return     `true` if the RNG is isSupported, `false` otherwise.
+     * @return     `true` if the RNG is supported, `false` otherwise.
      */
     virtual bool isSupported() const = 0;
 
     /**
-     * @brief      Generates a random number in the specified range.
+     * @brief      Fills a span with random values.
      *
-     * @param[in]  min  The minimum value of the random number.
-     * @param[in]  max  The maximum value of the random number.
-     *
-     * @return     A random number in the specified range.
+     * @param[out] out  The values.
      */
-    virtual random_return_type generate(const random_return_type min,
-                                        const random_return_type max) const = 0;
-
-    /**
-     * @brief      Shuffles the elements in a container.
-     *
-     * This function uses the random number generator to rearrange the elements
-     * in a container. The specific algorithm used for shuffling is dependent on
-     * the RNG implementation.
-     *
-     * @deprecated This function is a template, can't be overriden therefore a
-     * stub
-     * @tparam     T  The type of elements in the container.
-     * @param[in,out]  it  The container to be shuffled.
-     */
-    template <typename T>
-    void shuffle(std::vector<T>& it) const;
-
-    /**
-     * @brief      Shuffles the elements in a string container.
-     *
-     * This function uses the random number generator to rearrange the elements
-     * in a container. The specific algorithm used for shuffling is dependent on
-     * the RNG implementation.
-     */
-    virtual void shuffle_string(std::vector<std::string>& it) const = 0;
+    virtual void fill(std::span<uint64_t> out) const = 0;
 
     /**
      * @brief      Returns the name of the RNG.
      *
      * @return     A string containing the name of the RNG.
      */
-    virtual const std::string_view getName() const = 0;
+    virtual std::string_view getName() const = 0;
 
-    /**
-     * @brief      Shuffles the elements in a container using the specified
-     * random number engine.
-     *
-     * This function uses the specified random number engine to rearrange the
-     * elements in a container. The specific algorithm used for shuffling is
-     * dependent on the RNG implementation.
-     *
-     * @tparam     Engine  The type of random number engine to be used.
-     * @tparam     T  The type of elements in the container.
-     * @param[in,out]  in  The container to be shuffled.
-     * @param[in]  e  The random number engine to be used for shuffling.
-     */
-    template <class Engine, typename T>
-    void ShuffleImpl(std::vector<T>& in, Engine* e) const {
-        std::shuffle(in.begin(), in.end(), *e);
-    }
-
-    /**
-     * @brief      Generates a random number in the specified range using the
-     *             specified random number generator.
-     *
-     * This function uses the specified random number generator to generate a
-     * random number in the specified range.
-     *
-     * @tparam     Generator  The type of random number generator to be used.
-     * @param[in]  gen  The random number generator to be used for generating
-     * the random number.
-     * @param[in]  min  The minimum value of the random number.
-     * @param[in]  max  The maximum value of the random number.
-     *
-     * @return     A random number in the specified range.
-     */
-    template <class Generator>
-    random_return_type genRandomNumberImpl(Generator* gen,
-                                           random_return_type min,
-                                           random_return_type max) const {
-        if (min > max) {
-            LOG(WARNING) << "min(" << min << ") is bigger than max(" << max
-                         << ")";
-            std::swap(min, max);
-        } else if (min == max) {
-            LOG(WARNING) << "min == max == " << min;
-            return min;
-        }
-        std::uniform_int_distribution<return_type> distribution(min, max);
-        return distribution(*gen);
-    }
     virtual ~RNGBase() = default;
 };
 
-struct StdCpp : RNGBase {
-    static std::mt19937 RNG_std_create_rng(void) {
-        std::random_device rd;
-        std::mt19937 gen(rd());
-        return gen;
+// Seeded once per thread, from std::random_device
+struct Xoshiro : RNGBase {
+    void fill(std::span<uint64_t> out) const override {
+        static thread_local xoshiro256pp_engine engine = [] {
+            std::random_device rd;
+            return xoshiro256pp_engine(
+                (static_cast<uint64_t>(rd()) << 32) | rd());
+        }();
+        engine.fill(out);
     }
 
-    return_type generate(const return_type min,
-                         const return_type max) const override {
-        auto e = RNG_std_create_rng();
-        return genRandomNumberImpl(&e, min, max);
-    }
+    bool isSupported() const override { return true; }
 
-    bool isSupported(void) const override { return true; }
+    std::string_view getName() const override {
+        return "Xoshiro256++ per-thread pseudo RNG";
+    }
+    ~Xoshiro() override = default;
+};
 
-    template <typename T>
-    void shuffle(std::vector<T>& in) const {
-        auto e = RNG_std_create_rng();
-        ShuffleImpl(in, &e);
+#ifdef GETRANDOM_MAYBE_SUPPORTED
+struct GetRandom : RNGBase {
+    void fill(std::span<uint64_t> out) const override {
+        static thread_local buffered_engine<getrandom_source> engine;
+        engine.fill(out);
     }
 
-    void shuffle_string(std::vector<std::string>& it) const override {
-        shuffle(it);
+    bool isSupported() const override {
+        return getrandom_source::isSupported();
     }
 
-    const std::string_view getName(void) const override {
-        return "STD C++ pesudo RNG";
+    std::string_view getName() const override {
+        return "Linux getrandom(2) CSPRNG";
     }
-    ~StdCpp() override = default;
+    ~GetRandom() override = default;
 };
+#endif
 
 #ifdef RDRAND_MAYBE_SUPPORTED
 struct RDRand : RNGBase {
-    return_type generate(const return_type min,
-                         const return_type max) const override {
-        return genRandomNumberImpl(&engine, min, max);
-    }
+    void fill(std::span<uint64_t> out) const override { engine.fill(out); }
 
-    bool isSupported(void) const override {
+    bool isSupported() const override {
         unsigned int eax = 0;
         unsigned int ebx = 0;
         unsigned int ecx = 0;
@@ -179,16 +105,7 @@ struct RDRand : RNGBase {
         return BIT_SET(ecx, 30);
     }
 
-    template <typename T>
-    void shuffle(std::vector<T>& in) const {
-        ShuffleImpl(in, &engine);
-    }
-
-    void shuffle_string(std::vector<std::string>& it) const override {
-        shuffle(it);
-    }
-
-    const std::string_view getName() const override {
+    std::string_view getName() const override {
         return "X86 RDRAND instr. HWRNG (Intel/AMD)";
     }
     ~RDRand() override = default;
@@ -200,26 +117,21 @@ struct RDRand : RNGBase {
 
 #ifdef KERNELRAND_MAYBE_SUPPORTED
 struct KernelRand : RNGBase {
-    return_type generate(const return_type min,
-                         const return_type max) const override {
-        return genRandomNumberImpl(kernel_rand_engine::getInstance().get(), min,
-                                   max);
-    }
-
-    bool isSupported(void) const override {
-        return kernel_rand_engine::getInstance()->isSupported();
-    }
+    // Hardware RNGs can be as slow as 10KB/s, so a small buffer keeps a
+    // single number from waiting on a large read.
+    static constexpr size_t kBufferWords = 8;
 
-    template <typename T>
-    void shuffle(std::vector<T>& in) const {
-        ShuffleImpl(in, kernel_rand_engine::getInstance().get());
+    void fill(std::span<uint64_t> out) const override {
+        static thread_local buffered_engine<kernel_rand_source, kBufferWords>
+            engine;
+        engine.fill(out);
     }
 
-    void shuffle_string(std::vector<std::string>& it) const override {
-        shuffle(it);
+    bool isSupported() const override {
+        return kernel_rand_engine::getInstance()->isSupported();
     }
 
-    const std::string_view getName() const override {
+    std::string_view getName() const override {
         return "Linux/MacOS HWRNG interface";
     }
     ~KernelRand() override = default;
@@ -238,7 +150,15 @@ struct KernelRand : RNGBase {
 #define KERNELRAND_CLASS
 #endif
 
-#define IMPL_LIST KERNELRAND_CLASS RDRAND_CLASS StdCpp
+#ifdef GETRANDOM_MAYBE_SUPPORTED
+#define GETRANDOM_CLASS GetRandom,
+#else
+#define GETRANDOM_CLASS
+#endif
+
+// In order of preference. getrandom() comes first, as the kernel CSPRNG is
+// seeded from the hardware RNGs anyway, and is much faster to read.
+#define IMPL_LIST GETRANDOM_CLASS RDRAND_CLASS KERNELRAND_CLASS Xoshiro
 
 struct RandomBackendChooser : BackendChooser<RNGBase, IMPL_LIST> {
     ~RandomBackendChooser() override = default;
@@ -249,31 +169,48 @@ struct RandomBackendChooser : BackendChooser<RNGBase, IMPL_LIST> {
     }
 };
 
-static RNGBase* getRNG(void) {
+static RNGBase* getRNG() {
     static RandomBackendChooser chooser;
-    static RNGBase* rng = nullptr;
-    if (rng == nullptr) {
-        rng = chooser.getObject();
-    }
+    static RNGBase* const rng = chooser.getObject();
     return rng;
 }
 
 namespace RandomNumberGenerator {
 
-return_type generate(const return_type min, const return_type max) {
-    return getRNG()->generate(min, max);
-}
+void fill(std::span<uint64_t> out) { getRNG()->fill(out); }
+
+std::string_view backendName() { return getRNG()->getName(); }
 
-return_type generate(const return_type max) {
-    return generate(0, max);
+void generateN(std::span<return_type> out, return_type min, return_type max) {
+    if (min > max) {
+        LOG(WARNING) << "min(" << min << ") is bigger than max(" << max << ")";
+        std::swap(min, max);
+    }
+    // Unsigned, so INT_MIN to INT_MAX doesn't overflow. 0 means all values.
+    const uint64_t range =
+        static_cast<uint64_t>(max) - static_cast<uint64_t>(min) + 1;
+    detail::BatchSource source(out.size());
+    for (auto& value : out) {
+        const uint64_t offset =
+            range == 0 ? source.next() : source.below(range);
+        value = static_cast<return_type>(static_cast<uint64_t>(min) + offset);
+    }
 }
 
-void shuffleStringArray(std::vector<std::string>& inArray) {
-    getRNG()->shuffle_string(inArray);
+return_type generate(const return_type min, const return_type max) {
+    if (min == max) {
+        LOG(WARNING) << "min == max == " << min;
+        return min;
+    }
+    return_type value = 0;
+    generateN(std::span(&value, 1), min, max);
+    return value;
 }
 
+return_type generate(const return_type max) { return generate(0, max); }
+
 }  // namespace RandomNumberGenerator
 
 #ifdef KERNELRAND_MAYBE_SUPPORTED
 DECLARE_CLASS_INST(kernel_rand_engine);
-#endif
\ No newline at end of file
+#endif
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
 #include <string>
+#include <string_view>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 // Retval type for random
@@ -15,54 +21,125 @@ namespace RandomNumberGenerator {
  * Conditionally uses platform-specific RNG.
  *
  * @param min min value
- * @param max max value
- * @throws std::runtime_error if min >= max
+ * @param max max value, inclusive
  * @return Generated number
  */
 random_return_type generate(const random_return_type min,
                             const random_return_type max);
 
 /**
- * Alias for genRandomNumber(int, int) with min parameter as 0
- * @param max max value
+ * Alias for generate(min, max) with min parameter as 0
+ * @param max max value, inclusive
  *
- * @throws std::runtime_error if min >= max
  * @return Generated number
  */
 random_return_type generate(const random_return_type max);
 
 /**
- * Template function to shuffle an array of elements.
- * This function is specialized for std::string type to call an external
- * function. For other types, it is deleted to prevent compilation errors.
+ * generateN - Fills a span with random numbers in a range.
+ * Cheaper than calling generate() in a loop, the backend is asked for
+ * numbers in batches. Does not allocate.
  *
- * @tparam Elem The type of elements in the vector.
- * @param in The vector of elements to be shuffled.
+ * @param out The numbers
+ * @param min min value
+ * @param max max value, inclusive
+ */
+void generateN(std::span<random_return_type> out, random_return_type min,
+               random_return_type max);
+
+/**
+ * fill - Fills a span with uniformly distributed 64-bit values, straight
+ * from the backend.
  *
- * @note This function is marked as = delete for all types except std::string.
- *       For std::string, it calls an external function shuffleStringArray.
+ * @param out The values
+ */
+void fill(std::span<uint64_t> out);
+
+/**
+ * backendName - Name of the backend in use, chosen on the first call.
+ */
+std::string_view backendName();
+
+namespace detail {
+
+// Hands out the values of fill() one by one, asking for them in batches.
+class BatchSource {
+   public:
+    static constexpr size_t kMaxBatch = 64;
+
+    // expected: how many values the caller is going to need
+    explicit BatchSource(size_t expected)
+        : batch_(expected == 0 || expected > kMaxBatch ? kMaxBatch
+                                                       : expected),
+          pos_(batch_) {}
+
+    uint64_t next() {
+        if (pos_ == batch_) {
+            fill(std::span(buffer_.data(), batch_));
+            pos_ = 0;
+        }
+        return buffer_[pos_++];
+    }
+
+    // Uniform in [0, range), range must not be 0. Lemire's multiply and
+    // reject, no division in the common case.
+    uint64_t below(uint64_t range) {
+#ifdef __SIZEOF_INT128__
+        auto product = static_cast<unsigned __int128>(next()) * range;
+        auto low = static_cast<uint64_t>(product);
+        if (low < range) {
+            const uint64_t threshold = (0 - range) % range;
+            while (low < threshold) {
+                product = static_cast<unsigned __int128>(next()) * range;
+                low = static_cast<uint64_t>(product);
+            }
+        }
+        return static_cast<uint64_t>(product >> 64);
+#else
+        const uint64_t limit = UINT64_MAX - (UINT64_MAX % range + 1) % range;
+        uint64_t value = next();
+        while (value > limit) {
+            value = next();
+        }
+        return value % range;
+#endif
+    }
+
+   private:
+    std::array<uint64_t, kMaxBatch> buffer_;
+    size_t batch_;
+    size_t pos_;
+};
+
+}  // namespace detail
+
+/**
+ * Shuffles a range of elements, with Fisher-Yates.
+ * Does not allocate.
  *
- * @throws No exceptions are thrown by this function.
+ * @param in The elements to be shuffled.
  */
 template <typename Elem>
-void shuffleArray(std::vector<Elem>& in) = delete;
+void shuffle(std::span<Elem> in) {
+    if (in.size() < 2) {
+        return;
+    }
+    detail::BatchSource source(in.size() - 1);
+    for (size_t i = in.size() - 1; i > 0; --i) {
+        using std::swap;
+        swap(in[i], in[source.below(i + 1)]);
+    }
+}
 
 /**
- * Specialization of shuffleArray for std::string type.
- * Calls an external function shuffleStringArray to shuffle the vector of
- * strings.
- *
- * @param in The vector of strings to be shuffled.
- *
- * @note This function is called only when the template parameter Elem is
- * std::string. It calls an external function shuffleStringArray.
+ * Shuffles a vector of elements.
  *
- * @throws No exceptions are thrown by this function.
+ * @tparam Elem The type of elements in the vector.
+ * @param in The vector of elements to be shuffled.
  */
-template <>
-inline void shuffleArray<std::string>(std::vector<std::string>& inArray) {
-    extern void shuffleStringArray(std::vector<std::string> & inArray);
-    shuffleStringArray(inArray);
+template <typename Elem>
+void shuffleArray(std::vector<Elem>& in) {
+    shuffle(std::span<Elem>(in));
 }
 
 };  // namespace RandomNumberGenerator
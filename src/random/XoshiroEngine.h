@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+// xoshiro256++ 1.0, by David Blackman and Sebastiano Vigna.
+// Fast, 256 bits of state, and good enough for anything but cryptography.
+class xoshiro256pp_engine {
+   public:
+    using result_type = uint64_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    // Expands the seed with splitmix64, as recommended by the authors
+    explicit xoshiro256pp_engine(uint64_t seed) {
+        for (auto& word : state) {
+            seed += 0x9e3779b97f4a7c15;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    result_type operator()() {
+        const uint64_t result = rotl(state[0] + state[3], 23) + state[0];
+        const uint64_t t = state[1] << 17;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 45);
+        return result;
+    }
+
+    void fill(std::span<uint64_t> out) {
+        for (auto& value : out) {
+            value = (*this)();
+        }
+    }
+
+   private:
+    static constexpr uint64_t rotl(const uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    std::array<uint64_t, 4> state{};
+};
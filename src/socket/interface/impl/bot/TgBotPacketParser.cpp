@@ -3,6 +3,7 @@
 #include <absl/log/log.h>
 #include <zlib.h>
 
+#include <Metrics.hpp>
 #include <SharedMalloc.hpp>
 #include <SocketBase.hpp>
 #include <TgBotSocket_Export.hpp>
@@ -75,6 +76,13 @@ bool TgBotSocketParser::onNewBuffer(SocketConnContext ctx) {
     std::optional<SharedMalloc> data;
     std::optional<TgBotSocket::Packet> pkt;
     bool ret = false;
+    static auto& handled = Metrics::counter(
+        "tgbot_socket_packets_total", "Socket packets handled as commands");
+    static auto& dropped = Metrics::counter(
+        "tgbot_socket_packets_dropped_total",
+        "Socket packets dropped for a bad header, size or checksum");
+    static auto& latency = Metrics::histogram(
+        "tgbot_socket_command_seconds", "Time spent handling socket commands");
 
     data = interface->readFromSocket(ctx, sizeof(TgBotSocket::PacketHeader));
     switch (handle_PacketHeader(data, pkt)) {
@@ -82,20 +90,24 @@ bool TgBotSocketParser::onNewBuffer(SocketConnContext ctx) {
             data = interface->readFromSocket(ctx, pkt->header.data_size);
             switch (handle_Packet(data, pkt)) {
                 case HandleState::Ok: {
+                    const Metrics::ScopedTimer timer(latency);
+                    handled.add();
                     handle_CommandPacket(ctx, pkt.value());
                     break;
                 }
                 case HandleState::Ignore: {
+                    dropped.add();
                     break;
                 }
-                case HandleState::Fail: {
-                    ret = true;
-                    break;
-                }
+                case HandleState::Fail:
+                    LOG(ERROR) << "Failed to handle packet";
+                    return true;
             }
-            [[fallthrough]];
+            ret = false;
+            break;
         }
         case HandleState::Ignore:
+            dropped.add();
             ret = false;
             break;
         case HandleState::Fail:
@@ -23,14 +23,12 @@ void SocketInterfaceTgBot::doInitCall(Bot& bot) {
 
     if (wrapper.getInternalInterface()) {
         threads.emplace_back(
-            mgr->createController<ThreadManager::Usage::SOCKET_THREAD,
-                                  SocketInterfaceTgBot>(
+            mgr->createController<ThreadManager::Usage::SOCKET_THREAD>(
                 std::ref(bot), wrapper.getInternalInterface()));
     }
     if (wrapper.getExternalInterface()) {
         threads.emplace_back(
-            mgr->createController<ThreadManager::Usage::SOCKET_EXTERNAL_THREAD,
-                                  SocketInterfaceTgBot>(
+            mgr->createController<ThreadManager::Usage::SOCKET_EXTERNAL_THREAD>(
                 std::ref(bot), wrapper.getExternalInterface()));
     }
     for (auto& thr : threads) {
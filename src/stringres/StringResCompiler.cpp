@@ -1,47 +1,149 @@
-// Compiles string res xml to numbers
+// Compiles string res xml to numbers, and the strings themselves into
+// constexpr tables, one per locale.
 
 #include <absl/log/log.h>
 
 #include <AbslLogInit.hpp>
+#include <algorithm>
 #include <boost/algorithm/string.hpp>
 #include <cstdlib>
+#include <filesystem>
 #include <fstream>
+#include <iomanip>
+#include <vector>
 
 #include "StringResLoader.hpp"
 
+namespace {
+
+// Writes a string as a C++ string literal. Non-printable bytes are
+// written as 3-digit octal escapes, so they never merge with what follows.
+void writeEscaped(std::ostream& os, const std::string& str) {
+    os << '"';
+    for (const char c : str) {
+        const auto uc = static_cast<unsigned char>(c);
+        switch (c) {
+            case '"':
+                os << "\\\"";
+                break;
+            case '\\':
+                os << "\\\\";
+                break;
+            case '\n':
+                os << "\\n";
+                break;
+            case '\t':
+                os << "\\t";
+                break;
+            default:
+                if (uc < 0x20 || uc == 0x7f) {
+                    os << '\\' << std::oct << std::setw(3) << std::setfill('0')
+                       << static_cast<int>(uc) << std::dec;
+                } else {
+                    os << c;
+                }
+                break;
+        }
+    }
+    os << '"';
+}
+
+// en-US -> en_US
+std::string toIdentifier(std::string locale) {
+    std::ranges::replace(locale, '-', '_');
+    return locale;
+}
+
+}  // namespace
+
 int main(int argc, char** argv) {
-    StringResLoader manager;
     TgBot_AbslLogInit();
 
-    if (argc != 3) {
+    if (argc < 3) {
         LOG(ERROR) << "Usage: " << argv[0]
-                   << " <input_res_file> <output_hdr_file>";
+                   << " <default_res_file> [<res_file>...] <output_hdr_file>";
         return EXIT_FAILURE;
     }
+    const std::filesystem::path outputFile = argv[argc - 1];
     LOG(INFO) << "Starting";
-    LOG(INFO) << "Input file: " << argv[1];
-    LOG(INFO) << "Output file: " << argv[2];
 
-    if (!manager.parseFromFile(argv[1])) {
-        return EXIT_FAILURE;
+    // The first file decides the indexes, the rest must provide the same keys.
+    std::vector<std::pair<std::string, StringResLoader>> locales;
+    for (int i = 1; i < argc - 1; ++i) {
+        std::filesystem::path inputFile = argv[i];
+        StringResLoader loader;
+
+        LOG(INFO) << "Input file: " << inputFile;
+        if (!loader.parseFromFile(inputFile)) {
+            return EXIT_FAILURE;
+        }
+        if (!locales.empty()) {
+            const auto& base = locales.front().second.m_strings;
+            if (loader.m_strings.size() != base.size()) {
+                LOG(ERROR) << inputFile << " has " << loader.m_strings.size()
+                           << " strings, expected " << base.size();
+                return EXIT_FAILURE;
+            }
+            for (size_t j = 0; j < base.size(); ++j) {
+                if (loader.m_strings[j].first != base[j].first) {
+                    LOG(ERROR) << inputFile << ": Missing string "
+                               << base[j].first;
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+        locales.emplace_back(inputFile.stem().string(), std::move(loader));
     }
-    std::ofstream ofs(argv[2]);
+    LOG(INFO) << "Output file: " << outputFile;
+
+    std::ofstream ofs(outputFile);
     if (!ofs) {
-        LOG(ERROR) << "Failed to open output file: " << argv[2];
+        LOG(ERROR) << "Failed to open output file: " << outputFile;
         return EXIT_FAILURE;
     }
+    const auto& strings = locales.front().second.m_strings;
+
     ofs << "#pragma once" << std::endl << std::endl;
-    ofs << "/* generated by " << argv[0] << " */" << std::endl;
+    ofs << "/* generated by " << argv[0] << " */" << std::endl << std::endl;
+    ofs << "#include <array>" << std::endl;
+    ofs << "#include <string_view>" << std::endl << std::endl;
     int index = 0;
-    LOG(INFO) << "Total strings count: " << manager.m_strings.size();
-    for (const auto& elem : manager.m_strings) {
+    LOG(INFO) << "Total strings count: " << strings.size();
+    for (const auto& elem : strings) {
         ofs << "#define STRINGRES_" << boost::to_upper_copy<std::string>(elem.first)
             << " " << index << std::endl;
         index++;
     }
-    ofs << "#define STRINGRES_MAX " << index;
+    ofs << "#define STRINGRES_MAX " << index << std::endl << std::endl;
+
+    ofs << "namespace stringres {" << std::endl << std::endl;
+    ofs << "using table_type = std::array<std::string_view, STRINGRES_MAX>;"
+        << std::endl << std::endl;
+    for (const auto& [locale, loader] : locales) {
+        ofs << "inline constexpr table_type " << toIdentifier(locale) << " = {"
+            << std::endl;
+        for (const auto& [name, content] : loader.m_strings) {
+            ofs << "    ";
+            writeEscaped(ofs, content);
+            ofs << ",  // " << name << std::endl;
+        }
+        ofs << "};" << std::endl << std::endl;
+    }
+    ofs << "struct locale_entry {" << std::endl
+        << "    std::string_view name;" << std::endl
+        << "    const table_type* table;" << std::endl
+        << "};" << std::endl << std::endl;
+    ofs << "// The first entry is the default locale" << std::endl;
+    ofs << "inline constexpr std::array<locale_entry, " << locales.size()
+        << "> kLocales = {{" << std::endl;
+    for (const auto& [locale, loader] : locales) {
+        ofs << "    {\"" << locale << "\", &" << toIdentifier(locale) << "},"
+            << std::endl;
+    }
+    ofs << "}};" << std::endl << std::endl;
+    ofs << "}  // namespace stringres" << std::endl;
     ofs.close();
-    LOG(INFO) << "Strings written to file: " << argv[2];
+    LOG(INFO) << "Strings written to file: " << outputFile;
     LOG(INFO) << "Done";
     return 0;
-}
\ No newline at end of file
+}
@@ -79,6 +79,6 @@ bool StringResLoader::parseFromFile(const std::filesystem::path &path,
     return true;
 }
 
-std::string StringResLoader::getString(const int key) const {
+std::string_view StringResLoader::getString(const int key) const {
     return m_strings.at(key).second;
 }
\ No newline at end of file
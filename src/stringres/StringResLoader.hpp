@@ -3,6 +3,7 @@
 
 #include <filesystem>
 #include <string>
+#include <string_view>
 #include <vector>
 
 struct StringResLoader {
@@ -11,5 +12,5 @@ struct StringResLoader {
     bool parseFromFile(const std::filesystem::path& path,
                        int expected_size = 0);
     // One of STRINGRES_* constants
-    [[nodiscard]] std::string getString(const int key) const;
+    [[nodiscard]] std::string_view getString(const int key) const;
 };
\ No newline at end of file
@@ -1,25 +1,40 @@
 #include "StringResManager.hpp"
 
 #include <ConfigManager.h>
+
+#include <algorithm>
 #include <libos/libfs.hpp>
+
 #include "InstanceClassBase.hpp"
 
 void StringResManager::doInitCall() {
     auto locale = getVariable(ConfigManager::Configs::LOCALE);
     if (!locale) {
-        LOG(WARNING) << "Using default locale: en-US";
-        locale = "en-US";
+        LOG(WARNING) << "Using default locale: "
+                     << stringres::kLocales.front().name;
+        return;
     }
-    bool res = parseFromFile(FS::getPathForType(FS::PathType::RESOURCES) /
-                                 "strings" / locale->append(".xml"),
-                             STRINGRES_MAX);
+    const auto it = std::ranges::find(stringres::kLocales, *locale,
+                                      &stringres::locale_entry::name);
+    if (it != stringres::kLocales.end()) {
+        LOG(INFO) << "Using compiled-in locale: " << it->name;
+        m_table = it->table;
+        return;
+    }
+
+    StringResLoader loader;
+    bool res = loader.parseFromFile(FS::getPathForType(FS::PathType::RESOURCES) /
+                                        "strings" / locale->append(".xml"),
+                                    STRINGRES_MAX);
     if (!res) {
-        LOG(ERROR) << "Failed to parse string res, abort";
+        LOG(ERROR) << "Failed to parse string res, using default locale";
+        return;
     }
+    m_override = std::move(loader);
 }
 
 const CStringLifetime StringResManager::getInitCallName() const {
     return "Load language resource file";
 }
 
-DECLARE_CLASS_INST(StringResManager);
\ No newline at end of file
+DECLARE_CLASS_INST(StringResManager);
@@ -2,16 +2,33 @@
 
 #include <InstanceClassBase.hpp>
 #include <initcalls/Initcall.hpp>
+#include <optional>
+#include <string_view>
+
 #include "StringResLoader.hpp"
 
 #include <resources.gen.h>
 
-// Shorthand macro for getting a string
+// Shorthand macro for getting a string, as a std::string_view
 #define GETSTR(x) StringResManager::getInstance()->getString(STRINGRES_##x)
-#define GETSTR_IS(x) (GETSTR(x) + ": ")
-#define GETSTR_BRACE(x) ("(" + GETSTR(x) + ")")
+#define GETSTR_IS(x) (std::string(GETSTR(x)) + ": ")
+#define GETSTR_BRACE(x) ("(" + std::string(GETSTR(x)) + ")")
 
-struct StringResManager : InstanceClassBase<StringResManager>, InitCall, StringResLoader {
+// Strings are compiled in per locale by StringResCompiler.
+// A locale which isn't compiled in is loaded from its xml file instead.
+struct StringResManager : InstanceClassBase<StringResManager>, InitCall {
     void doInitCall() override;
     const CStringLifetime getInitCallName() const override;
-};
\ No newline at end of file
+
+    // One of STRINGRES_* constants
+    [[nodiscard]] std::string_view getString(const int key) const {
+        if (m_override) {
+            return m_override->getString(key);
+        }
+        return (*m_table)[key];
+    }
+
+   private:
+    const stringres::table_type* m_table = stringres::kLocales.front().table;
+    std::optional<StringResLoader> m_override;
+};
@@ -5,6 +5,7 @@
 #include <absl/log/log.h>
 #include <httplib.h>
 
+#include <Metrics.hpp>
 #include <TgBotWebpage.hpp>
 #include <iomanip>
 #include <libos/libfs.hpp>
@@ -18,6 +19,11 @@ namespace {
 std::string getOrEmpty(const std::string &in) {
     return in.empty() ? in : "Empty";
 }
+
+bool isLoopback(const std::string &address) {
+    return address == "::1" || address.starts_with("127.") ||
+           address.starts_with("::ffff:127.");
+}
 }  // namespace
 
 void TgBotWebServerBase::loggerFn(const httplib::Request &req,
@@ -62,6 +68,18 @@ void TgBotWebServerBase::startServer() {
              [this](const httplib::Request &req, httplib::Response &res) {
                  callback.handleAPIVotes(req, res);
              });
+    svr.Get(Constants::kMetricsNode.data(),
+            [](const httplib::Request &req, httplib::Response &res) {
+                // The server listens on every interface for the web page,
+                // the metrics are only for a scraper on this host
+                if (!isLoopback(req.remote_addr)) {
+                    res.status = httplib::StatusCode::Forbidden_403;
+                    res.set_content("403 Forbidden", "text/plain");
+                    return;
+                }
+                res.set_content(Metrics::serialize(),
+                                "text/plain; version=0.0.4");
+            });
     svr.set_logger(TgBotWebServerBase::loggerFn);
     svr.listen(Constants::kBindToIp.data(), port);
 }
@@ -0,0 +1,319 @@
+#include <gtest/gtest.h>
+#include <tgbot/TgException.h>
+
+#include <ApiScheduler.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+ApiScheduler::Limits fastLimits() {
+    ApiScheduler::Limits limits;
+    limits.globalPerSecond = 1000;
+    limits.chatPerSecond = 1000;
+    limits.chatBurst = 1000;
+    return limits;
+}
+
+TgBot::TgException tooManyRequests(const int retryAfter) {
+    return TgBot::TgException(
+        "Too Many Requests: retry after " + std::to_string(retryAfter),
+        static_cast<TgBot::TgException::ErrorCode>(429));
+}
+
+}  // namespace
+
+TEST(ApiSchedulerTest, FuturesGetResults) {
+    ApiScheduler scheduler(fastLimits());
+
+    auto value = scheduler.submit(1, [] { return 42; });
+    auto nothing = scheduler.submit(1, [] {});
+    auto error = scheduler.submit(
+        2, []() -> int { throw std::runtime_error("Bad Request"); });
+    EXPECT_EQ(value.get(), 42);
+    nothing.get();
+    EXPECT_THROW(error.get(), std::runtime_error);
+}
+
+TEST(ApiSchedulerTest, ChatRequestsAreSentInOrder) {
+    ApiScheduler scheduler(fastLimits());
+    std::mutex mutex;
+    std::vector<int> order;
+    std::atomic_int sending = 0;
+    std::atomic_bool overlapped = false;
+    std::vector<std::future<void>> futures;
+
+    for (int i = 0; i < 50; ++i) {
+        futures.emplace_back(scheduler.submit(1, [&, i] {
+            if (++sending > 1) {
+                overlapped = true;
+            }
+            {
+                const std::lock_guard<std::mutex> lock(mutex);
+                order.emplace_back(i);
+            }
+            --sending;
+        }));
+    }
+    for (auto& future : futures) {
+        future.get();
+    }
+    EXPECT_FALSE(overlapped);
+    ASSERT_EQ(order.size(), 50);
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_EQ(order[i], i);
+    }
+}
+
+TEST(ApiSchedulerTest, ChatRateIsLimited) {
+    ApiScheduler::Limits limits = fastLimits();
+    limits.chatPerSecond = 20;
+    limits.chatBurst = 2;
+    ApiScheduler scheduler(limits);
+    std::vector<std::future<ApiScheduler::Clock::time_point>> futures;
+
+    for (int i = 0; i < 12; ++i) {
+        futures.emplace_back(
+            scheduler.submit(1, [] { return ApiScheduler::Clock::now(); }));
+    }
+    // Another chat isn't held up by it
+    const auto other =
+        scheduler.submit(2, [] { return ApiScheduler::Clock::now(); }).get();
+    std::vector<ApiScheduler::Clock::time_point> sent;
+    for (auto& future : futures) {
+        sent.emplace_back(future.get());
+    }
+    // The burst goes at once, then one per 50ms
+    EXPECT_GE(sent.back() - sent.front(), 450ms);
+    EXPECT_LT(other - sent.front(), 200ms);
+}
+
+TEST(ApiSchedulerTest, GlobalRateIsLimited) {
+    ApiScheduler::Limits limits = fastLimits();
+    limits.globalPerSecond = 20;
+    ApiScheduler scheduler(limits);
+    std::vector<std::future<ApiScheduler::Clock::time_point>> futures;
+
+    for (int i = 0; i < 30; ++i) {
+        futures.emplace_back(
+            scheduler.submit(i, [] { return ApiScheduler::Clock::now(); }));
+    }
+    std::vector<ApiScheduler::Clock::time_point> sent;
+    for (auto& future : futures) {
+        sent.emplace_back(future.get());
+    }
+    std::ranges::sort(sent);
+    EXPECT_GE(sent.back() - sent.front(), 450ms);
+}
+
+TEST(ApiSchedulerTest, GlobalLaneOnlyUsesTheGlobalRate) {
+    ApiScheduler::Limits limits = fastLimits();
+    limits.chatPerSecond = 1;
+    limits.chatBurst = 1;
+    ApiScheduler scheduler(limits);
+    std::atomic_int inFlight = 0;
+    std::atomic_int mostInFlight = 0;
+    std::vector<std::future<void>> sent;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 8; ++i) {
+        sent.emplace_back(scheduler.submitGlobal([&] {
+            const int now = ++inFlight;
+            int most = mostInFlight;
+            while (now > most &&
+                   !mostInFlight.compare_exchange_weak(most, now)) {
+            }
+            std::this_thread::sleep_for(20ms);
+            --inFlight;
+        }));
+    }
+    for (auto& future : sent) {
+        future.get();
+    }
+    // Not one per second, and not one at a time
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 500ms);
+    EXPECT_GT(mostInFlight, 1);
+}
+
+TEST(ApiSchedulerTest, GlobalLaneAndChatsTakeTurns) {
+    ApiScheduler::Limits limits = fastLimits();
+    limits.workers = 1;
+    ApiScheduler scheduler(limits);
+    std::mutex mutex;
+    std::vector<char> order;
+    const auto record = [&](const char lane) {
+        return [&, lane] {
+            const std::lock_guard<std::mutex> lock(mutex);
+            order.emplace_back(lane);
+        };
+    };
+    std::promise<void> release;
+    // Holds the only worker until everything is queued
+    auto blocker = scheduler.submitGlobal(
+        [future = release.get_future().share()] { future.wait(); });
+    std::this_thread::sleep_for(20ms);
+    std::vector<std::future<void>> sent;
+    for (int i = 0; i < 3; ++i) {
+        sent.emplace_back(scheduler.submitGlobal(record('g')));
+        sent.emplace_back(scheduler.submit(i + 1, record('c')));
+    }
+    release.set_value();
+    blocker.get();
+    for (auto& future : sent) {
+        future.get();
+    }
+    EXPECT_EQ(order, (std::vector<char>{'c', 'g', 'c', 'g', 'c', 'g'}));
+}
+
+TEST(ApiSchedulerTest, UnlimitedIsNotThrottled) {
+    ApiScheduler scheduler(ApiScheduler::Limits::unlimited());
+    std::vector<std::future<void>> sent;
+    const auto start = std::chrono::steady_clock::now();
+    // Past the default burst of a chat, and the global rate
+    for (int i = 0; i < 100; ++i) {
+        sent.emplace_back(scheduler.submit(1, [] {}));
+    }
+    for (auto& future : sent) {
+        future.get();
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 500ms);
+}
+
+TEST(ApiSchedulerTest, QueuedEditsAreMerged) {
+    ApiScheduler scheduler(fastLimits());
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::atomic_int calls = 0;
+
+    // Holds the chat, so the edits stay queued
+    auto blocker = scheduler.submit(1, [opened] { opened.wait(); });
+    std::vector<std::future<ApiScheduler::Message::Ptr>> futures;
+    for (int i = 0; i < 3; ++i) {
+        futures.emplace_back(scheduler.edit(1, 5, [&calls, i] {
+            ++calls;
+            auto message = std::make_shared<TgBot::Message>();
+            message->text = std::to_string(i);
+            return message;
+        }));
+    }
+    auto other = scheduler.edit(1, 6, [&calls] {
+        ++calls;
+        return std::make_shared<TgBot::Message>();
+    });
+    gate.set_value();
+
+    for (auto& future : futures) {
+        EXPECT_EQ(future.get()->text, "2");
+    }
+    other.get();
+    blocker.get();
+    EXPECT_EQ(calls, 2);
+}
+
+TEST(ApiSchedulerTest, EditsAreNotMergedPastOtherRequests) {
+    ApiScheduler scheduler(fastLimits());
+    std::promise<void> gate;
+    std::shared_future<void> opened = gate.get_future().share();
+    std::mutex mutex;
+    std::vector<std::string> sent;
+    const auto editTo = [&](const std::string& text) {
+        return [&, text] {
+            const std::lock_guard<std::mutex> lock(mutex);
+            sent.emplace_back(text);
+            return std::make_shared<TgBot::Message>();
+        };
+    };
+
+    auto blocker = scheduler.submit(1, [opened] { opened.wait(); });
+    auto first = scheduler.edit(1, 5, editTo("first"));
+    auto between = scheduler.submit(1, [&] {
+        const std::lock_guard<std::mutex> lock(mutex);
+        sent.emplace_back("send");
+    });
+    auto second = scheduler.edit(1, 5, editTo("second"));
+    gate.set_value();
+
+    first.get();
+    between.get();
+    second.get();
+    blocker.get();
+    EXPECT_EQ(sent, (std::vector<std::string>{"first", "send", "second"}));
+}
+
+TEST(ApiSchedulerTest, RetriesAfterTooManyRequests) {
+    ApiScheduler scheduler(fastLimits());
+    std::atomic_int attempts = 0;
+    const auto start = ApiScheduler::Clock::now();
+
+    auto future = scheduler.submit(1, [&attempts] {
+        if (++attempts == 1) {
+            throw tooManyRequests(1);
+        }
+        return attempts.load();
+    });
+    EXPECT_EQ(future.get(), 2);
+    EXPECT_GE(ApiScheduler::Clock::now() - start, 1s);
+}
+
+TEST(ApiSchedulerTest, LoggedRequestsAreStillRetried) {
+    ApiScheduler scheduler(fastLimits());
+    int calls = 0;
+    auto retried = scheduler.submit(1, ApiScheduler::logged("test", [&calls] {
+        if (calls++ == 0) {
+            throw tooManyRequests(1);
+        }
+        return 42;
+    }));
+    EXPECT_EQ(retried.get(), 42);
+    EXPECT_EQ(calls, 2);
+
+    // Other failures are only logged
+    auto failed = scheduler.submit(1, ApiScheduler::logged("test", []() -> int {
+        throw std::runtime_error("Bad Request");
+    }));
+    EXPECT_EQ(failed.get(), 0);
+}
+
+TEST(ApiSchedulerTest, GivesUpAfterMaxRetries) {
+    ApiScheduler::Limits limits = fastLimits();
+    limits.maxRetries = 0;
+    ApiScheduler scheduler(limits);
+
+    auto future = scheduler.submit(1, [] { throw tooManyRequests(1); });
+    EXPECT_THROW(future.get(), TgBot::TgException);
+}
+
+TEST(ApiSchedulerTest, ParsesRetryAfter) {
+    EXPECT_EQ(ApiScheduler::retryAfter(tooManyRequests(7)), 7s);
+    EXPECT_EQ(ApiScheduler::retryAfter(tooManyRequests(0)), 1s);
+    EXPECT_EQ(ApiScheduler::retryAfter(TgBot::TgException(
+                  "Bad Request", TgBot::TgException::ErrorCode::BadRequest)),
+              std::nullopt);
+    EXPECT_EQ(ApiScheduler::retryAfter(std::runtime_error("retry after 3")),
+              std::nullopt);
+}
+
+TEST(ApiSchedulerTest, StopFailsQueuedRequests) {
+    ApiScheduler::Limits limits = fastLimits();
+    limits.chatPerSecond = 1;
+    limits.chatBurst = 1;
+    ApiScheduler scheduler(limits);
+
+    auto first = scheduler.submit(1, [] {});
+    auto second = scheduler.submit(1, [] {});
+    first.get();
+    scheduler.stop();
+    EXPECT_THROW(second.get(), TgBot::TgException);
+    EXPECT_THROW(scheduler.submit(1, [] {}).get(), TgBot::TgException);
+    EXPECT_EQ(scheduler.queued(), 0);
+}
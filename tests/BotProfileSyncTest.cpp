@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <BotProfileSync.hpp>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct FakeSink : BotProfileSync::Sink {
+    void setCommands(
+        const std::vector<BotProfileSync::Command>& commands) override {
+        if (failures > 0) {
+            --failures;
+            throw std::runtime_error("Too Many Requests");
+        }
+        sentCommands.emplace_back(commands);
+    }
+    void setDescription(const std::string& description) override {
+        sentDescriptions.emplace_back(description);
+    }
+    void setShortDescription(const std::string& description) override {
+        sentDescriptions.emplace_back(description);
+    }
+
+    int failures = 0;
+    std::vector<std::vector<BotProfileSync::Command>> sentCommands;
+    std::vector<std::string> sentDescriptions;
+};
+
+class BotProfileSyncTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        stateFile = std::filesystem::temp_directory_path() /
+                    ("BotProfileSyncTest_" + std::to_string(::getpid()));
+        std::filesystem::remove(stateFile);
+    }
+    void TearDown() override { std::filesystem::remove(stateFile); }
+
+    std::unique_ptr<BotProfileSync> makeSync() {
+        return std::make_unique<BotProfileSync>(
+            stateFile, sink,
+            [this](std::chrono::milliseconds /*delay*/,
+                   std::function<void()> fn) {
+                scheduled.emplace_back(std::move(fn));
+            });
+    }
+    void runScheduled() {
+        auto fns = std::move(scheduled);
+        scheduled.clear();
+        for (const auto& fn : fns) {
+            fn();
+        }
+    }
+
+    std::filesystem::path stateFile;
+    std::shared_ptr<FakeSink> sink = std::make_shared<FakeSink>();
+    std::vector<std::function<void()>> scheduled;
+    const std::vector<BotProfileSync::Command> commands{{"alive", "Alive?"}};
+};
+
+TEST_F(BotProfileSyncTest, ChangesAreDebouncedIntoOneUpdate) {
+    auto sync = makeSync();
+    sync->setCommands({{"a", "1"}});
+    sync->setCommands({{"b", "2"}});
+    sync->setCommands(commands);
+    EXPECT_TRUE(sink->sentCommands.empty());
+
+    runScheduled();
+    ASSERT_EQ(sink->sentCommands.size(), 1);
+    ASSERT_EQ(sink->sentCommands[0].size(), 1);
+    EXPECT_EQ(sink->sentCommands[0][0].command, "alive");
+}
+
+TEST_F(BotProfileSyncTest, OnlyChangedPartsAreSent) {
+    auto sync = makeSync();
+    sync->setCommands(commands);
+    sync->setDescription("description");
+    runScheduled();
+    EXPECT_EQ(sink->sentDescriptions.size(), 1);
+
+    sync->setDescription("description");
+    sync->setCommands({{"alive", "Alive!"}});
+    runScheduled();
+    EXPECT_EQ(sink->sentCommands.size(), 2);
+    EXPECT_EQ(sink->sentDescriptions.size(), 1);
+}
+
+TEST_F(BotProfileSyncTest, SentStateSurvivesRestart) {
+    {
+        auto sync = makeSync();
+        sync->setCommands(commands);
+        runScheduled();
+        ASSERT_EQ(sink->sentCommands.size(), 1);
+    }
+    auto sync = makeSync();
+    sync->setCommands(commands);
+    runScheduled();
+    EXPECT_EQ(sink->sentCommands.size(), 1);
+    sync->setCommands({});
+    runScheduled();
+    EXPECT_EQ(sink->sentCommands.size(), 2);
+}
+
+TEST_F(BotProfileSyncTest, FailedUpdateIsRetried) {
+    auto sync = makeSync();
+    sink->failures = 1;
+    sync->setCommands(commands);
+    runScheduled();
+    EXPECT_TRUE(sink->sentCommands.empty());
+    sync->flush();
+    EXPECT_EQ(sink->sentCommands.size(), 1);
+}
+
+}  // namespace
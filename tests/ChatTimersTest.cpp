@@ -0,0 +1,219 @@
+#include <gtest/gtest.h>
+
+#include <ChatTimers.hpp>
+#include <TimerWheel.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// Records what the timers did to each chat
+class FakeApi : public ChatTimers::Api {
+   public:
+    struct Chat {
+        int sent = 0;
+        int edits = 0;
+        int announced = 0;
+        int unpins = 0;
+        bool pinned = false;
+        std::string text;
+    };
+
+    MessageId sendMessage(ChatId chat, const std::string& text) override {
+        if (onSend) {
+            onSend();
+        }
+        const std::lock_guard<std::mutex> lock(mutex);
+        if (failSend) {
+            return 0;
+        }
+        Chat& state = chats[chat];
+        ++state.sent;
+        state.text = text;
+        callTimes.emplace_back(ChatTimers::Clock::now());
+        return ++lastMessage;
+    }
+    void announce(ChatId chat, const std::string& /*text*/) override {
+        const std::lock_guard<std::mutex> lock(mutex);
+        ++chats[chat].announced;
+        callTimes.emplace_back(ChatTimers::Clock::now());
+    }
+    void editMessage(ChatId chat, MessageId /*message*/,
+                     const std::string& text) override {
+        const std::lock_guard<std::mutex> lock(mutex);
+        Chat& state = chats[chat];
+        ++state.edits;
+        state.text = text;
+        callTimes.emplace_back(ChatTimers::Clock::now());
+        changed.notify_all();
+    }
+    bool pinMessage(ChatId chat, MessageId /*message*/) override {
+        const std::lock_guard<std::mutex> lock(mutex);
+        chats[chat].pinned = true;
+        return true;
+    }
+    void unpinMessage(ChatId chat, MessageId /*message*/) override {
+        const std::lock_guard<std::mutex> lock(mutex);
+        Chat& state = chats[chat];
+        ++state.unpins;
+        state.pinned = false;
+        // The last request of an ending
+        ++ended;
+        callTimes.emplace_back(ChatTimers::Clock::now());
+        changed.notify_all();
+    }
+
+    bool waitForEnded(const int count) {
+        std::unique_lock<std::mutex> lock(mutex);
+        return changed.wait_for(lock, 20s, [&] { return ended >= count; });
+    }
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::unordered_map<ChatId, Chat> chats;
+    std::vector<ChatTimers::Clock::time_point> callTimes;
+    MessageId lastMessage = 0;
+    int ended = 0;
+    bool failSend = false;
+    // Runs while a timer's message is being sent
+    std::function<void()> onSend;
+};
+
+ChatTimers::Limits fastLimits() {
+    ChatTimers::Limits limits;
+    limits.editInterval = 100ms;
+    limits.requestsPerSecond = 1000000;
+    return limits;
+}
+
+}  // namespace
+
+TEST(ChatTimersTest, ManyTimersAllEnd) {
+    constexpr int kTimers = 10000;
+    TimerWheel wheel;
+    auto api = std::make_shared<FakeApi>();
+    ChatTimers timers(api, wheel, fastLimits());
+
+    for (int i = 0; i < kTimers; ++i) {
+        const std::chrono::milliseconds duration(300 + i % 500);
+        ASSERT_EQ(timers.start(i, duration), ChatTimers::StartResult::kStarted);
+    }
+    ASSERT_TRUE(api->waitForEnded(kTimers));
+    EXPECT_EQ(timers.active(), 0);
+
+    const std::lock_guard<std::mutex> lock(api->mutex);
+    ASSERT_EQ(api->chats.size(), kTimers);
+    for (const auto& [chat, state] : api->chats) {
+        EXPECT_EQ(state.text, "Timer ended") << chat;
+        EXPECT_EQ(state.announced, 1) << chat;
+        EXPECT_EQ(state.unpins, 1) << chat;
+        EXPECT_FALSE(state.pinned) << chat;
+        // At most one edit per interval, and the final one
+        EXPECT_LE(state.edits, 800 / 100 + 1) << chat;
+    }
+}
+
+TEST(ChatTimersTest, EndingsStayWithinBudget) {
+    constexpr int kTimers = 15;
+    constexpr int kRate = 20;
+    TimerWheel wheel;
+    auto api = std::make_shared<FakeApi>();
+    ChatTimers::Limits limits;
+    limits.editInterval = 10s;
+    limits.requestsPerSecond = kRate;
+    ChatTimers timers(api, wheel, limits);
+
+    for (int i = 0; i < kTimers; ++i) {
+        ASSERT_EQ(timers.start(i, 50ms), ChatTimers::StartResult::kStarted);
+    }
+    ASSERT_TRUE(api->waitForEnded(kTimers));
+
+    const std::lock_guard<std::mutex> lock(api->mutex);
+    // The start messages aren't budgeted, every ending is an edit, an
+    // announcement and an unpin.
+    const std::vector endings(api->callTimes.begin() + kTimers,
+                              api->callTimes.end());
+    ASSERT_EQ(endings.size(), kTimers * 3);
+    // A full bucket goes out at once, and one ending may overdraw it
+    const auto spread = endings.back() - endings.front();
+    const int throttled = static_cast<int>(endings.size()) - kRate - 2;
+    EXPECT_GE(spread, std::chrono::milliseconds(throttled * 1000 / kRate));
+}
+
+TEST(ChatTimersTest, OneTimerPerChat) {
+    TimerWheel wheel;
+    auto api = std::make_shared<FakeApi>();
+    ChatTimers timers(api, wheel, fastLimits());
+
+    EXPECT_EQ(timers.start(1, 10s), ChatTimers::StartResult::kStarted);
+    EXPECT_EQ(timers.start(1, 10s), ChatTimers::StartResult::kAlreadyRunning);
+    EXPECT_EQ(timers.start(2, 10s), ChatTimers::StartResult::kStarted);
+    EXPECT_EQ(timers.active(), 2);
+}
+
+TEST(ChatTimersTest, StopEndsWithoutAnnouncing) {
+    TimerWheel wheel;
+    auto api = std::make_shared<FakeApi>();
+    ChatTimers timers(api, wheel, fastLimits());
+
+    ASSERT_EQ(timers.start(1, 10s), ChatTimers::StartResult::kStarted);
+    EXPECT_TRUE(timers.stop(1));
+    EXPECT_FALSE(timers.stop(1));
+    EXPECT_EQ(timers.active(), 0);
+
+    std::unique_lock<std::mutex> lock(api->mutex);
+    ASSERT_TRUE(api->changed.wait_for(
+        lock, 5s, [&] { return api->chats[1].unpins == 1; }));
+    EXPECT_EQ(api->chats[1].text, "Timer ended");
+    EXPECT_EQ(api->chats[1].announced, 0);
+    // The chat is free again
+    lock.unlock();
+    EXPECT_EQ(timers.start(1, 10s), ChatTimers::StartResult::kStarted);
+}
+
+TEST(ChatTimersTest, LimitsTimerCount) {
+    TimerWheel wheel;
+    auto api = std::make_shared<FakeApi>();
+    ChatTimers::Limits limits = fastLimits();
+    limits.maxTimers = 2;
+    ChatTimers timers(api, wheel, limits);
+
+    EXPECT_EQ(timers.start(1, 10s), ChatTimers::StartResult::kStarted);
+    EXPECT_EQ(timers.start(2, 10s), ChatTimers::StartResult::kStarted);
+    EXPECT_EQ(timers.start(3, 10s), ChatTimers::StartResult::kTooManyTimers);
+    EXPECT_TRUE(timers.stop(1));
+    EXPECT_EQ(timers.start(3, 10s), ChatTimers::StartResult::kStarted);
+}
+
+TEST(ChatTimersTest, FailedSendFreesChat) {
+    TimerWheel wheel;
+    auto api = std::make_shared<FakeApi>();
+    ChatTimers timers(api, wheel, fastLimits());
+
+    api->failSend = true;
+    EXPECT_EQ(timers.start(1, 10s), ChatTimers::StartResult::kFailed);
+    EXPECT_EQ(timers.active(), 0);
+    api->failSend = false;
+    EXPECT_EQ(timers.start(1, 10s), ChatTimers::StartResult::kStarted);
+}
+
+TEST(ChatTimersTest, StopWhileStarting) {
+    TimerWheel wheel;
+    auto api = std::make_shared<FakeApi>();
+    ChatTimers timers(api, wheel, fastLimits());
+
+    api->onSend = [&timers] { EXPECT_TRUE(timers.stop(1)); };
+    EXPECT_EQ(timers.start(1, 10s), ChatTimers::StartResult::kStopped);
+    EXPECT_EQ(timers.active(), 0);
+    // Its message is ended all the same
+    ASSERT_TRUE(api->waitForEnded(1));
+    EXPECT_EQ(api->chats[1].text, "Timer ended");
+}
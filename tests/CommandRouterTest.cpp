@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+#include <tgbot/tgbot.h>
+
+#include <CommandRouter.hpp>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr std::string_view kUsername = "test_bot";
+
+class CommandRouterTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        router.add("foo", record("foo"), false);
+        router.add("bar", record("bar"), false);
+    }
+
+    command_callback_t record(const std::string& name) {
+        return [this, name](Bot& /*bot*/, const Message::Ptr& message) {
+            called.emplace_back(name + ":" + message->text);
+        };
+    }
+
+    // Recent and from a user, so it is authorized
+    static Message::Ptr makeMessage(const std::string& text) {
+        auto message = std::make_shared<Message>();
+        message->text = text;
+        message->chat = std::make_shared<TgBot::Chat>();
+        message->from = std::make_shared<TgBot::User>();
+        message->from->id = 12345;
+        message->date = std::chrono::system_clock::to_time_t(
+            std::chrono::system_clock::now());
+        return message;
+    }
+
+    bool dispatch(const std::string& text) {
+        return router.dispatch(bot, makeMessage(text), kUsername);
+    }
+
+    Bot bot{"1:token"};
+    CommandRouter router;
+    std::vector<std::string> called;
+};
+
+TEST_F(CommandRouterTest, RunsCommandByName) {
+    EXPECT_TRUE(dispatch("/foo"));
+    EXPECT_TRUE(dispatch("/bar some args"));
+    EXPECT_TRUE(dispatch("/foo\nnext line"));
+    EXPECT_FALSE(dispatch("/baz"));
+    EXPECT_FALSE(dispatch("foo"));
+    EXPECT_EQ(called, (std::vector<std::string>{
+                          "foo:/foo", "bar:/bar some args",
+                          "foo:/foo\nnext line"}));
+}
+
+TEST_F(CommandRouterTest, ChecksTarget) {
+    EXPECT_FALSE(dispatch("/foo@other_bot"));
+    EXPECT_TRUE(dispatch("/foo@test_bot args"));
+    EXPECT_EQ(called.size(), 1);
+}
+
+TEST_F(CommandRouterTest, DisabledIsNotRun) {
+    EXPECT_TRUE(router.setEnabled("foo", false));
+    EXPECT_EQ(router.isEnabled("foo"), false);
+    EXPECT_FALSE(dispatch("/foo"));
+    EXPECT_TRUE(called.empty());
+
+    EXPECT_TRUE(router.setEnabled("foo", true));
+    EXPECT_TRUE(dispatch("/foo"));
+    EXPECT_EQ(called.size(), 1);
+
+    EXPECT_FALSE(router.setEnabled("baz", true));
+    EXPECT_FALSE(router.isEnabled("baz"));
+}
+
+TEST_F(CommandRouterTest, AddReplaces) {
+    router.setEnabled("foo", false);
+    router.add("foo", record("new foo"), false);
+    EXPECT_EQ(router.isEnabled("foo"), true);
+    EXPECT_TRUE(dispatch("/foo"));
+    EXPECT_EQ(called, std::vector<std::string>{"new foo:/foo"});
+}
+
+TEST_F(CommandRouterTest, CountsCallsAndRefusals) {
+    dispatch("/foo");
+    dispatch("/foo");
+    // Too old to be authorized
+    auto old = makeMessage("/foo");
+    old->date = 0;
+    EXPECT_TRUE(router.dispatch(bot, old, kUsername));
+
+    const auto stats = router.stats("foo");
+    ASSERT_TRUE(stats);
+    EXPECT_EQ(stats->command, "foo");
+    EXPECT_TRUE(stats->enabled);
+    EXPECT_EQ(stats->calls, 3);
+    EXPECT_EQ(stats->denied, 1);
+    EXPECT_EQ(called.size(), 2);
+    EXPECT_EQ(router.stats("bar")->calls, 0);
+    EXPECT_FALSE(router.stats("baz"));
+}
+
+}  // namespace
@@ -0,0 +1,156 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "command_modules/compiler/CompileCache.hpp"
+
+namespace {
+
+class CompileCacheTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        directory = std::filesystem::temp_directory_path() /
+                    ("CompileCacheTest_" + std::to_string(::getpid()));
+        std::filesystem::remove_all(directory);
+        std::filesystem::create_directories(directory / "work");
+        binary = directory / "work" / "a.out";
+        std::ofstream(binary) << "#!/bin/sh\necho hi\n";
+    }
+    void TearDown() override { std::filesystem::remove_all(directory); }
+
+    CompileCache makeCache(const uint64_t maxBytes = 1 << 20) {
+        return {directory / "cache", maxBytes};
+    }
+
+    std::filesystem::path directory;
+    std::filesystem::path binary;
+    const CompileCache::Key key{"/usr/bin/cc", "-O2", "int main() {}"};
+};
+
+TEST_F(CompileCacheTest, StoredEntryIsFound) {
+    auto cache = makeCache();
+    EXPECT_FALSE(cache.find(key));
+    cache.store(key, "warning: x", false, binary);
+
+    const auto entry = cache.find(key);
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(entry->diagnostics, "warning: x");
+    EXPECT_TRUE(entry->hasBinary);
+    EXPECT_FALSE(entry->output);
+
+    const auto copy = directory / "work" / "copy";
+    ASSERT_TRUE(cache.copyBinary(key, copy));
+    EXPECT_EQ(std::filesystem::file_size(copy),
+              std::filesystem::file_size(binary));
+    EXPECT_NE(std::filesystem::status(copy).permissions() &
+                  std::filesystem::perms::owner_exec,
+              std::filesystem::perms::none);
+}
+
+TEST_F(CompileCacheTest, EveryFieldIsPartOfTheKey) {
+    auto cache = makeCache();
+    cache.store(key, "", false, std::nullopt);
+    EXPECT_FALSE(cache.find({"/usr/bin/gcc", key.flags, key.source}));
+    EXPECT_FALSE(cache.find({key.compiler, "-O0", key.source}));
+    EXPECT_FALSE(cache.find({key.compiler, key.flags, "int main();"}));
+    // Not the same fields, even if they are the same characters
+    EXPECT_FALSE(cache.find({key.compiler + "-", "O2", key.source}));
+}
+
+TEST_F(CompileCacheTest, OutputIsServedOnceTwoRunsAgree) {
+    auto cache = makeCache();
+    cache.store(key, "", false, binary);
+    cache.recordRun(key, "hi\n", false);
+    EXPECT_FALSE(cache.find(key)->output);
+    cache.recordRun(key, "hi\n", false);
+    EXPECT_EQ(cache.find(key)->output, "hi\n");
+}
+
+TEST_F(CompileCacheTest, OutputWhichVariesIsNeverServed) {
+    auto cache = makeCache();
+    cache.store(key, "", false, binary);
+    cache.recordRun(key, "1\n", false);
+    cache.recordRun(key, "2\n", false);
+    cache.recordRun(key, "2\n", false);
+    cache.recordRun(key, "2\n", false);
+    EXPECT_FALSE(cache.find(key)->output);
+}
+
+TEST_F(CompileCacheTest, TruncationIsKept) {
+    auto cache = makeCache();
+    cache.store(key, "error: x", true, binary);
+    EXPECT_TRUE(cache.find(key)->diagnosticsTruncated);
+    cache.recordRun(key, "hi\n", true);
+    cache.recordRun(key, "hi\n", true);
+    const auto entry = cache.find(key);
+    EXPECT_EQ(entry->output, "hi\n");
+    EXPECT_TRUE(entry->outputTruncated);
+}
+
+TEST_F(CompileCacheTest, TruncatedOnceIsNotTheSameOutput) {
+    auto cache = makeCache();
+    cache.store(key, "", false, binary);
+    cache.recordRun(key, "hi\n", true);
+    cache.recordRun(key, "hi\n", false);
+    EXPECT_FALSE(cache.find(key)->output);
+}
+
+TEST_F(CompileCacheTest, EntriesSurviveRestart) {
+    makeCache().store(key, "diag", false, std::nullopt);
+    auto cache = makeCache();
+    const auto entry = cache.find(key);
+    ASSERT_TRUE(entry);
+    EXPECT_EQ(entry->diagnostics, "diag");
+    EXPECT_FALSE(entry->hasBinary);
+}
+
+TEST_F(CompileCacheTest, DirectoryOthersCanAccessIsRefused) {
+    const auto shared = directory / "cache";
+    std::filesystem::create_directories(shared);
+    std::filesystem::permissions(shared, std::filesystem::perms::all);
+    CompileCache cache(shared, 1 << 20);
+    EXPECT_FALSE(cache.usable());
+    cache.store(key, "", false, binary);
+    EXPECT_FALSE(cache.find(key));
+}
+
+TEST_F(CompileCacheTest, NewDirectoryIsPrivate) {
+    const auto cache = makeCache();
+    EXPECT_TRUE(cache.usable());
+    EXPECT_EQ(std::filesystem::status(directory / "cache").permissions(),
+              std::filesystem::perms::owner_all);
+}
+
+TEST_F(CompileCacheTest, OnlyItsOwnLeftoversAreRemoved) {
+    const auto cache = directory / "cache";
+    const auto mine = cache / ("tmp." + std::to_string(::getpid()) + ".0.1");
+    // Of another bot, still writing it
+    const auto other = cache / "tmp.1.0.1";
+    makeCache();
+    std::filesystem::create_directories(mine);
+    std::filesystem::create_directories(other);
+
+    makeCache().store(key, "", false, std::nullopt);
+    EXPECT_FALSE(std::filesystem::exists(mine));
+    EXPECT_TRUE(std::filesystem::exists(other));
+    EXPECT_TRUE(makeCache().find(key));
+}
+
+TEST_F(CompileCacheTest, LeastRecentlyUsedIsEvicted) {
+    // Room for two entries without binaries
+    const CompileCache::Key other{key.compiler, key.flags, "other"};
+    const CompileCache::Key third{key.compiler, key.flags, "third"};
+    auto cache = makeCache(2 * 64);
+    cache.store(key, std::string(20, 'k'), false, std::nullopt);
+    cache.store(other, std::string(20, 'o'), false, std::nullopt);
+    EXPECT_TRUE(cache.find(key));
+    cache.store(third, std::string(20, 't'), false, std::nullopt);
+    EXPECT_TRUE(cache.find(key));
+    EXPECT_FALSE(cache.find(other));
+    EXPECT_TRUE(cache.find(third));
+}
+
+}  // namespace
@@ -1,6 +1,13 @@
 #include <ConfigManager.h>
 #include <gtest/gtest.h>
 
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string_view>
+#include <utility>
+
 #ifndef _POSIX_C_SOURCE
 #define _POSIX_C_SOURCE 0
 #endif
@@ -28,4 +35,117 @@ TEST(ConfigManagerTest, CopyCommandLine) {
     EXPECT_EQ(out_argc, 2);
     EXPECT_STREQ(out_argv[0], ins_argv[0]);
     EXPECT_STREQ(out_argv[1], ins_argv[1]);
+
+    // ins_argv is gone after this, reloads in later tests would read it
+    in_argc = 0;
+    ins_argv2 = nullptr;
+    copyCommandLine(CommandLineOp::INSERT, &in_argc, &ins_argv2);
+}
+
+namespace {
+
+ConfigManager::Snapshot makeSnapshot(ConfigManager::Configs config,
+                                     const std::string &value) {
+    ConfigManager::Snapshot::Values values;
+    values.at(static_cast<int>(config)) = value;
+    return ConfigManager::Snapshot(values);
+}
+
+// Parsed as type, whatever kConfigsTypeMap says about config
+ConfigManager::Snapshot makeSnapshot(ConfigManager::Configs config,
+                                     const std::string &value,
+                                     ConfigManager::ConfigType type) {
+    ConfigManager::Snapshot::Values values;
+    ConfigManager::Snapshot::Types types{};
+    values.at(static_cast<int>(config)) = value;
+    types.at(static_cast<int>(config)) = type;
+    return {values, types};
+}
+
+}  // namespace
+
+TEST(ConfigManagerTest, SnapshotNumbers) {
+    using ConfigManager::Configs;
+    EXPECT_EQ(makeSnapshot(Configs::IMAGE_THREADS, "4")
+                  .getNumber<unsigned>(Configs::IMAGE_THREADS),
+              4);
+    EXPECT_FALSE(makeSnapshot(Configs::IMAGE_THREADS, "4x")
+                     .getNumber<unsigned>(Configs::IMAGE_THREADS));
+    EXPECT_FALSE(makeSnapshot(Configs::IMAGE_THREADS, "-1")
+                     .getNumber<unsigned>(Configs::IMAGE_THREADS));
+    EXPECT_FALSE(makeSnapshot(Configs::IMAGE_THREADS, "4")
+                     .getNumber<unsigned>(Configs::IMAGE_MIN_PIXELS));
+    EXPECT_FALSE(makeSnapshot(Configs::IMAGE_THREADS, "300")
+                     .getNumber<unsigned char>(Configs::IMAGE_THREADS));
+    EXPECT_EQ(makeSnapshot(Configs::REPLAY_SPEED, "0.5")
+                  .getNumber<double>(Configs::REPLAY_SPEED),
+              0.5);
+    EXPECT_FALSE(makeSnapshot(Configs::REPLAY_SPEED, "0.5")
+                     .getNumber<unsigned>(Configs::REPLAY_SPEED));
+}
+
+TEST(ConfigManagerTest, SnapshotPaths) {
+    using ConfigManager::Configs;
+    EXPECT_EQ(makeSnapshot(Configs::LOG_FILE, "bot.log")
+                  .getPath(Configs::LOG_FILE),
+              std::filesystem::path("bot.log"));
+    // Not a path, only a string
+    EXPECT_FALSE(makeSnapshot(Configs::LOCALE, "en").getPath(Configs::LOCALE));
 }
+
+TEST(ConfigManagerTest, SnapshotDurations) {
+    using ConfigManager::Configs;
+    using namespace std::chrono_literals;
+    const auto duration = [](const std::string &value) {
+        return makeSnapshot(Configs::SELECTOR, value,
+                            ConfigManager::ConfigType::DURATION)
+            .getDuration(Configs::SELECTOR);
+    };
+    EXPECT_EQ(duration("250ms"), 250ms);
+    EXPECT_EQ(duration("30"), 30s);
+    EXPECT_EQ(duration("30s"), 30s);
+    EXPECT_EQ(duration("5m"), 5min);
+    EXPECT_EQ(duration("2h"), 2h);
+    EXPECT_FALSE(duration("2d"));
+    EXPECT_FALSE(duration("s"));
+}
+
+TEST(ConfigManagerTest, SnapshotEnums) {
+    using ConfigManager::Configs;
+    enum class Selector { Poll, EPoll };
+    constexpr std::array<std::pair<Selector, std::string_view>, 2> kNames{
+        {{Selector::Poll, "poll"}, {Selector::EPoll, "epoll"}}};
+    EXPECT_EQ(makeSnapshot(Configs::SELECTOR, "epoll")
+                  .getEnum(Configs::SELECTOR, kNames),
+              Selector::EPoll);
+    EXPECT_FALSE(makeSnapshot(Configs::SELECTOR, "kqueue")
+                     .getEnum(Configs::SELECTOR, kNames));
+}
+
+TEST(ConfigManagerTest, HeldSnapshotSurvivesReload) {
+    using namespace ConfigManager;
+    ConfigManager::setVariable(Configs::LOCALE, "en");
+    const auto before = ConfigManager::snapshot();
+    ConfigManager::setVariable(Configs::LOCALE, "fr");
+    const auto after = ConfigManager::snapshot();
+    EXPECT_EQ(before->get(Configs::LOCALE), "en");
+    EXPECT_EQ(after->get(Configs::LOCALE), "fr");
+}
+
+TEST(ConfigManagerTest, ReplacedSnapshotIsFreed) {
+    std::weak_ptr<const ConfigManager::Snapshot> before =
+        ConfigManager::snapshot();
+    ConfigManager::reload();
+    EXPECT_TRUE(before.expired());
+}
+
+#ifndef _WIN32
+TEST(ConfigManagerTest, RequestedReloadIsApplied) {
+    using namespace ConfigManager;
+    ConfigManager::setVariable(Configs::LOCALE, "en");
+    setenv("LOCALE", "fr", 1);
+    EXPECT_EQ(ConfigManager::snapshot()->get(Configs::LOCALE), "en");
+    ConfigManager::requestReload();
+    EXPECT_EQ(ConfigManager::snapshot()->get(Configs::LOCALE), "fr");
+}
+#endif
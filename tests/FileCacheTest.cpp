@@ -0,0 +1,208 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <FileCache.hpp>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// Files are "path/<fileId>", with fileId repeated size times as contents
+class FakeSource : public FileCache::Source {
+   public:
+    std::optional<std::string> getFilePath(const std::string& fileId) override {
+        ++lookups;
+        if (fileId == "missing") {
+            return std::nullopt;
+        }
+        return "path/" + fileId;
+    }
+    std::string download(const std::string& filePath) override {
+        ++downloads;
+        if (delay.count() != 0) {
+            std::this_thread::sleep_for(delay);
+        }
+        if (fail) {
+            throw std::runtime_error("Download failed");
+        }
+        if (failOther) {
+            // Not a std::exception
+            throw 42;
+        }
+        const std::lock_guard<std::mutex> lock(mutex);
+        const auto fileId = filePath.substr(filePath.find('/') + 1);
+        return std::string(sizes.contains(fileId) ? sizes[fileId] : 16,
+                           fileId.front());
+    }
+
+    std::atomic_int lookups = 0;
+    std::atomic_int downloads = 0;
+    std::atomic_bool fail = false;
+    std::atomic_bool failOther = false;
+    std::chrono::milliseconds delay{0};
+    std::mutex mutex;
+    std::unordered_map<std::string, size_t> sizes;
+};
+
+class FileCacheTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        directory = std::filesystem::temp_directory_path() /
+                    ("FileCacheTest_" + std::to_string(::getpid()));
+        std::filesystem::remove_all(directory);
+        source = std::make_shared<FakeSource>();
+    }
+    void TearDown() override { std::filesystem::remove_all(directory); }
+
+    std::unique_ptr<FileCache> makeCache() {
+        return std::make_unique<FileCache>(directory, source, limits);
+    }
+
+    std::filesystem::path directory;
+    std::shared_ptr<FakeSource> source;
+    FileCache::Limits limits;
+};
+
+TEST_F(FileCacheTest, SecondGetIsServedFromMemory) {
+    const auto cache = makeCache();
+    const auto first = cache->get("a1", "A");
+    ASSERT_NE(first, nullptr);
+    EXPECT_EQ(*first, std::string(16, 'a'));
+
+    const auto second = cache->get("a2", "A");
+    EXPECT_EQ(second, first);
+    EXPECT_EQ(source->downloads, 1);
+    EXPECT_EQ(cache->stats().memoryHits, 1);
+    EXPECT_TRUE(std::filesystem::exists(directory / "A"));
+}
+
+TEST_F(FileCacheTest, DiskSurvivesRestart) {
+    makeCache()->get("abc", "A");
+    const auto cache = makeCache();
+    const auto data = cache->get("abc", "A");
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(*data, std::string(16, 'a'));
+    EXPECT_EQ(source->downloads, 1);
+    EXPECT_EQ(cache->stats().diskHits, 1);
+}
+
+TEST_F(FileCacheTest, DiskCapEvictsLeastRecentlyUsed) {
+    limits.diskBytes = 40;
+    const auto cache = makeCache();
+    cache->get("a", "A");
+    cache->get("b", "B");
+    cache->get("a", "A");
+    cache->get("c", "C");
+    EXPECT_TRUE(std::filesystem::exists(directory / "A"));
+    EXPECT_FALSE(std::filesystem::exists(directory / "B"));
+    EXPECT_TRUE(std::filesystem::exists(directory / "C"));
+
+    // Also on restart
+    limits.diskBytes = 16;
+    makeCache();
+    EXPECT_FALSE(std::filesystem::exists(directory / "A"));
+    EXPECT_TRUE(std::filesystem::exists(directory / "C"));
+}
+
+TEST_F(FileCacheTest, BigFilesStayOnDiskOnly) {
+    limits.memoryFileBytes = 32;
+    source->sizes["big"] = 64;
+    const auto cache = makeCache();
+    ASSERT_NE(cache->get("big", "B"), nullptr);
+    const auto data = cache->get("big", "B");
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(data->size(), 64);
+    EXPECT_EQ(source->downloads, 1);
+    EXPECT_EQ(cache->stats().memoryHits, 0);
+    EXPECT_EQ(cache->stats().diskHits, 1);
+}
+
+TEST_F(FileCacheTest, FilePathIsMemoizedUntilExpiry) {
+    limits.filePathTtl = 1s;
+    const auto cache = makeCache();
+    EXPECT_EQ(cache->filePath("x"), "path/x");
+    EXPECT_EQ(cache->filePath("x"), "path/x");
+    EXPECT_EQ(source->lookups, 1);
+    EXPECT_EQ(cache->filePath("missing"), std::nullopt);
+    EXPECT_EQ(cache->filePath("missing"), std::nullopt);
+    EXPECT_EQ(source->lookups, 3);
+
+    std::this_thread::sleep_for(1100ms);
+    EXPECT_EQ(cache->filePath("x"), "path/x");
+    EXPECT_EQ(source->lookups, 4);
+}
+
+TEST_F(FileCacheTest, FailedDownloadIsNotCached) {
+    const auto cache = makeCache();
+    source->fail = true;
+    EXPECT_EQ(cache->get("a", "A"), nullptr);
+    EXPECT_FALSE(std::filesystem::exists(directory / "A"));
+
+    source->fail = false;
+    EXPECT_NE(cache->get("a", "A"), nullptr);
+    EXPECT_EQ(source->downloads, 2);
+    // The path is looked up again, it may have been the reason
+    EXPECT_EQ(source->lookups, 2);
+}
+
+TEST_F(FileCacheTest, LoadWhichThrowsReleasesWaiters) {
+    source->delay = 50ms;
+    source->failOther = true;
+    const auto cache = makeCache();
+    std::thread waiter;
+    std::atomic_bool waited = false;
+
+    EXPECT_ANY_THROW({
+        waiter = std::thread([&] {
+            std::this_thread::sleep_for(10ms);
+            EXPECT_EQ(cache->get("a", "A"), nullptr);
+            waited = true;
+        });
+        (void)cache->get("a", "A");
+    });
+    waiter.join();
+    EXPECT_TRUE(waited);
+
+    source->failOther = false;
+    EXPECT_NE(cache->get("a", "A"), nullptr);
+}
+
+TEST_F(FileCacheTest, InvalidUniqueIdBypassesCache) {
+    const auto cache = makeCache();
+    EXPECT_NE(cache->get("a", "../A"), nullptr);
+    EXPECT_NE(cache->get("a", "../A"), nullptr);
+    EXPECT_EQ(source->downloads, 2);
+    EXPECT_TRUE(std::filesystem::is_empty(directory));
+}
+
+TEST_F(FileCacheTest, ConcurrentGetsDownloadOnce) {
+    source->delay = 50ms;
+    const auto cache = makeCache();
+    std::vector<std::thread> threads;
+    std::atomic_int found = 0;
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&] {
+            if (cache->get("a", "A") != nullptr) {
+                ++found;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(found, 8);
+    EXPECT_EQ(source->downloads, 1);
+}
+
+}  // namespace
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <imagep/ImageKernels.hpp>
+#include <imagep/ImageParallel.hpp>
+#include <limits>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using ImageKernels::Isa;
+
+constexpr std::array kIsas{Isa::kScalar, Isa::kSSE41, Isa::kAVX2, Isa::kNEON};
+constexpr std::array kAngles{90, 180, 270};
+// 5 goes through the kernels for any pixel size
+constexpr std::array kChannels{1, 3, 4, 5};
+
+struct Size {
+    size_t width;
+    size_t height;
+};
+
+// Odd sizes, and sizes around the edges of the 64 pixel tiles and of the
+// 4x4 blocks
+constexpr std::array<Size, 9> kSizes{{{1, 1},
+                                      {3, 5},
+                                      {7, 13},
+                                      {63, 64},
+                                      {64, 64},
+                                      {65, 63},
+                                      {64, 129},
+                                      {128, 4},
+                                      {131, 67}}};
+
+std::vector<uint8_t> makeImage(size_t size) {
+    std::vector<uint8_t> data(size);
+    std::mt19937 gen(size);
+    std::uniform_int_distribution<int> dist(0, 255);
+    for (auto& byte : data) {
+        byte = static_cast<uint8_t>(dist(gen));
+    }
+    return data;
+}
+
+// Pixel by pixel, as the header describes it
+std::vector<uint8_t> referenceRotate(const std::vector<uint8_t>& src,
+                                     size_t width, size_t height,
+                                     int channels, int angle) {
+    std::vector<uint8_t> dst(src.size());
+    for (size_t y = 0; y < height; ++y) {
+        for (size_t x = 0; x < width; ++x) {
+            size_t to = 0;
+            switch (angle) {
+                case 90:
+                    to = x * height + (height - 1 - y);
+                    break;
+                case 180:
+                    to = (height - 1 - y) * width + (width - 1 - x);
+                    break;
+                case 270:
+                    to = (width - 1 - x) * height + y;
+                    break;
+            }
+            for (int c = 0; c < channels; ++c) {
+                dst[to * channels + c] = src[(y * width + x) * channels + c];
+            }
+        }
+    }
+    return dst;
+}
+
+// BT.601 in 8-bit fixed point, rounded
+void referenceGreyscale(std::vector<uint8_t>& data, int channels) {
+    for (size_t i = 0; i + channels <= data.size(); i += channels) {
+        const auto grey = static_cast<uint8_t>(
+            (77 * data[i] + 150 * data[i + 1] + 29 * data[i + 2] + 128) >> 8);
+        data[i] = data[i + 1] = data[i + 2] = grey;
+    }
+}
+
+std::optional<size_t> firstDifference(const std::vector<uint8_t>& a,
+                                      const std::vector<uint8_t>& b) {
+    if (a.size() != b.size()) {
+        return std::min(a.size(), b.size());
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (a[i] != b[i]) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+std::string describe(Size size, int channels, int angle) {
+    return std::to_string(size.width) + "x" + std::to_string(size.height) +
+           "x" + std::to_string(channels) + " by " + std::to_string(angle);
+}
+
+// Rotations, alone and fused with greyscale, checked against the reference
+void expectRotationsMatch(Size size) {
+    for (const int channels : kChannels) {
+        const auto src = makeImage(size.width * size.height * channels);
+        for (const int angle : kAngles) {
+            SCOPED_TRACE(describe(size, channels, angle));
+            auto expected =
+                referenceRotate(src, size.width, size.height, channels, angle);
+            std::vector<uint8_t> dst(src.size());
+
+            ASSERT_TRUE(ImageKernels::rotate(src.data(), dst.data(),
+                                             size.width, size.height,
+                                             channels, angle));
+            EXPECT_EQ(firstDifference(dst, expected), std::nullopt);
+
+            if (channels != 3 && channels != 4) {
+                continue;
+            }
+            ImageKernels::TransformPlan plan(size.width, size.height);
+            ASSERT_TRUE(plan.rotate(angle));
+            plan.greyscale();
+            referenceGreyscale(expected, channels);
+            ASSERT_TRUE(plan.execute(src.data(), dst.data(), channels));
+            EXPECT_EQ(firstDifference(dst, expected), std::nullopt);
+        }
+    }
+}
+
+void expectGreyscaleMatches(size_t pixels, Isa isa) {
+    for (const int channels : {3, 4}) {
+        SCOPED_TRACE(std::to_string(pixels) + " pixels of " +
+                     std::to_string(channels) + " channels");
+        auto data = makeImage(pixels * channels);
+        auto expected = data;
+        referenceGreyscale(expected, channels);
+
+        ASSERT_TRUE(
+            ImageKernels::to_greyscale(data.data(), pixels, channels, isa));
+        EXPECT_EQ(firstDifference(data, expected), std::nullopt);
+    }
+}
+
+}  // namespace
+
+TEST(ImageKernelsTest, GreyscaleMatchesScalarOnEveryIsa) {
+    for (const Isa isa : kIsas) {
+        if (!ImageKernels::isSupported(isa)) {
+            continue;
+        }
+        SCOPED_TRACE(std::string(ImageKernels::isaName(isa)));
+        // Around the 4 and 16 pixel vectors
+        for (const size_t pixels : {1, 3, 4, 5, 15, 16, 17, 33, 1001}) {
+            expectGreyscaleMatches(pixels, isa);
+        }
+    }
+}
+
+TEST(ImageKernelsTest, GreyscaleRejectsOtherChannelCounts) {
+    auto data = makeImage(16);
+    const auto before = data;
+    EXPECT_FALSE(ImageKernels::to_greyscale(data.data(), 8, 2));
+    EXPECT_FALSE(ImageKernels::to_greyscale(data.data(), 4, 5));
+    EXPECT_EQ(data, before);
+}
+
+// The rotations use the baseline vectors of the build, and the fused
+// greyscale the best ISA of this CPU
+TEST(ImageKernelsTest, RotationsMatchReference) {
+    for (const auto size : kSizes) {
+        expectRotationsMatch(size);
+    }
+}
+
+TEST(ImageKernelsTest, InvalidAnglesAreRejected) {
+    const auto src = makeImage(4 * 4 * 4);
+    for (const int angle : {0, 45, 360, -90}) {
+        SCOPED_TRACE(angle);
+        std::vector<uint8_t> dst(src.size(), 0xAB);
+        const std::vector<uint8_t> before = dst;
+        EXPECT_FALSE(
+            ImageKernels::rotate(src.data(), dst.data(), 4, 4, 4, angle));
+        EXPECT_EQ(dst, before);
+    }
+    ImageKernels::TransformPlan plan(4, 4);
+    EXPECT_FALSE(plan.rotate(45));
+    EXPECT_FALSE(plan.rotate(-90));
+}
+
+class ImageKernelsParallelTest : public ::testing::Test {
+   protected:
+    void TearDown() override { ImageKernels::setParallelism(0); }
+
+    // Several 64 row bands and greyscale blocks, with odd sides
+    static constexpr Size kLarge{257, 301};
+};
+
+TEST_F(ImageKernelsParallelTest, AboveTheThresholdMatchesReference) {
+    ImageKernels::setParallelism(4, 1);
+    expectRotationsMatch(kLarge);
+    expectGreyscaleMatches(kLarge.width * kLarge.height,
+                           ImageKernels::bestIsa());
+}
+
+TEST_F(ImageKernelsParallelTest, BelowTheThresholdMatchesReference) {
+    ImageKernels::setParallelism(4, std::numeric_limits<size_t>::max());
+    expectRotationsMatch(kLarge);
+    expectGreyscaleMatches(kLarge.width * kLarge.height,
+                           ImageKernels::bestIsa());
+}
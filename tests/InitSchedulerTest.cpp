@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "initcalls/InitScheduler.hpp"
+
+TEST(InitSchedulerTest, DependenciesRunFirst) {
+    InitScheduler scheduler;
+    std::mutex mutex;
+    std::vector<std::string> order;
+    const auto record = [&](const std::string& name) {
+        return [&, name] {
+            const std::lock_guard<std::mutex> lock(mutex);
+            order.emplace_back(name);
+        };
+    };
+    const auto a = scheduler.add("a", {}, record("a"));
+    const auto b = scheduler.add("b", {a}, record("b"));
+    const auto c = scheduler.add("c", {a}, record("c"));
+    scheduler.add("d", {b, c}, record("d"));
+
+    const auto timings = scheduler.run(4);
+    ASSERT_EQ(order.size(), 4);
+    EXPECT_EQ(order.front(), "a");
+    EXPECT_EQ(order.back(), "d");
+    ASSERT_EQ(timings.size(), 4);
+    EXPECT_EQ(timings[2].name, "c");
+}
+
+TEST(InitSchedulerTest, IndependentTasksRunTogether) {
+    InitScheduler scheduler;
+    std::atomic<int> started = 0;
+    std::atomic<int> sawOther = 0;
+    // Each waits a while for the other to start
+    const auto task = [&] {
+        ++started;
+        const auto deadline =
+            std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (started < 2 && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::yield();
+        }
+        if (started == 2) {
+            ++sawOther;
+        }
+    };
+    scheduler.add("first", {}, task);
+    scheduler.add("second", {}, task);
+    scheduler.run(2);
+    EXPECT_EQ(sawOther, 2);
+}
+
+TEST(InitSchedulerTest, FailureSkipsDependents) {
+    InitScheduler scheduler;
+    bool dependentRan = false;
+    bool otherRan = false;
+    const auto failing = scheduler.add(
+        "failing", {}, [] { throw std::runtime_error("failed"); });
+    const auto dependent =
+        scheduler.add("dependent", {failing}, [&] { dependentRan = true; });
+    scheduler.add("indirect", {dependent}, [&] { dependentRan = true; });
+    scheduler.add("other", {}, [&] { otherRan = true; });
+
+    EXPECT_THROW(scheduler.run(1), std::runtime_error);
+    EXPECT_FALSE(dependentRan);
+    EXPECT_TRUE(otherRan);
+}
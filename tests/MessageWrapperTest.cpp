@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 #include <tgbot/tgbot.h>
 #include <MessageWrapper.hpp>
+#include <ParsedCommand.hpp>
 
 using namespace TgBot;
 
@@ -127,3 +128,71 @@ TEST_F(MessageWrapperLimitedTest, GetUser) {
     MessageWrapperLimited wrapper(message);
     EXPECT_EQ(wrapper.getUser(), user);
 }
+
+TEST_F(MessageWrapperLimitedTest, GetExtraTextView) {
+    auto message = createMockMessage(12345, "/cmd  two blanks");
+    MessageWrapperLimited wrapper(message);
+    EXPECT_EQ(wrapper.getExtraTextView(), " two blanks");
+    EXPECT_EQ(wrapper.getExtraTextView().data(), message->text.data() + 5);
+}
+
+TEST_F(MessageWrapperLimitedTest, GetCommand) {
+    auto message = createMockMessage(12345, "/cmd@some_bot extra text", true);
+    MessageWrapperLimited wrapper(message);
+    EXPECT_EQ(wrapper.getCommand().command, "cmd");
+    EXPECT_EQ(wrapper.getCommand().target, "some_bot");
+    EXPECT_EQ(wrapper.getCommand().args, "extra text");
+    // Parsed again for the message switched to
+    wrapper.switchToReplyToMessage();
+    EXPECT_FALSE(wrapper.getCommand().isCommand());
+    EXPECT_EQ(wrapper.getExtraTextView(), "message");
+    wrapper.switchToParent();
+    EXPECT_EQ(wrapper.getCommand().command, "cmd");
+}
+
+TEST_F(MessageWrapperLimitedTest, SwitchToParentFromDeepReply) {
+    auto message = createMockMessage(12345, "first", true);
+    auto third = std::make_shared<Message>();
+    third->text = "third";
+    message->replyToMessage->replyToMessage = third;
+    MessageWrapperLimited wrapper(message);
+    EXPECT_TRUE(wrapper.switchToReplyToMessage());
+    EXPECT_TRUE(wrapper.switchToReplyToMessage());
+    EXPECT_FALSE(wrapper.switchToReplyToMessage());
+    EXPECT_EQ(wrapper.getText(), "third");
+    wrapper.switchToParent();
+    EXPECT_EQ(wrapper.getText(), "Reply message");
+    wrapper.switchToParent();
+    wrapper.switchToParent();
+    EXPECT_EQ(wrapper.getText(), "first");
+}
+
+TEST(ParsedCommandTest, Parse) {
+    const auto parsed = ParsedCommand::parse("/start@some_bot\nfoo bar");
+    EXPECT_TRUE(parsed.isCommand());
+    EXPECT_EQ(parsed.command, "start");
+    EXPECT_EQ(parsed.target, "some_bot");
+    EXPECT_TRUE(parsed.hasArgs);
+    EXPECT_EQ(parsed.args, "foo bar");
+    EXPECT_TRUE(parsed.isFor("some_bot"));
+    EXPECT_FALSE(parsed.isFor("other_bot"));
+}
+
+TEST(ParsedCommandTest, WithoutTargetOrArgs) {
+    const auto parsed = ParsedCommand::parse("/start");
+    EXPECT_EQ(parsed.command, "start");
+    EXPECT_TRUE(parsed.target.empty());
+    EXPECT_FALSE(parsed.hasArgs);
+    EXPECT_TRUE(parsed.isFor("any_bot"));
+
+    const auto blank = ParsedCommand::parse("/start ");
+    EXPECT_TRUE(blank.hasArgs);
+    EXPECT_TRUE(blank.args.empty());
+}
+
+TEST(ParsedCommandTest, NotACommand) {
+    const auto parsed = ParsedCommand::parse("hello @some_bot");
+    EXPECT_FALSE(parsed.isCommand());
+    EXPECT_TRUE(parsed.target.empty());
+    EXPECT_EQ(parsed.args, "@some_bot");
+}
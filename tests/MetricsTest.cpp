@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+
+#include <Metrics.hpp>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+TEST(MetricsTest, CounterSumsAllThreads) {
+    constexpr int kThreads = 12;
+    constexpr int kAdds = 10000;
+    auto& counter = Metrics::counter("test_threads_total", "Adds");
+    std::vector<std::thread> threads;
+
+    for (int i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&counter] {
+            for (int j = 0; j < kAdds; ++j) {
+                counter.add();
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(counter.value(), kThreads * kAdds);
+}
+
+TEST(MetricsTest, SameNameIsSameMetric) {
+    auto& first = Metrics::gauge("test_same", "Same");
+    auto& second = Metrics::gauge("test_same", "Same");
+    EXPECT_EQ(&first, &second);
+    first.set(5);
+    second.add(-7);
+    EXPECT_EQ(first.value(), -2);
+}
+
+TEST(MetricsTest, HistogramBucketsHoldTheirValues) {
+    using Metrics::Histogram;
+    for (uint64_t value : {0ULL, 1ULL, 3ULL, 4ULL, 7ULL, 8ULL, 1000ULL,
+                           123456789ULL}) {
+        const auto bucket = Histogram::bucketOf(value);
+        EXPECT_LT(value, Histogram::upperBound(bucket)) << value;
+        if (bucket > 0) {
+            EXPECT_GE(value, Histogram::upperBound(bucket - 1)) << value;
+        }
+    }
+    EXPECT_EQ(Histogram::bucketOf(~0ULL), Histogram::kBuckets - 1);
+}
+
+TEST(MetricsTest, HistogramRecordsDurations) {
+    auto& histogram = Metrics::histogram("test_seconds", "Durations");
+    histogram.record(std::chrono::milliseconds(3));
+    histogram.record(std::chrono::microseconds(10));
+    histogram.record(std::chrono::microseconds(-1));
+
+    const auto snapshot = histogram.snapshot();
+    EXPECT_EQ(snapshot.count, 3);
+    EXPECT_EQ(snapshot.sum, 3010);
+    EXPECT_EQ(snapshot.counts[Metrics::Histogram::bucketOf(0)], 1);
+    EXPECT_EQ(snapshot.counts[Metrics::Histogram::bucketOf(3000)], 1);
+}
+
+TEST(MetricsTest, SerializesPrometheusText) {
+    Metrics::counter("test_serialized_total", "A counter").add(3);
+    Metrics::histogram("test_serialized_seconds", "A histogram").record(3);
+    const auto text = Metrics::serialize();
+
+    EXPECT_NE(text.find("# HELP test_serialized_total A counter\n"
+                        "# TYPE test_serialized_total counter\n"
+                        "test_serialized_total 3\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("# TYPE test_serialized_seconds histogram\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_serialized_seconds_bucket{le=\"4e-06\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_serialized_seconds_bucket{le=\"+Inf\"} 1\n"),
+              std::string::npos);
+    EXPECT_NE(text.find("test_serialized_seconds_count 1\n"),
+              std::string::npos);
+}
+
+}  // namespace
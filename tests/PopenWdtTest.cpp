@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "popen_wdt/popen_wdt.h"
+
+namespace {
+
+// Runs command without the watchdog, returns all of its output
+std::string runCommand(const char* command,
+                       const char* workingDir = nullptr) {
+    popen_watchdog_data_t* data = nullptr;
+    std::array<char, 4096> buf{};
+    std::string output;
+    int len = 0;
+
+    EXPECT_TRUE(popen_watchdog_init(&data));
+    data->command = command;
+    data->working_dir = workingDir;
+    data->watchdog_enabled = false;
+    EXPECT_TRUE(popen_watchdog_start(&data));
+    while ((len = popen_watchdog_read(&data, buf.data(), buf.size())) > 0) {
+        output.append(buf.data(), len);
+    }
+    EXPECT_EQ(len, 0);
+    EXPECT_FALSE(popen_watchdog_activated(&data));
+    popen_watchdog_destroy(&data);
+    EXPECT_EQ(data, nullptr);
+    return output;
+}
+
+}  // namespace
+
+TEST(PopenWdtTest, CapturesStdoutAndStderr) {
+    EXPECT_EQ(runCommand("echo out; echo err >&2"), "out\nerr\n");
+}
+
+TEST(PopenWdtTest, RunsInCLocale) {
+    EXPECT_EQ(runCommand("echo $LC_ALL"), "C\n");
+}
+
+TEST(PopenWdtTest, RunsInWorkingDir) {
+    EXPECT_EQ(runCommand("pwd", "/"), "/\n");
+}
+
+TEST(PopenWdtTest, LargeOutputIsNotSlowedDown) {
+    const auto start = std::chrono::steady_clock::now();
+    const auto output = runCommand("head -c 65536 /dev/zero");
+    EXPECT_EQ(output.size(), 65536);
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::seconds(2));
+}
+
+TEST(PopenWdtTest, BackgroundChildDoesNotHoldTheRead) {
+    // The child keeps the pipe open, the command itself is done
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_EQ(runCommand("echo done; sleep 5 &"), "done\n");
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::seconds(2));
+}
+
+TEST(PopenWdtTest, ConcurrentCommands) {
+    std::vector<std::thread> threads;
+    std::array<std::string, 8> outputs;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        threads.emplace_back([&outputs, i] {
+            const std::string command = "echo " + std::to_string(i);
+            outputs[i] = runCommand(command.c_str());
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        EXPECT_EQ(outputs[i], std::to_string(i) + "\n");
+    }
+}
@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <limits>
+#include <random/BufferedEngine.h>
+#include <random/RandomNumberGenerator.h>
+#include <string>
+#include <vector>
+
+TEST(RandomNumberGeneratorTest, GenerateStaysInRange) {
+    for (int i = 0; i < 1000; ++i) {
+        const auto value = RandomNumberGenerator::generate(-3, 3);
+        ASSERT_GE(value, -3);
+        ASSERT_LE(value, 3);
+    }
+}
+
+TEST(RandomNumberGeneratorTest, GenerateSwapsReversedRange) {
+    const auto value = RandomNumberGenerator::generate(10, 5);
+    EXPECT_GE(value, 5);
+    EXPECT_LE(value, 10);
+}
+
+TEST(RandomNumberGeneratorTest, GenerateNHitsEveryValue) {
+    std::vector<random_return_type> values(1000);
+    RandomNumberGenerator::generateN(values, 1, 6);
+    for (random_return_type face = 1; face <= 6; ++face) {
+        EXPECT_NE(std::ranges::find(values, face), values.end()) << face;
+    }
+    EXPECT_TRUE(std::ranges::all_of(
+        values, [](auto value) { return value >= 1 && value <= 6; }));
+}
+
+TEST(RandomNumberGeneratorTest, GenerateNFullRange) {
+    std::vector<random_return_type> values(64);
+    RandomNumberGenerator::generateN(
+        values, std::numeric_limits<random_return_type>::min(),
+        std::numeric_limits<random_return_type>::max());
+    // 64 equal values would mean the range overflowed
+    EXPECT_NE(std::ranges::count(values, values.front()), values.size());
+}
+
+TEST(RandomNumberGeneratorTest, ShuffleKeepsElements) {
+    std::vector<std::string> strings;
+    for (int i = 0; i < 100; ++i) {
+        strings.emplace_back(std::to_string(i));
+    }
+    auto shuffled = strings;
+    RandomNumberGenerator::shuffleArray(shuffled);
+    EXPECT_NE(shuffled, strings);
+    std::ranges::sort(shuffled);
+    std::ranges::sort(strings);
+    EXPECT_EQ(shuffled, strings);
+}
+
+namespace {
+// Counts up, one byte at a time, and counts the reads
+struct CountingSource {
+    int* reads;
+    uint8_t next = 0;
+    bool read(void* buf, size_t len) {
+        ++*reads;
+        auto* out = static_cast<uint8_t*>(buf);
+        for (size_t i = 0; i < len; ++i) {
+            out[i] = next++;
+        }
+        return true;
+    }
+};
+}  // namespace
+
+TEST(RandomNumberGeneratorTest, BufferedEngineReadsInBatches) {
+    int reads = 0;
+    buffered_engine<CountingSource, 4> engine(CountingSource{&reads});
+    std::vector<uint64_t> values(3);
+    engine.fill(values);
+    EXPECT_EQ(reads, 1);
+    // One left in the buffer, then a refill
+    values.resize(2);
+    engine.fill(values);
+    EXPECT_EQ(reads, 2);
+    EXPECT_EQ(values[0] & 0xFF, 3 * 8);
+    EXPECT_EQ(values[1] & 0xFF, 4 * 8);
+    // Larger than the buffer, read directly
+    values.resize(10);
+    engine.fill(values);
+    EXPECT_EQ(reads, 3);
+}
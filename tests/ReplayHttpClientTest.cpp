@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <ReplayHttpClient.hpp>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+
+namespace {
+
+class ReplayHttpClientTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        file = std::filesystem::temp_directory_path() /
+               ("ReplayHttpClientTest_" + std::to_string(::getpid()));
+        std::ofstream(file)
+            << R"({"update_id":50,"message":{"message_id":1,"date":1000,)"
+               R"("chat":{"id":-5,"type":"supergroup"},"text":"hi"}})"
+            << "\n\nnot json\n"
+            << R"({"update_id":51,"message":{"message_id":2,"date":1001,)"
+               R"("chat":{"id":-5,"type":"supergroup"},"text":"/start"}})"
+            << "\n";
+    }
+    void TearDown() override { std::filesystem::remove(file); }
+
+    static TgBot::Url url(const std::string& method) {
+        return TgBot::Url("https://api.telegram.org/bot1:token/" + method);
+    }
+
+    std::filesystem::path file;
+};
+
+TEST_F(ReplayHttpClientTest, ServesRecordedUpdatesInOrder) {
+    std::optional<ReplayHttpClient::Report> report;
+    const ReplayHttpClient client(
+        file, 0, [&report](const auto& result) { report = result; });
+    ASSERT_EQ(client.size(), 2);
+
+    const auto first = client.makeRequest(url("getUpdates"), {});
+    EXPECT_NE(first.find(R"("update_id":1)"), std::string::npos);
+    EXPECT_NE(first.find(R"("text":"hi")"), std::string::npos);
+    // Dated now, not when it was recorded
+    EXPECT_EQ(first.find(R"("date":1000)"), std::string::npos);
+
+    const auto second = client.makeRequest(url("getUpdates"), {});
+    EXPECT_NE(second.find(R"("update_id":2)"), std::string::npos);
+    EXPECT_NE(second.find("/start"), std::string::npos);
+    EXPECT_FALSE(report);
+
+    EXPECT_EQ(client.makeRequest(url("getUpdates"), {}),
+              R"({"ok":true,"result":[]})");
+    ASSERT_TRUE(report);
+    EXPECT_EQ(report->updates, 2);
+    EXPECT_GE(report->p99, report->p50);
+}
+
+TEST_F(ReplayHttpClientTest, AnswersOtherMethodsLocally) {
+    std::optional<ReplayHttpClient::Report> report;
+    const ReplayHttpClient client(
+        file, 0, [&report](const auto& result) { report = result; });
+
+    const auto sent = client.makeRequest(
+        url("sendMessage"), {{"chat_id", "-5"}, {"text", "a \"quote\""}});
+    EXPECT_TRUE(sent.starts_with(R"({"ok":true,"result":{"message_id":)"));
+    EXPECT_NE(sent.find(R"("chat":{"id":-5,)"), std::string::npos);
+    EXPECT_NE(sent.find(R"("text":"a \"quote\"")"), std::string::npos);
+    EXPECT_EQ(client.makeRequest(url("setMyCommands"), {}),
+              R"({"ok":true,"result":true})");
+    EXPECT_EQ(client.makeRequest(url("getMyCommands"), {}),
+              R"({"ok":true,"result":[]})");
+
+    for (int i = 0; i < 3; ++i) {
+        (void)client.makeRequest(url("getUpdates"), {});
+    }
+    ASSERT_TRUE(report);
+    EXPECT_EQ(report->calls.at("sendMessage").count, 1);
+    EXPECT_EQ(report->calls.at("setMyCommands").count, 1);
+    EXPECT_GE(report->calls.at("sendMessage").max,
+              report->calls.at("sendMessage").p50);
+    EXPECT_FALSE(report->calls.contains("getUpdates"));
+}
+
+}  // namespace
@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+
+#include <StickerSetCache.hpp>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+// A set of count stickers, whose fileIds have the fetch number in them
+class FakeSource : public StickerSetCache::Source {
+   public:
+    StickerSetCache::Set fetch(const std::string& name) override {
+        const int fetch = ++fetches;
+        std::this_thread::sleep_for(delay);
+        if (fail) {
+            throw std::runtime_error("STICKERSET_INVALID");
+        }
+        StickerSetCache::Set set{name + " title", {}};
+        for (int i = 0; i < count; ++i) {
+            set.stickers.push_back(
+                {name + std::to_string(fetch) + "_" + std::to_string(i),
+                 "😀"});
+        }
+        return set;
+    }
+
+    std::atomic_int fetches = 0;
+    int count = 3;
+    std::atomic_bool fail = false;
+    std::chrono::milliseconds delay{0};
+};
+
+class StickerSetCacheTest : public ::testing::Test {
+   protected:
+    void SetUp() override { source = std::make_shared<FakeSource>(); }
+
+    StickerSetCache* makeCache() {
+        // Refreshes are run when the test says so
+        owned = std::make_unique<StickerSetCache>(
+            source,
+            [this](std::function<void()> refresh) {
+                pending.emplace_back(std::move(refresh));
+            },
+            limits);
+        return owned.get();
+    }
+    void runPending() {
+        auto refreshes = std::move(pending);
+        pending.clear();
+        for (auto& refresh : refreshes) {
+            refresh();
+        }
+    }
+
+    std::shared_ptr<FakeSource> source;
+    // Before pending, the refreshes left there must not outlive it
+    std::unique_ptr<StickerSetCache> owned;
+    std::vector<std::function<void()>> pending;
+    StickerSetCache::Limits limits;
+};
+
+TEST_F(StickerSetCacheTest, HitNeedsNoFetch) {
+    const auto cache = makeCache();
+    const auto first = cache->get("pack");
+    ASSERT_EQ(first->stickers.size(), 3);
+    EXPECT_EQ(first->title, "pack title");
+    EXPECT_EQ(first->stickers[0].fileId, "pack1_0");
+
+    EXPECT_EQ(cache->get("pack"), first);
+    EXPECT_EQ(source->fetches, 1);
+    const auto stats = cache->stats();
+    EXPECT_EQ(stats.hits, 1);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_TRUE(pending.empty());
+}
+
+TEST_F(StickerSetCacheTest, StaleSetIsServedWhileRefreshed) {
+    limits.ttl = 1s;
+    const auto cache = makeCache();
+    const auto first = cache->get("pack");
+    std::this_thread::sleep_for(1100ms);
+
+    EXPECT_EQ(cache->get("pack"), first);
+    EXPECT_EQ(cache->get("pack"), first);
+    // A single refresh for both
+    ASSERT_EQ(pending.size(), 1);
+    runPending();
+
+    const auto refreshed = cache->get("pack");
+    EXPECT_EQ(refreshed->stickers[0].fileId, "pack2_0");
+    const auto stats = cache->stats();
+    EXPECT_EQ(stats.staleHits, 1);
+    EXPECT_EQ(stats.refreshes, 1);
+    EXPECT_EQ(stats.hits, 3);
+}
+
+TEST_F(StickerSetCacheTest, FailedRefreshKeepsTheSet) {
+    limits.ttl = 1s;
+    const auto cache = makeCache();
+    const auto first = cache->get("pack");
+    std::this_thread::sleep_for(1100ms);
+
+    source->fail = true;
+    cache->get("pack");
+    runPending();
+    EXPECT_EQ(cache->stats().failures, 1);
+    EXPECT_EQ(cache->get("pack"), first);
+    // And it is tried again
+    EXPECT_EQ(pending.size(), 1);
+}
+
+TEST_F(StickerSetCacheTest, DroppedRefreshIsStartedAgain) {
+    limits.ttl = 1s;
+    const auto cache = makeCache();
+    cache->get("pack");
+    std::this_thread::sleep_for(1100ms);
+
+    cache->get("pack");
+    // Like a stopped scheduler, which destroys what it didn't run
+    ASSERT_EQ(pending.size(), 1);
+    pending.clear();
+    cache->get("pack");
+    EXPECT_EQ(pending.size(), 1);
+    EXPECT_EQ(cache->stats().staleHits, 2);
+}
+
+TEST_F(StickerSetCacheTest, ConcurrentMissesShareAFetch) {
+    source->delay = 100ms;
+    const auto cache = makeCache();
+    std::vector<std::thread> threads;
+    std::vector<StickerSetCache::SetPtr> sets(4);
+    for (size_t i = 0; i < sets.size(); ++i) {
+        threads.emplace_back([&, i] { sets[i] = cache->get("pack"); });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(source->fetches, 1);
+    for (const auto& set : sets) {
+        EXPECT_EQ(set, sets[0]);
+    }
+    EXPECT_EQ(cache->stats().sharedMisses, 3);
+}
+
+TEST_F(StickerSetCacheTest, SharedFetchFailureReachesAllMisses) {
+    source->delay = 100ms;
+    source->fail = true;
+    const auto cache = makeCache();
+    std::atomic_int failures = 0;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 3; ++i) {
+        threads.emplace_back([&] {
+            try {
+                cache->get("pack");
+            } catch (const std::runtime_error&) {
+                ++failures;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failures, 3);
+    EXPECT_EQ(source->fetches, 1);
+
+    // Nothing is left to wait on
+    source->fail = false;
+    EXPECT_NO_THROW(cache->get("pack"));
+    EXPECT_EQ(source->fetches, 2);
+}
+
+TEST_F(StickerSetCacheTest, OldSetIsFetchedAgain) {
+    limits.ttl = 1s;
+    limits.maxAge = 1s;
+    const auto cache = makeCache();
+    cache->get("pack");
+    std::this_thread::sleep_for(1100ms);
+    EXPECT_EQ(cache->get("pack")->stickers[0].fileId, "pack2_0");
+    EXPECT_EQ(cache->stats().misses, 2);
+    EXPECT_TRUE(pending.empty());
+}
+
+TEST_F(StickerSetCacheTest, FailedFetchThrowsAndIsNotCached) {
+    const auto cache = makeCache();
+    source->fail = true;
+    EXPECT_THROW(cache->get("pack"), std::runtime_error);
+    source->fail = false;
+    EXPECT_NO_THROW(cache->get("pack"));
+    EXPECT_EQ(source->fetches, 2);
+}
+
+TEST_F(StickerSetCacheTest, LeastRecentlyUsedSetIsDropped) {
+    limits.maxSets = 2;
+    const auto cache = makeCache();
+    cache->get("a");
+    cache->get("b");
+    cache->get("a");
+    cache->get("c");
+    cache->get("a");
+    EXPECT_EQ(source->fetches, 3);
+    cache->get("b");
+    EXPECT_EQ(source->fetches, 4);
+}
+
+}  // namespace
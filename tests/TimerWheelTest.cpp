@@ -0,0 +1,139 @@
+#include <gtest/gtest.h>
+
+#include <TimerWheel.hpp>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+TEST(TimerWheelTest, OneShotFiresAfterDelay) {
+    TimerWheel wheel;
+    std::promise<TimerWheel::Clock::time_point> fired;
+    const auto start = TimerWheel::Clock::now();
+
+    wheel.schedule(30ms, [&fired] {
+        fired.set_value(TimerWheel::Clock::now());
+    });
+    auto future = fired.get_future();
+    ASSERT_EQ(future.wait_for(5s), std::future_status::ready);
+    EXPECT_GE(future.get() - start, 30ms);
+    EXPECT_EQ(wheel.pending(), 0);
+}
+
+TEST(TimerWheelTest, FiresInOrderAcrossLevels) {
+    TimerWheel wheel;
+    std::mutex mutex;
+    std::vector<int> order;
+    std::promise<void> done;
+
+    // 150ms and 300ms start out in the second level, and move down
+    for (const int delay : {300, 5, 150, 70, 20}) {
+        wheel.schedule(std::chrono::milliseconds(delay), [&, delay] {
+            const std::lock_guard<std::mutex> lock(mutex);
+            order.emplace_back(delay);
+            if (order.size() == 5) {
+                done.set_value();
+            }
+        });
+    }
+    ASSERT_EQ(done.get_future().wait_for(5s), std::future_status::ready);
+    EXPECT_EQ(order, (std::vector<int>{5, 20, 70, 150, 300}));
+}
+
+TEST(TimerWheelTest, CancelledTimerDoesNotFire) {
+    TimerWheel wheel;
+    std::atomic_bool fired = false;
+    std::promise<void> later;
+
+    const auto id = wheel.schedule(20ms, [&fired] { fired = true; });
+    wheel.schedule(60ms, [&later] { later.set_value(); });
+    EXPECT_TRUE(wheel.cancel(id));
+    EXPECT_FALSE(wheel.cancel(id));
+
+    ASSERT_EQ(later.get_future().wait_for(5s), std::future_status::ready);
+    EXPECT_FALSE(fired);
+}
+
+TEST(TimerWheelTest, CancelWaitsForRunningCallback) {
+    TimerWheel wheel;
+    std::promise<void> entered;
+    std::atomic_bool finished = false;
+
+    const auto id = wheel.schedule(1ms, [&] {
+        entered.set_value();
+        std::this_thread::sleep_for(50ms);
+        finished = true;
+    });
+    entered.get_future().wait();
+    EXPECT_TRUE(wheel.cancel(id));
+    EXPECT_TRUE(finished);
+}
+
+TEST(TimerWheelTest, PeriodicRunsUntilFalse) {
+    TimerWheel wheel;
+    std::atomic_int runs = 0;
+    std::promise<void> done;
+
+    wheel.schedulePeriodic(5ms, [&] {
+        if (++runs == 3) {
+            done.set_value();
+            return false;
+        }
+        return true;
+    });
+    ASSERT_EQ(done.get_future().wait_for(5s), std::future_status::ready);
+    std::this_thread::sleep_for(30ms);
+    EXPECT_EQ(runs, 3);
+    EXPECT_EQ(wheel.pending(), 0);
+}
+
+TEST(TimerWheelTest, PeriodicCanCancelItself) {
+    TimerWheel wheel;
+    std::atomic_int runs = 0;
+    std::promise<void> done;
+    std::atomic<TimerWheel::TimerId> id = TimerWheel::kInvalidTimer;
+
+    id = wheel.schedulePeriodic(5ms, [&] {
+        if (++runs == 2) {
+            EXPECT_TRUE(wheel.cancel(id));
+            done.set_value();
+        }
+        return true;
+    });
+    ASSERT_EQ(done.get_future().wait_for(5s), std::future_status::ready);
+    std::this_thread::sleep_for(30ms);
+    EXPECT_EQ(runs, 2);
+}
+
+TEST(TimerWheelTest, ThrowingCallbackDoesNotStopOthers) {
+    TimerWheel wheel;
+    std::atomic_int runs = 0;
+    std::promise<void> done;
+
+    wheel.schedulePeriodic(5ms, [&]() -> bool {
+        ++runs;
+        throw std::runtime_error("timer failed");
+    });
+    wheel.schedule(30ms, [&done] { done.set_value(); });
+    ASSERT_EQ(done.get_future().wait_for(5s), std::future_status::ready);
+    // Not run again once it threw
+    EXPECT_EQ(runs, 1);
+    EXPECT_EQ(wheel.pending(), 0);
+}
+
+TEST(TimerWheelTest, ScheduleFailsAfterStop) {
+    TimerWheel wheel;
+    std::atomic_bool fired = false;
+
+    wheel.schedule(20ms, [&fired] { fired = true; });
+    wheel.stop();
+    EXPECT_EQ(wheel.pending(), 0);
+    EXPECT_EQ(wheel.schedule(1ms, [] {}), TimerWheel::kInvalidTimer);
+    std::this_thread::sleep_for(40ms);
+    EXPECT_FALSE(fired);
+}
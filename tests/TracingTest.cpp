@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+#include <unistd.h>
+
+#include <Tracing.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+namespace {
+
+class TracingTest : public ::testing::Test {
+   protected:
+    void SetUp() override {
+        file = std::filesystem::temp_directory_path() /
+               ("TracingTest_" + std::to_string(::getpid()) + ".json");
+    }
+    void TearDown() override {
+        Tracing::stop();
+        std::filesystem::remove(file);
+    }
+
+    std::string read() {
+        std::ifstream in(file);
+        return {std::istreambuf_iterator<char>(in),
+                std::istreambuf_iterator<char>()};
+    }
+
+    std::filesystem::path file;
+};
+
+TEST_F(TracingTest, SpansOfATraceAreWritten) {
+    ASSERT_TRUE(Tracing::start(file, 1));
+    EXPECT_FALSE(Tracing::start(file, 1));
+
+    Tracing::beginTrace("update");
+    const auto context = Tracing::current();
+    EXPECT_NE(context.trace, 0);
+    {
+        const Tracing::Span span("auth");
+    }
+    std::thread([context] {
+        const Tracing::Resume resume(context);
+        const Tracing::Span span("send \"quoted\"");
+    }).join();
+    Tracing::endTrace();
+    EXPECT_EQ(Tracing::current().trace, 0);
+    Tracing::stop();
+
+    const auto json = read();
+    const auto trace = R"("args":{"trace":)" + std::to_string(context.trace);
+    EXPECT_TRUE(json.starts_with("[\n"));
+    EXPECT_TRUE(json.ends_with("\n]\n"));
+    EXPECT_NE(json.find(R"({"name":"update","ph":"X")"), std::string::npos);
+    EXPECT_NE(json.find(R"({"name":"auth","ph":"X")"), std::string::npos);
+    EXPECT_NE(json.find(R"({"name":"send \"quoted\"","ph":"X")"),
+              std::string::npos);
+    EXPECT_NE(json.find(trace), std::string::npos);
+}
+
+TEST_F(TracingTest, NothingIsRecordedOutsideATrace) {
+    ASSERT_TRUE(Tracing::start(file, 1));
+    {
+        const Tracing::Span span("orphan");
+    }
+    Tracing::stop();
+    EXPECT_EQ(read(), "[\n\n]\n");
+}
+
+TEST_F(TracingTest, UnsampledTracesAreNotRecorded) {
+    ASSERT_TRUE(Tracing::start(file, 0));
+    Tracing::beginTrace("update");
+    EXPECT_EQ(Tracing::current().trace, 0);
+    {
+        const Tracing::Span span("auth");
+    }
+    Tracing::endTrace();
+    Tracing::stop();
+    EXPECT_EQ(read().find("auth"), std::string::npos);
+}
+
+}  // namespace